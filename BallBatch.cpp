@@ -0,0 +1,466 @@
+// Tennis Ball Physics Simulator - structure-of-arrays ball batch
+
+#include "BallBatch.h"
+
+#include <bitset>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BALL_BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC exposes every intrinsic regardless of /arch; dispatch happens at runtime
+#define BALL_BATCH_TARGET_AVX2
+#define BALL_BATCH_TARGET_AVX512
+#else
+#define BALL_BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+// AVX-512F implies FMA in GCC/Clang; keep contraction off so lanes match the scalar path
+#define BALL_BATCH_TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#endif
+#else
+#define BALL_BATCH_X86 0
+#endif
+
+SimdLevel DetectSimdLevel() {
+#if BALL_BATCH_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7) return SIMD_SCALAR;
+
+    // The OS must save the YMM (and for AVX-512, the ZMM/opmask) registers on context switch
+    unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) return SIMD_SCALAR;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (avx512f && (xcr0 & 0xE6) == 0xE6) return SIMD_AVX512;
+    if (avx2) return SIMD_AVX2;
+    return SIMD_SCALAR;
+#elif BALL_BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+const wchar_t* SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SIMD_AVX512: return L"AVX-512";
+        case SIMD_AVX2: return L"AVX2";
+        default: return L"Scalar";
+    }
+}
+
+BallBatch::BallBatch()
+    : count(0), paddedCount(0), laneLimit(0), simdLevel(DetectSimdLevel()), anyDrag(false), anySpin(false) {
+}
+
+void BallBatch::LoadShots(const ShotParams* params, size_t shotCount, uint64_t randomSeed) {
+    Resize(shotCount);
+    for (size_t i = 0; i < count; i++) {
+        LaunchLane(i, params[i], randomSeed);
+        shotIndex[i] = (int32_t)i;
+    }
+}
+
+void BallBatch::Resize(size_t ballCount) {
+    count = ballCount;
+    paddedCount = (ballCount + BALL_BATCH_LANES - 1) / BALL_BATCH_LANES * BALL_BATCH_LANES;
+    laneLimit = paddedCount;
+    anyDrag = false;
+    anySpin = false;
+
+    // assign() keeps existing capacity, so reloading a batch of the same size does not allocate
+    x.assign(paddedCount, 0.0f);
+    y.assign(paddedCount, 0.0f);
+    vx.assign(paddedCount, 0.0f);
+    vy.assign(paddedCount, 0.0f);
+    spinRPM.assign(paddedCount, 0.0f);
+    time.assign(paddedCount, 0.0f);
+    airResistanceCoeff.assign(paddedCount, 0.0f);
+    restitution.assign(paddedCount, 0.0f);
+    firstBounceX.assign(paddedCount, -1.0f);
+    firstBounceTime.assign(paddedCount, -1.0f);
+    bounceCount.assign(paddedCount, 0);
+    active.assign(paddedCount, 0);
+    hitNet.assign(paddedCount, 0);
+    steps.assign(paddedCount, 0);
+    shotIndex.assign(paddedCount, 0);
+    random.assign(paddedCount, RandomStream());
+}
+
+void BallBatch::LaunchLane(size_t lane, const ShotParams& shot, uint64_t randomSeed) {
+    x[lane] = LEFTY_START_X;
+    y[lane] = 1.0f;
+    ComputeLaunchVelocity(shot.force, shot.angle, vx[lane], vy[lane]);
+    spinRPM[lane] = shot.spin;
+    time[lane] = 0.0f;
+    airResistanceCoeff[lane] = airModes[shot.airMode].coefficient;
+    restitution[lane] = courts[shot.surfaceIndex].coefficientOfRestitution;
+    firstBounceX[lane] = -1.0f;
+    firstBounceTime[lane] = -1.0f;
+    bounceCount[lane] = 0;
+    active[lane] = -1;
+    hitNet[lane] = 0;
+    steps[lane] = 0;
+    random[lane].Seed(randomSeed, shot.randomStream);
+    LaneChanged(lane);
+}
+
+void BallBatch::LaneChanged(size_t lane) {
+    if (airResistanceCoeff[lane] != 0.0f) anyDrag = true;
+    if (spinRPM[lane] != 0.0f) anySpin = true;
+}
+
+size_t BallBatch::Advance(float dt, float maxTime) {
+    if (anyDrag) {
+        return anySpin ? AdvanceWith<true, true>(dt, maxTime) : AdvanceWith<true, false>(dt, maxTime);
+    }
+    return anySpin ? AdvanceWith<false, true>(dt, maxTime) : AdvanceWith<false, false>(dt, maxTime);
+}
+
+template <bool Drag, bool Spin>
+size_t BallBatch::AdvanceWith(float dt, float maxTime) {
+#if BALL_BATCH_X86
+    if (simdLevel == SIMD_AVX512) return AdvanceAvx512<Drag, Spin>(dt, maxTime);
+    if (simdLevel == SIMD_AVX2) return AdvanceAvx2<Drag, Spin>(dt, maxTime);
+#endif
+    return AdvanceScalar<Drag, Spin>(0, laneLimit, dt, maxTime);
+}
+
+void BallBatch::RunToRest(float dt, float maxTime) {
+    if (simdLevel == SIMD_SCALAR) {
+        // Lanes are independent, so the scalar path finishes one ball at a time while it is hot in cache
+        // and each on the kernel for its own drag and spin
+        for (size_t i = 0; i < count; i++) {
+            bool drag = airResistanceCoeff[i] != 0.0f;
+            bool spin = spinRPM[i] != 0.0f;
+            while (AdvanceScalar(drag, spin, i, i + 1, dt, maxTime) > 0) {
+            }
+        }
+        return;
+    }
+
+    size_t compactBelow = count / 2;
+    size_t remaining;
+    while ((remaining = Advance(dt, maxTime)) > 0) {
+        if (remaining <= compactBelow) {
+            CompactActiveLanes();
+            compactBelow = remaining / 2;
+        }
+    }
+}
+
+void BallBatch::CompactActiveLanes() {
+    // Stable partition: active lanes move to the front, finished lanes keep their final state behind them
+    size_t write = 0;
+    for (size_t read = 0; read < laneLimit; read++) {
+        if (!active[read]) continue;
+        if (read != write) SwapLanes(read, write);
+        write++;
+    }
+    laneLimit = (write + BALL_BATCH_LANES - 1) / BALL_BATCH_LANES * BALL_BATCH_LANES;
+
+    // Only the lanes still in flight decide the kernel from here on
+    anyDrag = false;
+    anySpin = false;
+    for (size_t lane = 0; lane < write; lane++) {
+        LaneChanged(lane);
+    }
+}
+
+void BallBatch::SwapLanes(size_t a, size_t b) {
+    std::swap(x[a], x[b]);
+    std::swap(y[a], y[b]);
+    std::swap(vx[a], vx[b]);
+    std::swap(vy[a], vy[b]);
+    std::swap(spinRPM[a], spinRPM[b]);
+    std::swap(time[a], time[b]);
+    std::swap(airResistanceCoeff[a], airResistanceCoeff[b]);
+    std::swap(restitution[a], restitution[b]);
+    std::swap(firstBounceX[a], firstBounceX[b]);
+    std::swap(firstBounceTime[a], firstBounceTime[b]);
+    std::swap(bounceCount[a], bounceCount[b]);
+    std::swap(active[a], active[b]);
+    std::swap(hitNet[a], hitNet[b]);
+    std::swap(steps[a], steps[b]);
+    std::swap(shotIndex[a], shotIndex[b]);
+    std::swap(random[a], random[b]);
+}
+
+void BallBatch::StoreResults(ShotResult* results) const {
+    for (size_t i = 0; i < count; i++) {
+        ShotResult& result = results[shotIndex[i]];
+        result.firstBounceX = firstBounceX[i];
+        result.firstBounceTime = firstBounceTime[i];
+        result.finalX = x[i];
+        result.timeToRest = time[i];
+        result.bounceCount = bounceCount[i];
+        result.steps = steps[i];
+        result.hitNet = hitNet[i] != 0;
+        result.leftCourt = x[i] < 0.0f || x[i] > COURT_LENGTH;
+    }
+}
+
+void BallBatch::ResolveLaneEvents(size_t lane, float prevX, float prevY) {
+    // Same order as TennisBall::update: net first, then ground, then court bounds
+    if (CrossedNetPlane(prevX, x[lane]) &&
+        ResolveNetContact(prevX, prevY, x[lane], y[lane], vx[lane], vy[lane], spinRPM[lane], random[lane])) {
+        hitNet[lane] = 1;
+    }
+
+    if (y[lane] <= 0.0f) {
+        if (bounceCount[lane] == 0) {
+            firstBounceX[lane] = x[lane];
+            firstBounceTime[lane] = time[lane];
+        }
+        if (!ResolveGroundContact(y[lane], vx[lane], vy[lane], spinRPM[lane], bounceCount[lane], restitution[lane])) {
+            active[lane] = 0;
+        }
+    }
+
+    if (x[lane] < 0.0f || x[lane] > COURT_LENGTH) {
+        active[lane] = 0;
+    }
+}
+
+size_t BallBatch::AdvanceScalar(bool drag, bool spin, size_t begin, size_t end, float dt, float maxTime) {
+    if (drag) {
+        return spin ? AdvanceScalar<true, true>(begin, end, dt, maxTime) : AdvanceScalar<true, false>(begin, end, dt, maxTime);
+    }
+    return spin ? AdvanceScalar<false, true>(begin, end, dt, maxTime) : AdvanceScalar<false, false>(begin, end, dt, maxTime);
+}
+
+template <bool Drag, bool Spin>
+size_t BallBatch::AdvanceScalar(size_t begin, size_t end, float dt, float maxTime) {
+    size_t remaining = 0;
+    for (size_t i = begin; i < end; i++) {
+        if (!active[i]) continue;
+        if (time[i] >= maxTime) {
+            active[i] = 0;
+            continue;
+        }
+
+        float prevX = x[i];
+        float prevY = y[i];
+        time[i] += dt;
+        AdvanceFlightKernel<Drag, Spin>(x[i], y[i], vx[i], vy[i], spinRPM[i], airResistanceCoeff[i], dt);
+        steps[i]++;
+
+        if (CrossedNetPlane(prevX, x[i]) || y[i] <= 0.0f || x[i] < 0.0f || x[i] > COURT_LENGTH) {
+            ResolveLaneEvents(i, prevX, prevY);
+        }
+        if (active[i]) remaining++;
+    }
+    return remaining;
+}
+
+#if BALL_BATCH_X86
+
+// The kernels mirror AdvanceFlightKernel operation for operation (no fused multiply-add)
+// so a lane produces the same floats as TennisBall::update.
+
+template <bool Drag, bool Spin>
+BALL_BATCH_TARGET_AVX2
+size_t BallBatch::AdvanceAvx2(float dt, float maxTime) {
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 gravityStep = _mm256_set1_ps(GRAVITY * dt);
+    const __m256 vmaxTime = _mm256_set1_ps(maxTime);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 pi = _mm256_set1_ps(3.14159265f);
+    const __m256 sixty = _mm256_set1_ps(60.0f);
+    const __m256 magnusCoeff = _mm256_set1_ps(MAGNUS_COEFF);
+    const __m256 ballMass = _mm256_set1_ps(BALL_MASS);
+    const __m256 minMagnusSpeed = _mm256_set1_ps(0.1f);
+    const __m256 netX = _mm256_set1_ps(NET_X);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 courtLength = _mm256_set1_ps(COURT_LENGTH);
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    alignas(32) float prevXLanes[8];
+    alignas(32) float prevYLanes[8];
+    size_t remaining = 0;
+
+    for (size_t i = 0; i < laneLimit; i += 8) {
+        __m256 activeMask = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&active[i]));
+        if (_mm256_testz_ps(activeMask, activeMask)) continue;
+
+        __m256 t = _mm256_loadu_ps(&time[i]);
+        __m256 live = _mm256_and_ps(activeMask, _mm256_cmp_ps(t, vmaxTime, _CMP_LT_OQ));
+        _mm256_storeu_si256((__m256i*)&active[i], _mm256_castps_si256(live));
+        if (_mm256_testz_ps(live, live)) continue;
+
+        __m256 px = _mm256_loadu_ps(&x[i]);
+        __m256 py = _mm256_loadu_ps(&y[i]);
+        __m256 pvx = _mm256_loadu_ps(&vx[i]);
+        __m256 pvy = _mm256_loadu_ps(&vy[i]);
+        __m256 nt = _mm256_add_ps(t, vdt);
+
+        // Gravity
+        __m256 nvy = _mm256_sub_ps(pvy, gravityStep);
+
+        if (Spin) {
+            // Magnus lift, only above 0.1 m/s
+            __m256 spin = _mm256_loadu_ps(&spinRPM[i]);
+            __m256 omega = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(spin, two), pi), sixty);
+            __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(pvx, pvx), _mm256_mul_ps(nvy, nvy)));
+            __m256 magnusAccel = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(magnusCoeff, omega), speed), ballMass);
+            __m256 magnusVy = _mm256_sub_ps(nvy, _mm256_mul_ps(magnusAccel, vdt));
+            nvy = _mm256_blendv_ps(nvy, magnusVy, _mm256_cmp_ps(speed, minMagnusSpeed, _CMP_GT_OQ));
+        }
+
+        __m256 ny = _mm256_add_ps(py, _mm256_mul_ps(nvy, vdt));
+
+        __m256 nvx = pvx;
+        if (Drag) {
+            // Quadratic horizontal drag
+            __m256 air = _mm256_loadu_ps(&airResistanceCoeff[i]);
+            __m256 dragForce = _mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(air, signMask), pvx), _mm256_and_ps(pvx, absMask));
+            __m256 ax = _mm256_div_ps(dragForce, ballMass);
+            nvx = _mm256_add_ps(pvx, _mm256_mul_ps(ax, vdt));
+        }
+        __m256 nx = _mm256_add_ps(px, _mm256_mul_ps(nvx, vdt));
+
+        // Commit live lanes only
+        _mm256_storeu_ps(&time[i], _mm256_blendv_ps(t, nt, live));
+        _mm256_storeu_ps(&x[i], _mm256_blendv_ps(px, nx, live));
+        _mm256_storeu_ps(&y[i], _mm256_blendv_ps(py, ny, live));
+        _mm256_storeu_ps(&vx[i], _mm256_blendv_ps(pvx, nvx, live));
+        _mm256_storeu_ps(&vy[i], _mm256_blendv_ps(pvy, nvy, live));
+        __m256i laneSteps = _mm256_loadu_si256((const __m256i*)&steps[i]);
+        _mm256_storeu_si256((__m256i*)&steps[i], _mm256_sub_epi32(laneSteps, _mm256_castps_si256(live)));
+
+        // Net crossing, ground contact and court bounds are rare; flag them and resolve per lane
+        __m256 crossed = _mm256_or_ps(
+            _mm256_and_ps(_mm256_cmp_ps(px, netX, _CMP_LT_OQ), _mm256_cmp_ps(nx, netX, _CMP_GE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(px, netX, _CMP_GT_OQ), _mm256_cmp_ps(nx, netX, _CMP_LE_OQ)));
+        __m256 ground = _mm256_cmp_ps(ny, zero, _CMP_LE_OQ);
+        __m256 outOfBounds = _mm256_or_ps(_mm256_cmp_ps(nx, zero, _CMP_LT_OQ), _mm256_cmp_ps(nx, courtLength, _CMP_GT_OQ));
+        __m256 events = _mm256_and_ps(live, _mm256_or_ps(crossed, _mm256_or_ps(ground, outOfBounds)));
+
+        int eventBits = _mm256_movemask_ps(events);
+        if (eventBits) {
+            _mm256_store_ps(prevXLanes, px);
+            _mm256_store_ps(prevYLanes, py);
+            for (int lane = 0; lane < 8; lane++) {
+                if (eventBits & (1 << lane)) {
+                    ResolveLaneEvents(i + lane, prevXLanes[lane], prevYLanes[lane]);
+                }
+            }
+        }
+
+        __m256 stillActive = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&active[i]));
+        remaining += std::bitset<8>(_mm256_movemask_ps(stillActive)).count();
+    }
+    return remaining;
+}
+
+template <bool Drag, bool Spin>
+BALL_BATCH_TARGET_AVX512
+size_t BallBatch::AdvanceAvx512(float dt, float maxTime) {
+    const __m512 vdt = _mm512_set1_ps(dt);
+    const __m512 gravityStep = _mm512_set1_ps(GRAVITY * dt);
+    const __m512 vmaxTime = _mm512_set1_ps(maxTime);
+    const __m512 two = _mm512_set1_ps(2.0f);
+    const __m512 pi = _mm512_set1_ps(3.14159265f);
+    const __m512 sixty = _mm512_set1_ps(60.0f);
+    const __m512 magnusCoeff = _mm512_set1_ps(MAGNUS_COEFF);
+    const __m512 ballMass = _mm512_set1_ps(BALL_MASS);
+    const __m512 minMagnusSpeed = _mm512_set1_ps(0.1f);
+    const __m512 netX = _mm512_set1_ps(NET_X);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 courtLength = _mm512_set1_ps(COURT_LENGTH);
+    const __m512i signMask = _mm512_set1_epi32((int)0x80000000);
+    const __m512i allOnes = _mm512_set1_epi32(-1);
+    const __m512i one = _mm512_set1_epi32(1);
+
+    alignas(64) float prevXLanes[16];
+    alignas(64) float prevYLanes[16];
+    size_t remaining = 0;
+
+    for (size_t i = 0; i < laneLimit; i += 16) {
+        __mmask16 activeMask = _mm512_test_epi32_mask(_mm512_loadu_si512(&active[i]), allOnes);
+        if (!activeMask) continue;
+
+        __m512 t = _mm512_loadu_ps(&time[i]);
+        __mmask16 live = _mm512_mask_cmp_ps_mask(activeMask, t, vmaxTime, _CMP_LT_OQ);
+        if (live != activeMask) {
+            _mm512_storeu_si512(&active[i], _mm512_maskz_mov_epi32(live, allOnes));
+        }
+        if (!live) continue;
+
+        __m512 px = _mm512_loadu_ps(&x[i]);
+        __m512 py = _mm512_loadu_ps(&y[i]);
+        __m512 pvx = _mm512_loadu_ps(&vx[i]);
+        __m512 pvy = _mm512_loadu_ps(&vy[i]);
+        // Gravity
+        __m512 nvy = _mm512_sub_ps(pvy, gravityStep);
+
+        if (Spin) {
+            // Magnus lift, only above 0.1 m/s
+            __m512 spin = _mm512_loadu_ps(&spinRPM[i]);
+            __m512 omega = _mm512_div_ps(_mm512_mul_ps(_mm512_mul_ps(spin, two), pi), sixty);
+            __m512 speed = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(pvx, pvx), _mm512_mul_ps(nvy, nvy)));
+            __m512 magnusAccel = _mm512_div_ps(_mm512_mul_ps(_mm512_mul_ps(magnusCoeff, omega), speed), ballMass);
+            __mmask16 magnusLanes = _mm512_cmp_ps_mask(speed, minMagnusSpeed, _CMP_GT_OQ);
+            nvy = _mm512_mask_sub_ps(nvy, magnusLanes, nvy, _mm512_mul_ps(magnusAccel, vdt));
+        }
+
+        __m512 ny = _mm512_add_ps(py, _mm512_mul_ps(nvy, vdt));
+
+        __m512 nvx = pvx;
+        if (Drag) {
+            // Quadratic horizontal drag
+            __m512 air = _mm512_loadu_ps(&airResistanceCoeff[i]);
+            __m512 negAir = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(air), signMask));
+            __m512 dragForce = _mm512_mul_ps(_mm512_mul_ps(negAir, pvx), _mm512_abs_ps(pvx));
+            __m512 ax = _mm512_div_ps(dragForce, ballMass);
+            nvx = _mm512_add_ps(pvx, _mm512_mul_ps(ax, vdt));
+        }
+        __m512 nx = _mm512_add_ps(px, _mm512_mul_ps(nvx, vdt));
+
+        // Commit live lanes only
+        _mm512_mask_storeu_ps(&time[i], live, _mm512_add_ps(t, vdt));
+        _mm512_mask_storeu_ps(&x[i], live, nx);
+        _mm512_mask_storeu_ps(&y[i], live, ny);
+        _mm512_mask_storeu_ps(&vx[i], live, nvx);
+        _mm512_mask_storeu_ps(&vy[i], live, nvy);
+        __m512i laneSteps = _mm512_loadu_si512(&steps[i]);
+        _mm512_storeu_si512(&steps[i], _mm512_mask_add_epi32(laneSteps, live, laneSteps, one));
+
+        // Net crossing, ground contact and court bounds are rare; flag them and resolve per lane
+        __mmask16 crossed =
+            (_mm512_cmp_ps_mask(px, netX, _CMP_LT_OQ) & _mm512_cmp_ps_mask(nx, netX, _CMP_GE_OQ)) |
+            (_mm512_cmp_ps_mask(px, netX, _CMP_GT_OQ) & _mm512_cmp_ps_mask(nx, netX, _CMP_LE_OQ));
+        __mmask16 ground = _mm512_cmp_ps_mask(ny, zero, _CMP_LE_OQ);
+        __mmask16 outOfBounds = _mm512_cmp_ps_mask(nx, zero, _CMP_LT_OQ) | _mm512_cmp_ps_mask(nx, courtLength, _CMP_GT_OQ);
+        unsigned eventBits = live & (crossed | ground | outOfBounds);
+
+        if (eventBits) {
+            _mm512_store_ps(prevXLanes, px);
+            _mm512_store_ps(prevYLanes, py);
+            for (int lane = 0; lane < 16; lane++) {
+                if (eventBits & (1u << lane)) {
+                    ResolveLaneEvents(i + lane, prevXLanes[lane], prevYLanes[lane]);
+                }
+            }
+        }
+
+        __mmask16 stillActive = _mm512_test_epi32_mask(_mm512_loadu_si512(&active[i]), allOnes);
+        remaining += std::bitset<16>(stillActive).count();
+    }
+    return remaining;
+}
+
+#endif
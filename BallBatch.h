@@ -0,0 +1,101 @@
+// Tennis Ball Physics Simulator - structure-of-arrays ball batch
+// Advances many independent shots per step with AVX2 (8 lanes) or AVX-512 (16 lanes)
+// kernels, falling back to scalar code on older CPUs
+
+#pragma once
+
+#include "SimulationEngine.h"
+
+#include <cstdint>
+#include <vector>
+
+// Instruction set used by BallBatch::Advance
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+// Highest instruction set supported by both the CPU and the operating system
+SimdLevel DetectSimdLevel();
+const wchar_t* SimdLevelName(SimdLevel level);
+
+// Ball state stored as one contiguous array per field. Arrays are padded to a
+// multiple of BALL_BATCH_LANES so the vector kernels never need a scalar tail;
+// padding lanes are permanently inactive.
+class BallBatch {
+public:
+    static const size_t BALL_BATCH_LANES = 16;
+
+    BallBatch();
+
+    // Resets the batch to one ball per shot, launched as TennisBall::resetForHorizontalShot would,
+    // each drawing from its shot's random stream under randomSeed
+    void LoadShots(const ShotParams* params, size_t count, uint64_t randomSeed = 0);
+
+    // Resets the batch to count lanes, all inactive, to be launched one at a time
+    void Resize(size_t count);
+
+    // Launches shot in lane, which must be below Size(); the lane's previous ball is replaced.
+    // Lanes only stay where they are while RunToRest is not used.
+    void LaunchLane(size_t lane, const ShotParams& shot, uint64_t randomSeed = 0);
+
+    // Call after writing a lane's spinRPM or airResistanceCoeff directly. Advance runs
+    // one kernel for the whole batch, without the drag or Magnus terms when no lane
+    // needs them, and only learns of new drag or spin through here.
+    void LaneChanged(size_t lane);
+
+    // Advances every active ball by dt; balls whose time reaches maxTime are retired.
+    // Returns the number of balls still active after the step.
+    size_t Advance(float dt, float maxTime);
+
+    // Advances until every ball has come to rest, left the court or reached maxTime.
+    // Finished lanes are periodically compacted away so vector lanes stay busy while
+    // long rallies finish; shotIndex tracks where each shot ended up.
+    void RunToRest(float dt, float maxTime);
+
+    void StoreResults(ShotResult* results) const;
+
+    size_t Size() const { return count; }
+    SimdLevel GetSimdLevel() const { return simdLevel; }
+    void SetSimdLevel(SimdLevel level) { simdLevel = level; }
+
+    // Field arrays (public for kernels and inspection, like TennisBall's members)
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> spinRPM;
+    std::vector<float> time;
+    std::vector<float> airResistanceCoeff;
+    std::vector<float> restitution;
+    std::vector<float> firstBounceX;
+    std::vector<float> firstBounceTime;
+    std::vector<int32_t> bounceCount;
+    std::vector<int32_t> active;   // 0 or -1 so the arrays load directly as lane masks
+    std::vector<int32_t> hitNet;
+    std::vector<int32_t> steps;
+    std::vector<int32_t> shotIndex; // Shot loaded into each lane (lanes move during compaction)
+    std::vector<RandomStream> random; // Net deflection draws, only touched on lane events
+
+private:
+    size_t count;
+    size_t paddedCount;
+    size_t laneLimit; // Kernels only visit lanes below this; everything beyond has finished
+    SimdLevel simdLevel;
+    bool anyDrag; // Some lane may have a drag or a spin term; spin only ever decays,
+    bool anySpin; // so a batch that launched without one keeps the lighter kernel
+
+    void CompactActiveLanes();
+    void SwapLanes(size_t a, size_t b);
+
+    // Kernels specialized on whether any lane they visit has drag and spin (AdvanceFlightKernel)
+    template <bool Drag, bool Spin> size_t AdvanceWith(float dt, float maxTime);
+    template <bool Drag, bool Spin> size_t AdvanceScalar(size_t begin, size_t end, float dt, float maxTime);
+    template <bool Drag, bool Spin> size_t AdvanceAvx2(float dt, float maxTime);
+    template <bool Drag, bool Spin> size_t AdvanceAvx512(float dt, float maxTime);
+    size_t AdvanceScalar(bool drag, bool spin, size_t begin, size_t end, float dt, float maxTime);
+
+    // Net, ground and out-of-bounds handling for a lane flagged by a kernel
+    void ResolveLaneEvents(size_t lane, float prevX, float prevY);
+};
@@ -0,0 +1,109 @@
+// Tennis Ball Physics Simulator - ball machine drills
+
+#include "BallMachine.h"
+
+#include <algorithm>
+#include <cmath>
+
+CourtGrid::CourtGrid(float cellSize)
+    : cellSize(cellSize), cellCount(std::max(1, (int)ceilf(COURT_LENGTH / cellSize))) {
+    cellStart.assign(cellCount + 1, 0);
+}
+
+int CourtGrid::CellOf(float x) const {
+    int cell = (int)(x / cellSize);
+    return std::max(0, std::min(cellCount - 1, cell));
+}
+
+void CourtGrid::Build(const float* x, const int32_t* active, size_t count) {
+    // Count per cell, turn the counts into offsets, then place each lane
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    laneCell.resize(count);
+    size_t bucketed = 0;
+    for (size_t lane = 0; lane < count; lane++) {
+        if (!active[lane]) continue;
+        int cell = CellOf(x[lane]);
+        laneCell[lane] = (uint16_t)cell;
+        cellStart[cell + 1]++;
+        bucketed++;
+    }
+    for (int cell = 0; cell < cellCount; cell++) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+
+    lanes.resize(bucketed);
+    for (size_t lane = 0; lane < count; lane++) {
+        if (!active[lane]) continue;
+        lanes[cellStart[laneCell[lane]]++] = (uint32_t)lane;
+    }
+    // Placing advanced each start to the next cell's; shift them back by one
+    for (int cell = cellCount; cell > 0; cell--) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+    cellStart[0] = 0;
+}
+
+BallMachine::BallMachine()
+    : config(), feedTimer(0.0f), nextLane(0), activeCount(0), launched(0), returned(0) {
+}
+
+void BallMachine::Start(const BallMachineConfig& machineConfig) {
+    config = machineConfig;
+    balls.Resize(config.ballCount);
+    feedTimer = config.feedInterval; // The first ball leaves at once
+    nextLane = 0;
+    activeCount = 0;
+    launched = 0;
+    returned = 0;
+}
+
+void BallMachine::Aim(const ShotParams& center) {
+    config.feed.center = center;
+}
+
+void BallMachine::Feed() {
+    // Round-robin from the last launch: the lane freed longest ago is usually next
+    size_t count = balls.Size();
+    for (size_t probe = 0; probe < count; probe++) {
+        size_t lane = (nextLane + probe) % count;
+        if (balls.active[lane]) continue;
+        ShotParams shot = EnsembleShot(config.feed, launched);
+        balls.LaunchLane(lane, shot, config.feed.seed);
+        nextLane = lane + 1;
+        launched++;
+        activeCount++;
+        return;
+    }
+    // Every lane is in flight; this launch is skipped
+}
+
+void BallMachine::Step(float dt, const RallyReceiver& righty) {
+    if (balls.Size() == 0) return;
+
+    feedTimer += dt;
+    while (feedTimer >= config.feedInterval) {
+        feedTimer -= config.feedInterval;
+        Feed();
+    }
+
+    activeCount = balls.Advance(dt, BALL_MACHINE_MAX_BALL_TIME);
+
+    // Only the balls bucketed within RIGHTY's reach are tested
+    grid.Build(balls.x.data(), balls.active.data(), balls.Size());
+    grid.ForEachInRange(righty.x - righty.reach, righty.x + righty.reach, [&](uint32_t lane) {
+        float& x = balls.x[lane];
+        float y = balls.y[lane];
+        if (fabsf(x - righty.x) > righty.reach || y < 0.0f || y > righty.height) return;
+        ApplyReturnHit(x, balls.vx[lane], balls.vy[lane], balls.spinRPM[lane], righty.hit, righty.x);
+        balls.LaneChanged(lane);
+        returned++;
+    });
+}
+
+void BallMachine::CopyPositions(std::vector<float>& x, std::vector<float>& y) const {
+    for (size_t lane = 0; lane < balls.Size(); lane++) {
+        if (!balls.active[lane]) continue;
+        x.push_back(balls.x[lane]);
+        y.push_back(balls.y[lane]);
+    }
+}
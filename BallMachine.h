@@ -0,0 +1,104 @@
+// Tennis Ball Physics Simulator - ball machine drills
+// Hundreds of balls in flight on one court at once. The balls live in a BallBatch
+// and advance together on its SIMD kernels; a machine at LEFTY's spot feeds a new
+// one at a fixed interval into whichever lane has finished. Contact with RIGHTY is
+// no longer tested per ball: after every step the balls are bucketed into a
+// uniform grid along the court length, and only the cells within RIGHTY's reach are
+// visited. Net contact stays in the kernels, which test the net plane lane by lane.
+
+#pragma once
+
+#include "BallBatch.h"
+#include "ReturnHitPolicy.h"
+#include "ShotEnsemble.h"
+
+#include <cstdint>
+#include <vector>
+
+// Width of a grid cell along the court; RIGHTY's reach spans three to four. A fast
+// ball crosses several cells per step (about five at 30 m/s), which is harmless as
+// the grid is rebuilt after every step.
+const float COURT_GRID_CELL = 0.05f; // meters
+
+// Balls older than this are retired even if they are still rolling
+const float BALL_MACHINE_MAX_BALL_TIME = 20.0f; // seconds
+
+// Indices of balls bucketed by cell over [0, COURT_LENGTH], rebuilt from scratch with
+// a counting sort. Balls off either end go to the end cells.
+class CourtGrid {
+public:
+    explicit CourtGrid(float cellSize = COURT_GRID_CELL);
+
+    // Buckets the lanes whose active entry is set; keeps its arrays, so rebuilding
+    // with at most as many lanes as before does not allocate
+    void Build(const float* x, const int32_t* active, size_t count);
+
+    int CellCount() const { return cellCount; }
+    int CellOf(float x) const;
+
+    // Calls visit(lane) for every lane bucketed in the cells that overlap [minX, maxX]
+    template <class Visit>
+    void ForEachInRange(float minX, float maxX, Visit visit) const {
+        int last = CellOf(maxX);
+        for (uint32_t i = cellStart[CellOf(minX)]; i < cellStart[last + 1]; i++) {
+            visit(lanes[i]);
+        }
+    }
+
+private:
+    float cellSize;
+    int cellCount;
+    std::vector<uint32_t> cellStart; // cellCount + 1 offsets into lanes
+    std::vector<uint32_t> lanes;     // Lane indices, grouped by cell
+    std::vector<uint16_t> laneCell;  // Cell of each bucketed lane, kept between the two passes
+};
+
+// RIGHTY as the drill sees it
+struct RallyReceiver {
+    float x;      // Position on the court
+    float reach;  // Contact distance, ball radius included
+    float height; // Top of the stick
+    ReturnHit hit; // Return played on every ball that reaches RIGHTY
+};
+
+struct BallMachineConfig {
+    size_t ballCount;   // Lanes: the most balls in flight at once
+    float feedInterval; // Seconds between launches
+    EnsembleSpec feed;  // Aimed shot and its jitter; launch i is EnsembleShot(feed, i)
+};
+
+class BallMachine {
+public:
+    BallMachine();
+
+    // Clears the court and starts feeding
+    void Start(const BallMachineConfig& config);
+
+    // Aims the launches still to come; balls in flight are left alone
+    void Aim(const ShotParams& center);
+
+    // One fixed step: launches the balls that have come due, advances every ball and
+    // returns the ones that reached RIGHTY
+    void Step(float dt, const RallyReceiver& righty);
+
+    size_t BallCount() const { return balls.Size(); }
+    size_t ActiveCount() const { return activeCount; }
+    uint64_t Launched() const { return launched; }
+    uint64_t Returned() const { return returned; }
+    const BallBatch& Balls() const { return balls; }
+
+    // Positions of the balls in flight, appended to x and y
+    void CopyPositions(std::vector<float>& x, std::vector<float>& y) const;
+
+private:
+    BallMachineConfig config;
+    BallBatch balls;
+    CourtGrid grid;
+    float feedTimer;
+    size_t nextLane;   // Where the search for a free lane starts
+    size_t activeCount;
+    uint64_t launched;
+    uint64_t returned;
+
+    void Feed();
+};
@@ -0,0 +1,52 @@
+// Tennis Ball Physics Simulator - batched ball drawing
+
+#include "BallSprites.h"
+
+#include <cmath>
+
+namespace {
+    // Polygon sides per ball
+    const int BALL_SIDES = 8;
+}
+
+HRESULT BallSprites::Draw(ID2D1RenderTarget* target, ID2D1Brush* brush, float radius) {
+    if (centers.empty()) return S_OK;
+
+    D2D1_POINT_2F corners[BALL_SIDES];
+    for (int i = 0; i < BALL_SIDES; i++) {
+        float angle = 2.0f * 3.14159265f * i / BALL_SIDES;
+        corners[i] = D2D1::Point2F(radius * cosf(angle), radius * sinf(angle));
+    }
+
+    triangles.clear();
+    for (const D2D1_POINT_2F& center : centers) {
+        for (int i = 0; i < BALL_SIDES; i++) {
+            const D2D1_POINT_2F& a = corners[i];
+            const D2D1_POINT_2F& b = corners[(i + 1) % BALL_SIDES];
+            D2D1_TRIANGLE triangle = {center, D2D1::Point2F(center.x + a.x, center.y + a.y),
+                                      D2D1::Point2F(center.x + b.x, center.y + b.y)};
+            triangles.push_back(triangle);
+        }
+    }
+
+    ID2D1Mesh* mesh = NULL;
+    ID2D1TessellationSink* sink = NULL;
+    HRESULT hr = target->CreateMesh(&mesh);
+    if (SUCCEEDED(hr)) {
+        hr = mesh->Open(&sink);
+    }
+    if (SUCCEEDED(hr)) {
+        sink->AddTriangles(triangles.data(), (UINT32)triangles.size());
+        hr = sink->Close();
+        sink->Release();
+    }
+    if (SUCCEEDED(hr)) {
+        // FillMesh only draws with antialiasing off
+        D2D1_ANTIALIAS_MODE previous = target->GetAntialiasMode();
+        target->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        target->FillMesh(mesh, brush);
+        target->SetAntialiasMode(previous);
+    }
+    if (mesh) mesh->Release();
+    return hr;
+}
@@ -0,0 +1,30 @@
+// Tennis Ball Physics Simulator - batched ball drawing
+// Draws any number of same-colored balls with one FillMesh call. Each ball becomes a
+// small polygon fan of triangles; the triangles of every ball go into one mesh, so
+// a court with hundreds of balls in flight costs one draw instead of one FillEllipse
+// per ball. Meshes are device resources and the balls move every frame, so the mesh
+// is rebuilt on each Draw from a triangle buffer that keeps its capacity.
+
+#pragma once
+
+#include <d2d1.h>
+#include <vector>
+
+class BallSprites {
+public:
+    // Forgets the balls of the previous frame
+    void Clear() { centers.clear(); }
+
+    // Adds a ball centered at the pixel position
+    void Add(float x, float y) { centers.push_back(D2D1::Point2F(x, y)); }
+
+    size_t Count() const { return centers.size(); }
+
+    // Fills every ball added since Clear with brush. Meshes are drawn aliased, so at
+    // the few pixels of a court-view ball the polygon reads as a round ball.
+    HRESULT Draw(ID2D1RenderTarget* target, ID2D1Brush* brush, float radius);
+
+private:
+    std::vector<D2D1_POINT_2F> centers;
+    std::vector<D2D1_TRIANGLE> triangles;
+};
@@ -0,0 +1,665 @@
+// Tennis Ball Physics Simulator - command-line batch runner
+// Console tool for headless build agents and compute nodes (tennis-batch.exe): runs
+// the parameter sweep or Monte Carlo ensemble described by a spec file on every
+// core, streams the per-shot rows to a CSV or Parquet file while it runs (and a
+// sweep's trajectories to a .trj archive), and reports throughput in shots and
+// integration steps per second. The spec is an INI file like settings.ini;
+// batch_example.ini lists every key with its default.
+//
+// Sweeps too large for one machine run as shards: shard i of N simulates a contiguous
+// range of the grid's chunks into a binary result file and checkpoints the rows it
+// has flushed, so a killed shard resumes after its last checkpoint. Each shot's random
+// stream is its grid index, so the shards' rows are exactly those of the whole sweep,
+// whichever node ran them. --merge checks the N shard files and writes one result
+// table. Nodes only need the spec, their shard number and the shard count.
+//
+// Usage: tennis-batch.exe <spec.ini>
+//        tennis-batch.exe <spec.ini> --shard <index> <count>
+//        tennis-batch.exe <spec.ini> --merge <count>
+
+#include "SimulationEngine.h"
+#include "ParameterSweep.h"
+#include "ShotEnsemble.h"
+#include "ResultExport.h"
+#include "TrajectoryArchive.h"
+#include "SettingsFile.h"
+#include "FileMapping.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    enum BatchMode {
+        BATCH_SWEEP,
+        BATCH_ENSEMBLE
+    };
+
+    struct BatchSpec {
+        BatchMode mode;
+        SweepGrid grid;
+        EnsembleSpec ensemble;
+        std::string outputPath;  // Empty: rows are only counted
+        ResultFormat format;
+        std::string archivePath; // Sweep trajectories, empty for none
+        unsigned threads;        // 0 = all cores
+        float timeStep;
+        IntegrationMode integrationMode;
+        IntegratorType integrator;
+        bool exactVacuum;
+        uint64_t seed;
+        bool clockSeed;          // RandomSeed=0: seed taken from the clock
+        double progressSeconds;  // Between progress lines, 0 for none
+        double checkpointSeconds; // Between a shard's checkpoints
+    };
+
+    std::wstring Widen(const std::string& text) {
+        std::wstring wide(text.size() + 1, L'\0');
+        size_t length = mbstowcs(&wide[0], text.c_str(), wide.size());
+        wide.resize(length == (size_t)-1 ? 0 : length);
+        return wide;
+    }
+
+    std::string Lower(std::string text) {
+        for (char& c : text) {
+            if (c >= 'A' && c <= 'Z') c = (char)(c + ('a' - 'A'));
+        }
+        return text;
+    }
+
+    // Entry of table whose key is token, or whose index it is; -1 if none
+    template <class T, size_t N>
+    int FindKey(const T (&table)[N], const std::string& token) {
+        std::string key = Lower(token);
+        for (size_t i = 0; i < N; i++) {
+            if (key == table[i].key) return (int)i;
+        }
+        char* end;
+        long index = strtol(token.c_str(), &end, 10);
+        if (!token.empty() && *end == '\0' && index >= 0 && index < (long)N) return (int)index;
+        return -1;
+    }
+
+    // Comma separated entries of table; every entry when value is null
+    template <class T, size_t N>
+    bool ParseKeyList(const char* value, const T (&table)[N], const char* name, std::vector<int>& indices) {
+        indices.clear();
+        if (!value) {
+            for (size_t i = 0; i < N; i++) indices.push_back((int)i);
+            return true;
+        }
+        std::string list = value;
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            size_t end = std::min(list.find(',', begin), list.size());
+            std::string token = list.substr(begin, end - begin);
+            token.erase(0, token.find_first_not_of(" \t"));
+            token.erase(token.find_last_not_of(" \t") + 1);
+            int index = FindKey(table, token);
+            if (index < 0) {
+                fprintf(stderr, "Unknown %s '%s'\n", name, token.c_str());
+                return false;
+            }
+            indices.push_back(index);
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    std::string GetString(const SettingsFile& file, const char* section, const char* key, const char* defaultValue) {
+        const char* value = file.Find(section, key);
+        return value ? value : defaultValue;
+    }
+
+    bool LoadSpec(const char* path, BatchSpec& spec) {
+        SettingsFile file;
+        if (!file.Load(Widen(path).c_str())) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return false;
+        }
+        LoadEngineTables(file);
+
+        std::string mode = Lower(GetString(file, "Batch", "Mode", "sweep"));
+        if (mode != "sweep" && mode != "ensemble") {
+            fprintf(stderr, "Mode must be sweep or ensemble, not '%s'\n", mode.c_str());
+            return false;
+        }
+        spec.mode = mode == "sweep" ? BATCH_SWEEP : BATCH_ENSEMBLE;
+
+        // Format follows the output's extension unless given
+        spec.outputPath = GetString(file, "Batch", "Output", "");
+        std::string extension = Lower(spec.outputPath.substr(std::min(spec.outputPath.size(), spec.outputPath.find_last_of('.'))));
+        std::string format = Lower(GetString(file, "Batch", "Format",
+                                             extension == ".parquet" ? "parquet" : extension == ".tbr" ? "binary" : "csv"));
+        if (format != "csv" && format != "parquet" && format != "binary") {
+            fprintf(stderr, "Format must be csv, parquet or binary, not '%s'\n", format.c_str());
+            return false;
+        }
+        spec.format = format == "parquet" ? RESULT_FORMAT_PARQUET : format == "binary" ? RESULT_FORMAT_BINARY : RESULT_FORMAT_CSV;
+        spec.archivePath = GetString(file, "Batch", "Archive", "");
+        if (!spec.archivePath.empty() && spec.mode != BATCH_SWEEP) {
+            fprintf(stderr, "Archive is only written by sweeps\n");
+            return false;
+        }
+
+        // Stepping as in settings.ini's [Physics]
+        spec.threads = file.GetInt("Batch", "Threads", 0);
+        spec.timeStep = std::max(100, (int)file.GetInt("Batch", "PhysicsStepMicros", 8300)) / 1000000.0f;
+        spec.integrationMode = file.GetInt("Batch", "EventDriven", 0) != 0 ? INTEGRATION_EVENT_DRIVEN : INTEGRATION_FIXED_STEP;
+        spec.integrator = (IntegratorType)std::min(2u, file.GetInt("Batch", "Integrator", 0));
+        spec.exactVacuum = file.GetInt("Batch", "ExactVacuum", 0) != 0;
+        spec.seed = file.GetInt("Batch", "RandomSeed", 1);
+        spec.clockSeed = spec.seed == 0;
+        if (spec.clockSeed) {
+            spec.seed = (uint64_t)time(NULL);
+        }
+        spec.progressSeconds = (double)file.GetInt("Batch", "ProgressSeconds", 5);
+        spec.checkpointSeconds = (double)std::max(1, (int)file.GetInt("Batch", "CheckpointSeconds", 10));
+
+        SweepGrid& grid = spec.grid;
+        grid = DefaultSweepGrid();
+        grid.force.minValue = file.GetFloat("Sweep", "MinForce", grid.force.minValue);
+        grid.force.maxValue = file.GetFloat("Sweep", "MaxForce", grid.force.maxValue);
+        grid.force.steps = std::max(1, (int)file.GetInt("Sweep", "ForceSteps", grid.force.steps));
+        grid.angle.minValue = file.GetFloat("Sweep", "MinAngle", grid.angle.minValue);
+        grid.angle.maxValue = file.GetFloat("Sweep", "MaxAngle", grid.angle.maxValue);
+        grid.angle.steps = std::max(1, (int)file.GetInt("Sweep", "AngleSteps", grid.angle.steps));
+        grid.spin.minValue = file.GetFloat("Sweep", "MinSpin", grid.spin.minValue);
+        grid.spin.maxValue = file.GetFloat("Sweep", "MaxSpin", grid.spin.maxValue);
+        grid.spin.steps = std::max(1, (int)file.GetInt("Sweep", "SpinSteps", grid.spin.steps));
+        std::vector<int> airModeIndices;
+        if (!ParseKeyList(file.Find("Sweep", "Surfaces"), courts, "surface", grid.surfaces) ||
+            !ParseKeyList(file.Find("Sweep", "AirModes"), airModes, "air mode", airModeIndices)) {
+            return false;
+        }
+        grid.airModes.clear();
+        for (int index : airModeIndices) grid.airModes.push_back((AirResistanceMode)index);
+
+        // The ensemble's mean shot: a launch pattern's, then any of Force, Angle and Spin
+        EnsembleSpec& ensemble = spec.ensemble;
+        ShotParams& center = ensemble.center;
+        center = {270.0f, 39.0f, 120.0f, US_OPEN_HARD, AIR_SEA_LEVEL, 0};
+        std::string pattern = GetString(file, "Ensemble", "Pattern", "");
+        if (!pattern.empty()) {
+            int index = FindKey(launchPatterns, pattern);
+            if (index <= PATTERN_RANDOM) {
+                fprintf(stderr, "Unknown launch pattern '%s'\n", pattern.c_str());
+                return false;
+            }
+            center.force = launchPatterns[index].force;
+            center.angle = launchPatterns[index].angle;
+            center.spin = launchPatterns[index].spin;
+        }
+        center.force = file.GetFloat("Ensemble", "Force", center.force);
+        center.angle = file.GetFloat("Ensemble", "Angle", center.angle);
+        center.spin = file.GetFloat("Ensemble", "Spin", center.spin);
+        center.surfaceIndex = FindKey(courts, GetString(file, "Ensemble", "Surface", "hard"));
+        center.airMode = (AirResistanceMode)FindKey(airModes, GetString(file, "Ensemble", "AirMode", "sea_level"));
+        if (center.surfaceIndex < 0 || center.airMode < 0) {
+            fprintf(stderr, "Unknown ensemble Surface or AirMode\n");
+            return false;
+        }
+        ensemble.shotCount = std::max(1u, file.GetInt("Ensemble", "Shots", 50000));
+        ensemble.forceSigma = file.GetFloat("Ensemble", "ForceSigma", 15.0f);
+        ensemble.angleSigma = file.GetFloat("Ensemble", "AngleSigma", 2.0f);
+        ensemble.spinSigma = file.GetFloat("Ensemble", "SpinSigma", 150.0f);
+        ensemble.seed = spec.seed;
+        return true;
+    }
+
+    double Seconds(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // FNV-1a
+    void HashBytes(uint64_t& hash, const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    // Everything a sweep's rows depend on: the grid, the tables of the surfaces and air
+    // modes it uses, the stepping and the seed. Shards of one dataset share it.
+    uint64_t SpecFingerprint(const BatchSpec& spec) {
+        uint64_t hash = 14695981039346656037ull;
+        uint64_t shotCount = spec.grid.ShotCount(), chunkShots = SWEEP_CHUNK_SHOTS;
+        HashBytes(hash, &shotCount, sizeof(shotCount));
+        HashBytes(hash, &chunkShots, sizeof(chunkShots));
+        HashBytes(hash, &spec.grid.force, sizeof(SweepAxis));
+        HashBytes(hash, &spec.grid.angle, sizeof(SweepAxis));
+        HashBytes(hash, &spec.grid.spin, sizeof(SweepAxis));
+        for (int surface : spec.grid.surfaces) {
+            HashBytes(hash, &surface, sizeof(surface));
+            HashBytes(hash, &courts[surface].coefficientOfRestitution, sizeof(float));
+            HashBytes(hash, &courts[surface].friction, sizeof(float));
+        }
+        for (AirResistanceMode mode : spec.grid.airModes) {
+            HashBytes(hash, &mode, sizeof(mode));
+            HashBytes(hash, &airModes[mode].coefficient, sizeof(float));
+        }
+        HashBytes(hash, &spec.timeStep, sizeof(spec.timeStep));
+        HashBytes(hash, &spec.integrationMode, sizeof(spec.integrationMode));
+        HashBytes(hash, &spec.integrator, sizeof(spec.integrator));
+        // Only when set, so shards written before the option keep their fingerprint
+        if (spec.exactVacuum) HashBytes(hash, &spec.exactVacuum, sizeof(spec.exactVacuum));
+        HashBytes(hash, &spec.seed, sizeof(spec.seed));
+        return hash;
+    }
+
+    // Output with its extension replaced by a shard's suffix, e.g. results.shard3-of-16.tbr
+    std::string ShardPath(const BatchSpec& spec, unsigned shard, unsigned shardCount, const char* extension) {
+        const std::string& output = spec.outputPath;
+        size_t dot = output.find_last_of('.');
+        size_t slash = output.find_last_of("\\/");
+        std::string base = (dot == std::string::npos || (slash != std::string::npos && dot < slash)) ? output : output.substr(0, dot);
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".shard%u-of-%u%s", shard, shardCount, extension);
+        return base + suffix;
+    }
+
+    size_t ChunkShots(const SweepGrid& grid, size_t chunk) {
+        return std::min(SWEEP_CHUNK_SHOTS, grid.ShotCount() - chunk * SWEEP_CHUNK_SHOTS);
+    }
+
+    // A shard's progress: the first rows rows of its binary file are whole chunks
+    struct ShardCheckpoint {
+        uint64_t fingerprint;
+        unsigned shard;
+        unsigned shardCount;
+        uint64_t rows;
+        bool complete;
+    };
+
+    bool ReadCheckpoint(const std::string& path, ShardCheckpoint& checkpoint) {
+        SettingsFile file;
+        if (!file.Load(Widen(path).c_str())) return false;
+        const char* fingerprint = file.Find("Checkpoint", "Fingerprint");
+        const char* rows = file.Find("Checkpoint", "Rows");
+        if (!fingerprint || !rows) return false;
+        checkpoint.fingerprint = strtoull(fingerprint, nullptr, 16);
+        checkpoint.shard = file.GetInt("Checkpoint", "Shard", -1);
+        checkpoint.shardCount = file.GetInt("Checkpoint", "ShardCount", 0);
+        checkpoint.rows = strtoull(rows, nullptr, 10);
+        checkpoint.complete = file.GetInt("Checkpoint", "Complete", 0) != 0;
+        return true;
+    }
+
+    // Written beside the checkpoint and renamed over it, so a kill leaves the old one whole
+    bool WriteCheckpoint(const std::string& path, const ShardCheckpoint& checkpoint) {
+        std::string temporary = path + ".tmp";
+        FILE* out = CreateBinaryFile(Widen(temporary).c_str());
+        if (!out) return false;
+        bool ok = fprintf(out, "; tennis-batch.exe shard checkpoint: the first Rows rows of the shard's .tbr file are done\n"
+                               "[Checkpoint]\nFingerprint=%016llx\nShard=%u\nShardCount=%u\nRows=%llu\nComplete=%d\n",
+                          (unsigned long long)checkpoint.fingerprint, checkpoint.shard, checkpoint.shardCount,
+                          (unsigned long long)checkpoint.rows, checkpoint.complete ? 1 : 0) > 0;
+        ok = fclose(out) == 0 && ok;
+        return ok && ReplaceFileWith(Widen(path).c_str(), Widen(temporary).c_str());
+    }
+
+    // A shard's binary rows, checkpointed every interval seconds once the file is
+    // flushed. The exporter hands over one chunk per batch, so the checkpointed rows
+    // always end on a chunk boundary. Nothing is checkpointed after a failed write.
+    class CheckpointSink : public ResultSink {
+    public:
+        CheckpointSink(FILE* out, bool append, const std::string& path, const ShardCheckpoint& checkpoint, double interval)
+            : out(out), rows(out, checkpoint.fingerprint, append), path(path), checkpoint(checkpoint),
+              interval(interval), pendingRows(0), lastCommit(std::chrono::steady_clock::now()), failed(false) {}
+
+        bool WriteRows(const ShotRow* batch, size_t count) override {
+            if (!rows.WriteRows(batch, count)) failed = true;
+            pendingRows += count;
+            if (!failed && Seconds(lastCommit) >= interval) Commit(false);
+            return !failed;
+        }
+
+        bool Finish() override {
+            if (!rows.Finish()) failed = true;
+            if (!failed) Commit(true);
+            return !failed;
+        }
+
+        bool Commit(bool complete) {
+            if (failed || fflush(out) != 0) {
+                failed = true;
+                return false;
+            }
+            checkpoint.rows += pendingRows;
+            checkpoint.complete = complete;
+            pendingRows = 0;
+            lastCommit = std::chrono::steady_clock::now();
+            if (!WriteCheckpoint(path, checkpoint)) failed = true;
+            return !failed;
+        }
+
+    private:
+        FILE* out;
+        BinaryResultSink rows;
+        std::string path;
+        ShardCheckpoint checkpoint;
+        double interval;
+        uint64_t pendingRows; // Written since the last checkpoint
+        std::chrono::steady_clock::time_point lastCommit;
+        bool failed;
+    };
+
+    // Opens shard's binary file, resuming after its checkpoint when there is one for
+    // this spec, and lists the chunks still to run. 0 to go on, else the exit code.
+    int PrepareShard(const BatchSpec& spec, unsigned shard, unsigned shardCount, FILE*& out,
+                     std::unique_ptr<CheckpointSink>& sink, std::vector<size_t>& chunks) {
+        std::string rowsPath = ShardPath(spec, shard, shardCount, ".tbr");
+        std::string checkpointPath = ShardPath(spec, shard, shardCount, ".ckpt");
+        size_t chunkBegin, chunkEnd;
+        SweepShardChunks(spec.grid, shard, shardCount, chunkBegin, chunkEnd);
+        std::vector<size_t> chunkRows(chunkEnd - chunkBegin, 0);
+
+        ShardCheckpoint checkpoint = {SpecFingerprint(spec), shard, shardCount, 0, false};
+        ShardCheckpoint saved;
+        bool resume = ReadCheckpoint(checkpointPath, saved);
+        if (resume) {
+            if (saved.fingerprint != checkpoint.fingerprint || saved.shard != shard || saved.shardCount != shardCount) {
+                fprintf(stderr, "%s belongs to another spec or shard; delete it to start the shard over\n", checkpointPath.c_str());
+                return 1;
+            }
+            if (saved.complete) {
+                printf("Shard %u of %u is already complete: %s\n", shard, shardCount, rowsPath.c_str());
+                return -1;
+            }
+
+            // Rows past the checkpoint may be torn or half a chunk; they are cut off
+            BinaryResultReader reader;
+            if (!reader.Open(Widen(rowsPath).c_str()) || reader.DatasetId() != saved.fingerprint ||
+                reader.RowCount() < saved.rows) {
+                fprintf(stderr, "%s does not hold the %llu rows its checkpoint records\n", rowsPath.c_str(),
+                        (unsigned long long)saved.rows);
+                return 1;
+            }
+            for (uint64_t i = 0; i < saved.rows; i++) {
+                size_t chunk = (size_t)(reader.Row(i).shotId / SWEEP_CHUNK_SHOTS);
+                if (chunk < chunkBegin || chunk >= chunkEnd) {
+                    fprintf(stderr, "%s holds shots of another shard\n", rowsPath.c_str());
+                    return 1;
+                }
+                chunkRows[chunk - chunkBegin]++;
+            }
+            reader.Close();
+            checkpoint.rows = saved.rows;
+            out = ReopenBinaryFile(Widen(rowsPath).c_str(),
+                                   BINARY_RESULT_HEADER_BYTES + saved.rows * sizeof(BinaryResultRecord));
+        } else {
+            out = CreateBinaryFile(Widen(rowsPath).c_str());
+        }
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", rowsPath.c_str());
+            return 1;
+        }
+
+        for (size_t chunk = chunkBegin; chunk < chunkEnd; chunk++) {
+            size_t done = chunkRows[chunk - chunkBegin];
+            if (done == ChunkShots(spec.grid, chunk)) continue;
+            if (done != 0) {
+                fprintf(stderr, "%s ends inside a chunk; delete it to start the shard over\n", checkpointPath.c_str());
+                fclose(out);
+                return 1;
+            }
+            chunks.push_back(chunk);
+        }
+
+        sink = std::make_unique<CheckpointSink>(out, resume, checkpointPath, checkpoint, spec.checkpointSeconds);
+        if (!sink->Commit(false)) {
+            fprintf(stderr, "Cannot write %s\n", checkpointPath.c_str());
+            return 1;
+        }
+        printf("Shard %u of %u: shots %zu to %zu, %s", shard, shardCount, chunkBegin * SWEEP_CHUNK_SHOTS,
+               std::min(chunkEnd * SWEEP_CHUNK_SHOTS, spec.grid.ShotCount()), rowsPath.c_str());
+        if (resume) printf(", resuming after %llu rows", (unsigned long long)checkpoint.rows);
+        printf("\n");
+        return 0;
+    }
+
+    // Checks that shardCount complete shards of this spec are present, each with every
+    // shot of its range once, then writes their rows, shard by shard, to the output.
+    // The shards stay mapped in between, so the rows written are the rows checked.
+    int MergeShards(const BatchSpec& spec, unsigned shardCount) {
+        uint64_t fingerprint = SpecFingerprint(spec);
+        std::vector<std::unique_ptr<BinaryResultReader>> readers(shardCount);
+        for (unsigned shard = 0; shard < shardCount; shard++) {
+            readers[shard] = std::make_unique<BinaryResultReader>();
+            BinaryResultReader& reader = *readers[shard];
+            std::string path = ShardPath(spec, shard, shardCount, ".tbr");
+            size_t chunkBegin, chunkEnd;
+            SweepShardChunks(spec.grid, shard, shardCount, chunkBegin, chunkEnd);
+            uint64_t first = chunkBegin * SWEEP_CHUNK_SHOTS;
+            uint64_t last = std::min(chunkEnd * SWEEP_CHUNK_SHOTS, spec.grid.ShotCount());
+            if (!reader.Open(Widen(path).c_str())) {
+                fprintf(stderr, "Cannot read %s\n", path.c_str());
+                return 1;
+            }
+            if (reader.DatasetId() != fingerprint) {
+                fprintf(stderr, "%s was written for another spec\n", path.c_str());
+                return 1;
+            }
+            std::vector<bool> seen((size_t)(last - first), false);
+            bool whole = reader.RowCount() == last - first;
+            for (uint64_t i = 0; whole && i < reader.RowCount(); i++) {
+                uint64_t id = reader.Row(i).shotId;
+                whole = id >= first && id < last && !seen[(size_t)(id - first)];
+                if (whole) seen[(size_t)(id - first)] = true;
+            }
+            if (!whole) {
+                fprintf(stderr, "%s is not a complete shard %u of %u (%llu of %llu rows)\n", path.c_str(), shard,
+                        shardCount, (unsigned long long)reader.RowCount(), (unsigned long long)(last - first));
+                return 1;
+            }
+        }
+
+        FILE* out = CreateBinaryFile(Widen(spec.outputPath).c_str());
+        if (!out) {
+            fprintf(stderr, "Cannot create %s\n", spec.outputPath.c_str());
+            return 1;
+        }
+        std::unique_ptr<ResultSink> sink = CreateResultSink(spec.format, out);
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        uint64_t rowsWritten = 0;
+        std::vector<ShotRow> rows;
+        for (unsigned shard = 0; ok && shard < shardCount; shard++) {
+            const BinaryResultReader& reader = *readers[shard];
+            for (uint64_t i = 0; ok && i < reader.RowCount();) {
+                rows.clear();
+                for (; i < reader.RowCount() && rows.size() < PARQUET_ROW_GROUP_ROWS; i++) rows.push_back(reader.Row(i));
+                ok = sink->WriteRows(rows.data(), rows.size());
+                rowsWritten += rows.size();
+            }
+        }
+        readers.clear();
+        ok = sink->Finish() && ok;
+        ok = fclose(out) == 0 && ok;
+        if (!ok) {
+            fprintf(stderr, "Writing %s failed\n", spec.outputPath.c_str());
+            return 1;
+        }
+        printf("Merged %u shards, %llu rows, into %s in %.2f s\n", shardCount, (unsigned long long)rowsWritten,
+               spec.outputPath.c_str(), Seconds(start));
+        return 0;
+    }
+
+    bool ParseCount(const char* text, unsigned& value) {
+        char* end;
+        unsigned long parsed = strtoul(text, &end, 10);
+        value = (unsigned)parsed;
+        return *text && *end == '\0' && parsed <= 0xFFFFFFFFul;
+    }
+
+    void PrintUsage() {
+        fprintf(stderr, "Usage: tennis-batch.exe <spec.ini>\n"
+                        "       tennis-batch.exe <spec.ini> --shard <index> <count>\n"
+                        "       tennis-batch.exe <spec.ini> --merge <count>\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    // Shards are numbered from 0; a shard count of 0 is an unsharded run
+    unsigned shard = 0, shardCount = 0;
+    bool merge = false;
+    if (argc == 5 && strcmp(argv[2], "--shard") == 0) {
+        if (!ParseCount(argv[3], shard) || !ParseCount(argv[4], shardCount) || shard >= shardCount) {
+            PrintUsage();
+            return 2;
+        }
+    } else if (argc == 4 && strcmp(argv[2], "--merge") == 0) {
+        merge = true;
+        if (!ParseCount(argv[3], shardCount) || shardCount == 0) {
+            PrintUsage();
+            return 2;
+        }
+    } else if (argc != 2) {
+        PrintUsage();
+        return 2;
+    }
+    BatchSpec spec;
+    if (!LoadSpec(argv[1], spec)) return 2;
+    if (shardCount) {
+        if (spec.mode != BATCH_SWEEP || spec.outputPath.empty() || !spec.archivePath.empty()) {
+            fprintf(stderr, "Shards are sweeps with an Output and no Archive\n");
+            return 2;
+        }
+        if (spec.clockSeed) {
+            fprintf(stderr, "Shards need a fixed RandomSeed, the same on every node\n");
+            return 2;
+        }
+    }
+    if (merge) return MergeShards(spec, shardCount);
+
+    SimulationEngine engine(spec.timeStep);
+    engine.SetIntegrationMode(spec.integrationMode);
+    engine.SetIntegrator(spec.integrator);
+    engine.SetExactVacuum(spec.exactVacuum);
+    engine.SetRandomSeed(spec.seed);
+    ThreadPool pool(spec.threads);
+
+    FILE* out = nullptr;
+    std::unique_ptr<ResultSink> sink;
+    std::unique_ptr<ResultExporter> exporter;
+    std::vector<size_t> shardChunks;
+    if (shardCount) {
+        std::unique_ptr<CheckpointSink> checkpointed;
+        int code = PrepareShard(spec, shard, shardCount, out, checkpointed, shardChunks);
+        if (code) return code < 0 ? 0 : code;
+        sink = std::move(checkpointed);
+    } else if (!spec.outputPath.empty()) {
+        out = CreateBinaryFile(Widen(spec.outputPath).c_str());
+        if (!out) {
+            fprintf(stderr, "Cannot create %s\n", spec.outputPath.c_str());
+            return 1;
+        }
+        sink = CreateResultSink(spec.format, out);
+    }
+    if (sink) {
+        exporter = std::make_unique<ResultExporter>(*sink);
+    }
+    TrajectoryWriter archive;
+    if (!spec.archivePath.empty() && !archive.Open(Widen(spec.archivePath).c_str())) {
+        fprintf(stderr, "Cannot create %s\n", spec.archivePath.c_str());
+        return 1;
+    }
+
+    bool sweep = spec.mode == BATCH_SWEEP;
+    size_t shotCount = sweep ? spec.grid.ShotCount() : spec.ensemble.shotCount;
+    if (shardCount) {
+        shotCount = 0;
+        for (size_t chunk : shardChunks) shotCount += ChunkShots(spec.grid, chunk);
+    }
+    printf("%s: %zu shots on %u threads, %s %s, step %.0f us\n", sweep ? "Sweep" : "Ensemble", shotCount,
+           pool.ThreadCount(), spec.integrationMode == INTEGRATION_EVENT_DRIVEN ? "event-driven" : "fixed-step",
+           spec.integrator == INTEGRATOR_RK45 ? "RK45" : spec.integrator == INTEGRATOR_RK4 ? "RK4" : "Euler",
+           spec.timeStep * 1e6);
+
+    // The run has the pool; this thread only reports progress
+    std::atomic<size_t> sweepShotsDone(0);
+    std::atomic<uint64_t> steps(0);
+    std::atomic<bool> finished(false);
+    LandingHistogram histogram;
+    auto start = std::chrono::steady_clock::now();
+    std::thread run([&]() {
+        if (sweep) {
+            SweepOutputs outputs;
+            outputs.archive = archive.IsOpen() ? &archive : nullptr;
+            outputs.results = exporter.get();
+            outputs.steps = &steps;
+            outputs.keepResults = false;
+            if (shardCount) {
+                RunSweepChunks(spec.grid, engine, pool, shardChunks, &sweepShotsDone, nullptr, outputs);
+            } else {
+                RunParameterSweep(spec.grid, engine, pool, &sweepShotsDone, nullptr, outputs);
+            }
+        } else {
+            EnsembleOutputs outputs;
+            outputs.results = exporter.get();
+            outputs.steps = &steps;
+            RunEnsemble(spec.ensemble, engine, pool, histogram, nullptr, outputs);
+        }
+        finished = true;
+    });
+
+    double nextReport = spec.progressSeconds;
+    while (!finished) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        double elapsed = Seconds(start);
+        if (spec.progressSeconds > 0.0 && elapsed >= nextReport && !finished) {
+            size_t done = sweep ? sweepShotsDone.load() : (size_t)histogram.Shots();
+            printf("  %7.1f s  %zu / %zu shots (%.1f%%)  %.0f shots/s\n", elapsed, done, shotCount,
+                   shotCount ? 100.0 * done / shotCount : 100.0, done / elapsed); // An empty shard is done
+            fflush(stdout);
+            nextReport += spec.progressSeconds;
+        }
+    }
+    run.join();
+    double simulated = Seconds(start);
+
+    // Writers drain their queues before the totals count as done
+    bool ok = true;
+    uint64_t rows = 0;
+    if (exporter) {
+        ok = exporter->Finish();
+        rows = exporter->RowsWritten();
+        ok = fclose(out) == 0 && ok;
+    }
+    if (archive.IsOpen()) {
+        ok = archive.Close() && ok;
+    }
+    double total = Seconds(start);
+
+    uint64_t totalSteps = steps;
+    double perShot = shotCount ? (double)totalSteps / shotCount : 0.0;
+    printf("Simulated %zu shots in %.2f s: %.0f shots/s, %.3g steps/s (%.1f steps per shot)\n", shotCount,
+           simulated, shotCount / simulated, totalSteps / simulated, perShot);
+    if (!sweep) {
+        uint64_t landed = 0;
+        for (int bin = 0; bin < histogram.BinCount(); bin++) landed += histogram.Count(bin);
+        printf("Landed in court: %.1f%%, net hits: %.1f%%, long: %.1f%%\n", 100.0 * landed / shotCount,
+               100.0 * histogram.NetHits() / shotCount, 100.0 * histogram.LongShots() / shotCount);
+    }
+    if (exporter) {
+        printf("Wrote %llu rows to %s (%.2f s including the writer's drain)\n", (unsigned long long)rows,
+               shardCount ? ShardPath(spec, shard, shardCount, ".tbr").c_str() : spec.outputPath.c_str(), total);
+    }
+    if (!spec.archivePath.empty()) {
+        printf("Archived trajectories to %s\n", spec.archivePath.c_str());
+    }
+    if (!ok) {
+        fprintf(stderr, "Writing the results failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,623 @@
+// Tennis Ball Physics Simulator - micro-benchmark suite
+// Times the hot paths of the simulator: single-ball updates, BallBatch kernels,
+// full shots to rest for every launch pattern preset and court, and Direct2D frame
+// cost against trajectory length on an offscreen WIC bitmap. Output follows the
+// Google Benchmark console and JSON formats so results can be compared between releases.
+// Every operator new in the process is counted, and each run reports the allocations
+// its measured loop made per item, so steady-state paths can be held at zero.
+//
+// Usage: Benchmark.exe [--benchmark_filter=<regex>] [--benchmark_format=console|json]
+//                      [--benchmark_out=<file>] [--benchmark_min_time=<seconds>]
+
+#ifndef UNICODE
+#define UNICODE
+#endif
+
+#include <windows.h>
+#include <d2d1.h>
+#include <wincodec.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "SimulationEngine.h"
+#include "BallBatch.h"
+#include "TraceRenderer.h"
+
+#pragma comment(lib, "d2d1")
+#pragma comment(lib, "windowscodecs")
+#pragma comment(lib, "ole32")
+
+namespace {
+    const double DEFAULT_MIN_TIME = 0.5;    // Seconds each benchmark runs for after calibration
+    const long long MAX_ITERATIONS = 1000000000LL;
+    const size_t BATCH_SHOTS = 4096;        // Shots per BallBatch run, as SimulationEngine::RunBatch chunks them
+    const UINT FRAME_WIDTH = 640;           // Offscreen target matches the application window
+    const UINT FRAME_HEIGHT = 480;
+    const size_t TRACE_LENGTHS[] = {256, 1024, 4096, DEFAULT_TRAJECTORY_CAPACITY};
+
+    std::atomic<long long> allocationCount(0);
+
+    long long AllocationCount() {
+        return allocationCount.load(std::memory_order_relaxed);
+    }
+
+    // Passed to each benchmark body, which runs its measured work iterations times
+    struct BenchmarkState {
+        long long iterations;
+        long long itemsProcessed;   // Set by the body; reported as items_per_second when non-zero
+        long long loopAllocations;  // AllocationCount() when the measured loop started
+    };
+
+    // Called by bodies between their setup and the measured loop, so only the loop's allocations count
+    void StartMeasuredLoop(BenchmarkState& state) {
+        state.loopAllocations = AllocationCount();
+    }
+
+    struct Benchmark {
+        std::string name;
+        std::function<void(BenchmarkState&)> body;
+    };
+
+    struct BenchmarkRun {
+        std::string name;
+        long long iterations;
+        double realTime; // Nanoseconds per iteration
+        double cpuTime;
+        double itemsPerSecond;
+        double allocationsPerItem; // Per iteration when the body sets no item count
+    };
+
+    std::vector<Benchmark>& Registry() {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    void Register(const std::string& name, std::function<void(BenchmarkState&)> body) {
+        Registry().push_back({name, std::move(body)});
+    }
+
+    // Benchmark names are ASCII identifiers: spaces and line breaks from the display names are dropped
+    std::string NameToken(const wchar_t* name) {
+        std::string token;
+        for (const wchar_t* c = name; *c; c++) {
+            if (*c == L'\n') break;
+            if (*c != L' ' && *c < 128) token += (char)*c;
+        }
+        return token;
+    }
+
+    double ThreadCpuSeconds() {
+        FILETIME creation, exit, kernel, user;
+        GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        return (k.QuadPart + u.QuadPart) * 1e-7;
+    }
+
+    // Grows the iteration count until one run lasts minTime, then reports that run
+    BenchmarkRun RunBenchmark(const Benchmark& benchmark, double minTime) {
+        long long iterations = 1;
+        for (;;) {
+            BenchmarkState state = {iterations, 0, AllocationCount()};
+            double cpuStart = ThreadCpuSeconds();
+            auto start = std::chrono::steady_clock::now();
+            benchmark.body(state);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double cpuSeconds = ThreadCpuSeconds() - cpuStart;
+            long long allocations = AllocationCount() - state.loopAllocations;
+
+            if (seconds >= minTime || iterations >= MAX_ITERATIONS) {
+                BenchmarkRun run;
+                run.name = benchmark.name;
+                run.iterations = iterations;
+                run.realTime = seconds * 1e9 / iterations;
+                run.cpuTime = cpuSeconds * 1e9 / iterations;
+                run.itemsPerSecond = state.itemsProcessed > 0 ? state.itemsProcessed / seconds : 0.0;
+                run.allocationsPerItem = (double)allocations / (state.itemsProcessed > 0 ? state.itemsProcessed
+                                                                                          : iterations);
+                return run;
+            }
+
+            // Aim 40% past minTime, growing at most 10x per attempt like Google Benchmark
+            double multiplier = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+            if (multiplier > 10.0) multiplier = 10.0;
+            long long next = (long long)(iterations * multiplier);
+            iterations = next > iterations ? next : iterations + 1;
+            if (iterations > MAX_ITERATIONS) iterations = MAX_ITERATIONS;
+        }
+    }
+
+    // Physics benchmarks
+
+    ShotParams PatternShot(int pattern, int surfaceIndex) {
+        const LaunchPatternData& data = launchPatterns[pattern];
+        return {data.force, data.angle, data.spin, surfaceIndex, AIR_SEA_LEVEL};
+    }
+
+    // One TennisBall stepped at DT with trajectory recording on, as the application runs it
+    void RegisterSingleBallUpdate(IntegratorType type) {
+        std::unique_ptr<Integrator> prototype = CreateIntegrator(type);
+        Register("BM_TennisBallUpdate/" + NameToken(prototype->Name()), [type](BenchmarkState& state) {
+            std::unique_ptr<Integrator> integrator = CreateIntegrator(type);
+            TennisBall ball(&courts[US_OPEN_HARD]);
+            ball.setIntegrator(type == INTEGRATOR_EULER ? nullptr : integrator.get());
+            ball.setAirResistance(airModes[AIR_SEA_LEVEL].coefficient);
+            const LaunchPatternData& pattern = launchPatterns[PATTERN_NADAL_TOPSPIN];
+            ball.resetForHorizontalShot(pattern.force, pattern.angle, pattern.spin);
+
+            StartMeasuredLoop(state);
+            for (long long i = 0; i < state.iterations; i++) {
+                if (!ball.isActive) ball.resetForHorizontalShot(pattern.force, pattern.angle, pattern.spin);
+                ball.update(DT);
+            }
+            state.itemsProcessed = state.iterations;
+        });
+    }
+
+    // BATCH_SHOTS shots cycling through the presets and courts; the vacuum variant
+    // flies them without spin
+    std::vector<ShotParams> BatchShots(bool vacuum) {
+        std::vector<ShotParams> shots(BATCH_SHOTS);
+        for (size_t i = 0; i < BATCH_SHOTS; i++) {
+            shots[i] = PatternShot(1 + (int)(i % 7), (int)(i / 7 % 4));
+            shots[i].randomStream = i;
+            if (vacuum) {
+                shots[i].airMode = AIR_VACUUM;
+                shots[i].spin = 0.0f;
+            }
+        }
+        return shots;
+    }
+
+    // BatchShots run to rest on one instruction set; vacuum ones run on the gravity-only kernels
+    void RegisterBatchRunToRest(SimdLevel level, bool vacuum) {
+        Register("BM_BallBatchRunToRest/" + NameToken(SimdLevelName(level)) + "/" + std::to_string(BATCH_SHOTS) +
+                     (vacuum ? "/Vacuum" : ""),
+                 [level, vacuum](BenchmarkState& state) {
+            std::vector<ShotParams> shots = BatchShots(vacuum);
+            BallBatch batch;
+            batch.SetSimdLevel(level);
+            batch.LoadShots(shots.data(), shots.size());
+            StartMeasuredLoop(state);
+            for (long long i = 0; i < state.iterations; i++) {
+                batch.LoadShots(shots.data(), shots.size());
+                batch.RunToRest(DT, 60.0f);
+            }
+            state.itemsProcessed = state.iterations * (long long)BATCH_SHOTS;
+        });
+    }
+
+    // BatchShots through SimulationEngine::RunBatch, as sweeps and ensembles run them
+    void RegisterEngineRunBatch(IntegrationMode mode, IntegratorType type) {
+        std::string stepper = mode == INTEGRATION_EVENT_DRIVEN ? "EventDriven" : NameToken(CreateIntegrator(type)->Name());
+        Register("BM_EngineRunBatch/" + stepper + "/" + std::to_string(BATCH_SHOTS), [mode, type](BenchmarkState& state) {
+            std::vector<ShotParams> shots = BatchShots(false);
+            std::vector<ShotResult> results(shots.size());
+            SimulationEngine engine;
+            engine.SetIntegrationMode(mode);
+            engine.SetIntegrator(type);
+            // The first run sizes the engine's per-thread buffers
+            engine.RunBatch(shots.data(), shots.size(), results.data());
+            StartMeasuredLoop(state);
+            for (long long i = 0; i < state.iterations; i++) {
+                engine.RunBatch(shots.data(), shots.size(), results.data());
+            }
+            state.itemsProcessed = state.iterations * (long long)BATCH_SHOTS;
+        });
+    }
+
+    void RegisterShotToRest() {
+        SimulationEngine engine;
+        // PATTERN_RANDOM (index 0) has no fixed launch values
+        for (int p = 1; p < 8; p++) {
+            for (int c = 0; c < 4; c++) {
+                ShotParams shot = PatternShot(p, c);
+                Register("BM_ShotToRest/" + NameToken(launchPatterns[p].name) + "/" + courts[c].key,
+                         [engine, shot](BenchmarkState& state) {
+                    int bounces = 0;
+                    StartMeasuredLoop(state);
+                    for (long long i = 0; i < state.iterations; i++) {
+                        bounces += engine.SimulateShot(shot).bounceCount;
+                    }
+                    // Keeps the optimizer from discarding the shots
+                    if (bounces < 0) printf("%d\n", bounces);
+                    state.itemsProcessed = state.iterations;
+                });
+            }
+        }
+    }
+
+    // Render benchmarks
+
+    // Offscreen software target with the application's court layout
+    struct OffscreenFrame {
+        ID2D1Factory* factory = nullptr;
+        IWICImagingFactory* wicFactory = nullptr;
+        IWICBitmap* bitmap = nullptr;
+        ID2D1RenderTarget* target = nullptr;
+        ID2D1SolidColorBrush* brush = nullptr;
+
+        bool Create() {
+            if (FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &factory))) return false;
+            if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                        IID_PPV_ARGS(&wicFactory)))) return false;
+            if (FAILED(wicFactory->CreateBitmap(FRAME_WIDTH, FRAME_HEIGHT, GUID_WICPixelFormat32bppPBGRA,
+                                                WICBitmapCacheOnLoad, &bitmap))) return false;
+            D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(
+                D2D1_RENDER_TARGET_TYPE_DEFAULT,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+            if (FAILED(factory->CreateWicBitmapRenderTarget(bitmap, props, &target))) return false;
+            return SUCCEEDED(target->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &brush));
+        }
+
+        ~OffscreenFrame() {
+            if (brush) brush->Release();
+            if (target) target->Release();
+            if (bitmap) bitmap->Release();
+            if (wicFactory) wicFactory->Release();
+            if (factory) factory->Release();
+        }
+    };
+
+    // Back-to-back Nadal topspin shots at DT, appended to a trajectory the way a ball records during a rally
+    struct TraceSource {
+        TennisBall ball;
+        float time;
+
+        TraceSource() : ball(&courts[US_OPEN_HARD], false), time(0.0f) {
+            ball.setAirResistance(airModes[AIR_SEA_LEVEL].coefficient);
+        }
+
+        void Record(TrajectoryBuffer& trajectory, size_t samples) {
+            const LaunchPatternData& pattern = launchPatterns[PATTERN_NADAL_TOPSPIN];
+            for (size_t i = 0; i < samples; i++) {
+                if (!ball.isActive) ball.resetForHorizontalShot(pattern.force, pattern.angle, pattern.spin);
+                ball.update(DT);
+                time += DT;
+                trajectory.push_back({time, ball.y, ball.x});
+            }
+        }
+    };
+
+    // How the render benchmarks stroke the trajectory
+    enum TraceDrawing {
+        TRACE_DRAW_LINE,     // One DrawLine per segment (DrawTrajectoryTrace / DrawHeightGraphTrace)
+        TRACE_DRAW_GEOMETRY, // Cached chunked path geometry (TraceGeometry), as the application draws the courts
+        TRACE_DRAW_LAYER     // Cached bitmap taking only new segments (HeightGraphLayer), as it draws the graph
+    };
+
+    std::string TraceDrawingName(TraceDrawing drawing) {
+        switch (drawing) {
+        case TRACE_DRAW_GEOMETRY: return "Geometry";
+        case TRACE_DRAW_LAYER: return "Layer";
+        default: return "DrawLine";
+        }
+    }
+
+    // Court, net, trace and ball of a single-court view (RenderClayCourt without text). The
+    // trajectory ring is full at length samples and gains one sample per frame, as in a long rally.
+    void RegisterCourtFrame(std::shared_ptr<OffscreenFrame> frame, TraceDrawing drawing, size_t length) {
+        Register("BM_RenderCourtFrame/" + TraceDrawingName(drawing) + "/" + std::to_string(length),
+                 [frame, drawing, length](BenchmarkState& state) {
+            TrajectoryBuffer trajectory(length);
+            TraceSource source;
+            source.Record(trajectory, length);
+            TraceGeometry geometry(TRACE_AXIS_POSITION);
+
+            const float courtMargin = 50.0f;
+            const float zoomFactor = 0.25f;
+            const float courtPixelWidth = (FRAME_WIDTH - 2 * courtMargin) * 4.0f * zoomFactor;
+            const float courtTop = 240.0f;
+            const float courtBottom = courtTop + 300.0f * zoomFactor;
+            const float netX = courtMargin + courtPixelWidth / 2.0f;
+            const float netPixelHeight = NET_HEIGHT * 50.0f * zoomFactor;
+            const D2D1_MATRIX_3X2_F toPixels = CourtTraceTransform(courtMargin, courtPixelWidth, courtBottom, zoomFactor);
+            ID2D1RenderTarget* target = frame->target;
+            ID2D1SolidColorBrush* brush = frame->brush;
+
+            for (long long i = 0; i < state.iterations; i++) {
+                source.Record(trajectory, 1);
+
+                target->BeginDraw();
+                target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+
+                D2D1_RECT_F courtRect = D2D1::RectF(courtMargin, courtTop, courtMargin + courtPixelWidth, courtBottom);
+                brush->SetColor(D2D1::ColorF(0.8f, 0.4f, 0.2f));
+                target->FillRectangle(courtRect, brush);
+                brush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+                target->DrawRectangle(courtRect, brush, 2.0f);
+                target->FillRectangle(D2D1::RectF(netX - 2.0f, courtBottom - netPixelHeight, netX + 2.0f, courtBottom), brush);
+
+                brush->SetColor(D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f));
+                if (drawing == TRACE_DRAW_GEOMETRY) {
+                    geometry.Draw(frame->factory, target, brush, trajectory, toPixels, 1.0f);
+                } else {
+                    DrawTrajectoryTrace(target, brush, trajectory, courtMargin, courtPixelWidth, courtBottom, zoomFactor);
+                }
+
+                const BounceData& last = trajectory.back();
+                brush->SetColor(D2D1::ColorF(1.0f, 1.0f, 0.0f));
+                target->FillEllipse(D2D1::Ellipse(
+                    D2D1::Point2F(courtMargin + (last.xPosition / COURT_LENGTH) * courtPixelWidth,
+                                  courtBottom - last.height * 50.0f * zoomFactor),
+                    10.0f * zoomFactor, 10.0f * zoomFactor), brush);
+
+                target->EndDraw();
+            }
+            state.itemsProcessed = state.iterations;
+        });
+    }
+
+    // Four height-vs-time traces over the graph panel (DrawCombinedGraph without text),
+    // gaining one sample each per frame. The layer variant rescales its time axis in
+    // doubling steps like the application, the others every frame.
+    void RegisterCombinedGraphFrame(std::shared_ptr<OffscreenFrame> frame, TraceDrawing drawing, size_t length) {
+        Register("BM_RenderCombinedGraph/" + TraceDrawingName(drawing) + "/" + std::to_string(length),
+                 [frame, drawing, length](BenchmarkState& state) {
+            std::vector<TrajectoryBuffer> trajectories(4, TrajectoryBuffer(length));
+            std::vector<std::unique_ptr<TraceGeometry>> geometries;
+            TraceSource sources[4];
+            for (int c = 0; c < 4; c++) {
+                sources[c].Record(trajectories[c], length);
+                geometries.push_back(std::make_unique<TraceGeometry>(TRACE_AXIS_TIME, 2.5f));
+            }
+
+            const float graphX = 10;
+            const float graphY = 10;
+            const float graphWidth = FRAME_WIDTH - 20;
+            const float graphHeight = 150;
+            const float plotY = graphY + 30;
+            const float plotHeight = graphHeight - 40;
+            ID2D1RenderTarget* target = frame->target;
+            ID2D1SolidColorBrush* brush = frame->brush;
+            HeightGraphLayer layer(2.5f);
+            const TrajectoryBuffer* traces[4] = {&trajectories[0], &trajectories[1], &trajectories[2], &trajectories[3]};
+
+            // Background, border and grid with the panel's top left corner at (x, y)
+            auto drawPanel = [&](ID2D1RenderTarget* panelTarget, float x, float y) {
+                D2D1_RECT_F graphRect = D2D1::RectF(x, y, x + graphWidth, y + graphHeight);
+                brush->SetColor(D2D1::ColorF(0.1f, 0.1f, 0.1f, 0.8f));
+                panelTarget->FillRectangle(graphRect, brush);
+                brush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+                panelTarget->DrawRectangle(graphRect, brush, 1.0f);
+
+                brush->SetColor(D2D1::ColorF(0.3f, 0.3f, 0.3f));
+                for (int g = 0; g <= 5; g++) {
+                    float lineY = y + (plotY - graphY) + (plotHeight * g / 5.0f);
+                    panelTarget->DrawLine(D2D1::Point2F(x, lineY), D2D1::Point2F(x + graphWidth, lineY), brush, 0.5f);
+                }
+            };
+
+            for (long long i = 0; i < state.iterations; i++) {
+                for (int c = 0; c < 4; c++) {
+                    sources[c].Record(trajectories[c], 1);
+                }
+                float maxTime = trajectories[0].back().time;
+
+                target->BeginDraw();
+                target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+
+                if (drawing == TRACE_DRAW_LAYER) {
+                    float timeSpan = HeightGraphTimeSpan(maxTime);
+                    bool redraw;
+                    if (SUCCEEDED(layer.Begin(target, D2D1::SizeF(graphWidth, graphHeight), timeSpan, traces, 4, redraw))) {
+                        if (redraw) drawPanel(layer.Target(), 0.0f, 0.0f);
+                        D2D1_MATRIX_3X2_F toLayer = HeightGraphTransform(0.0f, plotY - graphY, graphWidth, plotHeight,
+                                                                         timeSpan, 2.5f);
+                        for (int c = 0; c < 4; c++) {
+                            brush->SetColor(D2D1::ColorF(1.0f, 1.0f - c * 0.2f, c * 0.2f));
+                            layer.DrawTrace(c, frame->factory, geometries[c].get(), brush, trajectories[c], toLayer, 2.0f);
+                        }
+                        layer.End(D2D1::Point2F(graphX, graphY));
+                    }
+                    target->EndDraw();
+                    continue;
+                }
+
+                drawPanel(target, graphX, graphY);
+
+                D2D1_MATRIX_3X2_F toPixels = HeightGraphTransform(graphX, plotY, graphWidth, plotHeight, maxTime, 2.5f);
+                for (int c = 0; c < 4; c++) {
+                    brush->SetColor(D2D1::ColorF(1.0f, 1.0f - c * 0.2f, c * 0.2f));
+                    if (drawing == TRACE_DRAW_GEOMETRY) {
+                        geometries[c]->Draw(frame->factory, target, brush, trajectories[c], toPixels, 2.0f);
+                    } else {
+                        DrawHeightGraphTrace(target, brush, trajectories[c], graphX, plotY, graphWidth, plotHeight,
+                                             maxTime, 2.5f);
+                    }
+                }
+
+                target->EndDraw();
+            }
+            state.itemsProcessed = state.iterations;
+        });
+    }
+
+    // Output
+
+    void PrintConsole(const std::vector<BenchmarkRun>& runs) {
+        size_t nameWidth = 10;
+        for (const BenchmarkRun& run : runs) {
+            if (run.name.size() > nameWidth) nameWidth = run.name.size();
+        }
+        printf("%-*s %15s %15s %12s %16s %12s\n", (int)nameWidth, "Benchmark", "Time", "CPU", "Iterations", "Items/s",
+               "Allocs/item");
+        printf("%s\n", std::string(nameWidth + 90, '-').c_str());
+        for (const BenchmarkRun& run : runs) {
+            printf("%-*s %12.0f ns %12.0f ns %12lld %16.4g %12.4g\n", (int)nameWidth, run.name.c_str(),
+                   run.realTime, run.cpuTime, run.iterations, run.itemsPerSecond, run.allocationsPerItem);
+        }
+    }
+
+    void WriteJson(FILE* file, const std::vector<BenchmarkRun>& runs, const char* executable) {
+        char date[64];
+        time_t now = time(nullptr);
+        struct tm local;
+        localtime_s(&local, &now);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local);
+
+        SYSTEM_INFO system;
+        GetSystemInfo(&system);
+
+        std::string exe;
+        for (const char* c = executable; *c; c++) {
+            if (*c == '\\' || *c == '"') exe += '\\';
+            exe += *c;
+        }
+
+        fprintf(file, "{\n");
+        fprintf(file, "  \"context\": {\n");
+        fprintf(file, "    \"date\": \"%s\",\n", date);
+        fprintf(file, "    \"executable\": \"%s\",\n", exe.c_str());
+        fprintf(file, "    \"num_cpus\": %u,\n", (unsigned)system.dwNumberOfProcessors);
+        fprintf(file, "    \"simd_level\": \"%s\",\n", NameToken(SimdLevelName(DetectSimdLevel())).c_str());
+        fprintf(file, "    \"physics_dt\": %g,\n", DT);
+        fprintf(file, "    \"library_build_type\": \"release\"\n");
+        fprintf(file, "  },\n");
+        fprintf(file, "  \"benchmarks\": [\n");
+        for (size_t i = 0; i < runs.size(); i++) {
+            const BenchmarkRun& run = runs[i];
+            fprintf(file, "    {\n");
+            fprintf(file, "      \"name\": \"%s\",\n", run.name.c_str());
+            fprintf(file, "      \"run_name\": \"%s\",\n", run.name.c_str());
+            fprintf(file, "      \"run_type\": \"iteration\",\n");
+            fprintf(file, "      \"iterations\": %lld,\n", run.iterations);
+            fprintf(file, "      \"real_time\": %.6g,\n", run.realTime);
+            fprintf(file, "      \"cpu_time\": %.6g,\n", run.cpuTime);
+            fprintf(file, "      \"time_unit\": \"ns\"");
+            if (run.itemsPerSecond > 0.0) fprintf(file, ",\n      \"items_per_second\": %.6g", run.itemsPerSecond);
+            fprintf(file, ",\n      \"allocs_per_item\": %.6g", run.allocationsPerItem);
+            fprintf(file, "\n    }%s\n", i + 1 < runs.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n");
+        fprintf(file, "}\n");
+    }
+
+    bool ParseFlag(const char* arg, const char* flag, std::string& value) {
+        size_t length = strlen(flag);
+        if (strncmp(arg, flag, length) != 0 || arg[length] != '=') return false;
+        value = arg + length + 1;
+        return true;
+    }
+}
+
+// Counting replacements of the global allocation functions; the array and sized
+// forms forward to these by default
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* block = malloc(size ? size : 1);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+int main(int argc, char** argv) {
+    std::string filter = ".";
+    std::string format = "console";
+    std::string outPath;
+    double minTime = DEFAULT_MIN_TIME;
+
+    for (int i = 1; i < argc; i++) {
+        std::string value;
+        if (ParseFlag(argv[i], "--benchmark_filter", filter) || ParseFlag(argv[i], "--benchmark_format", format) ||
+            ParseFlag(argv[i], "--benchmark_out", outPath)) {
+            continue;
+        }
+        if (ParseFlag(argv[i], "--benchmark_min_time", value)) {
+            minTime = atof(value.c_str());
+            continue;
+        }
+        fprintf(stderr, "usage: Benchmark [--benchmark_filter=<regex>] [--benchmark_format=console|json] "
+                        "[--benchmark_out=<file>] [--benchmark_min_time=<seconds>]\n");
+        return 1;
+    }
+    if (format != "console" && format != "json") {
+        fprintf(stderr, "unknown --benchmark_format: %s\n", format.c_str());
+        return 1;
+    }
+
+    RegisterSingleBallUpdate(INTEGRATOR_EULER);
+    RegisterSingleBallUpdate(INTEGRATOR_RK4);
+    RegisterSingleBallUpdate(INTEGRATOR_RK45);
+
+    SimdLevel supported = DetectSimdLevel();
+    for (bool vacuum : {false, true}) {
+        RegisterBatchRunToRest(SIMD_SCALAR, vacuum);
+        if (supported >= SIMD_AVX2) RegisterBatchRunToRest(SIMD_AVX2, vacuum);
+        if (supported >= SIMD_AVX512) RegisterBatchRunToRest(SIMD_AVX512, vacuum);
+    }
+
+    RegisterEngineRunBatch(INTEGRATION_FIXED_STEP, INTEGRATOR_EULER);
+    RegisterEngineRunBatch(INTEGRATION_FIXED_STEP, INTEGRATOR_RK4);
+    RegisterEngineRunBatch(INTEGRATION_FIXED_STEP, INTEGRATOR_RK45);
+    RegisterEngineRunBatch(INTEGRATION_EVENT_DRIVEN, INTEGRATOR_EULER);
+
+    RegisterShotToRest();
+
+    // Render benchmarks are skipped (with a note) where WIC or Direct2D is unavailable
+    HRESULT com = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    std::shared_ptr<OffscreenFrame> frame = std::make_shared<OffscreenFrame>();
+    if (frame->Create()) {
+        for (TraceDrawing drawing : {TRACE_DRAW_LINE, TRACE_DRAW_GEOMETRY}) {
+            for (size_t length : TRACE_LENGTHS) RegisterCourtFrame(frame, drawing, length);
+        }
+        for (TraceDrawing drawing : {TRACE_DRAW_LINE, TRACE_DRAW_GEOMETRY, TRACE_DRAW_LAYER}) {
+            for (size_t length : TRACE_LENGTHS) RegisterCombinedGraphFrame(frame, drawing, length);
+        }
+    } else {
+        fprintf(stderr, "Offscreen Direct2D target unavailable, render benchmarks skipped\n");
+    }
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error&) {
+        fprintf(stderr, "invalid --benchmark_filter: %s\n", filter.c_str());
+        return 1;
+    }
+
+    std::vector<BenchmarkRun> runs;
+    for (const Benchmark& benchmark : Registry()) {
+        if (!std::regex_search(benchmark.name, pattern)) continue;
+        runs.push_back(RunBenchmark(benchmark, minTime));
+    }
+
+    if (format == "json") {
+        WriteJson(stdout, runs, argv[0]);
+    } else {
+        PrintConsole(runs);
+    }
+
+    if (!outPath.empty()) {
+        FILE* file = nullptr;
+        if (fopen_s(&file, outPath.c_str(), "w") != 0 || !file) {
+            fprintf(stderr, "cannot write %s\n", outPath.c_str());
+            return 1;
+        }
+        WriteJson(file, runs, argv[0]);
+        fclose(file);
+    }
+
+    Registry().clear();
+    frame.reset();
+    if (SUCCEEDED(com)) CoUninitialize();
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Tennis Ball Physics Simulator - Direct2D device resources
+
+#include "DeviceResources.h"
+
+DeviceResources::DeviceResources() : factory(NULL), hwnd(NULL), target(NULL) {
+}
+
+DeviceResources::~DeviceResources() {
+    Discard();
+}
+
+void DeviceResources::Configure(ID2D1Factory* factory, HWND hwnd, const D2D1_COLOR_F* brushColors, size_t brushCount) {
+    Discard();
+    this->factory = factory;
+    this->hwnd = hwnd;
+    this->brushColors.assign(brushColors, brushColors + brushCount);
+    brushes.assign(brushCount, NULL);
+}
+
+HRESULT DeviceResources::EnsureCreated() {
+    if (target) return S_OK;
+    if (!factory) return E_UNEXPECTED;
+
+    RECT rc;
+    GetClientRect(hwnd, &rc);
+    HRESULT hr = factory->CreateHwndRenderTarget(
+        D2D1::RenderTargetProperties(),
+        D2D1::HwndRenderTargetProperties(hwnd, D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top)),
+        &target
+    );
+
+    for (size_t i = 0; SUCCEEDED(hr) && i < brushColors.size(); i++) {
+        hr = target->CreateSolidColorBrush(brushColors[i], &brushes[i]);
+    }
+
+    if (FAILED(hr)) {
+        Discard();
+        return hr;
+    }
+    return S_OK;
+}
+
+void DeviceResources::Discard() {
+    for (ID2D1SolidColorBrush*& brush : brushes) {
+        if (brush) brush->Release();
+        brush = NULL;
+    }
+    if (target) target->Release();
+    target = NULL;
+}
+
+HRESULT DeviceResources::EndDraw() {
+    HRESULT hr = target->EndDraw();
+    if (hr == D2DERR_RECREATE_TARGET) {
+        Discard();
+        return S_OK;
+    }
+    return hr;
+}
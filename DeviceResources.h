@@ -0,0 +1,47 @@
+// Tennis Ball Physics Simulator - Direct2D device resources
+// Owns everything tied to the Direct2D device behind the window: the HWND render
+// target and a fixed table of solid color brushes. All of it is created once and
+// reused every frame; when EndDraw reports D2DERR_RECREATE_TARGET (GPU reset, driver
+// update, remote session switch) the resources are discarded and recreated on the
+// next frame. Device-independent objects (factories, geometries) live elsewhere and
+// survive device loss.
+
+#pragma once
+
+#include <windows.h>
+#include <d2d1.h>
+#include <vector>
+
+class DeviceResources {
+public:
+    DeviceResources();
+    ~DeviceResources();
+
+    DeviceResources(const DeviceResources&) = delete;
+    DeviceResources& operator=(const DeviceResources&) = delete;
+
+    // Remembers what to build; nothing is created until the first EnsureCreated.
+    // brushColors[i] becomes Brush(i). The factory must outlive this object.
+    void Configure(ID2D1Factory* factory, HWND hwnd, const D2D1_COLOR_F* brushColors, size_t brushCount);
+
+    // Creates the render target and brushes if they do not exist (first frame, after device loss)
+    HRESULT EnsureCreated();
+
+    // Releases every device resource; the next EnsureCreated rebuilds them
+    void Discard();
+
+    // Ends the frame; on D2DERR_RECREATE_TARGET discards the resources and returns S_OK,
+    // so the next frame rebuilds them instead of rendering into a dead target
+    HRESULT EndDraw();
+
+    bool IsCreated() const { return target != NULL; }
+    ID2D1HwndRenderTarget* Target() const { return target; }
+    ID2D1SolidColorBrush* Brush(size_t index) const { return brushes[index]; }
+
+private:
+    ID2D1Factory* factory;
+    HWND hwnd;
+    std::vector<D2D1_COLOR_F> brushColors;
+    ID2D1HwndRenderTarget* target;
+    std::vector<ID2D1SolidColorBrush*> brushes;
+};
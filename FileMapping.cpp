@@ -0,0 +1,171 @@
+// Tennis Ball Physics Simulator - file helpers
+
+#include "FileMapping.h"
+
+#include <cstdlib>
+#include <cwchar>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+namespace {
+    // Multibyte form of path in the current locale; false if it has no such form
+    bool NarrowPath(const wchar_t* path, std::string& narrow) {
+        narrow.assign(wcslen(path) * MB_CUR_MAX + 1, '\0');
+        size_t length = wcstombs(&narrow[0], path, narrow.size());
+        if (length == (size_t)-1) return false;
+        narrow.resize(length);
+        return true;
+    }
+}
+#endif
+
+FILE* CreateBinaryFile(const wchar_t* path) {
+#ifdef _WIN32
+    return _wfopen(path, L"wb");
+#else
+    std::string narrow;
+    if (!NarrowPath(path, narrow)) return nullptr;
+    return fopen(narrow.c_str(), "wb");
+#endif
+}
+
+FILE* ReopenBinaryFile(const wchar_t* path, uint64_t size) {
+#ifdef _WIN32
+    FILE* file = _wfopen(path, L"r+b");
+    if (!file) return nullptr;
+    if (_chsize_s(_fileno(file), (__int64)size) != 0 || _fseeki64(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return nullptr;
+    }
+    return file;
+#else
+    std::string narrow;
+    if (!NarrowPath(path, narrow)) return nullptr;
+    FILE* file = fopen(narrow.c_str(), "r+b");
+    if (!file) return nullptr;
+    if (ftruncate(fileno(file), (off_t)size) != 0 || fseeko(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return nullptr;
+    }
+    return file;
+#endif
+}
+
+bool ReplaceFileWith(const wchar_t* to, const wchar_t* from) {
+#ifdef _WIN32
+    return MoveFileExW(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    std::string narrowFrom, narrowTo;
+    if (!NarrowPath(from, narrowFrom) || !NarrowPath(to, narrowTo)) return false;
+    return rename(narrowFrom.c_str(), narrowTo.c_str()) == 0;
+#endif
+}
+
+// The file and mapping handles are not needed once the view exists
+const uint8_t* MapFileReadOnly(const wchar_t* path, size_t& size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER fileSize;
+    const uint8_t* view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && (uint64_t)fileSize.QuadPart <= SIZE_MAX) {
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            view = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+    CloseHandle(file);
+    return view;
+#else
+    std::string narrow;
+    if (!NarrowPath(path, narrow)) return nullptr;
+
+    int fd = open(narrow.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = (size_t)info.st_size;
+        view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    return view == MAP_FAILED ? nullptr : (const uint8_t*)view;
+#endif
+}
+
+void UnmapFile(const uint8_t* view, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(view);
+#else
+    munmap((void*)view, size);
+#endif
+}
+
+bool ReadWholeFile(const wchar_t* path, std::vector<char>& contents) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    DWORD read = 0;
+    bool ok = GetFileSizeEx(file, &fileSize) && fileSize.QuadPart < MAXDWORD;
+    if (ok) {
+        contents.resize((size_t)fileSize.QuadPart);
+        ok = contents.empty() || ReadFile(file, contents.data(), (DWORD)contents.size(), &read, NULL);
+        contents.resize(read);
+    }
+    CloseHandle(file);
+    return ok;
+#else
+    std::string narrow;
+    if (!NarrowPath(path, narrow)) return false;
+
+    int fd = open(narrow.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+    if (ok) {
+        contents.resize((size_t)info.st_size);
+        ssize_t read = contents.empty() ? 0 : ::read(fd, contents.data(), contents.size());
+        ok = read >= 0;
+        contents.resize(ok ? (size_t)read : 0);
+    }
+    close(fd);
+    return ok;
+#endif
+}
+
+bool GetFileStamp(const wchar_t* path, uint64_t& writeTime, uint64_t& size) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &attributes)) return false;
+    writeTime = (uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+    size = (uint64_t)attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+    return true;
+#else
+    std::string narrow;
+    struct stat info;
+    if (!NarrowPath(path, narrow) || stat(narrow.c_str(), &info) != 0) return false;
+    writeTime = (uint64_t)info.st_mtime;
+    size = (uint64_t)info.st_size;
+    return true;
+#endif
+}
@@ -0,0 +1,35 @@
+// Tennis Ball Physics Simulator - file helpers
+// Wide-path binary file creation and replacement, whole-file reads and read-only
+// memory mappings, shared by the trajectory archives, the landing table cache, the
+// settings file and the batch runner's result files.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Creates (or truncates) path for binary writing; nullptr on failure
+FILE* CreateBinaryFile(const wchar_t* path);
+
+// Opens the existing file path for binary writing, cut back to its first size bytes
+// and positioned at their end; nullptr on failure
+FILE* ReopenBinaryFile(const wchar_t* path, uint64_t size);
+
+// Renames from to to, replacing any file there in one step, so readers of to see
+// either the old file or the new one whole
+bool ReplaceFileWith(const wchar_t* to, const wchar_t* from);
+
+// Maps the whole file read-only and stores its size; nullptr if the file is missing,
+// empty or cannot be mapped. The view stays valid until UnmapFile.
+const uint8_t* MapFileReadOnly(const wchar_t* path, size_t& size);
+void UnmapFile(const uint8_t* view, size_t size);
+
+// Replaces contents with the whole file, read with one call; false if the file is
+// missing or cannot be read. The file may be open for writing elsewhere.
+bool ReadWholeFile(const wchar_t* path, std::vector<char>& contents);
+
+// Last write time, in the platform's own units, and size of path; false, leaving
+// both alone, if the file is missing
+bool GetFileStamp(const wchar_t* path, uint64_t& writeTime, uint64_t& size);
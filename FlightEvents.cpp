@@ -0,0 +1,150 @@
+// Tennis Ball Physics Simulator - event-driven flight integration
+
+#include "FlightEvents.h"
+
+#include <cmath>
+
+namespace {
+    // Event surface: component (0 = x, 1 = y) reaching value; direction +1 rising, -1 falling, 0 either
+    struct EventPlane {
+        FlightEvent event;
+        int component;
+        double value;
+        int direction;
+    };
+
+    bool Crosses(const EventPlane& plane, double g0, double g1) {
+        bool rising = g0 < 0.0 && g1 >= 0.0;
+        bool falling = g0 > 0.0 && g1 <= 0.0;
+        if (plane.direction > 0) return rising;
+        if (plane.direction < 0) return falling;
+        return rising || falling;
+    }
+
+    // Lands state exactly on plane so the next call does not see the same crossing
+    void SnapToPlane(FlightState& state, const EventPlane& plane) {
+        if (plane.component == 0) {
+            state.x = plane.value;
+        } else {
+            state.y = plane.value;
+        }
+    }
+
+    // Without drag or spin the flight is a parabola, so every plane is reached at a
+    // time known in closed form and no stepping is needed
+    FlightEvent SolveParabolaToEvent(FlightState& state, const EventPlane* planes, int planeCount,
+                                     double duration, float& elapsed, int& steps) {
+        const double g = GRAVITY;
+        steps++;
+
+        int hit = -1;
+        double hitTime = duration;
+        for (int i = 0; i < planeCount; i++) {
+            const EventPlane& plane = planes[i];
+            double time = -1.0;
+            if (plane.component == 1) {
+                // Later root of y + vy t - g t^2 / 2 = value; a ball resting on the
+                // surface must rise off it first, as with the stepped crossing test
+                double height = state.y - plane.value;
+                if (height < 0.0 || (height == 0.0 && state.vy <= 0.0)) continue;
+                time = (state.vy + std::sqrt(state.vy * state.vy + 2.0 * g * height)) / g;
+            } else {
+                double gap = plane.value - state.x;
+                if (gap == 0.0 || state.vx == 0.0) continue;
+                if (plane.direction > 0 && (gap < 0.0 || state.vx < 0.0)) continue;
+                if (plane.direction < 0 && (gap > 0.0 || state.vx > 0.0)) continue;
+                time = gap / state.vx;
+            }
+            if (time > 0.0 && time < hitTime) {
+                hitTime = time;
+                hit = i;
+            }
+        }
+
+        double t = hit >= 0 ? hitTime : duration;
+        state.x += state.vx * t;
+        state.y += (state.vy - 0.5 * g * t) * t;
+        state.vy -= g * t;
+        if (hit < 0) {
+            elapsed = (float)duration;
+            return EVENT_NONE;
+        }
+
+        SnapToPlane(state, planes[hit]);
+        elapsed = (float)t;
+        return planes[hit].event;
+    }
+}
+
+FlightEvent IntegrateToEvent(FlightState& state, float spinRPM, float airResistanceCoeff, float duration,
+                             float rightyX, float& stepHint, float& elapsed, int& steps) {
+    EventPlane planes[5] = {
+        {EVENT_GROUND, 1, 0.0, -1},
+        {EVENT_NET_PLANE, 0, NET_X, 0},
+        {EVENT_LEFT_COURT, 0, 0.0, -1},
+        {EVENT_LEFT_COURT, 0, COURT_LENGTH, 1},
+        {EVENT_RIGHTY_PLANE, 0, rightyX, 1}
+    };
+    int planeCount = rightyX > 0.0f ? 5 : 4;
+
+    if (airResistanceCoeff == 0.0f && spinRPM == 0.0f) {
+        return SolveParabolaToEvent(state, planes, planeCount, duration, elapsed, steps);
+    }
+
+    double remaining = duration;
+    double h = stepHint > 0.0f ? stepHint : 0.01;
+    double t = 0.0;
+    FlightDerivative k0 = EvaluateFlight(state, spinRPM, airResistanceCoeff);
+
+    while (remaining - t > 1e-9) {
+        if (h > EVENT_MAX_STEP) h = EVENT_MAX_STEP;
+        bool lastStep = h >= remaining - t;
+        if (lastStep) h = remaining - t;
+
+        FlightState next;
+        FlightDerivative k7;
+        double error = DormandPrinceStep(state, k0, spinRPM, airResistanceCoeff, h, EVENT_TOLERANCE, next, k7);
+        steps++;
+
+        double factor = DormandPrinceStepFactor(error);
+        if (error > 1.0) {
+            h *= factor;
+            continue;
+        }
+
+        // Earliest event inside the accepted step
+        int hit = -1;
+        double hitTheta = 2.0;
+        for (int i = 0; i < planeCount; i++) {
+            const EventPlane& plane = planes[i];
+            double p0 = plane.component == 0 ? state.x : state.y;
+            double p1 = plane.component == 0 ? next.x : next.y;
+            if (!Crosses(plane, p0 - plane.value, p1 - plane.value)) continue;
+            double theta = FindStepCrossing(state, k0, next, k7, h, plane.component, plane.value);
+            if (theta < hitTheta) {
+                hitTheta = theta;
+                hit = i;
+            }
+        }
+
+        if (hit >= 0) {
+            FlightState atEvent = InterpolateFlight(state, k0, next, k7, h, hitTheta);
+            SnapToPlane(atEvent, planes[hit]);
+            state = atEvent;
+            t += hitTheta * h;
+            stepHint = (float)h;
+            elapsed = (float)t;
+            return planes[hit].event;
+        }
+
+        state = next;
+        k0 = k7;
+        t += h;
+        if (!lastStep) stepHint = (float)h;
+        h *= factor;
+        if (lastStep) break;
+    }
+
+    elapsed = (float)remaining;
+    return EVENT_NONE;
+}
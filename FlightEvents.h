@@ -0,0 +1,33 @@
+// Tennis Ball Physics Simulator - event-driven flight integration
+// Integrates the continuous flight model with an adaptive Dormand-Prince RK45
+// stepper and stops exactly at the next event (ground contact, net plane, RIGHTY
+// plane or a baseline) instead of polling for crossings after every fixed step.
+// Flights in vacuum without spin are parabolas and are solved in closed form.
+
+#pragma once
+
+#include "SimulationEngine.h"
+#include "Integrator.h"
+
+enum FlightEvent {
+    EVENT_NONE,          // Duration elapsed without an event
+    EVENT_GROUND,        // Ball center reached y = 0 while falling
+    EVENT_NET_PLANE,     // Ball crossed NET_X in either direction (height decides if it hit the net)
+    EVENT_RIGHTY_PLANE,  // Ball reached the RIGHTY contact plane moving right
+    EVENT_LEFT_COURT     // Ball crossed a baseline (x = 0 or x = COURT_LENGTH)
+};
+
+// Local error tolerance per step (meters for position, m/s for velocity, also used as relative tolerance)
+const double EVENT_TOLERANCE = 1e-6;
+
+// Largest allowed step in seconds; keeps the cubic used for root finding well conditioned
+const float EVENT_MAX_STEP = 0.25f;
+
+// Integrates up to duration seconds and stops at the earliest event. On an event,
+// state is placed exactly on the event surface and elapsed is the time taken to
+// reach it. rightyX <= 0 disables the RIGHTY plane. stepHint carries the adaptive
+// step size between calls (start with 0); steps is incremented per attempted step.
+// With no air resistance and no spin the event is found analytically in one step
+// and stepHint is left alone.
+FlightEvent IntegrateToEvent(FlightState& state, float spinRPM, float airResistanceCoeff, float duration,
+                             float rightyX, float& stepHint, float& elapsed, int& steps);
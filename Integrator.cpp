@@ -0,0 +1,211 @@
+// Tennis Ball Physics Simulator - flight integrators
+
+#include "Integrator.h"
+#include "SimulationEngine.h"
+
+#include <cmath>
+
+namespace {
+    // Dormand-Prince 5(4) tableau
+    const double A21 = 1.0 / 5.0;
+    const double A31 = 3.0 / 40.0, A32 = 9.0 / 40.0;
+    const double A41 = 44.0 / 45.0, A42 = -56.0 / 15.0, A43 = 32.0 / 9.0;
+    const double A51 = 19372.0 / 6561.0, A52 = -25360.0 / 2187.0, A53 = 64448.0 / 6561.0, A54 = -212.0 / 729.0;
+    const double A61 = 9017.0 / 3168.0, A62 = -355.0 / 33.0, A63 = 46732.0 / 5247.0, A64 = 49.0 / 176.0, A65 = -5103.0 / 18656.0;
+    const double B1 = 35.0 / 384.0, B3 = 500.0 / 1113.0, B4 = 125.0 / 192.0, B5 = -2187.0 / 6784.0, B6 = 11.0 / 84.0;
+    // Difference between the 5th and embedded 4th order weights
+    const double E1 = 71.0 / 57600.0, E3 = -71.0 / 16695.0, E4 = 71.0 / 1920.0, E5 = -17253.0 / 339200.0,
+                 E6 = 22.0 / 525.0, E7 = -1.0 / 40.0;
+
+    // state + h * sum(a[i] * k[i])
+    FlightState Offset(const FlightState& s, double h, const FlightDerivative* k, const double* a, int count) {
+        FlightState out = s;
+        for (int i = 0; i < count; i++) {
+            out.x += h * a[i] * k[i].dx;
+            out.y += h * a[i] * k[i].dy;
+            out.vx += h * a[i] * k[i].dvx;
+            out.vy += h * a[i] * k[i].dvy;
+        }
+        return out;
+    }
+
+    // Scaled difference between the 5th and 4th order solutions for one component
+    double ComponentError(const FlightDerivative* k, double h, double FlightDerivative::*field,
+                          double before, double after, double tolerance) {
+        double e = h * (E1 * (k[0].*field) + E3 * (k[2].*field) + E4 * (k[3].*field) +
+                        E5 * (k[4].*field) + E6 * (k[5].*field) + E7 * (k[6].*field));
+        return fabs(e) / (tolerance + tolerance * fmax(fabs(before), fabs(after)));
+    }
+
+    double Hermite(double p0, double d0, double p1, double d1, double h, double theta) {
+        double t2 = theta * theta;
+        double t3 = t2 * theta;
+        return (2.0 * t3 - 3.0 * t2 + 1.0) * p0 + (t3 - 2.0 * t2 + theta) * h * d0 +
+               (-2.0 * t3 + 3.0 * t2) * p1 + (t3 - t2) * h * d1;
+    }
+}
+
+void FlightAcceleration(double vx, double vy, float spinRPM, float airResistanceCoeff, double& ax, double& ay) {
+    ay = -GRAVITY;
+
+    // Magnus lift, as in AdvanceFlight: F = k * omega * |v|, applied vertically
+    double omega = spinRPM * 2.0 * 3.14159265 / 60.0;
+    double ballSpeed = sqrt(vx * vx + vy * vy);
+    if (ballSpeed > 0.1) {
+        ay -= MAGNUS_COEFF * omega * ballSpeed / BALL_MASS;
+    }
+
+    // Quadratic drag on horizontal motion only
+    ax = -airResistanceCoeff * vx * fabs(vx) / BALL_MASS;
+}
+
+FlightDerivative EvaluateFlight(const FlightState& state, float spinRPM, float airResistanceCoeff) {
+    FlightDerivative d;
+    d.dx = state.vx;
+    d.dy = state.vy;
+    FlightAcceleration(state.vx, state.vy, spinRPM, airResistanceCoeff, d.dvx, d.dvy);
+    return d;
+}
+
+double DormandPrinceStep(const FlightState& state, const FlightDerivative& k0, float spinRPM, float airResistanceCoeff,
+                         double h, double tolerance, FlightState& next, FlightDerivative& k7) {
+    static const double a2[] = {A21};
+    static const double a3[] = {A31, A32};
+    static const double a4[] = {A41, A42, A43};
+    static const double a5[] = {A51, A52, A53, A54};
+    static const double a6[] = {A61, A62, A63, A64, A65};
+    static const double b[] = {B1, 0.0, B3, B4, B5, B6};
+
+    FlightDerivative k[7];
+    k[0] = k0;
+    k[1] = EvaluateFlight(Offset(state, h, k, a2, 1), spinRPM, airResistanceCoeff);
+    k[2] = EvaluateFlight(Offset(state, h, k, a3, 2), spinRPM, airResistanceCoeff);
+    k[3] = EvaluateFlight(Offset(state, h, k, a4, 3), spinRPM, airResistanceCoeff);
+    k[4] = EvaluateFlight(Offset(state, h, k, a5, 4), spinRPM, airResistanceCoeff);
+    k[5] = EvaluateFlight(Offset(state, h, k, a6, 5), spinRPM, airResistanceCoeff);
+    next = Offset(state, h, k, b, 6);
+    k[6] = EvaluateFlight(next, spinRPM, airResistanceCoeff);
+    k7 = k[6];
+
+    return fmax(fmax(ComponentError(k, h, &FlightDerivative::dx, state.x, next.x, tolerance),
+                     ComponentError(k, h, &FlightDerivative::dy, state.y, next.y, tolerance)),
+                fmax(ComponentError(k, h, &FlightDerivative::dvx, state.vx, next.vx, tolerance),
+                     ComponentError(k, h, &FlightDerivative::dvy, state.vy, next.vy, tolerance)));
+}
+
+double DormandPrinceStepFactor(double error) {
+    double factor = error > 0.0 ? 0.9 * pow(error, -0.2) : 5.0;
+    return fmin(5.0, fmax(0.2, factor));
+}
+
+FlightState InterpolateFlight(const FlightState& a, const FlightDerivative& da, const FlightState& b,
+                              const FlightDerivative& db, double h, double theta) {
+    FlightState s;
+    s.x = Hermite(a.x, da.dx, b.x, db.dx, h, theta);
+    s.y = Hermite(a.y, da.dy, b.y, db.dy, h, theta);
+    s.vx = Hermite(a.vx, da.dvx, b.vx, db.dvx, h, theta);
+    s.vy = Hermite(a.vy, da.dvy, b.vy, db.dvy, h, theta);
+    return s;
+}
+
+double FindStepCrossing(const FlightState& a, const FlightDerivative& da, const FlightState& b,
+                        const FlightDerivative& db, double h, int component, double value) {
+    double p0 = component == 0 ? a.x : a.y;
+    double p1 = component == 0 ? b.x : b.y;
+    double d0 = component == 0 ? da.dx : da.dy;
+    double d1 = component == 0 ? db.dx : db.dy;
+
+    // Illinois (modified regula falsi); one bracket end usually stays fixed, so
+    // converge on the residual (0.1 nm) rather than the bracket width
+    double lo = 0.0, hi = 1.0;
+    double gLo = p0 - value, gHi = p1 - value;
+    int side = 0;
+    double theta = 1.0;
+    for (int i = 0; i < 60; i++) {
+        theta = (lo * gHi - hi * gLo) / (gHi - gLo);
+        double g = Hermite(p0, d0, p1, d1, h, theta) - value;
+        if (fabs(g) < 1e-10) break;
+        if ((g > 0.0) == (gHi > 0.0)) {
+            hi = theta;
+            gHi = g;
+            if (side == -1) gLo *= 0.5;
+            side = -1;
+        } else {
+            lo = theta;
+            gLo = g;
+            if (side == 1) gHi *= 0.5;
+            side = 1;
+        }
+    }
+    return theta;
+}
+
+int EulerIntegrator::Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) {
+    float x = (float)state.x, y = (float)state.y, vx = (float)state.vx, vy = (float)state.vy;
+    AdvanceFlight(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+    state = {x, y, vx, vy};
+    return 1;
+}
+
+int Rk4Integrator::Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) {
+    static const double half[] = {0.5};
+    static const double zeroHalf[] = {0.0, 0.5};
+    static const double zeroZeroOne[] = {0.0, 0.0, 1.0};
+    static const double weights[] = {1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0};
+
+    FlightDerivative k[4];
+    k[0] = EvaluateFlight(state, spinRPM, airResistanceCoeff);
+    k[1] = EvaluateFlight(Offset(state, dt, k, half, 1), spinRPM, airResistanceCoeff);
+    k[2] = EvaluateFlight(Offset(state, dt, k, zeroHalf, 2), spinRPM, airResistanceCoeff);
+    k[3] = EvaluateFlight(Offset(state, dt, k, zeroZeroOne, 3), spinRPM, airResistanceCoeff);
+    state = Offset(state, dt, k, weights, 4);
+    return 1;
+}
+
+Rk45Integrator::Rk45Integrator(double tolerance) : tolerance(tolerance), stepHint(0.0) {
+}
+
+int Rk45Integrator::Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) {
+    int steps = 0;
+    double t = 0.0;
+    double h = stepHint > 0.0 ? stepHint : dt;
+    FlightDerivative k0 = EvaluateFlight(state, spinRPM, airResistanceCoeff);
+
+    while (dt - t > 1e-9) {
+        bool lastStep = h >= dt - t;
+        if (lastStep) h = dt - t;
+
+        FlightState next;
+        FlightDerivative k7;
+        double error = DormandPrinceStep(state, k0, spinRPM, airResistanceCoeff, h, tolerance, next, k7);
+        steps++;
+
+        double factor = DormandPrinceStepFactor(error);
+        if (error > 1.0) {
+            h *= factor;
+            continue;
+        }
+
+        state = next;
+        k0 = k7;
+        t += h;
+        // A last step truncated to fit dt says nothing about the step the error allows
+        if (!lastStep) stepHint = h * factor;
+        h *= factor;
+    }
+    if (stepHint <= 0.0) stepHint = dt;
+    return steps;
+}
+
+std::unique_ptr<Integrator> CreateIntegrator(IntegratorType type) {
+    if (type == INTEGRATOR_RK4) return std::make_unique<Rk4Integrator>();
+    if (type == INTEGRATOR_RK45) return std::make_unique<Rk45Integrator>();
+    return std::make_unique<EulerIntegrator>();
+}
+
+Integrator* ThreadIntegrator(IntegratorType type) {
+    thread_local std::unique_ptr<Integrator> integrators[INTEGRATOR_RK45 + 1];
+    std::unique_ptr<Integrator>& integrator = integrators[type];
+    if (!integrator) integrator = CreateIntegrator(type);
+    return integrator.get();
+}
@@ -0,0 +1,103 @@
+// Tennis Ball Physics Simulator - flight integrators
+// The flight model as an ODE plus interchangeable steppers for it: the original
+// semi-implicit Euler, classic fixed-step RK4 and adaptive Dormand-Prince RK45.
+
+#pragma once
+
+#include <memory>
+
+// Position and velocity of a ball in flight
+struct FlightState {
+    double x;
+    double y;
+    double vx;
+    double vy;
+};
+
+// Time derivative of a FlightState
+struct FlightDerivative {
+    double dx;
+    double dy;
+    double dvx;
+    double dvy;
+};
+
+// Accelerations of the continuous flight model; AdvanceFlight discretizes the same forces
+void FlightAcceleration(double vx, double vy, float spinRPM, float airResistanceCoeff, double& ax, double& ay);
+
+FlightDerivative EvaluateFlight(const FlightState& state, float spinRPM, float airResistanceCoeff);
+
+// One Dormand-Prince 5(4) step of length h from state, whose derivative k0 is passed in
+// (first-same-as-last: k1 of the next step is the returned k7). Writes the 5th order
+// solution and returns the embedded error estimate scaled by tolerance (<= 1 accepts).
+double DormandPrinceStep(const FlightState& state, const FlightDerivative& k0, float spinRPM, float airResistanceCoeff,
+                         double h, double tolerance, FlightState& next, FlightDerivative& k7);
+
+// Step size factor for the next attempt after a step with the given scaled error
+double DormandPrinceStepFactor(double error);
+
+// Cubic Hermite interpolation between the end states of one step of length h; theta in [0, 1]
+FlightState InterpolateFlight(const FlightState& a, const FlightDerivative& da, const FlightState& b,
+                              const FlightDerivative& db, double h, double theta);
+
+// Theta in [0, 1] where x (component 0) or y (component 1) reaches value on the step's
+// Hermite cubic; the end states must lie on opposite sides of value
+double FindStepCrossing(const FlightState& a, const FlightDerivative& da, const FlightState& b,
+                        const FlightDerivative& db, double h, int component, double value);
+
+enum IntegratorType {
+    INTEGRATOR_EULER,  // Semi-implicit Euler (AdvanceFlight), the default stepper of TennisBall and BallBatch
+    INTEGRATOR_RK4,    // Classic 4th order Runge-Kutta, one evaluation set per dt
+    INTEGRATOR_RK45    // Adaptive Dormand-Prince with error control, substeps within dt as needed
+};
+
+// Advances a FlightState by a time step. Implementations may keep per-ball state
+// (the adaptive step size), so each ball needs its own instance.
+class Integrator {
+public:
+    virtual ~Integrator() {}
+
+    virtual IntegratorType Type() const = 0;
+    virtual const wchar_t* Name() const = 0;
+
+    // Advances state by dt; returns the number of internal steps attempted
+    virtual int Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) = 0;
+
+    // Forgets adaptive state when a new shot starts
+    virtual void Reset() {}
+};
+
+class EulerIntegrator : public Integrator {
+public:
+    IntegratorType Type() const override { return INTEGRATOR_EULER; }
+    const wchar_t* Name() const override { return L"Euler"; }
+    int Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) override;
+};
+
+class Rk4Integrator : public Integrator {
+public:
+    IntegratorType Type() const override { return INTEGRATOR_RK4; }
+    const wchar_t* Name() const override { return L"RK4"; }
+    int Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) override;
+};
+
+class Rk45Integrator : public Integrator {
+public:
+    // tolerance: local error per substep (meters, m/s), also used as relative tolerance
+    explicit Rk45Integrator(double tolerance = 1e-6);
+
+    IntegratorType Type() const override { return INTEGRATOR_RK45; }
+    const wchar_t* Name() const override { return L"RK45"; }
+    int Step(FlightState& state, float spinRPM, float airResistanceCoeff, float dt) override;
+    void Reset() override { stepHint = 0.0; }
+
+private:
+    double tolerance;
+    double stepHint; // Substep proposed by the error control, first attempt of the next Step
+};
+
+std::unique_ptr<Integrator> CreateIntegrator(IntegratorType type);
+
+// The calling thread's stepper of type, created on its first use. Headless flights
+// borrow it for one ball at a time and rely on the ball's reset to clear it.
+Integrator* ThreadIntegrator(IntegratorType type);
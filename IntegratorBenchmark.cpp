@@ -0,0 +1,166 @@
+// Tennis Ball Physics Simulator - integrator benchmark
+// Console tool: for every launchPatterns[] preset, compares each integrator's first
+// bounce against a double-precision RK4 reference at 10 us steps and measures
+// integration throughput in steps per second.
+//
+// Usage: IntegratorBenchmark.exe [surfaceIndex 0-3] [airMode 0-3]
+
+#include "SimulationEngine.h"
+#include "FlightEvents.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+    const double REFERENCE_STEP = 1e-5; // seconds
+    const int REPEATS = 2000;           // Full shots timed per configuration
+
+    struct BenchmarkConfig {
+        const char* name;
+        IntegrationMode mode;
+        IntegratorType integrator;
+        float dt;
+    };
+
+    const BenchmarkConfig configs[] = {
+        {"Euler   dt=8.3ms", INTEGRATION_FIXED_STEP, INTEGRATOR_EULER, DT},
+        {"Euler   dt=1ms", INTEGRATION_FIXED_STEP, INTEGRATOR_EULER, 0.001f},
+        {"RK4     dt=8.3ms", INTEGRATION_FIXED_STEP, INTEGRATOR_RK4, DT},
+        {"RK4     dt=20ms", INTEGRATION_FIXED_STEP, INTEGRATOR_RK4, 0.02f},
+        {"RK45    dt=50ms", INTEGRATION_FIXED_STEP, INTEGRATOR_RK45, 0.05f},
+        {"RK45    dt=250ms", INTEGRATION_FIXED_STEP, INTEGRATOR_RK45, 0.25f},
+        {"Events  (RK45)", INTEGRATION_EVENT_DRIVEN, INTEGRATOR_EULER, 0.0f}
+    };
+
+    // First bounce of the continuous model: double-precision RK4 at REFERENCE_STEP,
+    // the contact root-found on each step's Hermite cubic. Returns false on a net hit.
+    bool ReferenceFirstBounce(const ShotParams& shot, double& bounceX, double& bounceTime) {
+        float vx, vy;
+        ComputeLaunchVelocity(shot.force, shot.angle, vx, vy);
+        FlightState state = {LEFTY_START_X, 1.0, vx, vy};
+        float air = airModes[shot.airMode].coefficient;
+
+        Rk4Integrator rk4;
+        double time = 0.0;
+        while (time < 60.0) {
+            FlightState next = state;
+            rk4.Step(next, shot.spin, air, (float)REFERENCE_STEP);
+            FlightDerivative rate = EvaluateFlight(state, shot.spin, air);
+            FlightDerivative nextRate = EvaluateFlight(next, shot.spin, air);
+
+            if (CrossedNetPlane((float)state.x, (float)next.x)) {
+                double theta = FindStepCrossing(state, rate, next, nextRate, REFERENCE_STEP, 0, NET_X);
+                FlightState atNet = InterpolateFlight(state, rate, next, nextRate, REFERENCE_STEP, theta);
+                if (atNet.y <= NET_HEIGHT + BALL_RADIUS) return false;
+            }
+            if (next.y <= 0.0) {
+                double theta = FindStepCrossing(state, rate, next, nextRate, REFERENCE_STEP, 1, 0.0);
+                bounceX = InterpolateFlight(state, rate, next, nextRate, REFERENCE_STEP, theta).x;
+                bounceTime = time + theta * REFERENCE_STEP;
+                return true;
+            }
+            state = next;
+            time += REFERENCE_STEP;
+        }
+        return false;
+    }
+
+    // Runs one shot on a TennisBall the way SimulationEngine::SimulateShot does, with dt chosen per config
+    void RunShot(const BenchmarkConfig& config, const ShotParams& shot, Integrator* integrator, TennisBall& ball) {
+        ball.setIntegrator(config.integrator == INTEGRATOR_EULER ? nullptr : integrator);
+        ball.setAirResistance(airModes[shot.airMode].coefficient);
+        ball.resetForHorizontalShot(shot.force, shot.angle, shot.spin);
+        while (ball.isActive && ball.time < 60.0f) {
+            if (config.mode == INTEGRATION_EVENT_DRIVEN) {
+                ball.updateEventDriven(60.0f - ball.time);
+            } else {
+                ball.update(config.dt);
+            }
+        }
+    }
+
+    // Integrator steps until the first ground contact (or the end of the shot if it never lands)
+    int StepsToFirstBounce(const BenchmarkConfig& config, const ShotParams& shot, Integrator* integrator) {
+        TennisBall ball(&courts[shot.surfaceIndex], false);
+        ball.setIntegrator(config.integrator == INTEGRATOR_EULER ? nullptr : integrator);
+        ball.setAirResistance(airModes[shot.airMode].coefficient);
+        ball.resetForHorizontalShot(shot.force, shot.angle, shot.spin);
+
+        if (config.mode == INTEGRATION_EVENT_DRIVEN) {
+            // updateEventDriven runs through every contact, so drive the event integrator directly
+            FlightState state = {ball.x, ball.y, ball.vx, ball.vy};
+            float stepHint = 0.0f;
+            int steps = 0;
+            float time = 0.0f;
+            while (time < 60.0f) {
+                float elapsed = 0.0f;
+                FlightEvent event = IntegrateToEvent(state, shot.spin, ball.airResistanceCoeff, 60.0f - time, -1.0f,
+                                                     stepHint, elapsed, steps);
+                time += elapsed;
+                if (event == EVENT_GROUND || event == EVENT_LEFT_COURT || event == EVENT_NONE) break;
+            }
+            return steps;
+        }
+
+        while (ball.isActive && ball.bounces.empty() && ball.time < 60.0f) {
+            ball.update(config.dt);
+        }
+        return ball.stepCount;
+    }
+}
+
+int main(int argc, char** argv) {
+    int surfaceIndex = argc > 1 ? atoi(argv[1]) : 2;
+    int airMode = argc > 2 ? atoi(argv[2]) : AIR_SEA_LEVEL;
+    if (surfaceIndex < 0 || surfaceIndex > 3 || airMode < 0 || airMode > 3) {
+        fprintf(stderr, "usage: IntegratorBenchmark [surfaceIndex 0-3] [airMode 0-3]\n");
+        return 1;
+    }
+
+    printf("Surface: %ls, air: %ls\n", courts[surfaceIndex].name, airModes[airMode].name);
+    printf("Landing error is the first-bounce x versus a double-precision RK4 reference at 10 us steps.\n\n");
+
+    // PATTERN_RANDOM (index 0) has no fixed launch values
+    for (int p = 1; p < 8; p++) {
+        const LaunchPatternData& pattern = launchPatterns[p];
+        ShotParams shot = {pattern.force, pattern.angle, pattern.spin, surfaceIndex, (AirResistanceMode)airMode, 0};
+
+        double referenceX = 0.0, referenceTime = 0.0;
+        bool landed = ReferenceFirstBounce(shot, referenceX, referenceTime);
+        printf("%ls (%.0f N, %.0f deg, %.0f RPM)", pattern.name, pattern.force, pattern.angle, pattern.spin);
+        if (landed) {
+            printf(": reference first bounce %.4f m at %.4f s\n", referenceX, referenceTime);
+        } else {
+            printf(": reference hits the net, landing error not applicable\n");
+        }
+        printf("  %-18s %12s %13s %11s %10s %10s\n", "integrator", "error (mm)", "steps/bounce", "steps/shot", "Msteps/s", "kshots/s");
+
+        for (const BenchmarkConfig& config : configs) {
+            std::unique_ptr<Integrator> integrator = CreateIntegrator(config.integrator);
+            TennisBall ball(&courts[surfaceIndex], false);
+            int bounceSteps = StepsToFirstBounce(config, shot, integrator.get());
+
+            auto start = std::chrono::steady_clock::now();
+            long long steps = 0;
+            for (int r = 0; r < REPEATS; r++) {
+                RunShot(config, shot, integrator.get(), ball);
+                steps += ball.stepCount;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            char error[32];
+            if (landed && !ball.bounces.empty()) {
+                snprintf(error, sizeof(error), "%.3f", fabs(ball.bounces[0].xPosition - referenceX) * 1000.0);
+            } else {
+                snprintf(error, sizeof(error), "-");
+            }
+            printf("  %-18s %12s %13d %11d %10.2f %10.1f\n", config.name, error, bounceSteps,
+                   ball.stepCount, steps / seconds / 1e6, REPEATS / seconds / 1e3);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+// Tennis Ball Physics Simulator - landing-zone lookup tables
+
+#include "LandingTable.h"
+#include "FileMapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    LandingTableHeader MakeHeader(const LandingTableConfig& config) {
+        LandingTableHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "TBLT", 4);
+        header.version = LANDING_TABLE_VERSION;
+        header.airModeCount = 4;
+        header.integrationMode = (uint32_t)config.integrationMode;
+        // Only fixed steps use the integrator
+        header.integrator = config.integrationMode == INTEGRATION_FIXED_STEP ? (uint32_t)config.integrator : 0;
+        header.timeStep = config.timeStep;
+        header.force = config.force;
+        header.angle = config.angle;
+        header.spin = config.spin;
+        header.force.steps = std::max(1, header.force.steps);
+        header.angle.steps = std::max(1, header.angle.steps);
+        header.spin.steps = std::max(1, header.spin.steps);
+        for (int i = 0; i < 4; i++) {
+            header.airCoefficients[i] = airModes[i].coefficient;
+        }
+        header.gravity = GRAVITY;
+        header.magnusCoefficient = MAGNUS_COEFF;
+        header.ballMass = BALL_MASS;
+        header.ballRadius = BALL_RADIUS;
+        header.netHeight = NET_HEIGHT;
+        header.netX = NET_X;
+        header.launchX = LEFTY_START_X;
+        return header;
+    }
+
+    // Grid cell holding value and the weight of its upper corner
+    void LocateOnAxis(const SweepAxis& axis, float value, int& cell, float& weight) {
+        if (axis.steps <= 1 || axis.maxValue <= axis.minValue) {
+            cell = 0;
+            weight = 0.0f;
+            return;
+        }
+        float position = (value - axis.minValue) / (axis.maxValue - axis.minValue) * (float)(axis.steps - 1);
+        position = std::max(0.0f, std::min((float)(axis.steps - 1), position));
+        cell = std::min(axis.steps - 2, (int)position);
+        weight = position - (float)cell;
+    }
+}
+
+LandingTableConfig DefaultLandingTableConfig(float minSpin, float maxSpin) {
+    LandingTableConfig config;
+    config.force = {MIN_HORIZONTAL_FORCE, MAX_HORIZONTAL_FORCE, 101};
+    config.angle = {MIN_ANGLE, MAX_ANGLE, 61};
+    config.spin = {minSpin, maxSpin, std::max(2, (int)((maxSpin - minSpin) / 200.0f) + 1)};
+    config.timeStep = DT;
+    config.integrationMode = INTEGRATION_FIXED_STEP;
+    config.integrator = INTEGRATOR_EULER;
+    return config;
+}
+
+TennisBall LandingFlightBall(const LandingTableConfig& config, AirResistanceMode airMode, uint64_t seed,
+                             uint64_t stream, float force, float angle, float spin) {
+    // Any surface will do; nothing before the first bounce touches it
+    TennisBall ball(&courts[0], false);
+    if (config.integrationMode == INTEGRATION_FIXED_STEP && config.integrator != INTEGRATOR_EULER) {
+        ball.setIntegrator(ThreadIntegrator(config.integrator));
+    }
+    ball.setAirResistance(airModes[airMode].coefficient);
+    ball.setRandomStream(seed, stream);
+    ball.resetForHorizontalShot(force, angle, spin);
+    return ball;
+}
+
+LandingSample SimulateLanding(const ShotParams& shot, const LandingTableConfig& config) {
+    TennisBall ball = LandingFlightBall(config, shot.airMode, LANDING_TABLE_SEED, shot.randomStream,
+                                        shot.force, shot.angle, shot.spin);
+    return SimulateLanding(ball, config);
+}
+
+LandingSample SimulateLanding(TennisBall& ball, const LandingTableConfig& config) {
+    // Euler steps record a bounce where the step ends, not where the ball met the
+    // ground, so the landing would move in jumps of one step's travel as the aim
+    // changes; the other steppers already locate the contact within the step
+    bool eulerSteps = config.integrationMode == INTEGRATION_FIXED_STEP && !ball.integrator;
+
+    LandingSample sample;
+    sample.netClearance = -NET_HEIGHT;
+    sample.firstBounceX = ball.x;
+    bool crossedNet = false;
+    while (ball.isActive && ball.bounces.empty() && ball.time < LANDING_MAX_FLIGHT_TIME) {
+        float startX = ball.x;
+        float startY = ball.y;
+        float startVx = ball.vx;
+        float startVy = ball.vy;
+        float startSpin = ball.spinRPM;
+        bool startHitNet = ball.hitNet;
+        if (config.integrationMode == INTEGRATION_EVENT_DRIVEN) {
+            ball.updateEventDriven(config.timeStep);
+        } else {
+            ball.update(config.timeStep);
+        }
+
+        sample.firstBounceX = ball.bounces.empty() ? ball.x : ball.bounces[0].xPosition;
+        if (eulerSteps && !ball.bounces.empty() && ball.hitNet == startHitNet) {
+            // Repeat the step's flight without the ground to find where it crossed y = 0
+            float endX = startX, endY = startY, endVx = startVx, endVy = startVy;
+            AdvanceFlight(endX, endY, endVx, endVy, startSpin, ball.airResistanceCoeff, config.timeStep);
+            if (endY < startY) {
+                sample.firstBounceX = startX + (endX - startX) * startY / (startY - endY);
+            }
+        }
+
+        if (!crossedNet && (ball.hitNet || CrossedNetPlane(startX, ball.x))) {
+            crossedNet = true;
+            // A net contact leaves the ball where it struck the net
+            float netY = ball.y;
+            if (!ball.hitNet && ball.x != startX) {
+                netY = startY + (NET_X - startX) / (ball.x - startX) * (ball.y - startY);
+            }
+            sample.netClearance = netY - BALL_RADIUS - NET_HEIGHT;
+        }
+    }
+    return sample;
+}
+
+LandingTable::LandingTable() : header(), sampleCount(0), mapping(nullptr), mappingSize(0), samples(nullptr) {
+}
+
+LandingTable::~LandingTable() {
+    Close();
+}
+
+size_t LandingTable::SampleCount(const LandingTableConfig& config) {
+    return 4 * (size_t)std::max(1, config.force.steps) * (size_t)std::max(1, config.angle.steps) *
+           (size_t)std::max(1, config.spin.steps);
+}
+
+bool LandingTable::Open(const wchar_t* path, const LandingTableConfig& config) {
+    Close();
+
+    LandingTableHeader expected = MakeHeader(config);
+    size_t size = 0;
+    const uint8_t* view = MapFileReadOnly(path, size);
+    if (!view) return false;
+
+    if (size != sizeof(expected) + SampleCount(config) * sizeof(LandingSample) ||
+        memcmp(view, &expected, sizeof(expected)) != 0) {
+        UnmapFile(view, size);
+        return false;
+    }
+
+    header = expected;
+    sampleCount = SampleCount(config);
+    mapping = view;
+    mappingSize = size;
+    samples = (const LandingSample*)(view + sizeof(LandingTableHeader));
+    return true;
+}
+
+bool LandingTable::Build(const LandingTableConfig& config, ThreadPool& pool,
+                         const std::atomic<bool>* cancel, std::atomic<size_t>* shotsDone) {
+    Close();
+
+    LandingTableHeader tableHeader = MakeHeader(config);
+    int forceSteps = tableHeader.force.steps;
+    int angleSteps = tableHeader.angle.steps;
+    int spinSteps = tableHeader.spin.steps;
+    std::vector<LandingSample> table(SampleCount(config));
+
+    // One task per spin row keeps tasks long enough to be worth dealing out
+    size_t rows = table.size() / spinSteps;
+    pool.ParallelFor(rows, [&](size_t row) {
+        if (cancel && *cancel) return;
+
+        ShotParams shot;
+        shot.surfaceIndex = 0;
+        shot.angle = config.angle.ValueAt((int)(row % angleSteps));
+        shot.force = config.force.ValueAt((int)(row / angleSteps % forceSteps));
+        shot.airMode = (AirResistanceMode)(row / angleSteps / forceSteps);
+        for (int spin = 0; spin < spinSteps; spin++) {
+            size_t index = row * spinSteps + spin;
+            shot.spin = config.spin.ValueAt(spin);
+            shot.randomStream = index;
+            table[index] = SimulateLanding(shot, config);
+        }
+        if (shotsDone) *shotsDone += spinSteps;
+    });
+    if (cancel && *cancel) return false;
+
+    header = tableHeader;
+    sampleCount = table.size();
+    built.swap(table);
+    samples = built.data();
+    return true;
+}
+
+bool LandingTable::Save(const wchar_t* path) const {
+    if (!samples) return false;
+
+    FILE* file = CreateBinaryFile(path);
+    if (!file) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(samples, sizeof(LandingSample), sampleCount, file) == sampleCount;
+    return fclose(file) == 0 && ok;
+}
+
+void LandingTable::Close() {
+    if (mapping) {
+        UnmapFile(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+    }
+    std::vector<LandingSample>().swap(built);
+    samples = nullptr;
+    sampleCount = 0;
+}
+
+bool LandingTable::IsBuiltFor(const LandingTableConfig& config) const {
+    LandingTableHeader expected = MakeHeader(config);
+    return samples && memcmp(&header, &expected, sizeof(expected)) == 0;
+}
+
+const LandingSample& LandingTable::Sample(int airMode, int force, int angle, int spin) const {
+    size_t index = (((size_t)airMode * header.force.steps + force) * header.angle.steps + angle) * header.spin.steps + spin;
+    return samples[index];
+}
+
+LandingSample LandingTable::Lookup(float force, float angle, float spin, AirResistanceMode airMode) const {
+    int forceCell, angleCell, spinCell;
+    float forceWeight, angleWeight, spinWeight;
+    LocateOnAxis(header.force, force, forceCell, forceWeight);
+    LocateOnAxis(header.angle, angle, angleCell, angleWeight);
+    LocateOnAxis(header.spin, spin, spinCell, spinWeight);
+
+    // Axes with one step have no upper neighbor
+    int forceNext = header.force.steps > 1 ? 1 : 0;
+    int angleNext = header.angle.steps > 1 ? 1 : 0;
+    int spinNext = header.spin.steps > 1 ? 1 : 0;
+
+    LandingSample result = {0.0f, 0.0f};
+    for (int corner = 0; corner < 8; corner++) {
+        int df = corner & 1, da = (corner >> 1) & 1, ds = (corner >> 2) & 1;
+        float weight = (df ? forceWeight : 1.0f - forceWeight) *
+                       (da ? angleWeight : 1.0f - angleWeight) *
+                       (ds ? spinWeight : 1.0f - spinWeight);
+        if (weight == 0.0f) continue;
+
+        const LandingSample& sample = Sample((int)airMode, forceCell + df * forceNext,
+                                             angleCell + da * angleNext, spinCell + ds * spinNext);
+        result.firstBounceX += weight * sample.firstBounceX;
+        result.netClearance += weight * sample.netClearance;
+    }
+    return result;
+}
@@ -0,0 +1,129 @@
+// Tennis Ball Physics Simulator - landing-zone lookup tables
+// First-bounce position and net clearance of horizontal shots, precomputed over a
+// (force, angle, spin) grid per air mode and queried with trilinear interpolation,
+// so aiming screens can predict a shot without simulating it. Tables are built on a
+// ThreadPool and cached in a file that later runs memory-map instead of rebuilding.
+//
+// The court surface only enters a shot at ground contact, so flight up to the
+// first bounce is the same on every entry of courts[] and one table per air mode
+// serves them all.
+//
+// File layout (little endian):
+//   LandingTableHeader
+//   LandingSample[airMode][force][angle][spin]
+
+#pragma once
+
+#include "ParameterSweep.h"
+#include "SimulationEngine.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// What a shot does before its first bounce
+struct LandingSample {
+    float firstBounceX; // meters, where the ball met the ground; where the flight ended if it left the court first
+    float netClearance; // meters from the net tape to the bottom of the ball as it crosses the net plane;
+                        // negative when it strikes the net, -NET_HEIGHT when it lands short of it
+};
+
+// Grid and stepping the table is built for; stepping should match the shots being predicted
+struct LandingTableConfig {
+    SweepAxis force;   // Newtons
+    SweepAxis angle;   // degrees
+    SweepAxis spin;    // RPM
+    float timeStep;    // seconds
+    IntegrationMode integrationMode;
+    IntegratorType integrator;
+};
+
+// Aiming key range: 10 N force steps, 1.5 degree angle steps, 200 RPM spin steps
+LandingTableConfig DefaultLandingTableConfig(float minSpin, float maxSpin);
+
+// Flights longer than this stop without a bounce
+const float LANDING_MAX_FLIGHT_TIME = 30.0f; // seconds
+
+// Key of the random streams of the shots that strike the net; stream = grid index
+const uint64_t LANDING_TABLE_SEED = 0x4C414E44ull;
+
+const uint32_t LANDING_TABLE_VERSION = 2;
+
+// A cache is only used when every field matches the table that would be built:
+// grid, stepping and the physics constants the flight depends on
+struct LandingTableHeader {
+    char magic[4];           // "TBLT"
+    uint32_t version;
+    uint32_t airModeCount;
+    uint32_t integrationMode;
+    uint32_t integrator;
+    float timeStep;
+    SweepAxis force;
+    SweepAxis angle;
+    SweepAxis spin;
+    float airCoefficients[4];
+    float gravity;
+    float magnusCoefficient;
+    float ballMass;
+    float ballRadius;
+    float netHeight;
+    float netX;
+    float launchX;
+};
+
+// A headless LEFTY launch stepped as config says, with its random stream keyed by
+// seed and stream, ready for SimulateLanding
+TennisBall LandingFlightBall(const LandingTableConfig& config, AirResistanceMode airMode, uint64_t seed,
+                             uint64_t stream, float force, float angle, float spin);
+
+// Flies a launched ball (right after resetForHorizontalShot or ApplyReturnHit) up to
+// its first bounce; the ball's integrator, if any, must match config
+LandingSample SimulateLanding(TennisBall& ball, const LandingTableConfig& config);
+// Launches shot from LEFTY and flies it up to its first bounce
+LandingSample SimulateLanding(const ShotParams& shot, const LandingTableConfig& config);
+
+class LandingTable {
+public:
+    LandingTable();
+    ~LandingTable();
+
+    LandingTable(const LandingTable&) = delete;
+    LandingTable& operator=(const LandingTable&) = delete;
+
+    // Maps a cache written by Save; false, with nothing loaded, if the file is missing
+    // or was built for another grid, stepping or physics
+    bool Open(const wchar_t* path, const LandingTableConfig& config);
+
+    // Simulates every grid point of every air mode on pool. shotsDone counts grid
+    // points as they finish; a cancelled build returns false and loads nothing.
+    bool Build(const LandingTableConfig& config, ThreadPool& pool,
+               const std::atomic<bool>* cancel = nullptr, std::atomic<size_t>* shotsDone = nullptr);
+
+    // Writes the loaded table as a cache file
+    bool Save(const wchar_t* path) const;
+
+    void Close();
+    bool IsReady() const { return samples != nullptr; }
+
+    // Whether the loaded table was built for config with the current airModes[]
+    // coefficients; a settings reload that changes them leaves it stale
+    bool IsBuiltFor(const LandingTableConfig& config) const;
+
+    // Grid points per air mode times air modes
+    static size_t SampleCount(const LandingTableConfig& config);
+
+    // Trilinear interpolation between the eight grid points around the aim; aims
+    // outside the grid use its nearest edge
+    LandingSample Lookup(float force, float angle, float spin, AirResistanceMode airMode) const;
+
+private:
+    LandingTableHeader header;
+    size_t sampleCount;
+    const uint8_t* mapping; // Cache file, mapped read-only
+    size_t mappingSize;
+    std::vector<LandingSample> built;
+    const LandingSample* samples; // Into mapping or built
+
+    const LandingSample& Sample(int airMode, int force, int angle, int spin) const;
+};
@@ -0,0 +1,128 @@
+// Tennis Ball Physics Simulator - parameter sweeps
+
+#include "ParameterSweep.h"
+
+float SweepAxis::ValueAt(int index) const {
+    if (steps <= 1) return minValue;
+    return minValue + (maxValue - minValue) * (float)index / (float)(steps - 1);
+}
+
+size_t SweepGrid::ShotCount() const {
+    return airModes.size() * surfaces.size() * (size_t)force.steps * (size_t)angle.steps * (size_t)spin.steps;
+}
+
+ShotParams SweepGrid::ShotAt(size_t index) const {
+    size_t shotIndex = index;
+    ShotParams shot;
+    shot.spin = spin.ValueAt((int)(index % spin.steps));
+    index /= spin.steps;
+    shot.angle = angle.ValueAt((int)(index % angle.steps));
+    index /= angle.steps;
+    shot.force = force.ValueAt((int)(index % force.steps));
+    index /= force.steps;
+    shot.surfaceIndex = surfaces[index % surfaces.size()];
+    index /= surfaces.size();
+    shot.airMode = airModes[index];
+    shot.randomStream = shotIndex;
+    return shot;
+}
+
+SweepGrid DefaultSweepGrid() {
+    SweepGrid grid;
+    grid.force = {100.0f, MAX_HORIZONTAL_FORCE, 91};
+    grid.angle = {MIN_ANGLE, 60.0f, 31};
+    grid.spin = {-3000.0f, 9000.0f, 25};
+    for (int i = 0; i < 4; i++) {
+        grid.surfaces.push_back(i);
+        grid.airModes.push_back((AirResistanceMode)i);
+    }
+    return grid;
+}
+
+namespace {
+    // Simulates one chunk into out, or into a per-thread buffer when out is null,
+    // and feeds the chunk's rows and steps to outputs
+    void SimulateChunk(const SweepGrid& grid, const SimulationEngine& engine, size_t chunk, ShotResult* out,
+                       std::atomic<size_t>* shotsDone, const SweepOutputs& outputs) {
+        size_t shotCount = grid.ShotCount();
+        size_t begin = chunk * SWEEP_CHUNK_SHOTS;
+        size_t end = (begin + SWEEP_CHUNK_SHOTS < shotCount) ? begin + SWEEP_CHUNK_SHOTS : shotCount;
+
+        thread_local std::vector<ShotParams> shots;
+        thread_local std::vector<ShotResult> chunkResults;
+        shots.resize(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            shots[i - begin] = grid.ShotAt(i);
+        }
+        if (!out) {
+            chunkResults.resize(end - begin);
+            out = chunkResults.data();
+        }
+        if (outputs.archive) {
+            thread_local ShotRecorder recorder;
+            auto record = [](const TennisBall& ball) { recorder.Record(ball); };
+            for (size_t i = begin; i < end; i++) {
+                recorder.Begin(shots[i - begin]);
+                out[i - begin] = engine.SimulateShot(shots[i - begin], record);
+                outputs.archive->AppendShot(i, recorder);
+            }
+        } else {
+            engine.RunBatch(shots.data(), shots.size(), out);
+        }
+        if (outputs.results) {
+            outputs.results->Submit(shots.data(), out, shots.size(), begin);
+        }
+        if (outputs.steps) {
+            uint64_t steps = 0;
+            for (size_t i = 0; i < shots.size(); i++) steps += (uint64_t)out[i].steps;
+            *outputs.steps += steps;
+        }
+
+        if (shotsDone) *shotsDone += end - begin;
+    }
+}
+
+size_t SweepChunkCount(const SweepGrid& grid) {
+    return (grid.ShotCount() + SWEEP_CHUNK_SHOTS - 1) / SWEEP_CHUNK_SHOTS;
+}
+
+void SweepShardChunks(const SweepGrid& grid, unsigned shard, unsigned shardCount, size_t& begin, size_t& end) {
+    size_t chunkCount = SweepChunkCount(grid);
+    begin = (size_t)((uint64_t)chunkCount * shard / shardCount);
+    end = (size_t)((uint64_t)chunkCount * (shard + 1) / shardCount);
+}
+
+std::vector<ShotResult> RunParameterSweep(const SweepGrid& grid, const SimulationEngine& engine, ThreadPool& pool,
+                                          std::atomic<size_t>* shotsDone, const std::atomic<bool>* cancel,
+                                          const SweepOutputs& outputs) {
+    std::vector<ShotResult> results(outputs.keepResults ? grid.ShotCount() : 0);
+
+    // Each chunk writes a disjoint slice of results, so workers never contend on output
+    pool.ParallelFor(SweepChunkCount(grid), [&](size_t chunk) {
+        if (cancel && *cancel) return;
+        ShotResult* out = outputs.keepResults ? &results[chunk * SWEEP_CHUNK_SHOTS] : nullptr;
+        SimulateChunk(grid, engine, chunk, out, shotsDone, outputs);
+    });
+    return results;
+}
+
+void RunSweepChunks(const SweepGrid& grid, const SimulationEngine& engine, ThreadPool& pool,
+                    const std::vector<size_t>& chunks, std::atomic<size_t>* shotsDone,
+                    const std::atomic<bool>* cancel, const SweepOutputs& outputs) {
+    pool.ParallelFor(chunks.size(), [&](size_t i) {
+        if (cancel && *cancel) return;
+        SimulateChunk(grid, engine, chunks[i], nullptr, shotsDone, outputs);
+    });
+}
+
+void WriteSweepTable(FILE* out, const SweepGrid& grid, const std::vector<ShotResult>& results) {
+    CsvResultSink sink(out);
+    ShotRow row;
+    for (size_t i = 0; i < results.size(); i++) {
+        row.shotId = i;
+        row.params = grid.ShotAt(i);
+        row.result = results[i];
+        sink.WriteRows(&row, 1);
+    }
+    sink.Finish();
+}
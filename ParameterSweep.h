@@ -0,0 +1,82 @@
+// Tennis Ball Physics Simulator - parameter sweeps
+// Maps landing results over a force x angle x spin x surface x air mode grid
+
+#pragma once
+
+#include "SimulationEngine.h"
+#include "ThreadPool.h"
+#include "TrajectoryArchive.h"
+#include "ResultExport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Evenly spaced values from minValue to maxValue inclusive
+struct SweepAxis {
+    float minValue;
+    float maxValue;
+    int steps;
+
+    float ValueAt(int index) const;
+};
+
+struct SweepGrid {
+    SweepAxis force;   // Newtons
+    SweepAxis angle;   // degrees
+    SweepAxis spin;    // RPM
+    std::vector<int> surfaces;                // Indices into courts[]
+    std::vector<AirResistanceMode> airModes;  // Indices into airModes[]
+
+    size_t ShotCount() const;
+
+    // Shot order: air mode, surface, force, angle, then spin varying fastest. The
+    // shot's random stream is its index, so results do not depend on scheduling.
+    ShotParams ShotAt(size_t index) const;
+};
+
+// Default grid: every court and air mode over the full force/angle/spin ranges
+SweepGrid DefaultSweepGrid();
+
+// Shots per pool task; small enough for stealing to balance long rallies, large
+// enough to amortize scheduling and keep the SIMD batch full
+const size_t SWEEP_CHUNK_SHOTS = 1024;
+
+// Optional streams fed while a sweep runs; shot ids are grid indices
+struct SweepOutputs {
+    // Every shot's trajectory. Those shots run one by one on SimulationEngine::SimulateShot,
+    // so the results match the archived flights rather than the SIMD batch.
+    TrajectoryWriter* archive = nullptr;
+    // Each chunk's rows as soon as the chunk is done
+    ResultExporter* results = nullptr;
+    // Advanced by each chunk's integration steps
+    std::atomic<uint64_t>* steps = nullptr;
+    // False when the outputs are all the run needs: the sweep then returns no
+    // results and only holds one chunk's per worker
+    bool keepResults = true;
+};
+
+// Chunks of SWEEP_CHUNK_SHOTS shots in grid order; the last one may be shorter
+size_t SweepChunkCount(const SweepGrid& grid);
+
+// Chunk range [begin, end) of shard number shard of shardCount. Shards are contiguous
+// and differ by at most one chunk; as each shot's random stream is its grid index,
+// the shards together give exactly the rows of the whole sweep.
+void SweepShardChunks(const SweepGrid& grid, unsigned shard, unsigned shardCount, size_t& begin, size_t& end);
+
+// Simulates every shot of the grid on the pool; results[i] belongs to grid.ShotAt(i).
+// shotsDone (optional) is advanced as chunks finish; setting cancel skips remaining chunks.
+std::vector<ShotResult> RunParameterSweep(const SweepGrid& grid, const SimulationEngine& engine, ThreadPool& pool,
+                                          std::atomic<size_t>* shotsDone = nullptr,
+                                          const std::atomic<bool>* cancel = nullptr,
+                                          const SweepOutputs& outputs = SweepOutputs());
+
+// Simulates only the listed chunks, for shards and resumed runs. Nothing is returned,
+// so outputs has to capture the results.
+void RunSweepChunks(const SweepGrid& grid, const SimulationEngine& engine, ThreadPool& pool,
+                    const std::vector<size_t>& chunks, std::atomic<size_t>* shotsDone = nullptr,
+                    const std::atomic<bool>* cancel = nullptr, const SweepOutputs& outputs = SweepOutputs());
+
+// Writes the result table as CSV (CsvResultSink columns), one row per shot in grid order
+void WriteSweepTable(FILE* out, const SweepGrid& grid, const std::vector<ShotResult>& results);
@@ -0,0 +1,80 @@
+// Tennis Ball Physics Simulator - counter-based random numbers
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"):
+// every output is a pure function of (key, counter), so there is no shared
+// generator state. Each ball or shot draws from its own stream, which makes runs
+// reproducible bit for bit no matter how shots are spread over threads or lanes.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+struct PhiloxBlock {
+    uint32_t v[4];
+};
+
+// Ten Philox rounds of counter under key
+inline PhiloxBlock Philox4x32(PhiloxBlock counter, uint32_t key0, uint32_t key1) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)M0 * counter.v[0];
+        uint64_t p1 = (uint64_t)M1 * counter.v[2];
+        PhiloxBlock next = {{
+            (uint32_t)(p1 >> 32) ^ counter.v[1] ^ key0,
+            (uint32_t)p1,
+            (uint32_t)(p0 >> 32) ^ counter.v[3] ^ key1,
+            (uint32_t)p0
+        }};
+        counter = next;
+        key0 += W0;
+        key1 += W1;
+    }
+    return counter;
+}
+
+// Sequence of draws number 0, 1, 2, ... of one stream under one seed: the seed is the
+// Philox key, the counter holds the stream id and draw number. Copying a stream
+// copies its position; nothing else is stored.
+class RandomStream {
+public:
+    explicit RandomStream(uint64_t seed = 0, uint64_t stream = 0) { Seed(seed, stream); }
+
+    // Restarts at draw 0 of the given stream
+    void Seed(uint64_t seed, uint64_t stream) {
+        this->seed = seed;
+        this->stream = stream;
+        draw = 0;
+    }
+
+    uint64_t Seed() const { return seed; }
+    uint64_t Stream() const { return stream; }
+    uint64_t DrawCount() const { return draw; }
+
+    uint32_t NextUInt() {
+        // One block yields four draws
+        uint64_t block = draw >> 2;
+        PhiloxBlock counter = {{(uint32_t)block, (uint32_t)(block >> 32), (uint32_t)stream, (uint32_t)(stream >> 32)}};
+        PhiloxBlock output = Philox4x32(counter, (uint32_t)seed, (uint32_t)(seed >> 32));
+        return output.v[draw++ & 3];
+    }
+
+    // Uniform in [0, 1)
+    float NextFloat() { return (NextUInt() >> 8) * (1.0f / 16777216.0f); }
+
+    // Uniform in [0, n) for n > 0
+    uint32_t NextInt(uint32_t n) { return (uint32_t)(((uint64_t)NextUInt() * n) >> 32); }
+
+    // Standard normal (Box-Muller on two draws; the sine half is discarded so that
+    // every value costs the same two draws)
+    float NextGaussian() {
+        float u1 = ((NextUInt() >> 8) + 1) * (1.0f / 16777216.0f); // (0, 1], keeps log finite
+        float u2 = NextFloat();
+        return sqrtf(-2.0f * logf(u1)) * cosf(6.28318531f * u2);
+    }
+
+private:
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t draw;
+};
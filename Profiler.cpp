@@ -0,0 +1,159 @@
+// Tennis Ball Physics Simulator - frame and physics instrumentation
+
+#include "Profiler.h"
+#include "FileMapping.h"
+
+#include <algorithm>
+
+namespace {
+    const wchar_t* zoneNames[ZONE_COUNT] = {
+        L"Frame",
+        L"RenderAllCourts",
+        L"RenderCourt",
+        L"DrawCombinedGraph",
+        L"Present",
+        L"RightyDialog",
+        L"PhysicsTick",
+        L"PhysicsStep",
+        L"Snapshot"
+    };
+
+    const char* threadNames[PROFILE_THREAD_COUNT] = {
+        "UI",
+        "Simulation"
+    };
+
+    const int ZONE_BITS = 8;
+
+    double TicksToMilliseconds(int64_t ticks) {
+        return ticks * 1000.0 * Profiler::Clock::period::num / Profiler::Clock::period::den;
+    }
+
+    // Sorts durations in place
+    ZoneStats Percentiles(std::vector<double>& durations) {
+        ZoneStats stats = {durations.size(), 0.0, 0.0, 0.0};
+        if (durations.empty()) return stats;
+        std::sort(durations.begin(), durations.end());
+        stats.p50 = durations[durations.size() / 2];
+        stats.p99 = durations[std::min(durations.size() - 1, durations.size() * 99 / 100)];
+        stats.max = durations.back();
+        return stats;
+    }
+}
+
+std::atomic<bool> Profiler::enabled(false);
+thread_local Profiler::Track* Profiler::boundTrack = nullptr;
+
+const wchar_t* ProfileZoneName(ProfileZone zone) {
+    return zoneNames[zone];
+}
+
+Profiler::Track::Track() : written(0) {
+    for (size_t i = 0; i < PROFILE_TRACK_EVENTS; i++) {
+        starts[i].store(0, std::memory_order_relaxed);
+        ends[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Profiler::Profiler() : origin(Clock::now()) {
+    for (int i = 0; i < PROFILE_THREAD_COUNT; i++) {
+        tracks[i] = std::make_unique<Track>();
+    }
+}
+
+Profiler& Profiler::Instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::BindThread(ProfileThread thread) {
+    boundTrack = tracks[thread].get();
+}
+
+void Profiler::Record(ProfileZone zone, Clock::time_point start, Clock::time_point end) {
+    Track* track = boundTrack;
+    if (!track) return;
+    size_t index = track->written.load(std::memory_order_relaxed);
+    size_t slot = index & (PROFILE_TRACK_EVENTS - 1);
+    track->starts[slot].store(Ticks(start), std::memory_order_relaxed);
+    track->ends[slot].store(Ticks(end) << ZONE_BITS | zone, std::memory_order_relaxed);
+    track->written.store(index + 1, std::memory_order_release);
+}
+
+std::vector<Profiler::Event> Profiler::CopyTrack(const Track& track, int64_t since) const {
+    std::vector<Event> events;
+    size_t written = track.written.load(std::memory_order_acquire);
+    size_t first = written > PROFILE_TRACK_EVENTS ? written - PROFILE_TRACK_EVENTS : 0;
+
+    // Newest first, stopping at the window's start
+    for (size_t index = written; index > first; index--) {
+        size_t slot = (index - 1) & (PROFILE_TRACK_EVENTS - 1);
+        int64_t start = track.starts[slot].load(std::memory_order_relaxed);
+        int64_t end = track.ends[slot].load(std::memory_order_relaxed);
+        if (start < since) break;
+        events.push_back({(ProfileZone)(end & ((1 << ZONE_BITS) - 1)), start, end >> ZONE_BITS});
+    }
+
+    // Slots the writer reused while they were copied hold newer events; drop them,
+    // and the slot it may be writing right now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    size_t rewritten = track.written.load(std::memory_order_relaxed) - written + 1;
+    size_t lost = std::min(events.size(), rewritten > PROFILE_TRACK_EVENTS - events.size()
+                                              ? rewritten - (PROFILE_TRACK_EVENTS - events.size()) : 0);
+    events.resize(events.size() - lost);
+    std::reverse(events.begin(), events.end());
+    return events;
+}
+
+ProfileSummary Profiler::Summarize(double windowSeconds) const {
+    ProfileSummary summary;
+    summary.windowSeconds = windowSeconds;
+    int64_t window = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(windowSeconds)).count();
+    int64_t since = Ticks(Clock::now()) - window;
+
+    std::vector<double> durations[ZONE_COUNT];
+    std::vector<double> intervals;
+    for (int thread = 0; thread < PROFILE_THREAD_COUNT; thread++) {
+        std::vector<Event> events = CopyTrack(*tracks[thread], since);
+        int64_t previousFrame = -1;
+        for (const Event& event : events) {
+            durations[event.zone].push_back(TicksToMilliseconds(event.end - event.start));
+            if (event.zone == ZONE_FRAME) {
+                if (previousFrame >= 0) intervals.push_back(TicksToMilliseconds(event.start - previousFrame));
+                previousFrame = event.start;
+            }
+        }
+    }
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        summary.zones[zone] = Percentiles(durations[zone]);
+    }
+    summary.frameIntervals = Percentiles(intervals);
+    return summary;
+}
+
+bool Profiler::WriteChromeTrace(const wchar_t* path) const {
+    FILE* out = CreateBinaryFile(path);
+    if (!out) return false;
+
+    // Complete ("X") events in microseconds, one trace thread per track
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (int thread = 0; thread < PROFILE_THREAD_COUNT; thread++) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", thread + 1, threadNames[thread]);
+        first = false;
+
+        for (const Event& event : CopyTrack(*tracks[thread], 0)) {
+            char name[32];
+            const wchar_t* wide = zoneNames[event.zone];
+            size_t i = 0;
+            for (; wide[i] && i + 1 < sizeof(name); i++) name[i] = (char)wide[i];
+            name[i] = 0;
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                    name, threadNames[thread], TicksToMilliseconds(event.start) * 1000.0,
+                    TicksToMilliseconds(event.end - event.start) * 1000.0, thread + 1);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
@@ -0,0 +1,141 @@
+// Tennis Ball Physics Simulator - frame and physics instrumentation
+// Scoped timers around the hot paths of the application (physics ticks and steps,
+// court rendering, the combined graph, present, the RIGHTY dialog). Each thread
+// records into its own fixed ring of timed zones, so recording never locks or
+// allocates. The rings feed the on-screen overlay's percentiles and rates and can be
+// written out as a Chrome trace (chrome://tracing, Perfetto) for a timeline view.
+//
+// Probes cost one relaxed load and a branch while profiling is switched off, and
+// building with TENNIS_PROFILING=0 compiles them out entirely.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifndef TENNIS_PROFILING
+#define TENNIS_PROFILING 1
+#endif
+
+enum ProfileZone {
+    ZONE_FRAME,             // UI thread: one Render call
+    ZONE_RENDER_ALL_COURTS,
+    ZONE_RENDER_COURT,
+    ZONE_COMBINED_GRAPH,
+    ZONE_PRESENT,           // EndDraw, including the wait for the swap chain
+    ZONE_RIGHTY_DIALOG,     // UI thread showing the hit dialog; the simulation waits meanwhile
+    ZONE_PHYSICS_TICK,      // Simulation thread: input, stepping and snapshot of one tick
+    ZONE_PHYSICS_STEP,      // Fixed physics steps of every court: one, or a tick's worth stepped in parallel
+    ZONE_SNAPSHOT,          // Publishing the render snapshot
+    ZONE_COUNT
+};
+
+// Threads with a track of their own
+enum ProfileThread {
+    PROFILE_THREAD_UI,
+    PROFILE_THREAD_SIMULATION,
+    PROFILE_THREAD_COUNT
+};
+
+// Zones kept per thread; at a few thousand physics steps a second the simulation
+// track covers the last several seconds
+const size_t PROFILE_TRACK_EVENTS = 1 << 16;
+
+const wchar_t* ProfileZoneName(ProfileZone zone);
+
+// Percentiles of one zone over a time window, in milliseconds
+struct ZoneStats {
+    size_t count;
+    double p50;
+    double p99;
+    double max;
+};
+
+struct ProfileSummary {
+    double windowSeconds;
+    ZoneStats zones[ZONE_COUNT];
+    ZoneStats frameIntervals; // Between the starts of consecutive frames
+};
+
+class Profiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static Profiler& Instance();
+
+    // Probes record only while enabled
+    static bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    // Binds the calling thread to a track; probes on unbound threads record nothing
+    void BindThread(ProfileThread thread);
+
+    // Appends a finished zone to the calling thread's track
+    void Record(ProfileZone zone, Clock::time_point start, Clock::time_point end);
+
+    // Zones of every track that started within the last windowSeconds. Safe to call
+    // from any thread while the tracks are being written.
+    ProfileSummary Summarize(double windowSeconds) const;
+
+    // Every zone still held by the tracks as a Chrome trace event file
+    bool WriteChromeTrace(const wchar_t* path) const;
+
+private:
+    // Single-writer ring. A slot is two relaxed atomics so readers racing the writer
+    // see whole values; events the writer lapped during a read are dropped by index.
+    struct Track {
+        std::atomic<int64_t> starts[PROFILE_TRACK_EVENTS]; // Clock ticks since origin
+        std::atomic<int64_t> ends[PROFILE_TRACK_EVENTS];   // ticks << 8 | zone
+        std::atomic<size_t> written;
+        Track();
+    };
+
+    struct Event {
+        ProfileZone zone;
+        int64_t start;
+        int64_t end;
+    };
+
+    Profiler();
+
+    // Events of a track that started at or after since (ticks), oldest first
+    std::vector<Event> CopyTrack(const Track& track, int64_t since) const;
+    int64_t Ticks(Clock::time_point time) const { return (time - origin).count(); }
+
+    static std::atomic<bool> enabled;
+    static thread_local Track* boundTrack;
+    Clock::time_point origin;
+    std::unique_ptr<Track> tracks[PROFILE_THREAD_COUNT];
+};
+
+// Times the enclosing scope as zone on the calling thread's track
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileZone zone) : zone(zone), active(Profiler::Enabled()) {
+        if (active) start = Profiler::Clock::now();
+    }
+    ~ProfileScope() {
+        if (active) Profiler::Instance().Record(zone, start, Profiler::Clock::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileZone zone;
+    bool active;
+    Profiler::Clock::time_point start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if TENNIS_PROFILING
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+#else
+#define PROFILE_SCOPE(zone) ((void)0)
+#endif
@@ -0,0 +1,505 @@
+// Tennis Ball Physics Simulator - streaming result export
+
+#include "ResultExport.h"
+#include "FileMapping.h"
+
+#include <cstring>
+
+namespace {
+    // Parquet physical types used by the export schema
+    enum ParquetType {
+        PARQUET_BOOLEAN = 0,
+        PARQUET_INT32 = 1,
+        PARQUET_INT64 = 2,
+        PARQUET_FLOAT = 4,
+        PARQUET_BYTE_ARRAY = 6
+    };
+
+    struct ExportColumn {
+        const char* name;
+        ParquetType type;
+    };
+
+    // Columns of both formats, in file order
+    const ExportColumn exportColumns[] = {
+        {"shot_id", PARQUET_INT64},
+        {"force_n", PARQUET_FLOAT},
+        {"angle_deg", PARQUET_FLOAT},
+        {"spin_rpm", PARQUET_FLOAT},
+        {"surface", PARQUET_BYTE_ARRAY},
+        {"air_mode", PARQUET_BYTE_ARRAY},
+        {"first_bounce_x_m", PARQUET_FLOAT},
+        {"first_bounce_time_s", PARQUET_FLOAT},
+        {"net_hit", PARQUET_BOOLEAN},
+        {"time_to_rest_s", PARQUET_FLOAT},
+        {"bounce_count", PARQUET_INT32},
+        {"final_x_m", PARQUET_FLOAT},
+        {"left_court", PARQUET_BOOLEAN},
+        {"steps", PARQUET_INT32}
+    };
+
+    const size_t EXPORT_COLUMN_COUNT = sizeof(exportColumns) / sizeof(exportColumns[0]);
+
+    void AppendBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    // PLAIN encoding of one column: little-endian values, booleans packed LSB first,
+    // byte arrays as a 4-byte length and the bytes
+    void EncodePlainColumn(size_t column, const std::vector<ShotRow>& rows, std::vector<uint8_t>& out) {
+        out.clear();
+        if (exportColumns[column].type == PARQUET_BOOLEAN) {
+            out.assign((rows.size() + 7) / 8, 0);
+            for (size_t i = 0; i < rows.size(); i++) {
+                bool value = column == 8 ? rows[i].result.hitNet : rows[i].result.leftCourt; // net_hit or left_court
+                if (value) out[i / 8] |= (uint8_t)(1 << (i % 8));
+            }
+            return;
+        }
+
+        for (const ShotRow& row : rows) {
+            const ShotParams& shot = row.params;
+            const ShotResult& result = row.result;
+            switch (column) {
+                case 0: AppendBytes(out, &row.shotId, 8); break;
+                case 1: AppendBytes(out, &shot.force, 4); break;
+                case 2: AppendBytes(out, &shot.angle, 4); break;
+                case 3: AppendBytes(out, &shot.spin, 4); break;
+                case 4:
+                case 5: {
+                    const char* key = column == 4 ? courts[shot.surfaceIndex].key : airModes[shot.airMode].key;
+                    uint32_t length = (uint32_t)strlen(key);
+                    AppendBytes(out, &length, 4);
+                    AppendBytes(out, key, length);
+                    break;
+                }
+                case 6: AppendBytes(out, &result.firstBounceX, 4); break;
+                case 7: AppendBytes(out, &result.firstBounceTime, 4); break;
+                case 9: AppendBytes(out, &result.timeToRest, 4); break;
+                case 10: AppendBytes(out, &result.bounceCount, 4); break;
+                case 11: AppendBytes(out, &result.finalX, 4); break;
+                default: AppendBytes(out, &result.steps, 4); break;
+            }
+        }
+    }
+
+    // Thrift compact protocol, the encoding of Parquet page headers and the footer
+    class CompactWriter {
+    public:
+        enum FieldType {
+            COMPACT_I32 = 5,
+            COMPACT_I64 = 6,
+            COMPACT_BINARY = 8,
+            COMPACT_LIST = 9,
+            COMPACT_STRUCT = 12
+        };
+
+        std::vector<uint8_t> bytes;
+
+        // Top-level structs and list elements; fields use Struct()
+        void BeginStruct() { lastFieldIds.push_back(0); }
+        void EndStruct() {
+            bytes.push_back(0); // Stop field
+            lastFieldIds.pop_back();
+        }
+
+        void I32(int16_t id, int32_t value) {
+            FieldHeader(id, COMPACT_I32);
+            I32Value(value);
+        }
+        void I64(int16_t id, int64_t value) {
+            FieldHeader(id, COMPACT_I64);
+            VarInt(ZigZag(value));
+        }
+        void String(int16_t id, const char* value) {
+            FieldHeader(id, COMPACT_BINARY);
+            StringValue(value);
+        }
+        void Struct(int16_t id) {
+            FieldHeader(id, COMPACT_STRUCT);
+            BeginStruct();
+        }
+        void List(int16_t id, FieldType elementType, size_t size) {
+            FieldHeader(id, COMPACT_LIST);
+            if (size < 15) {
+                bytes.push_back((uint8_t)(size << 4 | elementType));
+            } else {
+                bytes.push_back((uint8_t)(0xF0 | elementType));
+                VarInt(size);
+            }
+        }
+
+        void I32Value(int32_t value) { VarInt(ZigZag(value)); }
+        void StringValue(const char* value) {
+            size_t length = strlen(value);
+            VarInt(length);
+            AppendBytes(bytes, value, length);
+        }
+
+    private:
+        std::vector<int16_t> lastFieldIds; // Per open struct, for field id deltas
+
+        static uint64_t ZigZag(int64_t value) {
+            return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+        }
+
+        void VarInt(uint64_t value) {
+            while (value >= 0x80) {
+                bytes.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back((uint8_t)value);
+        }
+
+        void FieldHeader(int16_t id, FieldType type) {
+            int delta = id - lastFieldIds.back();
+            if (delta > 0 && delta <= 15) {
+                bytes.push_back((uint8_t)(delta << 4 | type));
+            } else {
+                bytes.push_back((uint8_t)type);
+                VarInt(ZigZag(id));
+            }
+            lastFieldIds.back() = id;
+        }
+    };
+
+    // Thrift enum values of parquet.thrift
+    const int32_t PAGE_TYPE_DATA_PAGE = 0;
+    const int32_t ENCODING_PLAIN = 0;
+    const int32_t ENCODING_RLE = 3;
+    const int32_t REPETITION_REQUIRED = 0;
+    const int32_t CONVERTED_TYPE_UTF8 = 0;
+    const int32_t CODEC_UNCOMPRESSED = 0;
+
+    const char BINARY_RESULT_MAGIC[4] = {'T', 'B', 'R', 'S'};
+    const uint32_t BINARY_RESULT_VERSION = 1;
+}
+
+CsvResultSink::CsvResultSink(FILE* out) : out(out), failed(false) {
+    for (size_t column = 0; column < EXPORT_COLUMN_COUNT; column++) {
+        if (fprintf(out, column ? ",%s" : "%s", exportColumns[column].name) < 0) failed = true;
+    }
+    if (fputc('\n', out) == EOF) failed = true;
+}
+
+bool CsvResultSink::WriteRows(const ShotRow* rows, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const ShotParams& shot = rows[i].params;
+        const ShotResult& result = rows[i].result;
+        int written = fprintf(out, "%llu,%.1f,%.2f,%.0f,%s,%s,%.3f,%.4f,%d,%.4f,%d,%.3f,%d,%d\n",
+                              (unsigned long long)rows[i].shotId, shot.force, shot.angle, shot.spin,
+                              courts[shot.surfaceIndex].key, airModes[shot.airMode].key,
+                              result.firstBounceX, result.firstBounceTime, result.hitNet ? 1 : 0,
+                              result.timeToRest, result.bounceCount, result.finalX, result.leftCourt ? 1 : 0,
+                              result.steps);
+        if (written < 0) failed = true;
+    }
+    return !failed;
+}
+
+bool CsvResultSink::Finish() {
+    if (fflush(out) != 0) failed = true;
+    return !failed;
+}
+
+ParquetResultSink::ParquetResultSink(FILE* out, size_t rowGroupRows)
+    : out(out), rowGroupRows(rowGroupRows ? rowGroupRows : PARQUET_ROW_GROUP_ROWS), offset(0), failed(false) {
+    Write("PAR1", 4);
+    buffered.reserve(this->rowGroupRows);
+}
+
+bool ParquetResultSink::Write(const void* data, size_t size) {
+    if (fwrite(data, 1, size, out) != size) failed = true;
+    offset += size;
+    return !failed;
+}
+
+bool ParquetResultSink::WriteRows(const ShotRow* rows, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        buffered.push_back(rows[i]);
+        if (buffered.size() == rowGroupRows) FlushRowGroup();
+    }
+    return !failed;
+}
+
+bool ParquetResultSink::FlushRowGroup() {
+    if (buffered.empty()) return !failed;
+
+    RowGroupInfo group;
+    group.rowCount = buffered.size();
+    std::vector<uint8_t> page;
+    for (size_t column = 0; column < EXPORT_COLUMN_COUNT; column++) {
+        EncodePlainColumn(column, buffered, page);
+
+        // Required columns carry no repetition or definition levels, so the page is just the values
+        CompactWriter header;
+        header.BeginStruct();
+        header.I32(1, PAGE_TYPE_DATA_PAGE);
+        header.I32(2, (int32_t)page.size()); // Uncompressed size
+        header.I32(3, (int32_t)page.size()); // Compressed size
+        header.Struct(5);                    // DataPageHeader
+        header.I32(1, (int32_t)buffered.size());
+        header.I32(2, ENCODING_PLAIN);
+        header.I32(3, ENCODING_RLE);
+        header.I32(4, ENCODING_RLE);
+        header.EndStruct();
+        header.EndStruct();
+
+        ColumnChunkInfo chunk;
+        chunk.pageOffset = offset;
+        chunk.byteCount = header.bytes.size() + page.size();
+        group.columns.push_back(chunk);
+        Write(header.bytes.data(), header.bytes.size());
+        Write(page.data(), page.size());
+    }
+    rowGroups.push_back(group);
+    buffered.clear();
+    return !failed;
+}
+
+bool ParquetResultSink::Finish() {
+    FlushRowGroup();
+
+    uint64_t totalRows = 0;
+    for (const RowGroupInfo& group : rowGroups) {
+        totalRows += group.rowCount;
+    }
+
+    CompactWriter footer;
+    footer.BeginStruct(); // FileMetaData
+    footer.I32(1, 1);     // Format version
+    footer.List(2, CompactWriter::COMPACT_STRUCT, EXPORT_COLUMN_COUNT + 1);
+    footer.BeginStruct(); // Schema root
+    footer.String(4, "schema");
+    footer.I32(5, (int32_t)EXPORT_COLUMN_COUNT);
+    footer.EndStruct();
+    for (const ExportColumn& column : exportColumns) {
+        footer.BeginStruct();
+        footer.I32(1, column.type);
+        footer.I32(3, REPETITION_REQUIRED);
+        footer.String(4, column.name);
+        if (column.type == PARQUET_BYTE_ARRAY) footer.I32(6, CONVERTED_TYPE_UTF8);
+        footer.EndStruct();
+    }
+    footer.I64(3, (int64_t)totalRows);
+
+    footer.List(4, CompactWriter::COMPACT_STRUCT, rowGroups.size());
+    for (const RowGroupInfo& group : rowGroups) {
+        uint64_t groupBytes = 0;
+        footer.BeginStruct(); // RowGroup
+        footer.List(1, CompactWriter::COMPACT_STRUCT, EXPORT_COLUMN_COUNT);
+        for (size_t column = 0; column < EXPORT_COLUMN_COUNT; column++) {
+            const ColumnChunkInfo& chunk = group.columns[column];
+            groupBytes += chunk.byteCount;
+            footer.BeginStruct(); // ColumnChunk
+            footer.I64(2, (int64_t)chunk.pageOffset);
+            footer.Struct(3);     // ColumnMetaData
+            footer.I32(1, exportColumns[column].type);
+            footer.List(2, CompactWriter::COMPACT_I32, 2);
+            footer.I32Value(ENCODING_PLAIN);
+            footer.I32Value(ENCODING_RLE);
+            footer.List(3, CompactWriter::COMPACT_BINARY, 1);
+            footer.StringValue(exportColumns[column].name);
+            footer.I32(4, CODEC_UNCOMPRESSED);
+            footer.I64(5, (int64_t)group.rowCount);
+            footer.I64(6, (int64_t)chunk.byteCount);
+            footer.I64(7, (int64_t)chunk.byteCount);
+            footer.I64(9, (int64_t)chunk.pageOffset);
+            footer.EndStruct();
+            footer.EndStruct();
+        }
+        footer.I64(2, (int64_t)groupBytes);
+        footer.I64(3, (int64_t)group.rowCount);
+        footer.EndStruct();
+    }
+    footer.String(6, "Tennis Ball Physics Simulator");
+    footer.EndStruct();
+
+    uint32_t footerLength = (uint32_t)footer.bytes.size();
+    Write(footer.bytes.data(), footer.bytes.size());
+    Write(&footerLength, 4);
+    Write("PAR1", 4);
+    if (fflush(out) != 0) failed = true;
+    return !failed;
+}
+
+BinaryResultSink::BinaryResultSink(FILE* out, uint64_t datasetId, bool append) : out(out), failed(false) {
+    if (append) return;
+    uint8_t header[BINARY_RESULT_HEADER_BYTES] = {};
+    uint32_t fields[3] = {BINARY_RESULT_VERSION, (uint32_t)sizeof(BinaryResultRecord), 0};
+    memcpy(header, BINARY_RESULT_MAGIC, 4);
+    memcpy(header + 4, fields, sizeof(fields));
+    memcpy(header + 16, &datasetId, 8);
+    if (fwrite(header, 1, sizeof(header), out) != sizeof(header)) failed = true;
+}
+
+bool BinaryResultSink::WriteRows(const ShotRow* rows, size_t count) {
+    // Rows go out whole with one fwrite per batch; nothing stays buffered here
+    records.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const ShotParams& shot = rows[i].params;
+        const ShotResult& result = rows[i].result;
+        BinaryResultRecord& record = records[i];
+        record.shotId = rows[i].shotId;
+        record.randomStream = shot.randomStream;
+        record.force = shot.force;
+        record.angle = shot.angle;
+        record.spin = shot.spin;
+        record.surfaceIndex = shot.surfaceIndex;
+        record.airMode = shot.airMode;
+        record.firstBounceX = result.firstBounceX;
+        record.firstBounceTime = result.firstBounceTime;
+        record.finalX = result.finalX;
+        record.timeToRest = result.timeToRest;
+        record.bounceCount = result.bounceCount;
+        record.steps = result.steps;
+        record.hitNet = result.hitNet ? 1 : 0;
+        record.leftCourt = result.leftCourt ? 1 : 0;
+        record.reserved[0] = record.reserved[1] = 0;
+    }
+    if (count && fwrite(records.data(), sizeof(BinaryResultRecord), count, out) != count) failed = true;
+    return !failed;
+}
+
+bool BinaryResultSink::Finish() {
+    if (fflush(out) != 0) failed = true;
+    return !failed;
+}
+
+BinaryResultReader::BinaryResultReader() : data(nullptr), size(0), datasetId(0), rowCount(0) {}
+
+BinaryResultReader::~BinaryResultReader() {
+    Close();
+}
+
+bool BinaryResultReader::Open(const wchar_t* path) {
+    Close();
+    data = MapFileReadOnly(path, size);
+    if (!data) return false;
+
+    uint32_t fields[3];
+    if (size < BINARY_RESULT_HEADER_BYTES || memcmp(data, BINARY_RESULT_MAGIC, 4) != 0) {
+        Close();
+        return false;
+    }
+    memcpy(fields, data + 4, sizeof(fields));
+    if (fields[0] != BINARY_RESULT_VERSION || fields[1] != sizeof(BinaryResultRecord)) {
+        Close();
+        return false;
+    }
+    memcpy(&datasetId, data + 16, 8);
+    rowCount = (size - BINARY_RESULT_HEADER_BYTES) / sizeof(BinaryResultRecord);
+    return true;
+}
+
+void BinaryResultReader::Close() {
+    if (data) UnmapFile(data, size);
+    data = nullptr;
+    size = 0;
+    datasetId = rowCount = 0;
+}
+
+ShotRow BinaryResultReader::Row(uint64_t index) const {
+    BinaryResultRecord record;
+    memcpy(&record, data + BINARY_RESULT_HEADER_BYTES + index * sizeof(BinaryResultRecord), sizeof(record));
+    ShotRow row;
+    row.shotId = record.shotId;
+    row.params.force = record.force;
+    row.params.angle = record.angle;
+    row.params.spin = record.spin;
+    row.params.surfaceIndex = record.surfaceIndex;
+    row.params.airMode = (AirResistanceMode)record.airMode;
+    row.params.randomStream = record.randomStream;
+    row.result.firstBounceX = record.firstBounceX;
+    row.result.firstBounceTime = record.firstBounceTime;
+    row.result.finalX = record.finalX;
+    row.result.timeToRest = record.timeToRest;
+    row.result.bounceCount = record.bounceCount;
+    row.result.steps = record.steps;
+    row.result.hitNet = record.hitNet != 0;
+    row.result.leftCourt = record.leftCourt != 0;
+    return row;
+}
+
+std::unique_ptr<ResultSink> CreateResultSink(ResultFormat format, FILE* out) {
+    if (format == RESULT_FORMAT_PARQUET) return std::make_unique<ParquetResultSink>(out);
+    if (format == RESULT_FORMAT_BINARY) return std::make_unique<BinaryResultSink>(out, 0);
+    return std::make_unique<CsvResultSink>(out);
+}
+
+const wchar_t* ResultFormatExtension(ResultFormat format) {
+    if (format == RESULT_FORMAT_PARQUET) return L".parquet";
+    if (format == RESULT_FORMAT_BINARY) return L".tbr";
+    return L".csv";
+}
+
+ResultExporter::ResultExporter(ResultSink& sink, size_t queueBatches)
+    : sink(sink), queueBatches(queueBatches ? queueBatches : 1), rowsWritten(0), finishing(false), finished(false),
+      failed(false) {
+    exportThread = std::thread(&ResultExporter::ExportLoop, this);
+}
+
+ResultExporter::~ResultExporter() {
+    Finish();
+}
+
+void ResultExporter::Submit(std::vector<ShotRow>&& rows) {
+    if (rows.empty()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    batchTaken.wait(lock, [this]() { return queue.size() < queueBatches || finishing; });
+    if (finishing) return; // Submitted after Finish: dropped
+    queue.push_back(std::move(rows));
+    batchReady.notify_one();
+}
+
+void ResultExporter::Submit(const ShotParams* params, const ShotResult* results, size_t count, uint64_t firstShotId) {
+    std::vector<ShotRow> rows(count);
+    for (size_t i = 0; i < count; i++) {
+        rows[i].shotId = firstShotId + i;
+        rows[i].params = params[i];
+        rows[i].result = results[i];
+    }
+    Submit(std::move(rows));
+}
+
+bool ResultExporter::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished) return !failed;
+        finishing = true;
+    }
+    batchReady.notify_one();
+    batchTaken.notify_all();
+    exportThread.join();
+
+    bool ok = sink.Finish();
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    if (!ok) failed = true;
+    return !failed;
+}
+
+uint64_t ResultExporter::RowsWritten() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rowsWritten;
+}
+
+void ResultExporter::ExportLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        batchReady.wait(lock, [this]() { return !queue.empty() || finishing; });
+        if (queue.empty()) break;
+
+        std::vector<ShotRow> rows = std::move(queue.front());
+        queue.pop_front();
+        batchTaken.notify_all();
+        lock.unlock();
+
+        bool ok = sink.WriteRows(rows.data(), rows.size());
+
+        lock.lock();
+        if (!ok) failed = true;
+        rowsWritten += rows.size();
+    }
+}
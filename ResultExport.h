@@ -0,0 +1,206 @@
+// Tennis Ball Physics Simulator - streaming result export
+// Per-shot summaries of sweeps and batch runs written as CSV or Apache Parquet
+// while the simulation is still running. Simulation threads hand finished batches
+// of rows to a bounded queue; one exporter thread formats them and writes the file.
+
+#pragma once
+
+#include "SimulationEngine.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One exported row: a shot's launch parameters and its outcome
+struct ShotRow {
+    uint64_t shotId; // e.g. the sweep grid index; rows arrive in completion order, not by id
+    ShotParams params;
+    ShotResult result;
+};
+
+// Destination of exported rows. Only the exporter thread calls it.
+class ResultSink {
+public:
+    virtual ~ResultSink() {}
+
+    virtual bool WriteRows(const ShotRow* rows, size_t count) = 0;
+
+    // Writes anything still buffered (and the footer of formats that have one);
+    // the caller closes the file afterwards
+    virtual bool Finish() = 0;
+};
+
+// Comma separated table with a header row, one line per shot
+class CsvResultSink : public ResultSink {
+public:
+    explicit CsvResultSink(FILE* out);
+
+    bool WriteRows(const ShotRow* rows, size_t count) override;
+    bool Finish() override;
+
+private:
+    FILE* out;
+    bool failed;
+};
+
+// Rows per Parquet row group; each column of a group is one PLAIN encoded data page
+const size_t PARQUET_ROW_GROUP_ROWS = 65536;
+
+// Apache Parquet file: flat schema of required columns, PLAIN encoding, no compression.
+// Rows are buffered until a row group is full; Finish writes the last group and the
+// footer (Thrift compact FileMetaData), without which the file is not readable.
+class ParquetResultSink : public ResultSink {
+public:
+    explicit ParquetResultSink(FILE* out, size_t rowGroupRows = PARQUET_ROW_GROUP_ROWS);
+
+    bool WriteRows(const ShotRow* rows, size_t count) override;
+    bool Finish() override;
+
+private:
+    // Column chunk already in the file, kept for the footer
+    struct ColumnChunkInfo {
+        uint64_t pageOffset;
+        uint64_t byteCount; // Page header and page
+    };
+
+    struct RowGroupInfo {
+        uint64_t rowCount;
+        std::vector<ColumnChunkInfo> columns;
+    };
+
+    FILE* out;
+    size_t rowGroupRows;
+    uint64_t offset; // Bytes written so far
+    bool failed;
+    std::vector<ShotRow> buffered;
+    std::vector<RowGroupInfo> rowGroups;
+
+    bool Write(const void* data, size_t size);
+    bool FlushRowGroup();
+};
+
+// Fixed-size little-endian record of one row in a binary result file
+struct BinaryResultRecord {
+    uint64_t shotId;
+    uint64_t randomStream;
+    float force;
+    float angle;
+    float spin;
+    int32_t surfaceIndex;
+    int32_t airMode;
+    float firstBounceX;
+    float firstBounceTime;
+    float finalX;
+    float timeToRest;
+    int32_t bounceCount;
+    int32_t steps;
+    uint8_t hitNet;
+    uint8_t leftCourt;
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(BinaryResultRecord) == 64, "binary result records are 64 bytes");
+
+// Magic "TBRS", version, record size, reserved, then the 64-bit dataset id
+const size_t BINARY_RESULT_HEADER_BYTES = 24;
+
+// Binary result file: a header and one BinaryResultRecord per row, with no footer.
+// Every whole record is valid however the writer stopped, so a file can be cut back
+// to any row count and appended to, which resumable runs rely on. The dataset id is
+// the writer's choice (e.g. a hash of the run's parameters) and lets readers check
+// that files belong together.
+class BinaryResultSink : public ResultSink {
+public:
+    // append: out already holds a header and rows, new rows follow them
+    BinaryResultSink(FILE* out, uint64_t datasetId, bool append = false);
+
+    bool WriteRows(const ShotRow* rows, size_t count) override;
+    bool Finish() override;
+
+private:
+    FILE* out;
+    bool failed;
+    std::vector<BinaryResultRecord> records; // Encoding buffer
+};
+
+// Read-only view of a binary result file through a memory mapping. A partly written
+// last record is not counted.
+class BinaryResultReader {
+public:
+    BinaryResultReader();
+    ~BinaryResultReader();
+
+    BinaryResultReader(const BinaryResultReader&) = delete;
+    BinaryResultReader& operator=(const BinaryResultReader&) = delete;
+
+    // Maps path and validates its header
+    bool Open(const wchar_t* path);
+    void Close();
+    bool IsOpen() const { return data != nullptr; }
+
+    uint64_t DatasetId() const { return datasetId; }
+    uint64_t RowCount() const { return rowCount; }
+    ShotRow Row(uint64_t index) const;
+
+private:
+    const uint8_t* data; // Whole file, mapped read-only
+    size_t size;
+    uint64_t datasetId;
+    uint64_t rowCount;
+};
+
+enum ResultFormat {
+    RESULT_FORMAT_CSV,
+    RESULT_FORMAT_PARQUET,
+    RESULT_FORMAT_BINARY  // BinaryResultSink with dataset id 0
+};
+
+std::unique_ptr<ResultSink> CreateResultSink(ResultFormat format, FILE* out);
+
+// File name extension of a format, with the dot
+const wchar_t* ResultFormatExtension(ResultFormat format);
+
+// Batches allowed to wait for the exporter thread before Submit blocks
+const size_t RESULT_QUEUE_BATCHES = 64;
+
+// Feeds a sink from a background thread. Submit only moves a batch into the queue;
+// simulation threads wait only when the queue already holds queueBatches batches,
+// i.e. when the disk has fallen that far behind. Submit is thread safe.
+class ResultExporter {
+public:
+    explicit ResultExporter(ResultSink& sink, size_t queueBatches = RESULT_QUEUE_BATCHES);
+    ~ResultExporter(); // Finishes if Finish was not called
+
+    ResultExporter(const ResultExporter&) = delete;
+    ResultExporter& operator=(const ResultExporter&) = delete;
+
+    void Submit(std::vector<ShotRow>&& rows);
+    // Rows of a RunBatch call; shot ids count up from firstShotId
+    void Submit(const ShotParams* params, const ShotResult* results, size_t count, uint64_t firstShotId);
+
+    // Drains the queue, finishes the sink and stops the thread; false if any write failed
+    bool Finish();
+
+    uint64_t RowsWritten();
+
+private:
+    ResultSink& sink;
+    size_t queueBatches;
+    std::thread exportThread;
+    std::mutex mutex;
+    std::condition_variable batchReady;
+    std::condition_variable batchTaken;
+    std::deque<std::vector<ShotRow>> queue;
+    uint64_t rowsWritten;
+    bool finishing;
+    bool finished;
+    bool failed;
+
+    void ExportLoop();
+};
@@ -0,0 +1,74 @@
+// Tennis Ball Physics Simulator - RIGHTY return hits
+
+#include "ReturnHitPolicy.h"
+
+#include <cmath>
+
+bool FixedReturnPolicy::ChooseReturn(const TennisBall&, LaunchPattern, float, AirResistanceMode, ReturnHit& hit) {
+    hit = this->hit;
+    return true;
+}
+
+PatternReturnPolicy::PatternReturnPolicy() {
+    table[PATTERN_RANDOM] = DEFAULT_RETURN_HIT;
+    for (int p = 1; p < 8; p++) {
+        table[p] = {launchPatterns[p].force, launchPatterns[p].angle, launchPatterns[p].spin};
+    }
+}
+
+PatternReturnPolicy::PatternReturnPolicy(const ReturnHit (&table)[8]) {
+    for (int p = 0; p < 8; p++) {
+        this->table[p] = table[p];
+    }
+}
+
+bool PatternReturnPolicy::ChooseReturn(const TennisBall&, LaunchPattern pattern, float, AirResistanceMode,
+                                       ReturnHit& hit) {
+    hit = table[pattern];
+    return true;
+}
+
+bool TargetReturnPolicy::ChooseReturn(const TennisBall& ball, LaunchPattern, float rightyX, AirResistanceMode airMode,
+                                      ReturnHit& hit) {
+    ShotTarget target = ReturnTarget(landingX, SOLVE_FORCE, 0.0f, shape.angle, shape.spin, airMode, rightyX, ball.y);
+    ShotSolution solution = solver.Solve(target);
+    hit = {solution.force, shape.angle, shape.spin};
+    return true;
+}
+
+bool CallbackReturnPolicy::ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX,
+                                        AirResistanceMode airMode, ReturnHit& hit) {
+    return callback && callback(ball, pattern, rightyX, airMode, hit);
+}
+
+std::unique_ptr<ReturnHitPolicy> CreateReturnPolicy(ReturnPolicyType type, const ReturnHit& fixedHit) {
+    switch (type) {
+        case RETURN_POLICY_FIXED: return std::make_unique<FixedReturnPolicy>(fixedHit);
+        case RETURN_POLICY_PATTERN: return std::make_unique<PatternReturnPolicy>();
+        default: return nullptr;
+    }
+}
+
+void ApplyReturnHit(TennisBall& ball, const ReturnHit& hit, float rightyX) {
+    ApplyReturnHit(ball.x, ball.vx, ball.vy, ball.spinRPM, hit, rightyX);
+}
+
+void ApplyReturnHit(float& x, float& vx, float& vy, float& spinRPM, const ReturnHit& hit, float rightyX) {
+    // Force range 10-600N maps to velocity 5-30 m/s
+    float totalVelocity = (hit.force / 600.0f) * 30.0f;
+    if (totalVelocity < 5.0f) totalVelocity = 5.0f;
+
+    // Negative x velocity: RIGHTY hits back to the left
+    float angleRad = hit.angle * 3.14159265f / 180.0f;
+    vx = -totalVelocity * cosf(angleRad);
+    vy = totalVelocity * sinf(angleRad);
+    spinRPM = hit.spin;
+
+    // Start slightly away from RIGHTY to avoid re-collision
+    x = rightyX - RETURN_START_OFFSET;
+}
+
+void BounceOffRighty(TennisBall& ball, float rightyX) {
+    ball.vx = -ball.vx * 0.5f;
+    ball.x = rightyX - RETURN_START_OFFSET;
+}
@@ -0,0 +1,125 @@
+// Tennis Ball Physics Simulator - RIGHTY return hits
+// Decides how RIGHTY answers a ball that reaches it. Policies run inline in the
+// physics step, so scripted rallies play at full simulation speed with no UI round
+// trip; the interactive hit dialog is one more policy, supplied by the application.
+
+#pragma once
+
+#include "SimulationEngine.h"
+#include "ShotSolver.h"
+
+#include <functional>
+#include <memory>
+
+// RIGHTY's return shot, in the units of a LEFTY launch
+struct ReturnHit {
+    float force; // Newtons
+    float angle; // degrees above horizontal, back towards LEFTY
+    float spin;  // RPM
+};
+
+// Returns and rebounds leave this far in front of RIGHTY, clear of its reach
+const float RETURN_START_OFFSET = 0.1f; // meters
+
+// Initial values of the hit dialog, also the fixed policy's default
+const ReturnHit DEFAULT_RETURN_HIT = {300.0f, 30.0f, 120.0f};
+
+enum ReturnPolicyType {
+    RETURN_POLICY_DIALOG,   // Ask for every return with the modal hit dialog (application only)
+    RETURN_POLICY_FIXED,    // The same return every time
+    RETURN_POLICY_PATTERN,  // Looked up by the launch pattern of the incoming shot
+    RETURN_POLICY_TARGET,   // Solved for a landing spot on LEFTY's side
+    RETURN_POLICY_CALLBACK  // Any function of the incoming ball, for scripted rallies
+};
+
+class ReturnHitPolicy {
+public:
+    virtual ~ReturnHitPolicy() {}
+
+    virtual ReturnPolicyType Type() const = 0;
+    virtual const wchar_t* Name() const = 0;
+
+    // Chooses the return for ball, which has just reached RIGHTY at rightyX on a shot
+    // launched with pattern in airMode. Returns false to let the ball bounce off RIGHTY
+    // instead.
+    virtual bool ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                              ReturnHit& hit) = 0;
+};
+
+class FixedReturnPolicy : public ReturnHitPolicy {
+public:
+    explicit FixedReturnPolicy(const ReturnHit& hit = DEFAULT_RETURN_HIT) : hit(hit) {}
+
+    ReturnPolicyType Type() const override { return RETURN_POLICY_FIXED; }
+    const wchar_t* Name() const override { return L"Fixed"; }
+    bool ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                      ReturnHit& hit) override;
+
+private:
+    ReturnHit hit;
+};
+
+// Indexed by LaunchPattern. The default table answers each preset in kind (the
+// preset's own force, angle and spin) and PATTERN_RANDOM with DEFAULT_RETURN_HIT.
+class PatternReturnPolicy : public ReturnHitPolicy {
+public:
+    PatternReturnPolicy();
+    explicit PatternReturnPolicy(const ReturnHit (&table)[8]);
+
+    ReturnPolicyType Type() const override { return RETURN_POLICY_PATTERN; }
+    const wchar_t* Name() const override { return L"Pattern table"; }
+    bool ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                      ReturnHit& hit) override;
+
+private:
+    ReturnHit table[8];
+};
+
+// Plays shape's angle and spin at the force that lands the return on landingX,
+// solved for every incoming ball from RIGHTY's position at the ball's height; a
+// target out of reach gets the closest return found.
+class TargetReturnPolicy : public ReturnHitPolicy {
+public:
+    TargetReturnPolicy(float landingX, const ReturnHit& shape, const LandingTableConfig& stepping)
+        : landingX(landingX), shape(shape), solver(stepping) {}
+
+    ReturnPolicyType Type() const override { return RETURN_POLICY_TARGET; }
+    const wchar_t* Name() const override { return L"Target"; }
+    bool ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                      ReturnHit& hit) override;
+
+private:
+    float landingX;
+    ReturnHit shape;
+    ShotSolver solver;
+};
+
+class CallbackReturnPolicy : public ReturnHitPolicy {
+public:
+    typedef std::function<bool(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                               ReturnHit& hit)> Callback;
+
+    CallbackReturnPolicy(const wchar_t* name, Callback callback) : name(name), callback(std::move(callback)) {}
+
+    ReturnPolicyType Type() const override { return RETURN_POLICY_CALLBACK; }
+    const wchar_t* Name() const override { return name; }
+    bool ChooseReturn(const TennisBall& ball, LaunchPattern pattern, float rightyX, AirResistanceMode airMode,
+                      ReturnHit& hit) override;
+
+private:
+    const wchar_t* name;
+    Callback callback;
+};
+
+// Fixed and pattern policies; the dialog, target and callback policies need the
+// caller's context, so nullptr is returned for them
+std::unique_ptr<ReturnHitPolicy> CreateReturnPolicy(ReturnPolicyType type, const ReturnHit& fixedHit = DEFAULT_RETURN_HIT);
+
+// Sends ball back towards LEFTY from RIGHTY's position rightyX
+void ApplyReturnHit(TennisBall& ball, const ReturnHit& hit, float rightyX);
+
+// The same for a ball held field by field, such as a BallBatch lane
+void ApplyReturnHit(float& x, float& vx, float& vy, float& spinRPM, const ReturnHit& hit, float rightyX);
+
+// No return: the ball rebounds off RIGHTY at half speed
+void BounceOffRighty(TennisBall& ball, float rightyX);
@@ -0,0 +1,245 @@
+// Tennis Ball Physics Simulator - settings.ini parsed into a lookup table
+
+#include "SettingsFile.h"
+#include "FileMapping.h"
+#include "SimulationEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+    const uint32_t NO_SECTION = UINT32_MAX;
+
+    // Case-insensitive like the profile APIs, for ASCII names
+    int CompareNames(const char* a, const char* b) {
+        for (;; a++, b++) {
+            int ca = (*a >= 'A' && *a <= 'Z') ? *a + ('a' - 'A') : (unsigned char)*a;
+            int cb = (*b >= 'A' && *b <= 'Z') ? *b + ('a' - 'A') : (unsigned char)*b;
+            if (ca != cb || ca == 0) return ca - cb;
+        }
+    }
+
+    bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Narrows [begin, end) to its first and one past its last non-blank character
+    void Trim(const std::vector<char>& text, size_t& begin, size_t& end) {
+        while (begin < end && IsBlank(text[begin])) begin++;
+        while (end > begin && IsBlank(text[end - 1])) end--;
+    }
+}
+
+bool SettingsFile::Load(const wchar_t* path) {
+    bool read = ReadWholeFile(path, text);
+    if (!read) text.clear();
+    Index();
+    return read;
+}
+
+void SettingsFile::Parse(const char* source, size_t length) {
+    text.assign(source, source + length);
+    Index();
+}
+
+void SettingsFile::Index() {
+    entries.clear();
+    text.push_back('\0');
+    size_t length = text.size() - 1;
+
+    // A UTF-8 byte order mark is not part of the first line
+    size_t lineBegin = 0;
+    if (length >= 3 && (unsigned char)text[0] == 0xEF && (unsigned char)text[1] == 0xBB &&
+        (unsigned char)text[2] == 0xBF) {
+        lineBegin = 3;
+    }
+
+    // Line ends and the ends of names and values become NULs; the trailing NUL
+    // ends the last line
+    uint32_t section = NO_SECTION;
+    while (lineBegin < length) {
+        size_t lineEnd = lineBegin;
+        while (lineEnd < length && text[lineEnd] != '\n') lineEnd++;
+        size_t begin = lineBegin, end = lineEnd;
+        lineBegin = lineEnd + 1;
+
+        Trim(text, begin, end);
+        if (begin == end || text[begin] == ';') continue;
+
+        if (text[begin] == '[') {
+            size_t nameBegin = begin + 1, nameEnd = nameBegin;
+            while (nameEnd < end && text[nameEnd] != ']') nameEnd++;
+            Trim(text, nameBegin, nameEnd);
+            text[nameEnd] = '\0';
+            section = (uint32_t)nameBegin;
+            continue;
+        }
+
+        // Lines before the first section belong to none and are skipped, like lines without '='
+        size_t equals = begin;
+        while (equals < end && text[equals] != '=') equals++;
+        if (section == NO_SECTION || equals == end) continue;
+        size_t keyBegin = begin, keyEnd = equals;
+        size_t valueBegin = equals + 1, valueEnd = end;
+        Trim(text, keyBegin, keyEnd);
+        Trim(text, valueBegin, valueEnd);
+        if (keyBegin == keyEnd) continue;
+        text[keyEnd] = '\0';
+        text[valueEnd] = '\0';
+        entries.push_back({section, (uint32_t)keyBegin, (uint32_t)valueBegin});
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b) {
+        int order = CompareNames(&text[a.section], &text[b.section]);
+        return order != 0 ? order < 0 : CompareNames(&text[a.key], &text[b.key]) < 0;
+    });
+}
+
+const char* SettingsFile::Find(const char* section, const char* key) const {
+    auto before = [&](const Entry& entry) {
+        int order = CompareNames(&text[entry.section], section);
+        return order != 0 ? order < 0 : CompareNames(&text[entry.key], key) < 0;
+    };
+    auto found = std::partition_point(entries.begin(), entries.end(), before);
+    if (found == entries.end() || CompareNames(&text[found->section], section) != 0 ||
+        CompareNames(&text[found->key], key) != 0) {
+        return nullptr;
+    }
+    return &text[found->value];
+}
+
+unsigned SettingsFile::GetInt(const char* section, const char* key, int defaultValue) const {
+    const char* value = Find(section, key);
+    if (!value) return (unsigned)defaultValue;
+
+    bool negative = *value == '-';
+    if (*value == '-' || *value == '+') value++;
+    unsigned result = 0;
+    for (; *value >= '0' && *value <= '9'; value++) {
+        result = result * 10 + (unsigned)(*value - '0');
+    }
+    return negative ? 0u - result : result;
+}
+
+float SettingsFile::GetFloat(const char* section, const char* key, float defaultValue) const {
+    const char* value = Find(section, key);
+    if (!value) return defaultValue;
+    char* end;
+    float result = strtof(value, &end);
+    return end == value ? defaultValue : result;
+}
+
+void LoadEngineTables(const SettingsFile& settings) {
+    // Taken before the first override
+    static const std::vector<CourtSurface> builtInCourts(courts, courts + 4);
+    static const std::vector<AirResistanceData> builtInAirModes(airModes, airModes + 4);
+    static const std::vector<LaunchPatternData> builtInPatterns(launchPatterns, launchPatterns + 8);
+
+    char section[64];
+    for (size_t i = 0; i < builtInCourts.size(); i++) {
+        snprintf(section, sizeof(section), "Surface.%s", courts[i].key);
+        courts[i].coefficientOfRestitution = settings.GetFloat(section, "Restitution", builtInCourts[i].coefficientOfRestitution);
+        courts[i].friction = settings.GetFloat(section, "Friction", builtInCourts[i].friction);
+    }
+    for (size_t i = 0; i < builtInAirModes.size(); i++) {
+        snprintf(section, sizeof(section), "Air.%s", airModes[i].key);
+        airModes[i].coefficient = settings.GetFloat(section, "Coefficient", builtInAirModes[i].coefficient);
+    }
+    for (size_t i = 0; i < builtInPatterns.size(); i++) {
+        snprintf(section, sizeof(section), "Pattern.%s", launchPatterns[i].key);
+        launchPatterns[i].force = settings.GetFloat(section, "Force", builtInPatterns[i].force);
+        launchPatterns[i].angle = settings.GetFloat(section, "Angle", builtInPatterns[i].angle);
+        launchPatterns[i].spin = settings.GetFloat(section, "Spin", builtInPatterns[i].spin);
+    }
+}
+
+SettingsWatcher::SettingsWatcher() : writeTime(0), fileSize(0), changed(false) {
+#ifdef _WIN32
+    stopEvent = nullptr;
+    notification = nullptr;
+#else
+    stopping = false;
+#endif
+}
+
+SettingsWatcher::~SettingsWatcher() {
+    Stop();
+}
+
+bool SettingsWatcher::Start(const wchar_t* filePath) {
+    Stop();
+    path = filePath;
+    writeTime = fileSize = 0;
+    CheckFile();
+    changed = false;
+
+#ifdef _WIN32
+    size_t slash = path.find_last_of(L"\\/");
+    std::wstring directory = slash == std::wstring::npos ? L"." : path.substr(0, slash + 1);
+
+    // Saves by rename change file names, saves in place the write time and size
+    notification = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+    if (notification == INVALID_HANDLE_VALUE) return false;
+    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!stopEvent) {
+        FindCloseChangeNotification(notification);
+        return false;
+    }
+#else
+    stopping = false;
+#endif
+    thread = std::thread([this]() { Watch(); });
+    return true;
+}
+
+void SettingsWatcher::Stop() {
+    if (!thread.joinable()) return;
+#ifdef _WIN32
+    SetEvent(stopEvent);
+    thread.join();
+    FindCloseChangeNotification(notification);
+    CloseHandle(stopEvent);
+    stopEvent = nullptr;
+#else
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+#endif
+}
+
+void SettingsWatcher::Watch() {
+#ifdef _WIN32
+    HANDLE handles[2] = {stopEvent, notification};
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        CheckFile();
+        if (!FindNextChangeNotification(notification)) break;
+    }
+#else
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(500), [this]() { return stopping; })) {
+        CheckFile();
+    }
+#endif
+}
+
+void SettingsWatcher::CheckFile() {
+    uint64_t time = 0, size = 0;
+    GetFileStamp(path.c_str(), time, size);
+    if (time == writeTime && size == fileSize) return;
+    writeTime = time;
+    fileSize = size;
+    changed.store(true, std::memory_order_release);
+}
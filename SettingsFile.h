@@ -0,0 +1,103 @@
+// Tennis Ball Physics Simulator - settings.ini parsed into a lookup table
+// The whole file is read with one call and parsed once into a compact table: the
+// file's own bytes, cut in place into section, key and value strings, and one
+// sorted entry of offsets per key. Lookups are binary searches, so loading every
+// setting costs one file read instead of one GetPrivateProfileInt open per value.
+//
+// The syntax follows GetPrivateProfileString: [section] headers, key=value lines,
+// and comment lines starting with ';'. Section and key names compare without case,
+// whitespace around them and around values is ignored, and when a key repeats in a
+// section the first value counts. The file is read as ANSI/UTF-8 text.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SettingsFile {
+public:
+    // Replaces the table with the settings of path; false, leaving the table empty,
+    // when the file cannot be read
+    bool Load(const wchar_t* path);
+
+    // Replaces the table with the settings in text
+    void Parse(const char* text, size_t length);
+
+    // Value of key in section, or nullptr when there is none
+    const char* Find(const char* section, const char* key) const;
+
+    // GetPrivateProfileInt: the value's leading decimal integer (0 if it has none,
+    // negative values wrapping around), defaultValue when the key is missing
+    unsigned GetInt(const char* section, const char* key, int defaultValue) const;
+
+    // The value's leading decimal number, defaultValue when the key is missing or has none
+    float GetFloat(const char* section, const char* key, float defaultValue) const;
+
+    size_t Size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        uint32_t section; // Offsets of NUL-terminated strings in text
+        uint32_t key;
+        uint32_t value;
+    };
+
+    // Cuts text into strings and builds the sorted entries
+    void Index();
+
+    std::vector<char> text;
+    std::vector<Entry> entries; // Sorted by section, then key, then file order
+};
+
+// Overrides the engine's compiled-in tables from settings: Restitution and Friction
+// of [Surface.<key>] for courts[], Coefficient of [Air.<key>] for airModes[], and
+// Force, Angle and Spin of [Pattern.<key>] for launchPatterns[]. Values settings
+// leave out are the compiled-in ones, also when an earlier call had overridden them.
+// Nothing may read the tables meanwhile.
+void LoadEngineTables(const SettingsFile& settings);
+
+// Watches one file from a thread of its own, so the owner can poll for changes
+// without touching the file system. Windows directory change notifications wake
+// the thread; elsewhere it polls twice a second. A change is the file's write time
+// or size differing from the last one seen, which also catches editors that save
+// by replacing the file.
+class SettingsWatcher {
+public:
+    SettingsWatcher();
+    ~SettingsWatcher();
+
+    SettingsWatcher(const SettingsWatcher&) = delete;
+    SettingsWatcher& operator=(const SettingsWatcher&) = delete;
+
+    // Starts watching path, as it is now; false if the watch cannot be set up
+    bool Start(const wchar_t* path);
+    void Stop();
+
+    // True once for any number of changes since the previous call
+    bool TakeChange() { return changed.exchange(false, std::memory_order_acquire); }
+
+private:
+    void Watch();
+    // Raises changed when the file's write time or size moved on
+    void CheckFile();
+
+    std::wstring path;
+    uint64_t writeTime;          // Last seen by the watcher thread; 0 while the file is missing
+    uint64_t fileSize;
+    std::atomic<bool> changed;
+    std::thread thread;
+#ifdef _WIN32
+    void* stopEvent;             // Manual-reset event ending Watch
+    void* notification;          // Change notification on the file's directory
+#else
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+#endif
+};
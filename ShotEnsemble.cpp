@@ -0,0 +1,92 @@
+// Tennis Ball Physics Simulator - Monte Carlo shot ensembles
+
+#include "ShotEnsemble.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Noise of shot i comes from stream NOISE_STREAMS | i; the shot itself flies on stream i
+    const uint64_t NOISE_STREAMS = 1ull << 63;
+}
+
+ShotParams EnsembleShot(const EnsembleSpec& spec, uint64_t index) {
+    RandomStream noise(spec.seed, NOISE_STREAMS | index);
+    ShotParams shot = spec.center;
+    shot.force = std::max(MIN_HORIZONTAL_FORCE,
+                          std::min(MAX_HORIZONTAL_FORCE, shot.force + spec.forceSigma * noise.NextGaussian()));
+    shot.angle = std::max(MIN_ANGLE, std::min(MAX_ANGLE, shot.angle + spec.angleSigma * noise.NextGaussian()));
+    shot.spin += spec.spinSigma * noise.NextGaussian();
+    shot.randomStream = index;
+    return shot;
+}
+
+LandingHistogram::LandingHistogram(int binCount)
+    : binCount(binCount), bins(new std::atomic<uint32_t>[binCount]), netHits(0), longShots(0), shots(0) {
+    Clear();
+}
+
+void LandingHistogram::Clear() {
+    for (int i = 0; i < binCount; i++) {
+        bins[i].store(0, std::memory_order_relaxed);
+    }
+    netHits.store(0, std::memory_order_relaxed);
+    longShots.store(0, std::memory_order_relaxed);
+    shots.store(0, std::memory_order_release);
+}
+
+void LandingHistogram::Add(const uint32_t* batchBins, uint32_t batchNetHits, uint32_t batchLongShots,
+                           uint32_t batchShots) {
+    for (int i = 0; i < binCount; i++) {
+        if (batchBins[i]) bins[i].fetch_add(batchBins[i], std::memory_order_relaxed);
+    }
+    netHits.fetch_add(batchNetHits, std::memory_order_relaxed);
+    longShots.fetch_add(batchLongShots, std::memory_order_relaxed);
+    shots.fetch_add(batchShots, std::memory_order_release);
+}
+
+int LandingHistogram::BinOf(float x) const {
+    int bin = (int)(x / COURT_LENGTH * binCount);
+    return std::max(0, std::min(binCount - 1, bin));
+}
+
+void RunEnsemble(const EnsembleSpec& spec, const SimulationEngine& engine, ThreadPool& pool,
+                 LandingHistogram& histogram, const std::atomic<bool>* cancel, const EnsembleOutputs& outputs) {
+    size_t chunkCount = (spec.shotCount + ENSEMBLE_CHUNK_SHOTS - 1) / ENSEMBLE_CHUNK_SHOTS;
+
+    pool.ParallelFor(chunkCount, [&](size_t chunk) {
+        if (cancel && *cancel) return;
+
+        size_t begin = chunk * ENSEMBLE_CHUNK_SHOTS;
+        size_t end = std::min(begin + ENSEMBLE_CHUNK_SHOTS, spec.shotCount);
+
+        thread_local std::vector<ShotParams> shots;
+        thread_local std::vector<ShotResult> results;
+        thread_local std::vector<uint32_t> bins;
+        shots.resize(end - begin);
+        results.resize(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            shots[i - begin] = EnsembleShot(spec, i);
+        }
+        engine.RunBatch(shots.data(), shots.size(), results.data());
+        if (outputs.results) {
+            outputs.results->Submit(shots.data(), results.data(), shots.size(), begin);
+        }
+
+        // Bin locally; the shared histogram sees one atomic add per occupied bin
+        bins.assign(histogram.BinCount(), 0);
+        uint32_t netHits = 0, longShots = 0;
+        uint64_t steps = 0;
+        for (const ShotResult& result : results) {
+            steps += (uint64_t)result.steps;
+            if (result.hitNet) netHits++;
+            if (result.firstBounceX < 0.0f) {
+                longShots++;
+            } else {
+                bins[histogram.BinOf(result.firstBounceX)]++;
+            }
+        }
+        histogram.Add(bins.data(), netHits, longShots, (uint32_t)results.size());
+        if (outputs.steps) *outputs.steps += steps;
+    });
+}
@@ -0,0 +1,83 @@
+// Tennis Ball Physics Simulator - Monte Carlo shot ensembles
+// Thousands of copies of one shot with Gaussian noise on force, angle and spin,
+// run in batches on a ThreadPool. Each batch's first bounces are binned locally and
+// then added to a shared LandingHistogram with atomic increments, so a reader (the
+// UI thread) can draw the landing density while the ensemble is still running
+// without taking any lock.
+
+#pragma once
+
+#include "SimulationEngine.h"
+#include "ThreadPool.h"
+#include "ResultExport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Shots per ThreadPool task; a finished task's shots appear in the histogram at once
+const size_t ENSEMBLE_CHUNK_SHOTS = 1024;
+
+// 10 cm bins over the court length
+const int LANDING_HISTOGRAM_BINS = 238;
+
+struct EnsembleSpec {
+    ShotParams center;  // Mean shot; randomStream is ignored
+    float forceSigma;   // Standard deviations of the noise: Newtons,
+    float angleSigma;   // degrees
+    float spinSigma;    // and RPM
+    size_t shotCount;
+    uint64_t seed;      // Key of the noise and of the shots' own random streams
+};
+
+// Shot index of the ensemble: center plus noise drawn from the index's own stream,
+// so any shot can be regenerated alone. Force and angle are clamped to their limits.
+ShotParams EnsembleShot(const EnsembleSpec& spec, uint64_t index);
+
+// First-bounce x of shots binned over [0, COURT_LENGTH]. Add may run on any number
+// of threads at once and concurrently with the readers; Clear may not.
+class LandingHistogram {
+public:
+    explicit LandingHistogram(int binCount = LANDING_HISTOGRAM_BINS);
+
+    LandingHistogram(const LandingHistogram&) = delete;
+    LandingHistogram& operator=(const LandingHistogram&) = delete;
+
+    void Clear();
+
+    // Adds a batch's counts: bins[binCount] first bounces, then the shots that struck
+    // the net and the ones that left the court without bouncing on it
+    void Add(const uint32_t* bins, uint32_t netHits, uint32_t longShots, uint32_t shots);
+
+    int BinCount() const { return binCount; }
+    float BinWidth() const { return COURT_LENGTH / binCount; }
+    int BinOf(float x) const;
+
+    // Readers see whole batches: Shots() is published after the batch's bins
+    uint64_t Shots() const { return shots.load(std::memory_order_acquire); }
+    uint32_t Count(int bin) const { return bins[bin].load(std::memory_order_relaxed); }
+    uint32_t NetHits() const { return netHits.load(std::memory_order_relaxed); }
+    uint32_t LongShots() const { return longShots.load(std::memory_order_relaxed); }
+
+private:
+    int binCount;
+    std::unique_ptr<std::atomic<uint32_t>[]> bins;
+    std::atomic<uint32_t> netHits;
+    std::atomic<uint32_t> longShots;
+    std::atomic<uint64_t> shots;
+};
+
+// Optional streams fed while an ensemble runs; shot ids are ensemble indices
+struct EnsembleOutputs {
+    // Each chunk's rows as soon as the chunk is done
+    ResultExporter* results = nullptr;
+    // Advanced by each chunk's integration steps
+    std::atomic<uint64_t>* steps = nullptr;
+};
+
+// Runs every shot of spec on pool with engine (SIMD batches for fixed-step Euler)
+// and accumulates them into histogram; returns early, with the batches done so far
+// counted, when cancel is set
+void RunEnsemble(const EnsembleSpec& spec, const SimulationEngine& engine, ThreadPool& pool,
+                 LandingHistogram& histogram, const std::atomic<bool>* cancel = nullptr,
+                 const EnsembleOutputs& outputs = EnsembleOutputs());
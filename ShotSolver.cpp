@@ -0,0 +1,225 @@
+// Tennis Ball Physics Simulator - inverse shot solver
+
+#include "ShotSolver.h"
+#include "ReturnHitPolicy.h"
+
+#include <cmath>
+
+namespace {
+    float& UnknownValue(float& force, float& angle, float& spin, SolveParameter unknown) {
+        switch (unknown) {
+            case SOLVE_ANGLE: return angle;
+            case SOLVE_SPIN: return spin;
+            default: return force;
+        }
+    }
+
+    // Signed miss of a shot along its direction of travel, positive when long. A shot
+    // that has to cross the net but does not clear it counts as falling short at the
+    // net, by more the lower it passed, so the miss still grows with the unknown.
+    class LandingError {
+    public:
+        explicit LandingError(const ShotTarget& target)
+            : target(target),
+              direction(target.origin == SHOT_FROM_LEFTY ? 1.0f : -1.0f),
+              originX(target.origin == SHOT_FROM_LEFTY ? LEFTY_START_X : target.rightyX - RETURN_START_OFFSET),
+              acrossNet((target.landingX - NET_X) * direction > 0.0f) {
+        }
+
+        bool ClearsNet(const LandingSample& landing) const {
+            return !acrossNet || landing.netClearance >= target.minNetClearance;
+        }
+
+        float Miss(const LandingSample& landing) const {
+            float distance = (landing.firstBounceX - originX) * direction;
+            if (!ClearsNet(landing)) {
+                distance = (NET_X - originX) * direction - (target.minNetClearance - landing.netClearance);
+            }
+            return distance - (target.landingX - originX) * direction;
+        }
+
+    private:
+        const ShotTarget& target;
+        float direction;
+        float originX;
+        bool acrossNet;
+    };
+
+    // One solve: simulated flights of the unknown, keeping the closest shot so far
+    class Search {
+    public:
+        Search(const ShotSolver& solver, const ShotTarget& target)
+            : solver(solver), target(target), error(target), bestMiss(INFINITY) {
+            best.solved = false;
+            best.force = target.force;
+            best.angle = target.angle;
+            best.spin = target.spin;
+            best.firstBounceX = -1.0f;
+            best.netClearance = -NET_HEIGHT;
+            best.flights = 0;
+        }
+
+        float Evaluate(float value) {
+            float force = target.force, angle = target.angle, spin = target.spin;
+            UnknownValue(force, angle, spin, target.unknown) = value;
+            LandingSample landing = solver.Fly(target, force, angle, spin);
+            best.flights++;
+
+            float miss = error.Miss(landing);
+            bool clears = error.ClearsNet(landing);
+            // Shots that clear the net beat closer ones that do not
+            float rank = fabs(miss) + (clears ? 0.0f : COURT_LENGTH);
+            if (rank < bestMiss) {
+                bestMiss = rank;
+                best.force = force;
+                best.angle = angle;
+                best.spin = spin;
+                best.firstBounceX = landing.firstBounceX;
+                best.netClearance = landing.netClearance;
+                best.solved = clears && fabs(miss) <= SOLVER_TOLERANCE;
+            }
+            return miss;
+        }
+
+        // Illinois false position on a bracket with a sign change
+        bool Refine(float low, float lowMiss, float high, float highMiss) {
+            if (best.solved) return true;
+            int retained = 0; // -1: low end kept last time, +1: high end
+            float width = high - low;
+            for (int iteration = 0; iteration < SOLVER_MAX_ITERATIONS; iteration++) {
+                float value = (low * highMiss - high * lowMiss) / (highMiss - lowMiss);
+                float miss = Evaluate(value);
+                if (best.solved) return true;
+
+                if ((miss > 0.0f) == (highMiss > 0.0f)) {
+                    high = value;
+                    highMiss = miss;
+                    if (retained == -1) lowMiss *= 0.5f;
+                    retained = -1;
+                } else {
+                    low = value;
+                    lowMiss = miss;
+                    if (retained == 1) highMiss *= 0.5f;
+                    retained = 1;
+                }
+                // Converged on a jump (e.g. the net edge) rather than a landing on the target
+                if (fabs(high - low) <= 1e-5f * width) break;
+            }
+            return false;
+        }
+
+        const ShotSolution& Best() const { return best; }
+        const LandingError& Error() const { return error; }
+
+    private:
+        const ShotSolver& solver;
+        const ShotTarget& target;
+        LandingError error;
+        ShotSolution best;
+        float bestMiss;
+    };
+}
+
+ShotTarget LaunchTarget(float landingX, SolveParameter unknown, float force, float angle, float spin,
+                        AirResistanceMode airMode) {
+    ShotTarget target;
+    target.landingX = landingX;
+    target.unknown = unknown;
+    target.force = force;
+    target.angle = angle;
+    target.spin = spin;
+    target.minValue = 0.0f;
+    target.maxValue = 0.0f;
+    target.airMode = airMode;
+    target.origin = SHOT_FROM_LEFTY;
+    target.rightyX = 0.0f;
+    target.contactHeight = 0.0f;
+    target.minNetClearance = 0.0f;
+    return target;
+}
+
+ShotTarget ReturnTarget(float landingX, SolveParameter unknown, float force, float angle, float spin,
+                        AirResistanceMode airMode, float rightyX, float contactHeight) {
+    ShotTarget target = LaunchTarget(landingX, unknown, force, angle, spin, airMode);
+    target.origin = SHOT_FROM_RIGHTY;
+    target.rightyX = rightyX;
+    target.contactHeight = contactHeight;
+    return target;
+}
+
+ShotSolver::ShotSolver(const LandingTableConfig& stepping, const LandingTable* seedTable)
+    : stepping(stepping), seedTable(seedTable) {
+}
+
+LandingSample ShotSolver::Fly(const ShotTarget& target, float force, float angle, float spin) const {
+    TennisBall ball = LandingFlightBall(stepping, target.airMode, SOLVER_RANDOM_SEED, 0, force, angle, spin);
+
+    if (target.origin == SHOT_FROM_RIGHTY) {
+        ball.y = target.contactHeight;
+        ReturnHit hit = {force, angle, spin};
+        ApplyReturnHit(ball, hit, target.rightyX);
+        ball.prevX = ball.x;
+        ball.prevY = ball.y;
+    }
+    return SimulateLanding(ball, stepping);
+}
+
+ShotSolution ShotSolver::Solve(const ShotTarget& target) const {
+    float minValue = target.minValue;
+    float maxValue = target.maxValue;
+    if (minValue >= maxValue) {
+        switch (target.unknown) {
+            case SOLVE_ANGLE: minValue = MIN_ANGLE; maxValue = MAX_ANGLE; break;
+            case SOLVE_SPIN: minValue = SOLVER_MIN_SPIN; maxValue = SOLVER_MAX_SPIN; break;
+            default: minValue = MIN_HORIZONTAL_FORCE; maxValue = MAX_HORIZONTAL_FORCE; break;
+        }
+    }
+
+    Search search(*this, target);
+    bool seeded = seedTable && seedTable->IsReady() && target.origin == SHOT_FROM_LEFTY;
+
+    // Walk up the scan and refine the first bracket that holds a landing on the target.
+    // Table misses only pick brackets; their ends are simulated before refining,
+    // and if no seeded bracket holds up the scan is repeated with simulated flights.
+    for (int pass = seeded ? 0 : 1; pass < 2; pass++) {
+        float previousValue = 0.0f, previousMiss = 0.0f;
+        for (int i = 0; i < SOLVER_SCAN_SAMPLES; i++) {
+            float value = minValue + (maxValue - minValue) * (float)i / (float)(SOLVER_SCAN_SAMPLES - 1);
+            float miss;
+            if (pass == 0) {
+                float force = target.force, angle = target.angle, spin = target.spin;
+                UnknownValue(force, angle, spin, target.unknown) = value;
+                miss = search.Error().Miss(seedTable->Lookup(force, angle, spin, target.airMode));
+            } else {
+                miss = search.Evaluate(value);
+                if (search.Best().solved) return search.Best();
+            }
+
+            if (i > 0 && (miss > 0.0f) != (previousMiss > 0.0f)) {
+                float lowMiss = previousMiss, highMiss = miss;
+                if (pass == 0) {
+                    lowMiss = search.Evaluate(previousValue);
+                    highMiss = search.Evaluate(value);
+                }
+                if ((lowMiss > 0.0f) != (highMiss > 0.0f) && search.Refine(previousValue, lowMiss, value, highMiss)) {
+                    return search.Best();
+                }
+            }
+            previousValue = value;
+            previousMiss = miss;
+        }
+    }
+    return search.Best();
+}
+
+void ShotSolver::SolveBatch(const ShotTarget* targets, size_t count, ShotSolution* solutions, ThreadPool& pool) const {
+    pool.ParallelFor(count, [&](size_t i) {
+        solutions[i] = Solve(targets[i]);
+    });
+}
+
+std::vector<ShotSolution> ShotSolver::SolveBatch(const std::vector<ShotTarget>& targets, ThreadPool& pool) const {
+    std::vector<ShotSolution> solutions(targets.size());
+    SolveBatch(targets.data(), targets.size(), solutions.data(), pool);
+    return solutions;
+}
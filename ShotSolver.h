@@ -0,0 +1,97 @@
+// Tennis Ball Physics Simulator - inverse shot solver
+// Finds the force, angle or spin that puts a shot's first bounce on a target x,
+// holding the other two. The unknown is scanned for a bracket of the landing
+// distance, from an interpolated LandingTable when one is supplied and by
+// simulation otherwise, and the bracket is refined by Illinois false position on
+// simulated flights. A solve takes a few dozen flights up to the first bounce, well
+// under a millisecond, so it can run inline in the physics step (RIGHTY returns)
+// or over thousands of targets on a ThreadPool.
+//
+// The court surface only matters from the first bounce on, so a target on grass
+// solves the same as on any other court.
+
+#pragma once
+
+#include "LandingTable.h"
+#include "SimulationEngine.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+enum SolveParameter {
+    SOLVE_FORCE,
+    SOLVE_ANGLE,
+    SOLVE_SPIN
+};
+
+enum ShotOrigin {
+    SHOT_FROM_LEFTY, // A LEFTY launch towards RIGHTY (resetForHorizontalShot)
+    SHOT_FROM_RIGHTY // A RIGHTY return back towards LEFTY (ApplyReturnHit)
+};
+
+// Spin searched when the target leaves the range to the solver
+const float SOLVER_MIN_SPIN = -3000.0f; // RPM
+const float SOLVER_MAX_SPIN = 9000.0f;  // RPM
+
+// Evenly spaced values of the unknown tried when looking for a bracket
+const int SOLVER_SCAN_SAMPLES = 25;
+const int SOLVER_MAX_ITERATIONS = 40;
+const float SOLVER_TOLERANCE = 0.01f; // meters of landing error accepted
+
+// Random stream of the solver's flights; only shots that strike the net draw from it
+const uint64_t SOLVER_RANDOM_SEED = 0x534F4C56ull;
+
+struct ShotTarget {
+    float landingX;           // Court x of the first bounce, meters
+    SolveParameter unknown;
+    float force;              // Newtons; the two besides unknown are held, unknown's value is ignored
+    float angle;              // degrees
+    float spin;               // RPM
+    float minValue;           // Search range of the unknown; minValue >= maxValue
+    float maxValue;           // searches all of it (force and angle limits, SOLVER_MIN/MAX_SPIN)
+    AirResistanceMode airMode;
+    ShotOrigin origin;
+    float rightyX;            // SHOT_FROM_RIGHTY: RIGHTY's position
+    float contactHeight;      // SHOT_FROM_RIGHTY: height of the ball when RIGHTY hits it
+    float minNetClearance;    // meters above the tape a shot across the net must pass
+};
+
+// Target of a LEFTY launch over the full range of the unknown
+ShotTarget LaunchTarget(float landingX, SolveParameter unknown, float force, float angle, float spin,
+                        AirResistanceMode airMode);
+
+// Target of a RIGHTY return hit from rightyX at contactHeight
+ShotTarget ReturnTarget(float landingX, SolveParameter unknown, float force, float angle, float spin,
+                        AirResistanceMode airMode, float rightyX, float contactHeight);
+
+struct ShotSolution {
+    bool solved;          // Landing within SOLVER_TOLERANCE of the target, clearing the net as asked
+    float force;          // Newtons; the solution, or the closest shot tried if there is none
+    float angle;          // degrees
+    float spin;           // RPM
+    float firstBounceX;   // meters, of that shot
+    float netClearance;   // meters, of that shot (see LandingSample)
+    int flights;          // Shots simulated
+};
+
+class ShotSolver {
+public:
+    // Flights are stepped as stepping says, which should match the shots being aimed;
+    // seedTable (not owned, may be null) replaces the simulated scan of LEFTY launches
+    explicit ShotSolver(const LandingTableConfig& stepping, const LandingTable* seedTable = nullptr);
+
+    // The lowest value of the unknown that lands on the target: the softest shot,
+    // the flattest arc or the least topspin
+    ShotSolution Solve(const ShotTarget& target) const;
+
+    // Solves every target on pool
+    void SolveBatch(const ShotTarget* targets, size_t count, ShotSolution* solutions, ThreadPool& pool) const;
+    std::vector<ShotSolution> SolveBatch(const std::vector<ShotTarget>& targets, ThreadPool& pool) const;
+
+    // First bounce and net clearance of a shot (unknown ignored; force, angle and spin as given)
+    LandingSample Fly(const ShotTarget& target, float force, float angle, float spin) const;
+
+private:
+    LandingTableConfig stepping;
+    const LandingTable* seedTable;
+};
@@ -0,0 +1,486 @@
+// Tennis Ball Physics Simulator - headless simulation engine
+
+#include "SimulationEngine.h"
+#include "BallBatch.h"
+#include "FlightEvents.h"
+
+#include <cmath>
+
+// Air resistance coefficients based on altitude
+// Coefficient formula: 0.5 * Cd * rho * A, where:
+// Cd ~= 0.5 (drag coefficient for sphere)
+// A = pi * r^2 ~= 0.00352 m^2 (tennis ball cross-section)
+// rho varies with altitude
+AirResistanceData airModes[4] = {
+    {AIR_VACUUM, L"Vacuum (no air)", 0.0f, "vacuum"},
+    {AIR_SEA_LEVEL, L"Sea Level", 0.0005f, "sea_level"},      // rho = 1.225 kg/m^3
+    {AIR_1000M, L"1000m altitude", 0.00044f, "1000m"},        // rho = 1.112 kg/m^3 (90% of sea level)
+    {AIR_2000M, L"2000m altitude", 0.00039f, "2000m"}         // rho = 1.007 kg/m^3 (82% of sea level)
+};
+
+// Launch pattern presets
+LaunchPatternData launchPatterns[8] = {
+    {PATTERN_RANDOM, L"Random", 0.0f, 0.0f, 0.0f, "random"},  // Special case - random values
+    {PATTERN_NADAL_TOPSPIN, L"Nadal Topspin", 600.0f, 45.0f, 7000.0f, "nadal_topspin"},
+    {PATTERN_FEDERER_BACKSPIN, L"Federer Slice", 240.0f, 21.0f, -1200.0f, "federer_slice"},
+    {PATTERN_AGASSI_RETURN, L"Agassi Return", 550.0f, 27.0f, 5000.0f, "agassi_return"},
+    {PATTERN_SAMPRAS_SERVE, L"Sampras Serve", 700.0f, 12.0f, 3000.0f, "sampras_serve"},
+    {PATTERN_ISNER_KICK_SERVE, L"Isner Kick Serve", 580.0f, 39.0f, 6500.0f, "isner_kick_serve"},
+    {PATTERN_FONSECA_FOREHAND, L"Fonseca Forehand", 580.0f, 24.0f, 5000.0f, "fonseca_forehand"},
+    {PATTERN_KUERTEN_BACKHAND, L"Kuerten Backhand", 450.0f, 35.0f, 4000.0f, "kuerten_backhand"}
+};
+
+// Define court surfaces with realistic physics properties
+CourtSurface courts[4] = {
+    {ROLAND_GARROS_CLAY, L"Roland Garros\n(Clay)", 0.75f, 0.6f, "clay"},
+    {WIMBLEDON_GRASS, L"Wimbledon\n(Grass)", 0.70f, 0.4f, "grass"},
+    {US_OPEN_HARD, L"US Open\n(Hard Court)", 0.73f, 0.5f, "hard"},
+    {LAVER_CUP_BLACK, L"Laver Cup\n(Black Court)", 0.72f, 0.5f, "laver"}
+};
+
+TennisBall::TennisBall(CourtSurface* courtSurface, bool record)
+    : trajectory(record ? DEFAULT_TRAJECTORY_CAPACITY : 0), recordTrajectory(record), integrator(nullptr) {
+    surface = courtSurface;
+    airResistanceCoeff = 0.0f;
+    spinRPM = 0.0f;
+    reset();
+}
+
+void TennisBall::reset() {
+    restitution = surface->coefficientOfRestitution;
+    y = INITIAL_HEIGHT;
+    vy = 0.0f;
+    x = 0.0f;
+    vx = 0.0f;
+    time = 0.0f;
+    bounceCount = 0;
+    isActive = true;
+    hitNet = false;
+    prevX = x;
+    prevY = y;
+    stepCount = 0;
+    eventStepHint = 0.0f;
+    if (integrator) integrator->Reset();
+    trajectory.clear();
+    bounces.clear();
+    // Record initial position
+    if (recordTrajectory) {
+        trajectory.push_back({time, y, x});
+    }
+}
+
+void TennisBall::resetForHorizontalShot(float horizontalForce, float angleDegrees, float spin) {
+    x = LEFTY_START_X; // Start from LEFTY position
+    y = 1.0f; // Start at net height
+    ComputeLaunchVelocity(horizontalForce, angleDegrees, vx, vy);
+
+    spinRPM = spin;
+    restitution = surface->coefficientOfRestitution;
+    time = 0.0f;
+    bounceCount = 0;
+    isActive = true;
+    hitNet = false;
+    prevX = x;
+    prevY = y;
+    stepCount = 0;
+    eventStepHint = 0.0f;
+    if (integrator) integrator->Reset();
+    trajectory.clear();
+    bounces.clear();
+    if (recordTrajectory) {
+        trajectory.push_back({time, y, x});
+    }
+}
+
+void TennisBall::update(float dt) {
+    if (!isActive) return;
+    if (integrator) {
+        updateWithIntegrator(dt);
+        return;
+    }
+
+    // Store previous position for net collision detection and render interpolation
+    prevX = x;
+    prevY = y;
+
+    time += dt;
+    stepCount++;
+
+    AdvanceFlight(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+
+    // Net collision detection
+    if (CrossedNetPlane(prevX, x) && ResolveNetContact(prevX, prevY, x, y, vx, vy, spinRPM, random)) {
+        hitNet = true;
+    }
+
+    // Record trajectory
+    if (recordTrajectory) {
+        trajectory.push_back({time, y, x});
+    }
+
+    // Check for ground collision
+    if (y <= 0.0f) {
+        // Record bounce if we haven't recorded 3 yet
+        if (bounceCount < 3) {
+            bounces.push_back({time, 0.0f, x});
+        }
+
+        if (!ResolveGroundContact(y, vx, vy, spinRPM, bounceCount, restitution)) {
+            isActive = false;
+        }
+    }
+
+    // Stop if ball goes out of bounds horizontally
+    if (x < 0.0f || x > COURT_LENGTH) {
+        isActive = false;
+    }
+}
+
+void TennisBall::updateWithIntegrator(float dt) {
+    prevX = x;
+    prevY = y;
+
+    FlightState start = {x, y, vx, vy};
+    FlightState end = start;
+    stepCount += integrator->Step(end, spinRPM, airResistanceCoeff, dt);
+
+    bool crossesNet = CrossedNetPlane(x, (float)end.x);
+    bool crossesGround = start.y > 0.0 && end.y <= 0.0;
+    double contactTheta = 1.0;
+    bool contact = false;
+
+    if (crossesNet || crossesGround) {
+        FlightDerivative startRate = EvaluateFlight(start, spinRPM, airResistanceCoeff);
+        FlightDerivative endRate = EvaluateFlight(end, spinRPM, airResistanceCoeff);
+        double netTheta = crossesNet ? FindStepCrossing(start, startRate, end, endRate, dt, 0, NET_X) : 2.0;
+        double groundTheta = crossesGround ? FindStepCrossing(start, startRate, end, endRate, dt, 1, 0.0) : 2.0;
+
+        // A net crossing above the tape is not a contact; the ground may still be
+        if (netTheta < groundTheta) {
+            FlightState atNet = InterpolateFlight(start, startRate, end, endRate, dt, netTheta);
+            if (atNet.y <= NET_HEIGHT + BALL_RADIUS) {
+                x = NET_X;
+                y = (float)atNet.y;
+                vx = (float)atNet.vx;
+                vy = (float)atNet.vy;
+                DeflectOffNet(vx, vy, spinRPM, random);
+                hitNet = true;
+                contactTheta = netTheta;
+                contact = true;
+            }
+        }
+        if (!contact && crossesGround) {
+            FlightState atGround = InterpolateFlight(start, startRate, end, endRate, dt, groundTheta);
+            x = (float)atGround.x;
+            y = 0.0f;
+            vx = (float)atGround.vx;
+            vy = (float)atGround.vy;
+            contactTheta = groundTheta;
+            contact = true;
+
+            if (bounceCount < 3) {
+                bounces.push_back({time + (float)(groundTheta * dt), 0.0f, x});
+            }
+            if (!ResolveGroundContact(y, vx, vy, spinRPM, bounceCount, restitution)) {
+                isActive = false;
+            }
+        }
+    }
+
+    if (contact) {
+        // Integrate the rest of the step from the contact
+        float rest = (float)((1.0 - contactTheta) * dt);
+        if (isActive && rest > 0.0f) {
+            FlightState after = {x, y, vx, vy};
+            stepCount += integrator->Step(after, spinRPM, airResistanceCoeff, rest);
+            end = after;
+        } else {
+            end = {x, y, vx, vy};
+        }
+    }
+
+    x = (float)end.x;
+    y = (float)end.y;
+    vx = (float)end.vx;
+    vy = (float)end.vy;
+    time += dt;
+
+    if (recordTrajectory) {
+        trajectory.push_back({time, y, x});
+    }
+
+    // A second contact inside the same step (a tiny hop) falls back to the polled bounce
+    if (isActive && y <= 0.0f) {
+        if (bounceCount < 3) {
+            bounces.push_back({time, 0.0f, x});
+        }
+        if (!ResolveGroundContact(y, vx, vy, spinRPM, bounceCount, restitution)) {
+            isActive = false;
+        }
+    }
+
+    if (x < 0.0f || x > COURT_LENGTH) {
+        isActive = false;
+    }
+}
+
+void TennisBall::updateEventDriven(float dt, float rightyX) {
+    if (!isActive) return;
+
+    prevX = x;
+    prevY = y;
+
+    float remaining = dt;
+    while (isActive && remaining > 0.0f) {
+        FlightState state = {x, y, vx, vy};
+        float elapsed = 0.0f;
+        FlightEvent event = IntegrateToEvent(state, spinRPM, airResistanceCoeff, remaining, rightyX,
+                                             eventStepHint, elapsed, stepCount);
+        x = (float)state.x;
+        y = (float)state.y;
+        vx = (float)state.vx;
+        vy = (float)state.vy;
+        time += elapsed;
+        remaining -= elapsed;
+
+        if (recordTrajectory) {
+            trajectory.push_back({time, y, x});
+        }
+
+        if (event == EVENT_NONE) {
+            break;
+        } else if (event == EVENT_GROUND) {
+            if (bounceCount < 3) {
+                bounces.push_back({time, 0.0f, x});
+            }
+            if (!ResolveGroundContact(y, vx, vy, spinRPM, bounceCount, restitution)) {
+                isActive = false;
+            }
+        } else if (event == EVENT_NET_PLANE) {
+            // Same contact height test as ResolveNetContact; above it the ball simply passes
+            if (y <= NET_HEIGHT + BALL_RADIUS) {
+                DeflectOffNet(vx, vy, spinRPM, random);
+                hitNet = true;
+            }
+        } else if (event == EVENT_LEFT_COURT) {
+            isActive = false;
+        } else if (event == EVENT_RIGHTY_PLANE) {
+            break;
+        }
+    }
+}
+
+TrajectoryBuffer::TrajectoryBuffer(size_t capacity) : head(0), count(0), pushed(0), clears(0) {
+    setCapacity(capacity);
+}
+
+void TrajectoryBuffer::setCapacity(size_t capacity) {
+    samples.assign(capacity, BounceData{0.0f, 0.0f, 0.0f});
+    clear();
+}
+
+void TrajectoryBuffer::syncFrom(const TrajectoryBuffer& source) {
+    size_t sourceOldest = source.pushed - source.count;
+    if (samples.size() != source.samples.size()) {
+        samples.assign(source.samples.size(), BounceData{0.0f, 0.0f, 0.0f});
+        count = 0;
+    }
+    if (samples.empty()) {
+        pushed = source.pushed;
+        clears = source.clears;
+        return;
+    }
+
+    // Start over from source's oldest sample when the ones missing here are gone
+    if (clears != source.clears || pushed > source.pushed || pushed < sourceOldest || count == 0) {
+        head = 0;
+        count = 0;
+        pushed = sourceOldest;
+        clears = source.clears;
+    }
+    while (pushed < source.pushed) {
+        push_back(source[pushed - sourceOldest]);
+    }
+}
+
+void ComputeLaunchVelocity(float horizontalForce, float angleDegrees, float& vx, float& vy) {
+    // Map force (0-1000N) to realistic tennis velocities (0-50 m/s)
+    // Professional tennis serves: 50-70 m/s, groundstrokes: 20-40 m/s
+    float totalVelocity = (horizontalForce / MAX_HORIZONTAL_FORCE) * 50.0f;
+
+    // Convert angle to radians and calculate velocity components
+    float angleRad = angleDegrees * 3.14159265f / 180.0f;
+    vx = totalVelocity * cos(angleRad);
+    vy = totalVelocity * sin(angleRad);
+}
+
+void AdvanceFlight(float& x, float& y, float& vx, float& vy, float spinRPM, float airResistanceCoeff, float dt) {
+    if (airResistanceCoeff != 0.0f) {
+        if (spinRPM != 0.0f) {
+            AdvanceFlightKernel<true, true>(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+        } else {
+            AdvanceFlightKernel<true, false>(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+        }
+    } else if (spinRPM != 0.0f) {
+        AdvanceFlightKernel<false, true>(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+    } else {
+        AdvanceFlightKernel<false, false>(x, y, vx, vy, spinRPM, airResistanceCoeff, dt);
+    }
+}
+
+bool ResolveNetContact(float prevX, float prevY, float& x, float& y, float& vx, float& vy, float& spinRPM,
+                       RandomStream& random) {
+    // Linear interpolation to find exact collision point
+    float t = (NET_X - prevX) / (x - prevX); // Interpolation factor
+    float collisionY = prevY + t * (y - prevY);
+
+    // Check if ball hit the net (collision height is below net height + ball radius)
+    if (collisionY > NET_HEIGHT + BALL_RADIUS) return false;
+
+    // Ball hit the net!
+    // Position ball at net surface
+    x = NET_X;
+    y = collisionY;
+
+    DeflectOffNet(vx, vy, spinRPM, random);
+    return true;
+}
+
+void DeflectOffNet(float& vx, float& vy, float& spinRPM, RandomStream& random) {
+    // Net absorbs 80% of force, reflects 20% back
+    // Reflect horizontal velocity with 80% energy absorption
+    vx = -vx * (1.0f - NET_ABSORPTION);
+
+    // Apply 80% absorption to vertical velocity as well
+    vy *= (1.0f - NET_ABSORPTION);
+
+    // Add some random deflection for realism
+    float randomDeflection = (random.NextInt(100) / 100.0f - 0.5f) * 0.3f; // -0.15 to +0.15 m/s
+    vy += randomDeflection;
+
+    // Reduce spin on net collision (80% absorption)
+    spinRPM *= (1.0f - NET_ABSORPTION);
+
+    // If ball is moving very slowly after net collision, it might drop straight down
+    if (fabs(vx) < 0.5f && fabs(vy) < 0.5f) {
+        vx = 0.0f;
+    }
+}
+
+bool ResolveGroundContact(float& y, float& vx, float& vy, float& spinRPM, int& bounceCount, float coefficientOfRestitution) {
+    y = 0.0f;
+
+    // Apply coefficient of restitution
+    vy = -vy * coefficientOfRestitution;
+    vx *= 0.8f; // Horizontal velocity reduction on bounce
+
+    // Spin affects bounce: topspin increases forward velocity, backspin decreases it
+    float spinEffect = (spinRPM / 5000.0f) * 2.0f; // Normalized spin effect
+    vx += spinEffect;
+
+    // Spin decays on bounce
+    spinRPM *= 0.7f;
+
+    bounceCount++;
+
+    // Stop if velocity is too low or we've bounced enough
+    if (fabs(vy) < 0.1f || bounceCount > 10) {
+        vy = 0.0f;
+        vx = 0.0f;
+        return false;
+    }
+    return true;
+}
+
+SimulationEngine::SimulationEngine(float timeStep, float maxShotTime)
+    : timeStep(timeStep), maxShotTime(maxShotTime), integrationMode(INTEGRATION_FIXED_STEP),
+      integratorType(INTEGRATOR_EULER), exactVacuum(false), randomSeed(0) {
+}
+
+ShotResult SimulationEngine::SimulateShot(const ShotParams& params) const {
+    return SimulateShot(params, nullptr);
+}
+
+ShotResult SimulationEngine::SimulateShot(const ShotParams& params,
+                                          const std::function<void(const TennisBall&)>& observer) const {
+    // A headless ball holds no heap storage; steppers are kept per thread and reset at
+    // launch, so a shot allocates nothing once each thread has run one of its type
+    TennisBall ball(&courts[params.surfaceIndex], false);
+    if (integrationMode == INTEGRATION_FIXED_STEP && integratorType != INTEGRATOR_EULER) {
+        ball.setIntegrator(ThreadIntegrator(integratorType));
+    }
+    ball.setAirResistance(airModes[params.airMode].coefficient);
+    ball.setRandomStream(randomSeed, params.randomStream);
+    ball.resetForHorizontalShot(params.force, params.angle, params.spin);
+    if (observer) observer(ball);
+
+    if (integrationMode == INTEGRATION_EVENT_DRIVEN) {
+        // One call runs the whole shot and only returns early on a contact; an observer
+        // gets the shot in timeStep slices instead so its samples stay evenly spaced
+        while (ball.isActive && ball.time < maxShotTime) {
+            float remaining = maxShotTime - ball.time;
+            ball.updateEventDriven(observer && timeStep < remaining ? timeStep : remaining);
+            if (observer) observer(ball);
+        }
+    } else {
+        while (ball.isActive && ball.time < maxShotTime) {
+            ball.update(timeStep);
+            if (observer) observer(ball);
+        }
+    }
+
+    ShotResult result;
+    result.firstBounceX = ball.bounces.empty() ? -1.0f : ball.bounces[0].xPosition;
+    result.firstBounceTime = ball.bounces.empty() ? -1.0f : ball.bounces[0].time;
+    result.finalX = ball.x;
+    result.timeToRest = ball.time;
+    result.bounceCount = ball.bounceCount;
+    result.steps = ball.stepCount;
+    result.hitNet = ball.hitNet;
+    // Event-driven shots stop exactly on the baseline rather than past it
+    result.leftCourt = ball.x <= 0.0f || ball.x >= COURT_LENGTH;
+    return result;
+}
+
+void SimulationEngine::RunBatch(const ShotParams* params, size_t count, ShotResult* results) const {
+    // Adaptive and higher-order steppers diverge per shot, so those batches run shot by shot
+    if (integrationMode == INTEGRATION_EVENT_DRIVEN || integratorType != INTEGRATOR_EULER) {
+        for (size_t i = 0; i < count; i++) {
+            results[i] = SimulateShot(params[i]);
+        }
+        return;
+    }
+
+    // Chunk so the SoA working set of one batch stays cache resident
+    const size_t BATCH_CHUNK = 4096;
+
+    // Parabolic shots go contact to contact in closed form, a handful of events each
+    SimulationEngine exact(*this);
+    exact.integrationMode = INTEGRATION_EVENT_DRIVEN;
+    auto fliesParabola = [this](const ShotParams& shot) {
+        return exactVacuum && shot.spin == 0.0f && airModes[shot.airMode].coefficient == 0.0f;
+    };
+
+    // Reused per thread: reloading keeps the lane arrays' capacity
+    thread_local BallBatch batch;
+    size_t begin = 0;
+    while (begin < count) {
+        if (fliesParabola(params[begin])) {
+            results[begin] = exact.SimulateShot(params[begin]);
+            begin++;
+            continue;
+        }
+        size_t end = begin + 1;
+        while (end < count && end - begin < BATCH_CHUNK && !fliesParabola(params[end])) end++;
+        batch.LoadShots(params + begin, end - begin, randomSeed);
+        batch.RunToRest(timeStep, maxShotTime);
+        batch.StoreResults(results + begin);
+        begin = end;
+    }
+}
+
+std::vector<ShotResult> SimulationEngine::RunBatch(const std::vector<ShotParams>& params) const {
+    std::vector<ShotResult> results(params.size());
+    RunBatch(params.data(), params.size(), results.data());
+    return results;
+}
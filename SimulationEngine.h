@@ -0,0 +1,371 @@
+// Tennis Ball Physics Simulator - headless simulation engine
+// Ball physics, court surfaces and batch shot integration without any
+// Windows, Direct2D or DirectWrite dependencies
+
+#pragma once
+
+#include "Integrator.h"
+#include "PhiloxRandom.h"
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Physics constants
+const float GRAVITY = 9.81f; // m/s^2
+const float BALL_RADIUS = 0.0335f; // Tennis ball radius in meters (6.7cm diameter)
+const float INITIAL_HEIGHT = 2.0f; // meters
+const float DT = 0.0083f; // ~120 FPS
+
+// Court constants
+const float COURT_WIDTH = 23.77f; // Tennis court width in meters (singles)
+const float COURT_LENGTH = 23.77f; // Tennis court length in meters
+const float NET_HEIGHT = 0.914f; // Net height at center in meters
+const float BALL_MASS = 0.058f; // Tennis ball mass in kg
+const float MIN_HORIZONTAL_FORCE = 0.0f; // Newtons
+const float MAX_HORIZONTAL_FORCE = 1000.0f; // Newtons
+const float MIN_ANGLE = 0.0f; // degrees
+const float MAX_ANGLE = 90.0f; // degrees
+
+// Net and spin constants
+const float NET_X = COURT_LENGTH / 2.0f; // Net is at center of court
+const float NET_ABSORPTION = 0.80f; // Net absorbs 80% of force, returns 20%
+const float MAGNUS_COEFF = 0.00015f; // Tuned Magnus coefficient, F_magnus = k * omega * v
+
+// LEFTY launches from 20 pixels inside the left edge of the 540 pixel single-court view
+const float LEFTY_START_X = (20.0f / 540.0f) * COURT_LENGTH; // meters
+
+// Air resistance modes
+enum AirResistanceMode {
+    AIR_VACUUM,
+    AIR_SEA_LEVEL,
+    AIR_1000M,
+    AIR_2000M
+};
+
+struct AirResistanceData {
+    AirResistanceMode mode;
+    const wchar_t* name;
+    float coefficient;
+    const char* key; // Short identifier for result files
+};
+
+extern AirResistanceData airModes[4];
+
+// Launch pattern modes
+enum LaunchPattern {
+    PATTERN_RANDOM,
+    PATTERN_NADAL_TOPSPIN,
+    PATTERN_FEDERER_BACKSPIN,
+    PATTERN_AGASSI_RETURN,
+    PATTERN_SAMPRAS_SERVE,
+    PATTERN_ISNER_KICK_SERVE,
+    PATTERN_FONSECA_FOREHAND,
+    PATTERN_KUERTEN_BACKHAND
+};
+
+struct LaunchPatternData {
+    LaunchPattern pattern;
+    const wchar_t* name;
+    float force;  // Newtons
+    float angle;  // degrees
+    float spin;   // RPM
+    const char* key; // Identifier in settings.ini sections
+};
+
+extern LaunchPatternData launchPatterns[8];
+
+// Court surface properties
+enum CourtType {
+    ROLAND_GARROS_CLAY,    // Clay court - slower, higher bounce
+    WIMBLEDON_GRASS,       // Grass court - faster, lower bounce
+    US_OPEN_HARD,          // Hard court - medium speed, consistent bounce
+    LAVER_CUP_BLACK        // Special hard court - similar to hard court
+};
+
+// Physical properties only; the GUI keeps its own colors per court type
+struct CourtSurface {
+    CourtType type;
+    const wchar_t* name;
+    float coefficientOfRestitution; // COR (bounce height ratio)
+    float friction;
+    const char* key; // Short identifier for result files
+};
+
+extern CourtSurface courts[4];
+
+// Bounce data structure
+struct BounceData {
+    float time;
+    float height;
+    float xPosition; // Horizontal position for trajectory tracking
+};
+
+// Default trajectory samples kept per ball (~68 s of flight at DT)
+const size_t DEFAULT_TRAJECTORY_CAPACITY = 8192;
+
+// Fixed-capacity ring of trajectory samples. Storage is allocated once by
+// setCapacity; when full, push_back overwrites the oldest sample, so recording
+// never allocates on the update path. Indexing follows std::vector with [0]
+// the oldest retained sample and back() the newest.
+class TrajectoryBuffer {
+public:
+    explicit TrajectoryBuffer(size_t capacity = DEFAULT_TRAJECTORY_CAPACITY);
+
+    // Reallocates storage and discards all samples; capacity 0 records nothing
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return samples.size(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { head = 0; count = 0; pushed = 0; clears++; }
+
+    // Samples pushed since the last clear, including ones already overwritten; the
+    // oldest retained sample is number totalPushed() - size()
+    size_t totalPushed() const { return pushed; }
+    // Incremented by every clear, so caches built from the samples can tell a reset apart from growth
+    unsigned clearCount() const { return clears; }
+
+    // Makes this ring a copy of source, sample numbers and clear count included, so
+    // caches keyed on them treat both alike. Only the samples pushed since the last
+    // sync are copied, unless source was cleared or has overwritten them since.
+    void syncFrom(const TrajectoryBuffer& source);
+
+    void push_back(const BounceData& sample) {
+        if (samples.empty()) return;
+        size_t tail = head + count;
+        if (tail >= samples.size()) tail -= samples.size();
+        samples[tail] = sample;
+        pushed++;
+        if (count < samples.size()) {
+            count++;
+        } else if (++head == samples.size()) {
+            head = 0;
+        }
+    }
+
+    const BounceData& operator[](size_t index) const {
+        size_t slot = head + index;
+        if (slot >= samples.size()) slot -= samples.size();
+        return samples[slot];
+    }
+    const BounceData& front() const { return (*this)[0]; }
+    const BounceData& back() const { return (*this)[count - 1]; }
+
+private:
+    std::vector<BounceData> samples;
+    size_t head;   // Slot of the oldest sample
+    size_t count;
+    size_t pushed;
+    unsigned clears;
+};
+
+// Bounces recorded per shot
+const size_t MAX_RECORDED_BOUNCES = 3;
+
+// The first MAX_RECORDED_BOUNCES bounces, held inside the ball so that creating and
+// resetting balls never allocates. push_back ignores bounces past the capacity.
+class BounceList {
+public:
+    BounceList() : count(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    void push_back(const BounceData& bounce) {
+        if (count < MAX_RECORDED_BOUNCES) entries[count++] = bounce;
+    }
+
+    const BounceData& operator[](size_t index) const { return entries[index]; }
+
+private:
+    BounceData entries[MAX_RECORDED_BOUNCES];
+    size_t count;
+};
+
+// Tennis ball physics state
+class TennisBall {
+public:
+    float y;              // Height in meters
+    float vy;             // Vertical velocity in m/s
+    float x;              // Horizontal position in meters
+    float vx;             // Horizontal velocity in m/s
+    float time;           // Elapsed time in seconds
+    float prevX;          // Position before the last update, for render interpolation
+    float prevY;
+    int bounceCount;
+    bool isActive;
+    bool hitNet;          // Ball has struck the net during the current shot
+    CourtSurface* surface;
+    float restitution;    // surface's COR as of the last reset, so a settings reload leaves balls in flight alone
+    float airResistanceCoeff; // Air resistance coefficient
+    float spinRPM;        // Ball spin in revolutions per minute (positive = topspin, negative = backspin)
+    TrajectoryBuffer trajectory; // Most recent samples only; see TrajectoryBuffer
+    BounceList bounces;
+    bool recordTrajectory; // Batch runs turn this off to skip trajectory samples entirely
+    int stepCount;        // Integrator steps since the last reset
+    float eventStepHint;  // Adaptive step carried between updateEventDriven calls
+    Integrator* integrator; // Optional flight stepper (not owned); null uses AdvanceFlight
+    RandomStream random;  // Net deflection draws; give each ball its own stream for reproducible runs
+
+    // Pass record = false for headless runs: no trajectory storage is allocated
+    TennisBall(CourtSurface* courtSurface, bool record = true);
+
+    void reset();
+    void resetForHorizontalShot(float horizontalForce, float angleDegrees, float spin);
+
+    void setAirResistance(float coefficient) {
+        airResistanceCoeff = coefficient;
+    }
+
+    void setIntegrator(Integrator* flightIntegrator) {
+        integrator = flightIntegrator;
+    }
+
+    // Restarts the ball's random draws at the beginning of stream under seed
+    void setRandomStream(uint64_t seed, uint64_t stream) {
+        random.Seed(seed, stream);
+    }
+
+    void update(float dt);
+
+    // update() with an Integrator: net and ground contacts are located on the cubic through
+    // the step's end states and the rest of the step is integrated from the contact
+    void updateWithIntegrator(float dt);
+
+    // Advances dt seconds with the adaptive event-driven integrator (FlightEvents.h):
+    // net, ground and baseline contacts are resolved at their exact times instead of
+    // at the end of a fixed step. When rightyX > 0 the ball stops early on reaching
+    // that plane moving right, leaving the RIGHTY hit to the caller.
+    void updateEventDriven(float dt, float rightyX = -1.0f);
+
+    // Position between the previous and current step; alpha = 0 is the previous state
+    float interpolatedX(float alpha) const { return prevX + (x - prevX) * alpha; }
+    float interpolatedY(float alpha) const { return prevY + (y - prevY) * alpha; }
+};
+
+// Per-step physics shared by TennisBall and the batched kernels so both resolve events identically
+
+// Advances gravity, Magnus lift and horizontal drag by one semi-implicit Euler step.
+// Picks the AdvanceFlightKernel for the ball's air and spin, so a ball in vacuum
+// without spin only integrates gravity.
+void AdvanceFlight(float& x, float& y, float& vx, float& vy, float spinRPM, float airResistanceCoeff, float dt);
+
+// AdvanceFlight with drag and spin fixed at compile time. Drag = false is only valid
+// for airResistanceCoeff == 0 and Spin = false for spinRPM == 0; in those cases the
+// dropped terms add exact zeros, so every variant gives the same floats as the full step.
+template <bool Drag, bool Spin>
+inline void AdvanceFlightKernel(float& x, float& y, float& vx, float& vy, float spinRPM, float airResistanceCoeff,
+                                float dt) {
+    vy -= GRAVITY * dt;
+
+    if (Spin) {
+        // Magnus lift, F = k * omega * |v| with omega in rad/s, applied vertically above 0.1 m/s.
+        // Topspin (positive) curves down, backspin (negative) curves up.
+        float omega = spinRPM * 2.0f * 3.14159265f / 60.0f;
+        float ballSpeed = std::sqrt(vx * vx + vy * vy);
+        if (ballSpeed > 0.1f) {
+            float magnusForce = MAGNUS_COEFF * omega * ballSpeed;
+            float magnusAccelY = magnusForce / BALL_MASS;
+            vy -= magnusAccelY * dt;
+        }
+    }
+
+    y += vy * dt;
+
+    if (Drag) {
+        // Quadratic horizontal drag
+        float airResistanceForce = -airResistanceCoeff * vx * std::fabs(vx);
+        float ax = airResistanceForce / BALL_MASS;
+        vx += ax * dt;
+    }
+    x += vx * dt;
+}
+
+// Converts LEFTY launch force and angle into initial velocity components
+void ComputeLaunchVelocity(float horizontalForce, float angleDegrees, float& vx, float& vy);
+
+// Returns true if the ball crossed the net plane between prevX and x
+inline bool CrossedNetPlane(float prevX, float x) {
+    return (prevX < NET_X && x >= NET_X) || (prevX > NET_X && x <= NET_X);
+}
+
+// Resolves a net-plane crossing; returns true if the ball struck the net (state is deflected in place)
+bool ResolveNetContact(float prevX, float prevY, float& x, float& y, float& vx, float& vy, float& spinRPM,
+                       RandomStream& random);
+
+// Velocity and spin response of a ball striking the net; the small random deflection is drawn from random
+void DeflectOffNet(float& vx, float& vy, float& spinRPM, RandomStream& random);
+
+// Applies a ground bounce at y <= 0; returns false once the ball has come to rest
+bool ResolveGroundContact(float& y, float& vx, float& vy, float& spinRPM, int& bounceCount, float coefficientOfRestitution);
+
+// Launch parameters for one headless shot
+struct ShotParams {
+    float force;                 // Newtons
+    float angle;                 // degrees
+    float spin;                  // RPM
+    int surfaceIndex;            // Index into courts[]
+    AirResistanceMode airMode;   // Index into airModes[]
+    uint64_t randomStream;       // Stream of the shot's random draws; the same stream replays the same shot
+};
+
+// Outcome of one headless shot
+struct ShotResult {
+    float firstBounceX;   // Landing spot of the first bounce in meters (-1 if the ball never landed)
+    float firstBounceTime; // Time of the first bounce in seconds (-1 if the ball never landed)
+    float finalX;         // Horizontal position when the shot ended
+    float timeToRest;     // Simulated time until the ball stopped or left the court
+    int bounceCount;
+    int steps;            // Integration steps taken
+    bool hitNet;
+    bool leftCourt;       // Ball crossed a baseline before coming to rest
+};
+
+// How SimulationEngine advances a shot
+enum IntegrationMode {
+    INTEGRATION_FIXED_STEP,   // Semi-implicit Euler at timeStep; batches use the SIMD kernels
+    INTEGRATION_EVENT_DRIVEN  // Adaptive RK45 stepping straight to each contact (FlightEvents.h)
+};
+
+// Integrates batches of shots as fast as the CPU allows, independent of any window or timer
+class SimulationEngine {
+public:
+    SimulationEngine(float timeStep = DT, float maxShotTime = 60.0f);
+
+    void SetIntegrationMode(IntegrationMode mode) { integrationMode = mode; }
+    IntegrationMode GetIntegrationMode() const { return integrationMode; }
+
+    // Stepper for fixed-step shots; anything but Euler runs shot by shot instead of on BallBatch
+    void SetIntegrator(IntegratorType type) { integratorType = type; }
+    IntegratorType GetIntegrator() const { return integratorType; }
+
+    // Shots with neither drag nor spin fly a parabola from contact to contact. With this
+    // set, fixed-step batches solve those in closed form, as event-driven mode does, and
+    // leave the Euler batch to the rest; their results then follow the exact flight
+    // rather than the step's, so it is off by default.
+    void SetExactVacuum(bool exact) { exactVacuum = exact; }
+    bool GetExactVacuum() const { return exactVacuum; }
+
+    // Key of every shot's random stream; results depend only on it and ShotParams::randomStream
+    void SetRandomSeed(uint64_t seed) { randomSeed = seed; }
+    uint64_t GetRandomSeed() const { return randomSeed; }
+
+    ShotResult SimulateShot(const ShotParams& params) const;
+    // The same shot, calling observer with the ball after launch and after every step
+    // (e.g. a ShotRecorder archiving the trajectory)
+    ShotResult SimulateShot(const ShotParams& params, const std::function<void(const TennisBall&)>& observer) const;
+    void RunBatch(const ShotParams* params, size_t count, ShotResult* results) const;
+    std::vector<ShotResult> RunBatch(const std::vector<ShotParams>& params) const;
+
+private:
+    float timeStep;
+    float maxShotTime;
+    IntegrationMode integrationMode;
+    IntegratorType integratorType;
+    bool exactVacuum;
+    uint64_t randomSeed;
+};
@@ -0,0 +1,43 @@
+// Tennis Ball Physics Simulator - lock-free single-producer single-consumer queue
+// A fixed ring of Capacity slots (a power of two) between one producer thread and
+// one consumer thread. Push and Pop never block and never allocate; a full queue
+// refuses the push instead.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+template <class T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer: false, with the queue unchanged, when all Capacity slots are taken
+    bool Push(const T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[position & (Capacity - 1)] = item;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false when there is nothing to take
+    bool Pop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) return false;
+        item = slots[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head; // Next slot to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail; // Next slot to push, written by the producer
+};
@@ -0,0 +1,164 @@
+// Tennis Ball Physics Simulator - work-stealing thread pool
+
+#include "ThreadPool.h"
+
+namespace {
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) : pendingTasks(0), queuedTasks(0), nextQueue(0), stopping(false) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    WaitIdle();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::CurrentWorkerIndex() const {
+    return currentPool == this ? currentWorker : -1;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    pendingTasks++;
+    int self = CurrentWorkerIndex();
+    unsigned target = self >= 0 ? (unsigned)self : (unsigned)(nextQueue++ % workers.size());
+    PushTo(target, std::move(task));
+}
+
+void ThreadPool::ParallelFor(size_t taskCount, const std::function<void(size_t)>& body) {
+    if (taskCount == 0) return;
+
+    struct Latch {
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    Latch latch;
+    latch.remaining = taskCount;
+
+    // Deal contiguous blocks so neighbouring indices share a worker; stealing evens out the rest
+    unsigned workerCount = (unsigned)workers.size();
+    pendingTasks += taskCount;
+    for (unsigned w = 0; w < workerCount; w++) {
+        size_t begin = taskCount * w / workerCount;
+        size_t end = taskCount * (w + 1) / workerCount;
+        // Pushed in reverse so the owner's LIFO pops walk its block in ascending order
+        for (size_t i = end; i > begin; i--) {
+            size_t index = i - 1;
+            PushTo(w, [&body, &latch, index]() {
+                body(index);
+                // Decrement under the latch mutex so the waiter cannot destroy it mid-notify
+                std::lock_guard<std::mutex> lock(latch.mutex);
+                if (--latch.remaining == 0) {
+                    latch.done.notify_all();
+                }
+            });
+        }
+    }
+
+    // A worker calling ParallelFor helps drain the queues instead of blocking its own thread
+    int self = CurrentWorkerIndex();
+    if (self >= 0) {
+        while (latch.remaining > 0) {
+            std::function<void()> task;
+            if (PopLocal((unsigned)self, task) || Steal((unsigned)self, task)) {
+                task();
+                FinishTask();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        // Wait for the last finisher to release the latch before it goes out of scope
+        std::lock_guard<std::mutex> lock(latch.mutex);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(latch.mutex);
+    latch.done.wait(lock, [&latch]() { return latch.remaining == 0; });
+}
+
+void ThreadPool::WaitIdle() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idleCondition.wait(lock, [this]() { return pendingTasks == 0; });
+}
+
+void ThreadPool::WorkerLoop(unsigned index) {
+    currentPool = this;
+    currentWorker = (int)index;
+
+    for (;;) {
+        std::function<void()> task;
+        if (PopLocal(index, task) || Steal(index, task)) {
+            task();
+            FinishTask();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) return;
+    }
+}
+
+bool ThreadPool::PopLocal(unsigned index, std::function<void()>& task) {
+    WorkerQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queuedTasks--;
+    return true;
+}
+
+bool ThreadPool::Steal(unsigned thief, std::function<void()>& task) {
+    unsigned workerCount = (unsigned)queues.size();
+    for (unsigned offset = 1; offset < workerCount; offset++) {
+        WorkerQueue& victim = *queues[(thief + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        // Steal the oldest task: the far end of the victim's block, least likely to be cache-warm for it
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::PushTo(unsigned index, std::function<void()> task) {
+    {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queuedTasks++;
+    }
+    // Taking the sleep mutex orders this wakeup after a worker's predicate check
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void ThreadPool::FinishTask() {
+    if (--pendingTasks == 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        idleCondition.notify_all();
+    }
+}
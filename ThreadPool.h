@@ -0,0 +1,64 @@
+// Tennis Ball Physics Simulator - work-stealing thread pool
+// Each worker owns a deque: it pops its own work LIFO and steals FIFO from the
+// others when it runs dry, so uneven task lengths (short volleys next to long
+// rallies) are rebalanced without a central queue.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // threadCount = 0 uses every hardware thread
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned ThreadCount() const { return (unsigned)workers.size(); }
+
+    // Queues a task; called from a worker it lands on that worker's own deque
+    void Submit(std::function<void()> task);
+
+    // Runs body(i) for every i in [0, taskCount) and blocks until all calls return.
+    // Indices are dealt to workers in contiguous blocks and rebalanced by stealing.
+    void ParallelFor(size_t taskCount, const std::function<void(size_t)>& body);
+
+    // Blocks until every submitted task has finished (must not be called from a worker)
+    void WaitIdle();
+
+    // Index of the calling worker thread, or -1 when called from outside the pool
+    int CurrentWorkerIndex() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable idleCondition;
+    std::atomic<size_t> pendingTasks;   // Submitted but not yet finished
+    std::atomic<size_t> queuedTasks;    // Sitting in a deque, not yet picked up
+    std::atomic<size_t> nextQueue;      // Round-robin target for external submissions
+    bool stopping;
+
+    void WorkerLoop(unsigned index);
+    bool PopLocal(unsigned index, std::function<void()>& task);
+    bool Steal(unsigned thief, std::function<void()>& task);
+    void PushTo(unsigned index, std::function<void()> task);
+    void FinishTask();
+};
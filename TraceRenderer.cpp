@@ -0,0 +1,429 @@
+// Tennis Ball Physics Simulator - trajectory drawing
+
+#include "TraceRenderer.h"
+
+#include <cmath>
+
+namespace {
+    // Position traces may stray this far from their samples, in pixels
+    const float DECIMATION_TOLERANCE = 0.5f;
+
+    // Largest power of two not above unitsPerPixel, so the tolerance holds within a factor of two
+    float ResolutionLevel(float pixelsPerUnit) {
+        if (!(pixelsPerUnit > 0.0f) || std::isinf(pixelsPerUnit)) return 0.0f;
+        return exp2f(floorf(log2f(1.0f / pixelsPerUnit)));
+    }
+
+    // Distance from p to segment ab
+    float SegmentDistance(D2D1_POINT_2F p, D2D1_POINT_2F a, D2D1_POINT_2F b) {
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float lengthSquared = dx * dx + dy * dy;
+        float t = lengthSquared > 0.0f ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSquared : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        float ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+        return sqrtf(ex * ex + ey * ey);
+    }
+}
+
+void DrawTrajectoryTrace(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const TrajectoryBuffer& trajectory,
+                         float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor) {
+    for (size_t i = 1; i < trajectory.size(); i++) {
+        float x1 = courtMargin + (trajectory[i-1].xPosition / COURT_LENGTH) * courtPixelWidth;
+        float y1 = courtBottom - (trajectory[i-1].height * 50.0f * zoomFactor);
+        float x2 = courtMargin + (trajectory[i].xPosition / COURT_LENGTH) * courtPixelWidth;
+        float y2 = courtBottom - (trajectory[i].height * 50.0f * zoomFactor);
+
+        target->DrawLine(D2D1::Point2F(x1, y1), D2D1::Point2F(x2, y2), brush, 1.0f);
+    }
+}
+
+void DrawHeightGraphTrace(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const TrajectoryBuffer& trajectory,
+                          float plotX, float plotY, float plotWidth, float plotHeight, float maxTime, float maxHeight) {
+    float plotBottom = plotY + plotHeight;
+    for (size_t j = 1; j < trajectory.size(); j++) {
+        float x1 = plotX + (trajectory[j-1].time / maxTime) * plotWidth;
+        float y1 = plotBottom - (trajectory[j-1].height / maxHeight) * plotHeight;
+        float x2 = plotX + (trajectory[j].time / maxTime) * plotWidth;
+        float y2 = plotBottom - (trajectory[j].height / maxHeight) * plotHeight;
+
+        // Clamp to graph bounds
+        y1 = y1 < plotY ? plotY : (y1 > plotBottom ? plotBottom : y1);
+        y2 = y2 < plotY ? plotY : (y2 > plotBottom ? plotBottom : y2);
+
+        target->DrawLine(D2D1::Point2F(x1, y1), D2D1::Point2F(x2, y2), brush, 2.0f);
+    }
+}
+
+D2D1_MATRIX_3X2_F CourtTraceTransform(float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor) {
+    return D2D1::Matrix3x2F(courtPixelWidth / COURT_LENGTH, 0.0f,
+                            0.0f, -50.0f * zoomFactor,
+                            courtMargin, courtBottom);
+}
+
+float HeightGraphTimeSpan(float longestTime) {
+    float span = 1.0f;
+    while (span < longestTime) span *= 2.0f;
+    return span;
+}
+
+D2D1_MATRIX_3X2_F HeightGraphTransform(float plotX, float plotY, float plotWidth, float plotHeight, float maxTime,
+                                       float maxHeight) {
+    return D2D1::Matrix3x2F(plotWidth / maxTime, 0.0f,
+                            0.0f, -plotHeight / maxHeight,
+                            plotX, plotY + plotHeight);
+}
+
+TraceGeometry::TraceGeometry(TraceAxis axis, float maxHeight)
+    : axis(axis), maxHeight(maxHeight), tail(nullptr), group(nullptr), strokeStyle(nullptr),
+      nextChunkStart(0), builtSamples(0), vertexCount(0), tailVertices(0), unitsPerPixelX(0.0f), unitsPerPixelY(0.0f),
+      clearCount(0), groupDirty(false) {
+    points.reserve(CHUNK_SEGMENTS + 1);
+}
+
+TraceGeometry::~TraceGeometry() {
+    Clear();
+    if (strokeStyle) strokeStyle->Release();
+}
+
+void TraceGeometry::Clear() {
+    for (Chunk& chunk : sealed) {
+        chunk.geometry->Release();
+    }
+    sealed.clear();
+    if (tail) tail->Release();
+    tail = nullptr;
+    if (group) group->Release();
+    group = nullptr;
+    nextChunkStart = 0;
+    builtSamples = 0;
+    vertexCount = 0;
+    tailVertices = 0;
+    groupDirty = false;
+}
+
+void TraceGeometry::SetPixelScale(float pixelsPerUnitX, float pixelsPerUnitY) {
+    float levelX = ResolutionLevel(pixelsPerUnitX);
+    float levelY = ResolutionLevel(pixelsPerUnitY);
+    if (levelX == unitsPerPixelX && levelY == unitsPerPixelY) return;
+
+    // Chunks built at the old level would be too coarse or needlessly fine
+    Clear();
+    unitsPerPixelX = levelX;
+    unitsPerPixelY = levelY;
+}
+
+void TraceGeometry::Decimate() {
+    if (unitsPerPixelX <= 0.0f || unitsPerPixelY <= 0.0f || points.size() <= 2) return;
+
+    size_t kept = 0;
+    if (axis == TRACE_AXIS_TIME) {
+        // Time only grows, so each pixel column is one run of points: keep its first,
+        // lowest, highest and last, in order, which draws the same vertical extent
+        size_t begin = 0;
+        while (begin < points.size()) {
+            float column = floorf(points[begin].x / unitsPerPixelX);
+            size_t end = begin + 1, lowest = begin, highest = begin;
+            while (end < points.size() && floorf(points[end].x / unitsPerPixelX) == column) {
+                if (points[end].y < points[lowest].y) lowest = end;
+                if (points[end].y > points[highest].y) highest = end;
+                end++;
+            }
+            size_t runKeep[4] = {begin, lowest < highest ? lowest : highest, lowest < highest ? highest : lowest, end - 1};
+            for (int k = 0; k < 4; k++) {
+                if (k > 0 && runKeep[k] == runKeep[k - 1]) continue;
+                points[kept++] = points[runKeep[k]];
+            }
+            begin = end;
+        }
+    } else {
+        // Ramer-Douglas-Peucker in pixel units; the ends of the chunk always stay, so
+        // neighbouring chunks still meet
+        keep.assign(points.size(), 0);
+        keep.front() = keep.back() = 1;
+        spans.clear();
+        spans.push_back(std::make_pair(size_t(0), points.size() - 1));
+        while (!spans.empty()) {
+            std::pair<size_t, size_t> span = spans.back();
+            spans.pop_back();
+            D2D1_POINT_2F a = D2D1::Point2F(points[span.first].x / unitsPerPixelX, points[span.first].y / unitsPerPixelY);
+            D2D1_POINT_2F b = D2D1::Point2F(points[span.second].x / unitsPerPixelX, points[span.second].y / unitsPerPixelY);
+            float farthest = DECIMATION_TOLERANCE;
+            size_t split = 0;
+            for (size_t i = span.first + 1; i < span.second; i++) {
+                D2D1_POINT_2F p = D2D1::Point2F(points[i].x / unitsPerPixelX, points[i].y / unitsPerPixelY);
+                float distance = SegmentDistance(p, a, b);
+                if (distance > farthest) {
+                    farthest = distance;
+                    split = i;
+                }
+            }
+            if (split) {
+                keep[split] = 1;
+                if (split - span.first > 1) spans.push_back(std::make_pair(span.first, split));
+                if (span.second - split > 1) spans.push_back(std::make_pair(split, span.second));
+            }
+        }
+        for (size_t i = 0; i < points.size(); i++) {
+            if (keep[i]) points[kept++] = points[i];
+        }
+    }
+    points.resize(kept);
+}
+
+HRESULT TraceGeometry::BuildChunk(ID2D1Factory* factory, const TrajectoryBuffer& trajectory, size_t first, size_t last,
+                                  ID2D1PathGeometry** geometry) {
+    size_t oldest = trajectory.totalPushed() - trajectory.size();
+    points.clear();
+    for (size_t sample = first; sample <= last; sample++) {
+        const BounceData& point = trajectory[sample - oldest];
+        float height = point.height;
+        if (maxHeight > 0.0f) {
+            height = height < 0.0f ? 0.0f : (height > maxHeight ? maxHeight : height);
+        }
+        points.push_back(D2D1::Point2F(axis == TRACE_AXIS_TIME ? point.time : point.xPosition, height));
+    }
+    Decimate();
+
+    ID2D1PathGeometry* path = nullptr;
+    HRESULT hr = factory->CreatePathGeometry(&path);
+    ID2D1GeometrySink* sink = nullptr;
+    if (SUCCEEDED(hr)) {
+        hr = path->Open(&sink);
+    }
+    if (SUCCEEDED(hr)) {
+        sink->BeginFigure(points[0], D2D1_FIGURE_BEGIN_HOLLOW);
+        sink->AddLines(&points[1], (UINT32)(points.size() - 1));
+        sink->EndFigure(D2D1_FIGURE_END_OPEN);
+        hr = sink->Close();
+        sink->Release();
+    }
+    if (FAILED(hr)) {
+        if (path) path->Release();
+        return hr;
+    }
+    *geometry = path;
+    return S_OK;
+}
+
+HRESULT TraceGeometry::Update(ID2D1Factory* factory, const TrajectoryBuffer& trajectory) {
+    size_t pushed = trajectory.totalPushed();
+    if (trajectory.clearCount() != clearCount || pushed < builtSamples) {
+        Clear();
+        clearCount = trajectory.clearCount();
+    }
+    if (pushed == builtSamples) return S_OK;
+
+    // Drop chunks whose every sample has been overwritten in the ring
+    size_t oldest = pushed - trajectory.size();
+    size_t expired = 0;
+    while (expired < sealed.size() && sealed[expired].lastSample < oldest) {
+        vertexCount -= sealed[expired].vertices;
+        sealed[expired].geometry->Release();
+        expired++;
+    }
+    if (expired > 0) {
+        sealed.erase(sealed.begin(), sealed.begin() + expired);
+        groupDirty = true;
+    }
+    // More samples than the ring holds arrived since the last update
+    if (nextChunkStart < oldest) nextChunkStart = oldest;
+
+    // Seal every full chunk; consecutive chunks share their boundary sample
+    HRESULT hr = S_OK;
+    while (SUCCEEDED(hr) && pushed - 1 - nextChunkStart >= CHUNK_SEGMENTS) {
+        ID2D1PathGeometry* geometry = nullptr;
+        size_t last = nextChunkStart + CHUNK_SEGMENTS;
+        hr = BuildChunk(factory, trajectory, nextChunkStart, last, &geometry);
+        if (SUCCEEDED(hr)) {
+            sealed.push_back({geometry, last, points.size()});
+            vertexCount += points.size();
+            nextChunkStart = last;
+        }
+    }
+
+    if (tail) tail->Release();
+    tail = nullptr;
+    vertexCount -= tailVertices;
+    tailVertices = 0;
+    if (SUCCEEDED(hr) && pushed - nextChunkStart >= 2) {
+        hr = BuildChunk(factory, trajectory, nextChunkStart, pushed - 1, &tail);
+        if (SUCCEEDED(hr)) {
+            tailVertices = points.size();
+            vertexCount += tailVertices;
+        }
+    }
+    groupDirty = true;
+
+    if (FAILED(hr)) {
+        Clear();
+        return hr;
+    }
+    builtSamples = pushed;
+    return S_OK;
+}
+
+HRESULT TraceGeometry::Prepare(ID2D1Factory* factory, const TrajectoryBuffer& trajectory,
+                               const D2D1_MATRIX_3X2_F& worldToPixels) {
+    SetPixelScale(fabsf(worldToPixels._11), fabsf(worldToPixels._22));
+    HRESULT hr = Update(factory, trajectory);
+    if (FAILED(hr)) return hr;
+
+    if (groupDirty) {
+        if (group) group->Release();
+        group = nullptr;
+        groupDirty = false;
+
+        groupMembers.clear();
+        for (const Chunk& chunk : sealed) {
+            groupMembers.push_back(chunk.geometry);
+        }
+        if (tail) groupMembers.push_back(tail);
+        if (!groupMembers.empty()) {
+            hr = factory->CreateGeometryGroup(D2D1_FILL_MODE_WINDING, groupMembers.data(), (UINT32)groupMembers.size(),
+                                              &group);
+            if (FAILED(hr)) return hr;
+        }
+    }
+    if (!group) return S_OK;
+
+    if (!strokeStyle) {
+        hr = factory->CreateStrokeStyle(
+            D2D1::StrokeStyleProperties(D2D1_CAP_STYLE_FLAT, D2D1_CAP_STYLE_FLAT, D2D1_CAP_STYLE_FLAT,
+                                        D2D1_LINE_JOIN_ROUND),
+            nullptr, 0, &strokeStyle);
+        if (FAILED(hr)) return hr;
+    }
+    return S_OK;
+}
+
+HRESULT TraceGeometry::Draw(ID2D1Factory* factory, ID2D1RenderTarget* target, ID2D1Brush* brush,
+                            const TrajectoryBuffer& trajectory, const D2D1_MATRIX_3X2_F& worldToPixels,
+                            float strokeWidth) {
+    HRESULT hr = Prepare(factory, trajectory, worldToPixels);
+    if (FAILED(hr) || !group) return hr;
+
+    ID2D1TransformedGeometry* transformed = nullptr;
+    hr = factory->CreateTransformedGeometry(group, worldToPixels, &transformed);
+    if (FAILED(hr)) return hr;
+    target->DrawGeometry(transformed, brush, strokeWidth, strokeStyle);
+    transformed->Release();
+    return S_OK;
+}
+
+HeightGraphLayer::HeightGraphLayer(float maxHeight)
+    : maxHeight(maxHeight), parent(nullptr), layer(nullptr), bitmap(nullptr), strokeStyle(nullptr),
+      size(D2D1::SizeF(0.0f, 0.0f)), timeSpan(0.0f), invalid(true) {
+}
+
+HeightGraphLayer::~HeightGraphLayer() {
+    Discard();
+    if (strokeStyle) strokeStyle->Release();
+}
+
+void HeightGraphLayer::Discard() {
+    if (bitmap) bitmap->Release();
+    if (layer) layer->Release();
+    if (parent) parent->Release();
+    bitmap = nullptr;
+    layer = nullptr;
+    parent = nullptr;
+    invalid = true;
+}
+
+HRESULT HeightGraphLayer::Begin(ID2D1RenderTarget* target, D2D1_SIZE_F layerSize, float span,
+                                const TrajectoryBuffer* const* trajectories, size_t traceCount, bool& redraw) {
+    redraw = false;
+    if (target != parent || layerSize.width != size.width || layerSize.height != size.height) {
+        Discard();
+    }
+
+    HRESULT hr = S_OK;
+    if (!layer) {
+        // Premultiplied alpha keeps the panel see-through like drawing it straight onto the target
+        D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+        hr = target->CreateCompatibleRenderTarget(&layerSize, nullptr, &format,
+                                                  D2D1_COMPATIBLE_RENDER_TARGET_OPTIONS_NONE, &layer);
+        if (SUCCEEDED(hr)) hr = layer->GetBitmap(&bitmap);
+        if (FAILED(hr)) {
+            Discard();
+            return hr;
+        }
+        layer->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE); // ClearType needs an opaque target
+        parent = target;
+        parent->AddRef();
+        size = layerSize;
+    }
+    if (!strokeStyle) {
+        ID2D1Factory* factory;
+        target->GetFactory(&factory);
+        hr = factory->CreateStrokeStyle(
+            D2D1::StrokeStyleProperties(D2D1_CAP_STYLE_ROUND, D2D1_CAP_STYLE_ROUND, D2D1_CAP_STYLE_FLAT,
+                                        D2D1_LINE_JOIN_ROUND),
+            nullptr, 0, &strokeStyle);
+        factory->Release();
+        if (FAILED(hr)) return hr;
+    }
+
+    if (span != timeSpan || traceCount != traces.size()) invalid = true;
+    for (size_t i = 0; !invalid && i < traceCount; i++) {
+        const TrajectoryBuffer& trajectory = *trajectories[i];
+        invalid = trajectory.clearCount() != traces[i].clearCount || trajectory.totalPushed() < traces[i].drawnSamples;
+    }
+
+    layer->BeginDraw();
+    if (invalid) {
+        layer->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+        traces.resize(traceCount);
+        for (size_t i = 0; i < traceCount; i++) {
+            traces[i].clearCount = trajectories[i]->clearCount();
+            traces[i].drawnSamples = 0;
+        }
+        timeSpan = span;
+        invalid = false;
+        redraw = true;
+    }
+    return S_OK;
+}
+
+HRESULT HeightGraphLayer::DrawTrace(size_t trace, ID2D1Factory* factory, TraceGeometry* geometry, ID2D1Brush* brush,
+                                    const TrajectoryBuffer& trajectory, const D2D1_MATRIX_3X2_F& toLayer,
+                                    float strokeWidth) {
+    TraceState& state = traces[trace];
+    size_t pushed = trajectory.totalPushed();
+    size_t oldest = pushed - trajectory.size();
+    size_t drawn = state.drawnSamples;
+    state.drawnSamples = pushed;
+    if (trajectory.size() < 2 || pushed == drawn) return S_OK;
+
+    if (drawn == 0 && geometry &&
+        SUCCEEDED(geometry->Draw(factory, layer, brush, trajectory, toLayer, strokeWidth))) {
+        return S_OK;
+    }
+
+    // New segments start at the last sample already drawn, or the oldest one kept
+    size_t first = drawn > oldest ? drawn - 1 - oldest : 0;
+    auto toPoint = [&](const BounceData& sample) {
+        float height = sample.height < 0.0f ? 0.0f : (sample.height > maxHeight ? maxHeight : sample.height);
+        return D2D1::Point2F(sample.time * toLayer._11 + height * toLayer._21 + toLayer._31,
+                             sample.time * toLayer._12 + height * toLayer._22 + toLayer._32);
+    };
+    D2D1_POINT_2F from = toPoint(trajectory[first]);
+    for (size_t i = first + 1; i < trajectory.size(); i++) {
+        D2D1_POINT_2F to = toPoint(trajectory[i]);
+        layer->DrawLine(from, to, brush, strokeWidth, strokeStyle);
+        from = to;
+    }
+    return S_OK;
+}
+
+HRESULT HeightGraphLayer::End(D2D1_POINT_2F origin) {
+    // A lost device fails here as well as on the parent, whose EndDraw reports it
+    HRESULT hr = layer->EndDraw();
+    if (FAILED(hr)) {
+        Discard();
+        return hr;
+    }
+    parent->DrawBitmap(bitmap, D2D1::RectF(origin.x, origin.y, origin.x + size.width, origin.y + size.height), 1.0f,
+                       D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+    return S_OK;
+}
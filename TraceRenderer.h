@@ -0,0 +1,175 @@
+// Tennis Ball Physics Simulator - trajectory drawing
+// Direct2D drawing of recorded trajectories, shared by the application and the
+// benchmark suite so both measure the same per-frame work.
+
+#pragma once
+
+#include <d2d1.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "SimulationEngine.h"
+
+// Side view of one court: x maps onto [courtMargin, courtMargin + courtPixelWidth],
+// height rises from courtBottom at 50 pixels per meter scaled by zoomFactor
+void DrawTrajectoryTrace(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const TrajectoryBuffer& trajectory,
+                         float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor);
+
+// Height against time inside the plot rectangle; time spans [0, maxTime] across plotWidth
+// and heights are clamped to [0, maxHeight]
+void DrawHeightGraphTrace(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush, const TrajectoryBuffer& trajectory,
+                          float plotX, float plotY, float plotWidth, float plotHeight, float maxTime, float maxHeight);
+
+// World-to-pixel mappings of the two views, for TraceGeometry::Draw
+D2D1_MATRIX_3X2_F CourtTraceTransform(float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor);
+D2D1_MATRIX_3X2_F HeightGraphTransform(float plotX, float plotY, float plotWidth, float plotHeight, float maxTime,
+                                       float maxHeight);
+
+// Time span of the height graph's axis: the smallest power of two seconds, one or
+// more, that holds longestTime, so the axis rescales only when a trace outgrows it
+float HeightGraphTimeSpan(float longestTime);
+
+// Horizontal coordinate a TraceGeometry plots against height
+enum TraceAxis {
+    TRACE_AXIS_POSITION, // xPosition in meters (court views)
+    TRACE_AXIS_TIME      // time in seconds (height graph)
+};
+
+// A trajectory kept as Direct2D path geometry in world units, so a frame draws it
+// with one DrawGeometry call instead of one DrawLine per sample. Samples are cut into
+// sealed chunks of CHUNK_SEGMENTS segments; new samples only rebuild the open tail
+// chunk, samples lost off the front of the ring drop whole chunks, and a cleared
+// trajectory rebuilds from scratch. Frame cost no longer depends on how many
+// samples the trajectory holds.
+//
+// Once the pixel scale is known (Draw passes it on), each chunk is also decimated to
+// what the screen can show: time traces keep the first, lowest, highest and last
+// point of every pixel column, position traces are simplified by Ramer-Douglas-Peucker
+// to half a pixel. A chunk then costs vertices in proportion to the pixels it spans
+// rather than to its samples, however long the shot or rally. The scale is kept
+// to a power of two, so a graph whose time axis keeps stretching rebuilds only each
+// time it has doubled.
+class TraceGeometry {
+public:
+    static const size_t CHUNK_SEGMENTS = 256;
+
+    // maxHeight > 0 clamps heights to [0, maxHeight] as the graph does
+    explicit TraceGeometry(TraceAxis axis = TRACE_AXIS_POSITION, float maxHeight = 0.0f);
+    ~TraceGeometry();
+
+    TraceGeometry(const TraceGeometry&) = delete;
+    TraceGeometry& operator=(const TraceGeometry&) = delete;
+
+    // Decimates for pixelsPerUnitX/Y pixels per world unit (<= 0 keeps every sample);
+    // a change of resolution level rebuilds on the next Update
+    void SetPixelScale(float pixelsPerUnitX, float pixelsPerUnitY);
+
+    // Brings the geometry up to date with trajectory
+    HRESULT Update(ID2D1Factory* factory, const TrajectoryBuffer& trajectory);
+
+    // Sets the pixel scale of worldToPixels and builds everything Draw needs. It only
+    // calls the factory, so traces can be prepared on worker threads when the factory
+    // is multithreaded; Draw then has nothing left to build.
+    HRESULT Prepare(ID2D1Factory* factory, const TrajectoryBuffer& trajectory, const D2D1_MATRIX_3X2_F& worldToPixels);
+
+    // Prepares, then strokes the whole trace once through worldToPixels. The transform
+    // is applied to the geometry, so strokeWidth stays in pixels.
+    HRESULT Draw(ID2D1Factory* factory, ID2D1RenderTarget* target, ID2D1Brush* brush, const TrajectoryBuffer& trajectory,
+                 const D2D1_MATRIX_3X2_F& worldToPixels, float strokeWidth);
+
+    // Releases every chunk; the next Update rebuilds from the trajectory
+    void Clear();
+
+    // Vertices of the current geometry, after decimation
+    size_t VertexCount() const { return vertexCount; }
+
+private:
+    struct Chunk {
+        ID2D1PathGeometry* geometry;
+        size_t lastSample; // Sample number (see TrajectoryBuffer::totalPushed) of the chunk's final point
+        size_t vertices;
+    };
+
+    // Drops the points of the scratch chunk the screen cannot tell apart
+    void Decimate();
+
+    HRESULT BuildChunk(ID2D1Factory* factory, const TrajectoryBuffer& trajectory, size_t first, size_t last,
+                       ID2D1PathGeometry** geometry);
+
+    TraceAxis axis;
+    float maxHeight;
+    std::vector<Chunk> sealed;
+    ID2D1PathGeometry* tail;       // Open chunk from nextChunkStart to the newest sample
+    ID2D1GeometryGroup* group;     // sealed + tail, rebuilt when either changes
+    ID2D1StrokeStyle* strokeStyle; // Round joins; mitred joins spike at bounce vertices
+    size_t nextChunkStart;         // First sample of the open chunk
+    size_t builtSamples;           // totalPushed() the chunks were last brought up to
+    size_t vertexCount;
+    size_t tailVertices;
+    float unitsPerPixelX;          // Decimation resolution, powers of two; 0 = none
+    float unitsPerPixelY;
+    unsigned clearCount;
+    bool groupDirty;
+    std::vector<D2D1_POINT_2F> points;        // Scratch for BuildChunk
+    std::vector<ID2D1Geometry*> groupMembers; // Scratch for the group rebuild
+    std::vector<uint8_t> keep;                // Scratch for Decimate
+    std::vector<std::pair<size_t, size_t>> spans;
+};
+
+// The height graph kept in an offscreen bitmap compatible with the frame's target.
+// Each frame strokes only the segments appended since the previous frame into the
+// bitmap and draws the bitmap with one DrawBitmap. The panel, grid, labels and whole
+// traces are drawn again only on a redraw: when the time span changes, a trace is
+// cleared, or the bitmap is first created or recreated for a new target (device
+// loss). Segments whose samples the ring has dropped stay on the bitmap
+// until the next redraw. Brushes of the frame's target also draw on the bitmap.
+//
+// Per frame: Begin; on a redraw, draw the static parts into Target(); DrawTrace for
+// every trace; End.
+class HeightGraphLayer {
+public:
+    // maxHeight clamps heights to [0, maxHeight] as the graph does
+    explicit HeightGraphLayer(float maxHeight);
+    ~HeightGraphLayer();
+
+    HeightGraphLayer(const HeightGraphLayer&) = delete;
+    HeightGraphLayer& operator=(const HeightGraphLayer&) = delete;
+
+    // Opens the size-DIP bitmap for drawing. traces are this frame's trajectories, in
+    // DrawTrace order. When everything has to be drawn again, redraw is set and the
+    // bitmap is cleared to transparent.
+    HRESULT Begin(ID2D1RenderTarget* parent, D2D1_SIZE_F size, float timeSpan, const TrajectoryBuffer* const* traces,
+                  size_t traceCount, bool& redraw);
+
+    // The bitmap's target between Begin and End; (0, 0) is the graph's top left corner
+    ID2D1BitmapRenderTarget* Target() const { return layer; }
+
+    // Strokes the samples of trace not yet on the bitmap through toLayer (a
+    // HeightGraphTransform in bitmap coordinates). After a redraw that is the whole
+    // trace, stroked with geometry when one is given.
+    HRESULT DrawTrace(size_t trace, ID2D1Factory* factory, TraceGeometry* geometry, ID2D1Brush* brush,
+                      const TrajectoryBuffer& trajectory, const D2D1_MATRIX_3X2_F& toLayer, float strokeWidth);
+
+    // Closes the bitmap and draws it onto the parent target with its top left at origin
+    HRESULT End(D2D1_POINT_2F origin);
+
+    // Releases the bitmap and the parent target; the next Begin recreates them
+    void Discard();
+
+private:
+    struct TraceState {
+        unsigned clearCount;
+        size_t drawnSamples; // totalPushed() the bitmap holds the trace up to; 0 after a redraw
+    };
+
+    float maxHeight;
+    ID2D1RenderTarget* parent;     // Held, so a target recreated after device loss is never taken for it
+    ID2D1BitmapRenderTarget* layer;
+    ID2D1Bitmap* bitmap;
+    ID2D1StrokeStyle* strokeStyle; // Round caps, so segments stroked one by one join without gaps
+    D2D1_SIZE_F size;
+    float timeSpan;
+    bool invalid;
+    std::vector<TraceState> traces;
+};
@@ -0,0 +1,418 @@
+// Tennis Ball Physics Simulator - trajectory archives
+
+#include "TrajectoryArchive.h"
+#include "FileMapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const int VALUE_COLUMNS = 6; // time, x, y, vx, vy, spin; flags follow as raw bytes
+
+    float ColumnValue(const TrajectorySample& sample, int column) {
+        switch (column) {
+            case 0: return sample.time;
+            case 1: return sample.x;
+            case 2: return sample.y;
+            case 3: return sample.vx;
+            case 4: return sample.vy;
+            default: return sample.spin;
+        }
+    }
+
+    void SetColumnValue(TrajectorySample& sample, int column, float value) {
+        switch (column) {
+            case 0: sample.time = value; break;
+            case 1: sample.x = value; break;
+            case 2: sample.y = value; break;
+            case 3: sample.vx = value; break;
+            case 4: sample.vy = value; break;
+            default: sample.spin = value; break;
+        }
+    }
+
+    const double* DefaultQuanta() {
+        static const double quanta[VALUE_COLUMNS] = {
+            ARCHIVE_TIME_QUANTUM, ARCHIVE_POSITION_QUANTUM, ARCHIVE_POSITION_QUANTUM,
+            ARCHIVE_VELOCITY_QUANTUM, ARCHIVE_VELOCITY_QUANTUM, ARCHIVE_SPIN_QUANTUM
+        };
+        return quanta;
+    }
+
+    void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t byte = *p++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint64_t ZigZag(int64_t value) {
+        return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t UnZigZag(uint64_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    // Flight is smooth between contacts, so second differences of the quantized
+    // columns stay within one or two varint bytes; contacts cost a few bytes once
+    void EncodeChunk(const std::vector<TrajectorySample>& samples, std::vector<uint8_t>& out) {
+        ChunkHeader header = {};
+        header.sampleCount = (uint32_t)samples.size();
+        out.assign(sizeof(header), 0);
+
+        for (int column = 0; column < VALUE_COLUMNS; column++) {
+            size_t start = out.size();
+            double quantum = DefaultQuanta()[column];
+            int64_t previous = 0, previousDelta = 0;
+            for (const TrajectorySample& sample : samples) {
+                int64_t value = (int64_t)llround(ColumnValue(sample, column) / quantum);
+                int64_t delta = value - previous;
+                PutVarint(out, ZigZag(delta - previousDelta));
+                previous = value;
+                previousDelta = delta;
+            }
+            header.columnBytes[column] = (uint32_t)(out.size() - start);
+        }
+
+        for (const TrajectorySample& sample : samples) {
+            out.push_back(sample.flags);
+        }
+        header.columnBytes[VALUE_COLUMNS] = (uint32_t)samples.size();
+        memcpy(out.data(), &header, sizeof(header));
+    }
+}
+
+void ShotRecorder::Begin(const ShotParams& shot) {
+    params = shot;
+    samples.clear();
+    lastBounceCount = 0;
+    lastHitNet = false;
+}
+
+void ShotRecorder::Record(const TennisBall& ball, uint8_t extraFlags) {
+    uint8_t flags = extraFlags;
+    if (samples.empty()) flags |= SAMPLE_SHOT_START;
+    // RIGHTY returns restart the counters, so only increases mark a contact
+    if (ball.bounceCount > lastBounceCount) flags |= SAMPLE_BOUNCE;
+    if (ball.hitNet && !lastHitNet) flags |= SAMPLE_NET;
+    lastBounceCount = ball.bounceCount;
+    lastHitNet = ball.hitNet;
+
+    samples.push_back({ball.time, ball.x, ball.y, ball.vx, ball.vy, ball.spinRPM, flags});
+}
+
+TrajectoryWriter::TrajectoryWriter()
+    : file(nullptr), sampleCount(0), fileOffset(0), closing(false), writeFailed(false) {
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    Close();
+}
+
+bool TrajectoryWriter::Open(const wchar_t* path) {
+    Close();
+    file = CreateBinaryFile(path);
+    if (!file) return false;
+
+    ArchiveHeader header = {};
+    memcpy(header.magic, "TBTA", 4);
+    header.version = ARCHIVE_VERSION;
+    header.chunkSamples = ARCHIVE_CHUNK_SAMPLES;
+    header.timeQuantum = ARCHIVE_TIME_QUANTUM;
+    header.positionQuantum = ARCHIVE_POSITION_QUANTUM;
+    header.velocityQuantum = ARCHIVE_VELOCITY_QUANTUM;
+    header.spinQuantum = ARCHIVE_SPIN_QUANTUM;
+
+    shots.clear();
+    chunks.clear();
+    pendingChunks.clear();
+    openChunk.clear();
+    openChunk.reserve(ARCHIVE_CHUNK_SAMPLES);
+    sampleCount = 0;
+    fileOffset = sizeof(header);
+    closing = false;
+    writeFailed = fwrite(&header, sizeof(header), 1, file) != 1;
+
+    writerThread = std::thread(&TrajectoryWriter::WriterLoop, this);
+    return true;
+}
+
+bool TrajectoryWriter::Close() {
+    if (!file) return false;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!openChunk.empty()) {
+            pendingChunks.push_back(std::move(openChunk));
+            openChunk.clear();
+        }
+        closing = true;
+    }
+    chunkReady.notify_one();
+    writerThread.join();
+
+    // Tables start 8-byte aligned so the reader can use them in place
+    static const uint8_t padding[8] = {};
+    size_t pad = (size_t)((8 - fileOffset % 8) % 8);
+    bool ok = !writeFailed && fwrite(padding, 1, pad, file) == pad;
+    fileOffset += pad;
+
+    ArchiveTrailer trailer = {};
+    trailer.shotTableOffset = fileOffset;
+    trailer.shotCount = shots.size();
+    trailer.chunkTableOffset = fileOffset + shots.size() * sizeof(ArchivedShot);
+    trailer.chunkCount = chunks.size();
+    trailer.sampleCount = sampleCount;
+    memcpy(trailer.magic, "TBTE", 4);
+    trailer.version = ARCHIVE_VERSION;
+
+    ok = ok && fwrite(shots.data(), sizeof(ArchivedShot), shots.size(), file) == shots.size();
+    ok = ok && fwrite(chunks.data(), sizeof(ArchiveChunk), chunks.size(), file) == chunks.size();
+    ok = ok && fwrite(&trailer, sizeof(trailer), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+void TrajectoryWriter::AppendShot(uint64_t shotId, const ShotParams& shot, const TrajectorySample* samples,
+                                  size_t count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    // Back-pressure: a producer faster than the disk waits here instead of buffering
+    // without bound. Only before the shot starts, so no other shot can interleave with it.
+    chunkWritten.wait(lock, [this]() { return pendingChunks.size() < ARCHIVE_MAX_PENDING_CHUNKS || writeFailed; });
+    if (!file || closing) return;
+
+    ArchivedShot entry;
+    entry.shotId = shotId;
+    entry.firstSample = sampleCount;
+    entry.sampleCount = (uint32_t)count;
+    entry.force = shot.force;
+    entry.angle = shot.angle;
+    entry.spin = shot.spin;
+    entry.surfaceIndex = shot.surfaceIndex;
+    entry.airMode = shot.airMode;
+    shots.push_back(entry);
+    sampleCount += count;
+
+    while (count > 0) {
+        size_t room = ARCHIVE_CHUNK_SAMPLES - openChunk.size();
+        size_t taken = count < room ? count : room;
+        openChunk.insert(openChunk.end(), samples, samples + taken);
+        samples += taken;
+        count -= taken;
+        if (openChunk.size() == ARCHIVE_CHUNK_SAMPLES) {
+            QueueOpenChunk();
+        }
+    }
+}
+
+size_t TrajectoryWriter::ShotCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shots.size();
+}
+
+void TrajectoryWriter::QueueOpenChunk() {
+    pendingChunks.push_back(std::move(openChunk));
+    // Chunks the writer thread is done with come back empty with their capacity
+    if (freeChunks.empty()) {
+        openChunk = std::vector<TrajectorySample>();
+        openChunk.reserve(ARCHIVE_CHUNK_SAMPLES);
+    } else {
+        openChunk = std::move(freeChunks.back());
+        freeChunks.pop_back();
+    }
+    chunkReady.notify_one();
+}
+
+void TrajectoryWriter::WriterLoop() {
+    uint64_t firstSample = 0;
+    std::vector<uint8_t> encoded;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        chunkReady.wait(lock, [this]() { return !pendingChunks.empty() || closing; });
+        if (pendingChunks.empty()) break;
+
+        std::vector<TrajectorySample> samples = std::move(pendingChunks.front());
+        pendingChunks.pop_front();
+        lock.unlock();
+
+        EncodeChunk(samples, encoded);
+        bool written = fwrite(encoded.data(), 1, encoded.size(), file) == encoded.size();
+
+        ArchiveChunk chunk;
+        chunk.offset = fileOffset;
+        chunk.firstSample = firstSample;
+        chunk.sampleCount = (uint32_t)samples.size();
+        chunk.byteCount = (uint32_t)encoded.size();
+        chunks.push_back(chunk);
+        firstSample += samples.size();
+        fileOffset += encoded.size();
+
+        lock.lock();
+        samples.clear();
+        freeChunks.push_back(std::move(samples));
+        if (!written) writeFailed = true;
+        chunkWritten.notify_all();
+    }
+}
+
+TrajectoryReader::TrajectoryReader()
+    : data(nullptr), size(0), shotTable(nullptr), chunkTable(nullptr), shotCount(0), chunkCount(0), sampleCount(0),
+      cachedChunk(0) {
+}
+
+TrajectoryReader::~TrajectoryReader() {
+    Close();
+}
+
+bool TrajectoryReader::Open(const wchar_t* path) {
+    Close();
+    data = MapFileReadOnly(path, size);
+    if (!data) return false;
+
+    ArchiveHeader header;
+    ArchiveTrailer trailer;
+    bool valid = size >= sizeof(header) + sizeof(trailer);
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+        uint64_t tablesEnd = size - sizeof(trailer);
+        valid = memcmp(header.magic, "TBTA", 4) == 0 && header.version == ARCHIVE_VERSION &&
+                memcmp(trailer.magic, "TBTE", 4) == 0 && trailer.version == ARCHIVE_VERSION &&
+                trailer.shotTableOffset % 8 == 0 && trailer.shotTableOffset <= tablesEnd &&
+                trailer.shotCount <= (tablesEnd - trailer.shotTableOffset) / sizeof(ArchivedShot) &&
+                trailer.chunkTableOffset == trailer.shotTableOffset + trailer.shotCount * sizeof(ArchivedShot) &&
+                trailer.chunkCount <= (tablesEnd - trailer.chunkTableOffset) / sizeof(ArchiveChunk);
+    }
+    if (!valid) {
+        Close();
+        return false;
+    }
+
+    double quanta[VALUE_COLUMNS] = {
+        header.timeQuantum, header.positionQuantum, header.positionQuantum,
+        header.velocityQuantum, header.velocityQuantum, header.spinQuantum
+    };
+    memcpy(columnQuanta, quanta, sizeof(quanta));
+    shotTable = (const ArchivedShot*)(data + trailer.shotTableOffset);
+    chunkTable = (const ArchiveChunk*)(data + trailer.chunkTableOffset);
+    shotCount = trailer.shotCount;
+    chunkCount = trailer.chunkCount;
+    sampleCount = trailer.sampleCount;
+    cachedChunk = (size_t)chunkCount;
+
+    shotsById.resize((size_t)shotCount);
+    for (size_t i = 0; i < shotsById.size(); i++) {
+        shotsById[i] = i;
+    }
+    std::stable_sort(shotsById.begin(), shotsById.end(), [this](size_t a, size_t b) {
+        return shotTable[a].shotId < shotTable[b].shotId;
+    });
+    return true;
+}
+
+void TrajectoryReader::Close() {
+    if (data) {
+        UnmapFile(data, size);
+    }
+    data = nullptr;
+    size = 0;
+    shotTable = nullptr;
+    chunkTable = nullptr;
+    shotCount = 0;
+    chunkCount = 0;
+    sampleCount = 0;
+    cachedChunk = 0;
+    shotsById.clear();
+    chunkSamples.clear();
+}
+
+size_t TrajectoryReader::FindShot(uint64_t shotId) const {
+    auto found = std::lower_bound(shotsById.begin(), shotsById.end(), shotId, [this](size_t index, uint64_t id) {
+        return shotTable[index].shotId < id;
+    });
+    if (found == shotsById.end() || shotTable[*found].shotId != shotId) return ShotCount();
+    return *found;
+}
+
+bool TrajectoryReader::ReadShot(size_t index, std::vector<TrajectorySample>& samples) {
+    samples.clear();
+    if (index >= ShotCount()) return false;
+
+    const ArchivedShot& shot = shotTable[index];
+    uint64_t next = shot.firstSample;
+    uint64_t end = shot.firstSample + shot.sampleCount;
+    samples.reserve(shot.sampleCount);
+
+    // Last chunk starting at or before the shot's first sample
+    const ArchiveChunk* chunk = std::upper_bound(chunkTable, chunkTable + chunkCount, next,
+        [](uint64_t sample, const ArchiveChunk& entry) { return sample < entry.firstSample; });
+    if (chunk == chunkTable) return shot.sampleCount == 0;
+    size_t chunkIndex = (size_t)(chunk - chunkTable) - 1;
+
+    while (next < end) {
+        if (chunkIndex >= chunkCount || !DecodeChunk(chunkIndex)) return false;
+        const ArchiveChunk& entry = chunkTable[chunkIndex];
+        uint64_t chunkEnd = entry.firstSample + entry.sampleCount;
+        uint64_t copyEnd = end < chunkEnd ? end : chunkEnd;
+        if (next < entry.firstSample || copyEnd <= next) return false;
+        samples.insert(samples.end(), chunkSamples.begin() + (size_t)(next - entry.firstSample),
+                       chunkSamples.begin() + (size_t)(copyEnd - entry.firstSample));
+        next = copyEnd;
+        chunkIndex++;
+    }
+    return true;
+}
+
+bool TrajectoryReader::DecodeChunk(size_t chunk) {
+    if (chunk == cachedChunk) return true;
+    cachedChunk = (size_t)chunkCount;
+
+    const ArchiveChunk& entry = chunkTable[chunk];
+    ChunkHeader header;
+    if (entry.offset > size || entry.byteCount > size - entry.offset || entry.byteCount < sizeof(header)) return false;
+    memcpy(&header, data + entry.offset, sizeof(header));
+    if (header.sampleCount != entry.sampleCount) return false;
+
+    const uint8_t* p = data + entry.offset + sizeof(header);
+    const uint8_t* chunkEnd = data + entry.offset + entry.byteCount;
+    chunkSamples.resize(header.sampleCount);
+
+    for (int column = 0; column < VALUE_COLUMNS; column++) {
+        if (header.columnBytes[column] > (size_t)(chunkEnd - p)) return false;
+        const uint8_t* columnEnd = p + header.columnBytes[column];
+        int64_t value = 0, delta = 0;
+        for (TrajectorySample& sample : chunkSamples) {
+            uint64_t encoded;
+            if (!GetVarint(p, columnEnd, encoded)) return false;
+            delta += UnZigZag(encoded);
+            value += delta;
+            SetColumnValue(sample, column, (float)(value * columnQuanta[column]));
+        }
+        if (p != columnEnd) return false;
+    }
+
+    if (header.columnBytes[VALUE_COLUMNS] != header.sampleCount || (size_t)(chunkEnd - p) < header.sampleCount) {
+        return false;
+    }
+    for (TrajectorySample& sample : chunkSamples) {
+        sample.flags = *p++;
+    }
+
+    cachedChunk = chunk;
+    return true;
+}
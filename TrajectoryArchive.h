@@ -0,0 +1,216 @@
+// Tennis Ball Physics Simulator - trajectory archives
+// Binary, chunked, columnar recording of whole shots (time, position, velocity,
+// spin and event flags per sample) written by a background thread, and a reader
+// that memory-maps an archive and decodes any shot on demand for replay.
+//
+// File layout (little endian):
+//   ArchiveHeader
+//   chunk 0 .. chunk n-1   ChunkHeader, then one column per field: six columns of
+//                          quantized values stored as zigzag varint second differences,
+//                          then one byte of flags per sample
+//   shot table             ArchivedShot per shot, in the order shots were appended
+//   chunk table            ArchiveChunk per chunk
+//   ArchiveTrailer         located from the end of the file
+// Samples form one continuous stream across shots; a shot is a range of it and may
+// span chunks. An archive without its trailer (writer never closed) does not open.
+
+#pragma once
+
+#include "SimulationEngine.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Sample event flags
+const uint8_t SAMPLE_SHOT_START = 0x01; // First sample of a shot (launch or relaunch)
+const uint8_t SAMPLE_BOUNCE = 0x02;     // Ball bounced during the step ending here
+const uint8_t SAMPLE_NET = 0x04;        // Ball struck the net during the step ending here
+const uint8_t SAMPLE_RIGHTY_HIT = 0x08; // RIGHTY returned or deflected the ball at this sample
+
+// One recorded ball state
+struct TrajectorySample {
+    float time;   // seconds since launch
+    float x;      // meters
+    float y;      // meters
+    float vx;     // m/s
+    float vy;     // m/s
+    float spin;   // RPM
+    uint8_t flags;
+};
+
+// Quantization steps of the stored columns: replayed values are within half a step of the recording
+const double ARCHIVE_TIME_QUANTUM = 1e-6;     // seconds
+const double ARCHIVE_POSITION_QUANTUM = 1e-5; // meters
+const double ARCHIVE_VELOCITY_QUANTUM = 1e-4; // m/s
+const double ARCHIVE_SPIN_QUANTUM = 0.01;     // RPM
+
+// Samples per chunk; the unit the writer encodes and the reader decodes
+const uint32_t ARCHIVE_CHUNK_SAMPLES = 4096;
+
+// Full chunks allowed to wait for the writer thread before appends block
+const size_t ARCHIVE_MAX_PENDING_CHUNKS = 16;
+
+const uint32_t ARCHIVE_VERSION = 1;
+
+struct ArchiveHeader {
+    char magic[4];    // "TBTA"
+    uint32_t version;
+    uint32_t chunkSamples;
+    uint32_t reserved;
+    double timeQuantum;
+    double positionQuantum;
+    double velocityQuantum;
+    double spinQuantum;
+};
+
+// Shot table entry: launch parameters and the shot's range of the sample stream
+struct ArchivedShot {
+    uint64_t shotId;      // Caller's identifier, e.g. the sweep grid index
+    uint64_t firstSample;
+    uint32_t sampleCount;
+    float force;          // Newtons
+    float angle;          // degrees
+    float spin;           // RPM
+    int32_t surfaceIndex; // Index into courts[]
+    int32_t airMode;      // Index into airModes[]
+};
+
+// Chunk table entry
+struct ArchiveChunk {
+    uint64_t offset;      // File offset of the ChunkHeader
+    uint64_t firstSample;
+    uint32_t sampleCount;
+    uint32_t byteCount;   // Header and columns
+};
+
+struct ChunkHeader {
+    uint32_t sampleCount;
+    uint32_t columnBytes[7]; // time, x, y, vx, vy, spin, flags
+};
+
+struct ArchiveTrailer {
+    uint64_t shotTableOffset;
+    uint64_t shotCount;
+    uint64_t chunkTableOffset;
+    uint64_t chunkCount;
+    uint64_t sampleCount;
+    char magic[4];        // "TBTE"
+    uint32_t version;
+};
+
+// Collects one shot's samples from a TennisBall. Bounce and net flags are derived
+// from the ball's counters, so Record only needs to see the ball after each step.
+class ShotRecorder {
+public:
+    ShotRecorder() : params(), lastBounceCount(0), lastHitNet(false) {}
+
+    // Starts a new shot; the next Record stores the launch sample
+    void Begin(const ShotParams& shot);
+    void Record(const TennisBall& ball, uint8_t extraFlags = 0);
+
+    const ShotParams& Params() const { return params; }
+    const std::vector<TrajectorySample>& Samples() const { return samples; }
+
+private:
+    ShotParams params;
+    std::vector<TrajectorySample> samples;
+    int lastBounceCount;
+    bool lastHitNet;
+};
+
+// Appends shots to an archive file. Encoding and disk writes run on a background
+// thread; AppendShot only copies samples into the open chunk, and blocks only while
+// ARCHIVE_MAX_PENDING_CHUNKS full chunks are still waiting. AppendShot is thread safe
+// and each shot's samples stay contiguous.
+class TrajectoryWriter {
+public:
+    TrajectoryWriter();
+    ~TrajectoryWriter(); // Closes the archive if still open
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    // Creates (or truncates) path and starts the writer thread
+    bool Open(const wchar_t* path);
+
+    // Flushes the open chunk, writes the tables and trailer and closes the file;
+    // returns false if any write failed
+    bool Close();
+
+    bool IsOpen() const { return file != nullptr; }
+
+    void AppendShot(uint64_t shotId, const ShotParams& shot, const TrajectorySample* samples, size_t count);
+    void AppendShot(uint64_t shotId, const ShotRecorder& recorder) {
+        AppendShot(shotId, recorder.Params(), recorder.Samples().data(), recorder.Samples().size());
+    }
+
+    size_t ShotCount();
+
+private:
+    FILE* file;
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable chunkReady;   // Writer thread waits for full chunks or close
+    std::condition_variable chunkWritten; // Appenders wait for room in the queue
+    std::deque<std::vector<TrajectorySample>> pendingChunks;
+    std::vector<TrajectorySample> openChunk;
+    std::vector<std::vector<TrajectorySample>> freeChunks; // Written chunk buffers, reused by QueueOpenChunk
+    std::vector<ArchivedShot> shots;
+    std::vector<ArchiveChunk> chunks; // Owned by the writer thread until it exits
+    uint64_t sampleCount;
+    uint64_t fileOffset; // End of the data written so far, advanced by the writer thread
+    bool closing;
+    bool writeFailed;
+
+    void WriterLoop();
+    void QueueOpenChunk(); // Called with mutex held
+};
+
+// Read-only view of an archive file through a memory mapping. Tables are used in
+// place; samples are decoded a chunk at a time, and the last decoded chunk is kept
+// so stepping through neighboring shots decodes each chunk once.
+class TrajectoryReader {
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    // Maps path and validates its header, trailer and tables
+    bool Open(const wchar_t* path);
+    void Close();
+    bool IsOpen() const { return data != nullptr; }
+
+    size_t ShotCount() const { return (size_t)shotCount; }
+    uint64_t SampleCount() const { return sampleCount; }
+    const ArchivedShot& Shot(size_t index) const { return shotTable[index]; }
+
+    // Table index of the shot with the given id, or ShotCount() if there is none
+    size_t FindShot(uint64_t shotId) const;
+
+    // Decodes a shot's samples into samples (replacing its contents)
+    bool ReadShot(size_t index, std::vector<TrajectorySample>& samples);
+
+private:
+    const uint8_t* data; // Whole file, mapped read-only
+    size_t size;
+    double columnQuanta[6];
+
+    const ArchivedShot* shotTable;
+    const ArchiveChunk* chunkTable;
+    uint64_t shotCount;
+    uint64_t chunkCount;
+    uint64_t sampleCount;
+    std::vector<size_t> shotsById; // Shot table indices sorted by shotId, for FindShot
+
+    size_t cachedChunk; // chunkCount when nothing is cached
+    std::vector<TrajectorySample> chunkSamples;
+
+    bool DecodeChunk(size_t chunk);
+};
@@ -0,0 +1,46 @@
+// Tennis Ball Physics Simulator - lock-free state handoff between two threads
+// A triple buffer passes whole states from one writer thread to one reader thread.
+// The writer fills its back buffer and publishes it by swapping it with the middle
+// one; the reader swaps the middle one for its front buffer when something new was
+// published. Neither side ever waits: the writer can publish as often as it likes
+// and the reader always sees the newest complete state, skipping any it missed.
+
+#pragma once
+
+#include <atomic>
+
+template <class T>
+class TripleBuffer {
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer: the buffer to fill next. It holds whatever state was last written to
+    // it, two or more publishes old, so it can be brought up to date incrementally.
+    T& WriteBuffer() { return buffers[back]; }
+
+    // Writer: makes WriteBuffer() the newest state and hands out another buffer
+    void Publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader: the newest published state, or the one read last time if nothing was
+    // published since. It stays untouched by the writer until the next Read.
+    const T& Read() {
+        if (middle.load(std::memory_order_relaxed) & FRESH) {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        }
+        return buffers[front];
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4; // Set on middle by Publish, cleared by Read
+
+    T buffers[3];
+    int back;                // Writer's, index only
+    std::atomic<int> middle; // Shared: index | FRESH
+    int front;               // Reader's, index only
+};
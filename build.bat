@@ -21,21 +21,58 @@ if exist "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\B
 REM Create build directory if it doesn't exist
 if not exist build mkdir build
 
+REM Compile headless simulation engine library (no Direct2D/DirectWrite linkage)
+cl.exe /c /EHsc /W4 /O2 /D_UNICODE /DUNICODE /std:c++17 ^
+    /Fo:build\ ^
+    SimulationEngine.cpp BallBatch.cpp ThreadPool.cpp ParameterSweep.cpp FlightEvents.cpp Integrator.cpp ^
+    ReturnHitPolicy.cpp TrajectoryArchive.cpp ResultExport.cpp FileMapping.cpp LandingTable.cpp ShotSolver.cpp ^
+    ShotEnsemble.cpp BallMachine.cpp SettingsFile.cpp
+if %ERRORLEVEL% NEQ 0 goto :failed
+
+lib.exe /nologo /OUT:build\SimulationEngine.lib build\SimulationEngine.obj build\BallBatch.obj ^
+    build\ThreadPool.obj build\ParameterSweep.obj build\FlightEvents.obj build\Integrator.obj ^
+    build\ReturnHitPolicy.obj build\TrajectoryArchive.obj build\ResultExport.obj ^
+    build\FileMapping.obj build\LandingTable.obj build\ShotSolver.obj build\ShotEnsemble.obj ^
+    build\BallMachine.obj build\SettingsFile.obj
+if %ERRORLEVEL% NEQ 0 goto :failed
+
 REM Compile
 cl.exe /EHsc /W4 /D_UNICODE /DUNICODE /std:c++17 ^
     /Fe:build\TennisBallSimulator.exe ^
-    main.cpp ^
-    /link d2d1.lib dwrite.lib user32.lib gdi32.lib
-
-if %ERRORLEVEL% EQU 0 (
-    echo.
-    echo Build successful! Executable: build\TennisBallSimulator.exe
-    echo Copying executable to project root...
-    copy /Y build\TennisBallSimulator.exe TennisBallSimulator.exe
-    echo.
-    echo Run with: .\TennisBallSimulator.exe
-) else (
-    echo.
-    echo Build failed!
-    exit /b 1
-)
+    main.cpp TraceRenderer.cpp DeviceResources.cpp Profiler.cpp BallSprites.cpp ^
+    /link build\SimulationEngine.lib d2d1.lib dwrite.lib user32.lib gdi32.lib
+if %ERRORLEVEL% NEQ 0 goto :failed
+
+REM Compile integrator benchmark (console, engine only)
+cl.exe /EHsc /W4 /O2 /D_UNICODE /DUNICODE /std:c++17 ^
+    /Fo:build\ /Fe:build\IntegratorBenchmark.exe ^
+    IntegratorBenchmark.cpp ^
+    /link build\SimulationEngine.lib
+if %ERRORLEVEL% NEQ 0 goto :failed
+
+REM Compile batch runner (console, engine only)
+cl.exe /EHsc /W4 /O2 /D_UNICODE /DUNICODE /std:c++17 ^
+    /Fo:build\ /Fe:build\tennis-batch.exe ^
+    BatchRunner.cpp ^
+    /link build\SimulationEngine.lib
+if %ERRORLEVEL% NEQ 0 goto :failed
+
+REM Compile micro-benchmark suite (console, offscreen Direct2D via WIC)
+cl.exe /EHsc /W4 /O2 /D_UNICODE /DUNICODE /std:c++17 ^
+    /Fo:build\ /Fe:build\Benchmark.exe ^
+    Benchmark.cpp TraceRenderer.cpp ^
+    /link build\SimulationEngine.lib d2d1.lib windowscodecs.lib ole32.lib
+if %ERRORLEVEL% NEQ 0 goto :failed
+
+echo.
+echo Build successful! Executable: build\TennisBallSimulator.exe
+echo Copying executable to project root...
+copy /Y build\TennisBallSimulator.exe TennisBallSimulator.exe
+echo.
+echo Run with: .\TennisBallSimulator.exe
+exit /b 0
+
+:failed
+echo.
+echo Build failed!
+exit /b 1
@@ -14,8 +14,31 @@
 #include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
 #include <commctrl.h>
 
+#include "SimulationEngine.h"
+#include "ParameterSweep.h"
+#include "TraceRenderer.h"
+#include "DeviceResources.h"
+#include "ReturnHitPolicy.h"
+#include "TrajectoryArchive.h"
+#include "LandingTable.h"
+#include "ShotSolver.h"
+#include "ShotEnsemble.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include "Profiler.h"
+#include "BallMachine.h"
+#include "BallSprites.h"
+#include "SettingsFile.h"
+
 #pragma comment(lib, "d2d1")
 #pragma comment(lib, "dwrite")
 #pragma comment(lib, "comctl32")
@@ -36,25 +59,23 @@ enum ScreenMode {
     MODE_LAVER
 };
 
-// Constants
-const float GRAVITY = 9.81f; // m/s^2
-const float BALL_RADIUS = 0.0335f; // Tennis ball radius in meters (6.7cm diameter)
-const float INITIAL_HEIGHT = 2.0f; // meters
+// Display constants
 const float PIXELS_PER_METER = 100.0f; // Scaling factor for visualization
 const int WINDOW_WIDTH = 640;
 const int WINDOW_HEIGHT = 480;
-const int SECTION_WIDTH = WINDOW_WIDTH / 4;
-const float DT = 0.0083f; // ~120 FPS
+const float GRAPH_MAX_HEIGHT = 2.5f; // meters, top of the combined height graph
+const float GRAPH_X = 10.0f;  // Combined height graph panel of the All Courts view
+const float GRAPH_Y = 10.0f;
+const float GRAPH_WIDTH = WINDOW_WIDTH - 20.0f;
+const float GRAPH_HEIGHT = 150.0f;
+const float MIN_LABEL_WIDTH = 75.0f; // All-courts sections and graph legend entries narrower than this drop their text
 
-// Clay court specific constants
-const float COURT_WIDTH = 23.77f; // Tennis court width in meters (singles)
-const float COURT_LENGTH = 23.77f; // Tennis court length in meters
-const float NET_HEIGHT = 0.914f; // Net height at center in meters
-const float BALL_MASS = 0.058f; // Tennis ball mass in kg
-const float MIN_HORIZONTAL_FORCE = 0.0f; // Newtons
-const float MAX_HORIZONTAL_FORCE = 1000.0f; // Newtons
-const float MIN_ANGLE = 0.0f; // degrees
-const float MAX_ANGLE = 90.0f; // degrees
+// Single-court view layout
+const float COURT_VIEW_MARGIN = 50.0f;
+const float COURT_VIEW_ZOOM = 0.25f; // 4x wider court with 2x zoom out = 0.25 total
+const float COURT_VIEW_PIXEL_WIDTH = (WINDOW_WIDTH - 2 * COURT_VIEW_MARGIN) * 4.0f * COURT_VIEW_ZOOM; // 4x width with zoom
+const float COURT_VIEW_TOP = 240.0f;
+const float COURT_VIEW_BOTTOM = COURT_VIEW_TOP + 300.0f * COURT_VIEW_ZOOM;
 
 // Configurable settings (loaded from settings.ini)
 float DEFAULT_HORIZONTAL_FORCE = 270.0f; // Newtons
@@ -66,9 +87,35 @@ float MAX_SPIN = 9000.0f; // Maximum spin in RPM
 float MIN_SPIN = -3000.0f; // Minimum backspin in RPM
 float DEFAULT_PACE = 2.0f; // Visual pace multiplier (2.0 = 200%)
 float RIGHTY_SPEED = 4.0f; // RIGHTY movement speed in m/s
+float PHYSICS_DT = DT; // Fixed physics step in seconds, independent of visual pace
+bool EVENT_DRIVEN = false; // Resolve contacts at their exact times with the adaptive integrator
+IntegratorType INTEGRATOR = INTEGRATOR_EULER; // Flight stepper for fixed-step updates
+size_t TRAJECTORY_CAPACITY = DEFAULT_TRAJECTORY_CAPACITY; // Trajectory samples kept per ball
+SweepGrid SWEEP_GRID = DefaultSweepGrid(); // Grid simulated by the P key
+unsigned SWEEP_THREADS = 0; // Worker threads for sweeps (0 = all cores)
+bool SWEEP_EVENT_DRIVEN = false; // Integrate sweeps with the event-driven mode instead of fixed SIMD steps
+IntegratorType SWEEP_INTEGRATOR = INTEGRATOR_EULER; // Anything but Euler runs sweeps shot by shot
+bool SWEEP_EXACT_VACUUM = false; // Fixed-step sweeps solve vacuum shots without spin in closed form
+bool SWEEP_ARCHIVE = false; // Also write every sweep shot's trajectory to sweep_trajectories.trj
+ResultFormat SWEEP_RESULT_FORMAT = RESULT_FORMAT_CSV; // File format of sweep_results
+uint64_t RANDOM_SEED = 0; // Key of every random stream (0 in settings.ini picks one from the clock)
+ReturnPolicyType RETURN_POLICY = RETURN_POLICY_DIALOG; // How RIGHTY answers a ball that reaches it
+ReturnHit FIXED_RETURN_HIT = DEFAULT_RETURN_HIT; // Return shot of RETURN_POLICY_FIXED
+float RETURN_TARGET_X = 3.0f; // Landing spot of RETURN_POLICY_TARGET returns, meters from the left edge
+bool LANDING_PREDICTION = true; // Show where the aimed shot lands on the single-court views
+LandingTableConfig LANDING_GRID = DefaultLandingTableConfig(-3000.0f, 9000.0f); // Grid and stepping of landing_table.bin
+size_t ENSEMBLE_SHOTS = 50000; // Perturbed shots per Monte Carlo ensemble (E key)
+float ENSEMBLE_FORCE_SIGMA = 15.0f; // Standard deviation of the force noise in Newtons
+float ENSEMBLE_ANGLE_SIGMA = 2.0f; // ... of the angle noise in degrees
+float ENSEMBLE_SPIN_SIGMA = 150.0f; // ... of the spin noise in RPM
+unsigned ENSEMBLE_THREADS = 0; // Worker threads for ensembles (0 = all cores but one, left to the UI)
+unsigned COURT_THREADS = 0; // Worker threads stepping the courts in parallel (0 = all cores but one, 1 = none)
+size_t RALLY_BALLS = 500; // Most balls in flight per court in ball machine drills (M key)
+float RALLY_FEED_INTERVAL = 0.01f; // Seconds between ball machine launches
+bool PROFILING_ENABLED = false; // Record frame and physics timings from startup, not only while the overlay is shown
 
-// Function to load settings from INI file
-void LoadSettings() {
+// Directory of the executable, with trailing backslash
+std::wstring GetExeDirectory() {
     wchar_t exePath[MAX_PATH];
     GetModuleFileNameW(NULL, exePath, MAX_PATH);
     std::wstring exeDir(exePath);
@@ -76,117 +123,334 @@ void LoadSettings() {
     if (lastSlash != std::wstring::npos) {
         exeDir = exeDir.substr(0, lastSlash + 1);
     }
-    std::wstring iniPath = exeDir + L"settings.ini";
-    
-    // Load settings with defaults
-    DEFAULT_HORIZONTAL_FORCE = GetPrivateProfileIntW(L"Physics", L"DefaultForce", 270, iniPath.c_str());
-    DEFAULT_ANGLE = GetPrivateProfileIntW(L"Physics", L"DefaultAngle", 39, iniPath.c_str());
-    ANGLE_STEP = GetPrivateProfileIntW(L"Physics", L"AngleStep", 3, iniPath.c_str());
-    DEFAULT_SPIN = GetPrivateProfileIntW(L"Physics", L"DefaultSpin", 120, iniPath.c_str());
-    SPIN_STEP = GetPrivateProfileIntW(L"Physics", L"SpinStep", 60, iniPath.c_str());
-    MIN_SPIN = GetPrivateProfileIntW(L"Physics", L"MinSpin", -3000, iniPath.c_str());
-    MAX_SPIN = GetPrivateProfileIntW(L"Physics", L"MaxSpin", 9000, iniPath.c_str());
-    DEFAULT_PACE = GetPrivateProfileIntW(L"Physics", L"DefaultPace", 200, iniPath.c_str()) / 100.0f; // Convert percentage to multiplier
-    RIGHTY_SPEED = GetPrivateProfileIntW(L"Physics", L"RightySpeed", 4, iniPath.c_str());
+    return exeDir;
 }
 
-// Air resistance modes
-enum AirResistanceMode {
-    AIR_VACUUM,
-    AIR_SEA_LEVEL,
-    AIR_1000M,
-    AIR_2000M
-};
+std::wstring GetSettingsPath() {
+    return GetExeDirectory() + L"settings.ini";
+}
 
-struct AirResistanceData {
-    AirResistanceMode mode;
-    const wchar_t* name;
-    float coefficient;
-};
+// Settings the simulation thread applies again whenever settings.ini changes: the
+// engine's surface, air and pattern tables, and values read afresh at every key
+// press, launch, return or drill start
+void LoadLiveSettings(const SettingsFile& settings) {
+    LoadEngineTables(settings);
+    ANGLE_STEP = settings.GetInt("Physics", "AngleStep", 3);
+    SPIN_STEP = settings.GetInt("Physics", "SpinStep", 60);
+    RIGHTY_SPEED = settings.GetInt("Physics", "RightySpeed", 4);
+    
+    // RIGHTY return hits (0 = ask with the dialog, 1 = fixed return, 2 = per launch pattern, 3 = solved for a target)
+    RETURN_POLICY = (ReturnPolicyType)min(3u, settings.GetInt("Righty", "ReturnPolicy", 0));
+    FIXED_RETURN_HIT.force = (float)settings.GetInt("Righty", "ReturnForce", 300);
+    FIXED_RETURN_HIT.angle = (float)settings.GetInt("Righty", "ReturnAngle", 30);
+    FIXED_RETURN_HIT.spin = (float)(INT)settings.GetInt("Righty", "ReturnSpin", 120);
+    RETURN_TARGET_X = (float)settings.GetInt("Righty", "ReturnTargetX", 3);
+    
+    // Ball machine drills; launches jitter like the ensemble's shots
+    RALLY_BALLS = max(1u, settings.GetInt("Rally", "Balls", 500));
+    RALLY_FEED_INTERVAL = max(1u, settings.GetInt("Rally", "FeedMillis", 10)) / 1000.0f;
+}
+
+// Every setting, once at startup
+void LoadSettings(const SettingsFile& settings) {
+    LoadLiveSettings(settings);
+    
+    // The rest only take effect at the next start
+    DEFAULT_HORIZONTAL_FORCE = settings.GetInt("Physics", "DefaultForce", 270);
+    DEFAULT_ANGLE = settings.GetInt("Physics", "DefaultAngle", 39);
+    DEFAULT_SPIN = (float)(INT)settings.GetInt("Physics", "DefaultSpin", 120);
+    MIN_SPIN = (float)(INT)settings.GetInt("Physics", "MinSpin", -3000);
+    MAX_SPIN = (float)(INT)settings.GetInt("Physics", "MaxSpin", 9000);
+    DEFAULT_PACE = settings.GetInt("Physics", "DefaultPace", 200) / 100.0f; // Convert percentage to multiplier
+    PHYSICS_DT = max(100, (int)settings.GetInt("Physics", "PhysicsStepMicros", 8300)) / 1000000.0f;
+    EVENT_DRIVEN = settings.GetInt("Physics", "EventDriven", 0) != 0;
+    INTEGRATOR = (IntegratorType)min(2u, settings.GetInt("Physics", "Integrator", 0));
+    TRAJECTORY_CAPACITY = settings.GetInt("Physics", "TrajectoryCapacity", (INT)DEFAULT_TRAJECTORY_CAPACITY);
+    RANDOM_SEED = settings.GetInt("Physics", "RandomSeed", 0);
+    if (RANDOM_SEED == 0) {
+        RANDOM_SEED = (uint64_t)time(NULL);
+    }
+    
+    // Parameter sweep grid (steps of 1 pins an axis to its minimum)
+    SWEEP_GRID.force.minValue = (float)settings.GetInt("Sweep", "MinForce", 100);
+    SWEEP_GRID.force.maxValue = (float)settings.GetInt("Sweep", "MaxForce", 1000);
+    SWEEP_GRID.force.steps = max(1, (int)settings.GetInt("Sweep", "ForceSteps", 91));
+    SWEEP_GRID.angle.minValue = (float)settings.GetInt("Sweep", "MinAngle", 0);
+    SWEEP_GRID.angle.maxValue = (float)settings.GetInt("Sweep", "MaxAngle", 60);
+    SWEEP_GRID.angle.steps = max(1, (int)settings.GetInt("Sweep", "AngleSteps", 31));
+    SWEEP_GRID.spin.minValue = (float)(INT)settings.GetInt("Sweep", "MinSpin", -3000);
+    SWEEP_GRID.spin.maxValue = (float)(INT)settings.GetInt("Sweep", "MaxSpin", 9000);
+    SWEEP_GRID.spin.steps = max(1, (int)settings.GetInt("Sweep", "SpinSteps", 25));
+    SWEEP_THREADS = settings.GetInt("Sweep", "Threads", 0);
+    SWEEP_EVENT_DRIVEN = settings.GetInt("Sweep", "EventDriven", 0) != 0;
+    SWEEP_INTEGRATOR = (IntegratorType)min(2u, settings.GetInt("Sweep", "Integrator", 0));
+    SWEEP_EXACT_VACUUM = settings.GetInt("Sweep", "ExactVacuum", 0) != 0;
+    SWEEP_ARCHIVE = settings.GetInt("Sweep", "ArchiveTrajectories", 0) != 0;
+    SWEEP_RESULT_FORMAT = (ResultFormat)min(1u, settings.GetInt("Sweep", "ResultFormat", 0));
+    
+    // Landing prediction table: spans the aiming range and steps like the shots it predicts
+    LANDING_PREDICTION = settings.GetInt("Landing", "ShowPrediction", 1) != 0;
+    LANDING_GRID = DefaultLandingTableConfig(MIN_SPIN, MAX_SPIN);
+    LANDING_GRID.force.steps = max(2, (int)settings.GetInt("Landing", "ForceSteps", LANDING_GRID.force.steps));
+    LANDING_GRID.angle.steps = max(2, (int)settings.GetInt("Landing", "AngleSteps", LANDING_GRID.angle.steps));
+    LANDING_GRID.spin.steps = max(2, (int)settings.GetInt("Landing", "SpinSteps", LANDING_GRID.spin.steps));
+    LANDING_GRID.timeStep = PHYSICS_DT;
+    LANDING_GRID.integrationMode = EVENT_DRIVEN ? INTEGRATION_EVENT_DRIVEN : INTEGRATION_FIXED_STEP;
+    LANDING_GRID.integrator = INTEGRATOR;
+    
+    // Monte Carlo ensembles
+    ENSEMBLE_SHOTS = max(1u, settings.GetInt("Ensemble", "Shots", 50000));
+    ENSEMBLE_FORCE_SIGMA = (float)settings.GetInt("Ensemble", "ForceSigma", 15);
+    ENSEMBLE_ANGLE_SIGMA = (float)settings.GetInt("Ensemble", "AngleSigma", 2);
+    ENSEMBLE_SPIN_SIGMA = (float)settings.GetInt("Ensemble", "SpinSigma", 150);
+    ENSEMBLE_THREADS = settings.GetInt("Ensemble", "Threads", 0);
+    if (ENSEMBLE_THREADS == 0) {
+        ENSEMBLE_THREADS = max(1u, std::thread::hardware_concurrency() - 1);
+    }
+    
+    // Per-court tasks of the all-courts view and the ball machine drills
+    COURT_THREADS = settings.GetInt("Courts", "Threads", 0);
+    if (COURT_THREADS == 0) {
+        COURT_THREADS = max(1u, std::thread::hardware_concurrency() - 1);
+    }
+    
+    // Instrumentation (O key shows the overlay, J saves a trace)
+    PROFILING_ENABLED = settings.GetInt("Profiling", "Enabled", 0) != 0;
+}
 
-// Air resistance coefficients based on altitude
-// Coefficient formula: 0.5 * Cd * rho * A, where:
-// Cd ~= 0.5 (drag coefficient for sphere)
-// A = pi * r^2 ~= 0.00352 m^2 (tennis ball cross-section)
-// rho varies with altitude
-AirResistanceData airModes[4] = {
-    {AIR_VACUUM, L"Vacuum (no air)", 0.0f},
-    {AIR_SEA_LEVEL, L"Sea Level", 0.0005f},      // rho = 1.225 kg/m^3
-    {AIR_1000M, L"1000m altitude", 0.00044f},    // rho = 1.112 kg/m^3 (90% of sea level)
-    {AIR_2000M, L"2000m altitude", 0.00039f}     // rho = 1.007 kg/m^3 (82% of sea level)
+// Random stream of PATTERN_RANDOM launches; court i's balls use streams 2 * i and 2 * i + 1
+const uint64_t LAUNCH_RANDOM_STREAM = 0xFFFFFFFFull << 32;
+
+// Court colors, indexed by CourtType
+struct CourtPalette {
+    D2D1_COLOR_F color;
+    D2D1_COLOR_F ballColor;
 };
 
-// Launch pattern modes
-enum LaunchPattern {
-    PATTERN_RANDOM,
-    PATTERN_NADAL_TOPSPIN,
-    PATTERN_FEDERER_BACKSPIN,
-    PATTERN_AGASSI_RETURN,
-    PATTERN_SAMPRAS_SERVE,
-    PATTERN_ISNER_KICK_SERVE,
-    PATTERN_FONSECA_FOREHAND,
-    PATTERN_KUERTEN_BACKHAND
+CourtPalette courtPalettes[4] = {
+    {D2D1::ColorF(0.82f, 0.52f, 0.30f), D2D1::ColorF(1.0f, 0.8f, 0.0f)},  // Orange clay, Yellow ball
+    {D2D1::ColorF(0.2f, 0.6f, 0.2f), D2D1::ColorF(0.0f, 1.0f, 0.0f)},      // Green grass, Bright green ball
+    {D2D1::ColorF(0.2f, 0.4f, 0.7f), D2D1::ColorF(1.0f, 0.3f, 0.3f)},      // Blue hard court, Red ball
+    {D2D1::ColorF(0.15f, 0.15f, 0.15f), D2D1::ColorF(1.0f, 1.0f, 1.0f)}    // Black court, White ball
 };
 
-struct LaunchPatternData {
-    LaunchPattern pattern;
-    const wchar_t* name;
-    float force;  // Newtons
-    float angle;  // degrees
-    float spin;   // RPM
+// Brushes created once per Direct2D device, indexed into appBrushColors
+enum AppBrush {
+    BRUSH_WHITE,
+    BRUSH_TRACE,            // Light gray trajectory trace
+    BRUSH_COMBO_BOX,        // Combo box background
+    BRUSH_LEFTY,
+    BRUSH_HEIGHT_MARKER,
+    BRUSH_BOUNCE_MARKER,
+    BRUSH_GRAPH_BACKGROUND,
+    BRUSH_GRAPH_GRID,
+    BRUSH_SWEEP_STATUS,
+    BRUSH_HEATMAP,          // Recolored per bin of the ensemble heatmap
+    BRUSH_COURT_FIRST       // Then per court instance i: court color at BRUSH_COURT_FIRST + 2 * i, ball color after it
 };
 
-// Launch pattern presets
-LaunchPatternData launchPatterns[8] = {
-    {PATTERN_RANDOM, L"Random", 0.0f, 0.0f, 0.0f},  // Special case - random values
-    {PATTERN_NADAL_TOPSPIN, L"Nadal Topspin", 600.0f, 45.0f, 7000.0f},
-    {PATTERN_FEDERER_BACKSPIN, L"Federer Slice", 240.0f, 21.0f, -1200.0f},
-    {PATTERN_AGASSI_RETURN, L"Agassi Return", 550.0f, 27.0f, 5000.0f},
-    {PATTERN_SAMPRAS_SERVE, L"Sampras Serve", 700.0f, 12.0f, 3000.0f},
-    {PATTERN_ISNER_KICK_SERVE, L"Isner Kick Serve", 580.0f, 39.0f, 6500.0f},
-    {PATTERN_FONSECA_FOREHAND, L"Fonseca Forehand", 580.0f, 24.0f, 5000.0f},
-    {PATTERN_KUERTEN_BACKHAND, L"Kuerten Backhand", 450.0f, 35.0f, 4000.0f}
+const D2D1_COLOR_F appBrushColors[BRUSH_COURT_FIRST] = {
+    D2D1::ColorF(D2D1::ColorF::White),
+    D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f),
+    D2D1::ColorF(0.2f, 0.2f, 0.2f),
+    D2D1::ColorF(D2D1::ColorF::Green),
+    D2D1::ColorF(D2D1::ColorF::Gray),
+    D2D1::ColorF(1.0f, 0.0f, 0.0f, 0.7f),
+    D2D1::ColorF(0.1f, 0.1f, 0.1f, 0.8f),
+    D2D1::ColorF(0.3f, 0.3f, 0.3f),
+    D2D1::ColorF(D2D1::ColorF::Yellow),
+    D2D1::ColorF(1.0f, 0.0f, 0.0f)
 };
 
-// Court surface properties
-enum CourtType {
-    ROLAND_GARROS_CLAY,    // Clay court - slower, higher bounce
-    WIMBLEDON_GRASS,       // Grass court - faster, lower bounce
-    US_OPEN_HARD,          // Hard court - medium speed, consistent bounce
-    LAVER_CUP_BLACK        // Special hard court - similar to hard court
+// Courts the application simulates, in display order. Each row becomes a
+// CourtInstance and all of them are stepped together every physics tick, so a row
+// with a custom CourtSurface and palette puts one more court in the all-courts view.
+// Rows with a screen other than MODE_ALL also get a single-court view opened by key.
+// The built-in rows come first, then the custom courts of settings.ini.
+struct CourtDefinition {
+    CourtSurface* surface;
+    const CourtPalette* palette;
+    ScreenMode screen;     // Single-court view of this court, MODE_ALL for none
+    WPARAM key;            // Upper-case letter opening that view, 0 for none
+    const wchar_t* title;  // Single-court view title
+    const wchar_t* legend; // Combined graph legend label
 };
 
-struct CourtSurface {
-    CourtType type;
-    const wchar_t* name;
-    float coefficientOfRestitution; // COR (bounce height ratio)
-    float friction;
-    D2D1_COLOR_F color;
-    D2D1_COLOR_F ballColor;
+const CourtDefinition builtInCourtDefinitions[] = {
+    {&courts[0], &courtPalettes[0], MODE_CLAY, 'C', L"Clay Court - Horizontal Shot", L"Clay"},
+    {&courts[1], &courtPalettes[1], MODE_GRASS, 'G', L"Grass Court - Horizontal Shot", L"Grass"},
+    {&courts[2], &courtPalettes[2], MODE_HARD, 'H', L"Hard Court - Horizontal Shot", L"Hard"},
+    {&courts[3], &courtPalettes[3], MODE_LAVER, 'L', L"Laver Cup - Horizontal Shot", L"Black"}
 };
 
-// Define court surfaces with realistic physics properties
-CourtSurface courts[4] = {
-    {ROLAND_GARROS_CLAY, L"Roland Garros\n(Clay)", 0.75f, 0.6f, 
-     D2D1::ColorF(0.82f, 0.52f, 0.30f), D2D1::ColorF(1.0f, 0.8f, 0.0f)},  // Orange clay, Yellow ball
+// Filled once by LoadCourtDefinitions before the window opens, and never resized
+// after, so CourtDefinition and CourtSurface pointers into them stay valid
+const int MAX_CUSTOM_COURTS = 60;
+std::vector<CourtDefinition> courtDefinitions;
+std::vector<CourtSurface> customSurfaces;
+std::vector<std::wstring> customCourtNames;   // CourtSurface::name of each custom court
+std::vector<std::wstring> customCourtLegends;
+
+// Built-in courts followed by the all-courts view courts of [Court1], [Court2], ...
+// in settings.ini: each copies a built-in surface's name and colors and may override
+// its bounce. Custom courts have no single-court view, and like the court list itself
+// they are only read at startup.
+void LoadCourtDefinitions(const SettingsFile& settings) {
+    const size_t builtInCount = sizeof(builtInCourtDefinitions) / sizeof(builtInCourtDefinitions[0]);
+    customSurfaces.reserve(MAX_CUSTOM_COURTS);
+    customCourtNames.reserve(MAX_CUSTOM_COURTS);
+    customCourtLegends.reserve(MAX_CUSTOM_COURTS);
+    courtDefinitions.assign(builtInCourtDefinitions, builtInCourtDefinitions + builtInCount);
     
-    {WIMBLEDON_GRASS, L"Wimbledon\n(Grass)", 0.70f, 0.4f, 
-     D2D1::ColorF(0.2f, 0.6f, 0.2f), D2D1::ColorF(0.0f, 1.0f, 0.0f)},      // Green grass, Bright green ball
+    for (int i = 1; i <= MAX_CUSTOM_COURTS; i++) {
+        char section[16];
+        sprintf_s(section, "Court%d", i);
+        int base = (INT)settings.GetInt(section, "Surface", -1);
+        if (base < 0 || base >= (int)builtInCount) break;
+        
+        const CourtDefinition& baseDefinition = builtInCourtDefinitions[base];
+        CourtSurface surface = *baseDefinition.surface;
+        surface.coefficientOfRestitution = settings.GetFloat(section, "Restitution", surface.coefficientOfRestitution);
+        surface.friction = settings.GetFloat(section, "Friction", surface.friction);
+        
+        // First line of the built-in name, then the court's own bounce
+        std::wstring baseName = baseDefinition.surface->name;
+        wchar_t name[64];
+        swprintf_s(name, L"%s\n(COR %.2f)", baseName.substr(0, baseName.find(L'\n')).c_str(),
+                   surface.coefficientOfRestitution);
+        customCourtNames.push_back(name);
+        surface.name = customCourtNames.back().c_str();
+        customSurfaces.push_back(surface);
+        
+        wchar_t legend[32];
+        swprintf_s(legend, L"%s %d", baseDefinition.legend, (int)(builtInCount + i));
+        customCourtLegends.push_back(legend);
+        
+        courtDefinitions.push_back({&customSurfaces.back(), baseDefinition.palette, MODE_ALL, 0,
+                                    baseDefinition.title, customCourtLegends.back().c_str()});
+    }
+}
+
+// Everything simulated and drawn for one court: the ball dropped in the all-courts
+// view and the ball fired at RIGHTY in the single-court view. The balls, integrators,
+// recorder and relaunch state belong to the simulation thread, the trace geometry
+// to the UI thread.
+struct CourtInstance {
+    const CourtDefinition* definition;
+    size_t index; // Position in D2DApp::courtInstances, also selects the court's brushes
+    std::unique_ptr<TennisBall> dropBall;
+    std::unique_ptr<TennisBall> shotBall;
+    std::unique_ptr<Integrator> dropIntegrator; // One per ball: RK45 keeps per-ball step state
+    std::unique_ptr<Integrator> shotIntegrator;
+    std::unique_ptr<TraceGeometry> courtTrace; // shotBall trace in the single-court view
+    std::unique_ptr<TraceGeometry> graphTrace; // dropBall height vs time in the combined graph
+    ShotRecorder recorder; // shotBall's current shot while recording; empty until its next launch
     
-    {US_OPEN_HARD, L"US Open\n(Hard Court)", 0.73f, 0.5f, 
-     D2D1::ColorF(0.2f, 0.4f, 0.7f), D2D1::ColorF(1.0f, 0.3f, 0.3f)},      // Blue hard court, Red ball
+    // Auto-relaunch state of shotBall
+    bool waitingToRelaunch;
+    float relaunchTimer;
     
-    {LAVER_CUP_BLACK, L"Laver Cup\n(Black Court)", 0.72f, 0.5f, 
-     D2D1::ColorF(0.15f, 0.15f, 0.15f), D2D1::ColorF(1.0f, 1.0f, 1.0f)}    // Black court, White ball
+    BallMachine machine; // Ball machine drill, in place of shotBall while rally mode is on
 };
 
-// Bounce data structure
-struct BounceData {
+// What the UI thread draws of one ball, copied from it after a physics tick
+struct BallSnapshot {
+    float x, y;
+    float prevX, prevY;
+    float vx, vy;
     float time;
-    float height;
-    float xPosition; // Horizontal position for trajectory tracking
+    float spinRPM;
+    int bounceCount;
+    size_t bounceMarks; // Recorded bounces, at most MAX_RECORDED_BOUNCES
+    bool isActive;
+    TrajectoryBuffer trajectory; // Same sample numbers as the ball's, so TraceGeometry caches carry over
+    
+    BallSnapshot() : x(0.0f), y(0.0f), prevX(0.0f), prevY(0.0f), vx(0.0f), vy(0.0f), time(0.0f), spinRPM(0.0f),
+                     bounceCount(0), bounceMarks(0), isActive(false) {}
+    
+    void capture(const TennisBall& ball) {
+        x = ball.x;
+        y = ball.y;
+        prevX = ball.prevX;
+        prevY = ball.prevY;
+        vx = ball.vx;
+        vy = ball.vy;
+        time = ball.time;
+        spinRPM = ball.spinRPM;
+        bounceCount = ball.bounceCount;
+        bounceMarks = ball.bounces.size();
+        isActive = ball.isActive;
+        trajectory.syncFrom(ball.trajectory);
+    }
+    
+    float interpolatedX(float alpha) const { return prevX + (x - prevX) * alpha; }
+    float interpolatedY(float alpha) const { return prevY + (y - prevY) * alpha; }
+};
+
+struct CourtSnapshot {
+    BallSnapshot dropBall;
+    BallSnapshot shotBall;
+    std::vector<float> rallyX, rallyY; // Balls of the ball machine drill in flight
+    uint64_t rallyLaunched;
+    uint64_t rallyReturned;
+    
+    CourtSnapshot() : rallyLaunched(0), rallyReturned(0) {}
+};
+
+// Simulation state published for drawing by the simulation thread after every tick.
+// Field names follow the D2DApp members they copy.
+struct SimSnapshot {
+    ScreenMode currentScreen;
+    bool simulationStarted;
+    float renderAlpha;
+    float rightyPosition;
+    float horizontalForce;
+    float launchAngle;
+    float ballSpin;
+    float visualPaceMultiplier;
+    AirResistanceMode airResistanceMode;
+    LaunchPattern currentLaunchPattern;
+    const wchar_t* returnPolicyName;
+    bool recording;
+    uint64_t recordedShots;
+    bool replaying;
+    size_t replayShot;
+    size_t replayShotCount;
+    uint64_t replayShotId;
+    bool rallyMode;
+    unsigned settingsGeneration; // Settings reloads applied so far
+    std::vector<CourtSnapshot> courts; // Indexed like D2DApp::courtInstances
+    
+    SimSnapshot() : currentScreen(MODE_ALL), simulationStarted(false), renderAlpha(1.0f), rightyPosition(0.0f),
+                    horizontalForce(0.0f), launchAngle(0.0f), ballSpin(0.0f), visualPaceMultiplier(1.0f),
+                    airResistanceMode(AIR_SEA_LEVEL), currentLaunchPattern(PATTERN_RANDOM), returnPolicyName(L""),
+                    recording(false), recordedShots(0), replaying(false), replayShot(0), replayShotCount(0),
+                    replayShotId(0), rallyMode(false), settingsGeneration(0) {}
 };
 
+// Window input forwarded from the UI thread to the simulation thread
+enum InputType {
+    INPUT_KEY,
+    INPUT_CLICK,
+    INPUT_RIGHT_CLICK,
+    INPUT_WHEEL
+};
+
+struct InputCommand {
+    InputType type;
+    WPARAM key;   // INPUT_KEY
+    bool control; // Modifier state when the key went down; GetKeyState only knows the UI thread's
+    bool shift;
+    int x, y;     // INPUT_CLICK, INPUT_RIGHT_CLICK
+    int delta;    // INPUT_WHEEL
+};
+
+const size_t INPUT_QUEUE_CAPACITY = 256;
+
+// Sent by the simulation thread to show the RIGHTY hit dialog on the UI thread;
+// lParam is the RightyHitParams, the result is nonzero when they were confirmed
+const UINT WM_RIGHTY_HIT = WM_APP + 1;
+
 // RIGHTY hit dialog parameters
 struct RightyHitParams {
     float force;
@@ -198,249 +462,222 @@ struct RightyHitParams {
 // Forward declaration
 bool ShowRightyHitDialog(HWND hwndParent, RightyHitParams* params);
 
-// Tennis ball physics state
-class TennisBall {
+// Interactive return policy: asks for every return with the modal hit dialog,
+// prefilled with the previous answer. It runs on the simulation thread, which waits
+// in SendMessage while the UI thread shows the dialog.
+class DialogReturnPolicy : public ReturnHitPolicy {
 public:
-    float y;              // Height in meters
-    float vy;             // Vertical velocity in m/s
-    float x;              // Horizontal position in meters
-    float vx;             // Horizontal velocity in m/s
-    float time;           // Elapsed time in seconds
-    int bounceCount;
-    bool isActive;
-    CourtSurface* surface;
-    float airResistanceCoeff; // Air resistance coefficient
-    float spinRPM;        // Ball spin in revolutions per minute (positive = topspin, negative = backspin)
-    std::vector<BounceData> trajectory;
-    std::vector<BounceData> bounces;
-    
-    TennisBall(CourtSurface* courtSurface) {
-        surface = courtSurface;
-        airResistanceCoeff = 0.0f;
-        spinRPM = 0.0f;
-        reset();
-    }
-    
-    void reset() {
-        y = INITIAL_HEIGHT;
-        vy = 0.0f;
-        x = 0.0f;
-        vx = 0.0f;
-        time = 0.0f;
-        bounceCount = 0;
-        isActive = true;
-        trajectory.clear();
-        bounces.clear();
-        // Record initial position
-        trajectory.push_back({time, y, x});
-    }
-    
-    void resetForHorizontalShot(float horizontalForce, float angleDegrees, float spin) {
-        // LEFTY position: 20 pixels from left court edge
-        // Convert 20 pixels to meters based on court scaling
-        x = (20.0f / (WINDOW_WIDTH - 100.0f)) * COURT_LENGTH; // Start from LEFTY position
-        y = 1.0f; // Start at net height
-        // Map force (0-1000N) to realistic tennis velocities (0-50 m/s)
-        // Professional tennis serves: 50-70 m/s, groundstrokes: 20-40 m/s
-        float totalVelocity = (horizontalForce / MAX_HORIZONTAL_FORCE) * 50.0f;
-        
-        // Convert angle to radians and calculate velocity components
-        float angleRad = angleDegrees * 3.14159265f / 180.0f;
-        vx = totalVelocity * cos(angleRad);
-        vy = totalVelocity * sin(angleRad);
-        
-        spinRPM = spin;
-        time = 0.0f;
-        bounceCount = 0;
-        isActive = true;
-        trajectory.clear();
-        bounces.clear();
-        trajectory.push_back({time, y, x});
-    }
-    
-    void setAirResistance(float coefficient) {
-        airResistanceCoeff = coefficient;
-    }
-    
-    void update(float dt) {
-        if (!isActive) return;
-        
-        // Store previous position for net collision detection
-        float prevX = x;
-        float prevY = y;
-        
-        time += dt;
-        
-        // Physics update
-        vy -= GRAVITY * dt;  // Apply gravity
-        
-        // Magnus effect from spin
-        // Convert RPM to rad/s: omega = RPM * 2*pi / 60
-        float omega = spinRPM * 2.0f * 3.14159265f / 60.0f;
-        // Magnus force coefficient: Cl ~= 0.3 for tennis ball
-        // Magnus force = 0.5 * Cl * rho * A * r * omega * v
-        // Simplified: F_magnus = k * omega * v, where k incorporates constants
-        float magnusCoeff = 0.00015f; // Tuned coefficient
-        float ballSpeed = sqrt(vx * vx + vy * vy);
-        
-        if (ballSpeed > 0.1f) {
-            // Magnus force perpendicular to velocity
-            // Topspin (positive) curves down, backspin (negative) curves up
-            float magnusForce = magnusCoeff * omega * ballSpeed;
-            float magnusAccelY = magnusForce / BALL_MASS;
-            
-            // Apply Magnus acceleration (perpendicular to velocity direction)
-            vy -= magnusAccelY * dt;
-        }
-        
-        y += vy * dt;        // Update position
-        
-        // Horizontal physics with air resistance
-        float airResistanceForce = -airResistanceCoeff * vx * fabs(vx);
-        float ax = airResistanceForce / BALL_MASS;
-        vx += ax * dt;
-        x += vx * dt;
-        
-        // Net collision detection
-        const float NET_X = COURT_LENGTH / 2.0f; // Net is at center of court
-        const float NET_ABSORPTION = 0.80f; // Net absorbs 80% of force, returns 20%
-        
-        // Check if ball crossed the net plane
-        bool crossedNet = (prevX < NET_X && x >= NET_X) || (prevX > NET_X && x <= NET_X);
-        
-        if (crossedNet) {
-            // Linear interpolation to find exact collision point
-            float t = (NET_X - prevX) / (x - prevX); // Interpolation factor
-            float collisionY = prevY + t * (y - prevY);
-            
-            // Check if ball hit the net (collision height is below net height + ball radius)
-            if (collisionY <= NET_HEIGHT + BALL_RADIUS) {
-                // Ball hit the net!
-                // Position ball at net surface
-                x = NET_X;
-                y = collisionY;
-                
-                // Net absorbs 80% of force, reflects 20% back
-                // Reflect horizontal velocity with 80% energy absorption
-                vx = -vx * (1.0f - NET_ABSORPTION);
-                
-                // Apply 80% absorption to vertical velocity as well
-                vy *= (1.0f - NET_ABSORPTION);
-                
-                // Add some random deflection for realism
-                float randomDeflection = ((rand() % 100) / 100.0f - 0.5f) * 0.3f; // -0.15 to +0.15 m/s
-                vy += randomDeflection;
-                
-                // Reduce spin on net collision (80% absorption)
-                spinRPM *= (1.0f - NET_ABSORPTION);
-                
-                // If ball is moving very slowly after net collision, it might drop straight down
-                if (fabs(vx) < 0.5f && fabs(vy) < 0.5f) {
-                    vx = 0.0f;
-                }
-            }
-        }
-        
-        // Record trajectory
-        trajectory.push_back({time, y, x});
-        
-        // Check for ground collision
-        if (y <= 0.0f) {
-            y = 0.0f;
-            
-            // Record bounce if we haven't recorded 3 yet
-            if (bounceCount < 3) {
-                bounces.push_back({time, 0.0f});
-            }
-            
-            // Apply coefficient of restitution
-            vy = -vy * surface->coefficientOfRestitution;
-            vx *= 0.8f; // Horizontal velocity reduction on bounce
-            
-            // Spin affects bounce: topspin increases forward velocity, backspin decreases it
-            float spinEffect = (spinRPM / 5000.0f) * 2.0f; // Normalized spin effect
-            vx += spinEffect;
-            
-            // Spin decays on bounce
-            spinRPM *= 0.7f;
-            
-            bounceCount++;
-            
-            // Stop if velocity is too low or we've bounced enough
-            if (fabs(vy) < 0.1f || bounceCount > 10) {
-                isActive = false;
-                vy = 0.0f;
-                vx = 0.0f;
-            }
-        }
-        
-        // Stop if ball goes out of bounds horizontally
-        if (x < 0.0f || x > COURT_LENGTH) {
-            isActive = false;
-        }
+    explicit DialogReturnPolicy(HWND hwnd) : hwnd(hwnd), lastHit(DEFAULT_RETURN_HIT) {}
+    
+    ReturnPolicyType Type() const override { return RETURN_POLICY_DIALOG; }
+    const wchar_t* Name() const override { return L"Dialog"; }
+    
+    bool ChooseReturn(const TennisBall&, LaunchPattern, float, AirResistanceMode, ReturnHit& hit) override {
+        RightyHitParams params;
+        params.force = lastHit.force;
+        params.angle = lastHit.angle;
+        params.spin = lastHit.spin;
+        params.confirmed = false;
+        
+        // User cancelled: the ball just bounces back
+        if (!SendMessage(hwnd, WM_RIGHTY_HIT, 0, (LPARAM)&params) || !params.confirmed) return false;
+        
+        lastHit.force = params.force;
+        lastHit.angle = params.angle;
+        lastHit.spin = params.spin;
+        hit = lastHit;
+        return true;
     }
+    
+private:
+    HWND hwnd;
+    ReturnHit lastHit;
 };
 
-// Direct2D Application
+// Direct2D Application. Physics runs on its own simulation thread (RunSimulation),
+// which owns the balls, the launch settings and every other member the physics step
+// touches. The UI thread forwards window input to it through inputQueue and draws the
+// newest SimSnapshot, so neither a slow frame nor the physics delays the other; the
+// UI thread itself keeps the Direct2D resources, the trace geometry, the landing
+// prediction and the ensemble.
 class D2DApp {
 private:
     HWND hwnd;
     ID2D1Factory* pFactory;
-    ID2D1HwndRenderTarget* pRenderTarget;
+    DeviceResources deviceResources;
+    ID2D1HwndRenderTarget* pRenderTarget; // deviceResources' target, refreshed every frame
     IDWriteFactory* pDWriteFactory;
     IDWriteTextFormat* pTextFormat;
     IDWriteTextFormat* pSmallTextFormat;
     
-    ID2D1SolidColorBrush* pBrush;
-    TennisBall* balls[4];
+    ID2D1SolidColorBrush* pBrush; // Brush for the next draw calls, selected from deviceResources
+    ID2D1RectangleGeometry* pCourtGeometry; // Single-court view floor, built once
+    ID2D1PathGeometry* pNetGeometry;        // Single-court view net post and top bar
+    HeightGraphLayer graphLayer;            // Combined graph, cached; only new segments are drawn into it
+    IDWriteTextLayout* pGraphTitleLayout;   // Combined graph labels, laid out once
+    std::vector<IDWriteTextLayout*> graphLegendLayouts;         // Per court; null where the entry is too narrow
+    std::vector<const TrajectoryBuffer*> graphTrajectories;     // This frame's drop ball traces, for graphLayer
+    std::vector<CourtInstance> courtInstances; // One per courtDefinitions row
+    // Per-court work of both threads: the simulation thread steps courts on it, the UI
+    // thread builds their graph traces. Null with [Courts] Threads=1.
+    std::unique_ptr<ThreadPool> courtPool;
     bool simulationStarted;
     bool simulationComplete;
     
     ScreenMode currentScreen;
-    TennisBall* clayBall;
-    TennisBall* grassBall;
-    TennisBall* hardBall;
-    TennisBall* laverBall;
     float horizontalForce;
     float launchAngle; // Launch angle in degrees
     float ballSpin; // Ball spin in RPM
     float visualPaceMultiplier; // Visual speed multiplier
     AirResistanceMode airResistanceMode;
     LaunchPattern currentLaunchPattern;
+    RandomStream launchRandom; // PATTERN_RANDOM draws, stream LAUNCH_RANDOM_STREAM
     D2D1_RECT_F comboBoxRect;
     D2D1_RECT_F launchPatternComboBoxRect;
     
-    // Auto-relaunch state
-    bool waitingToRelaunch;
-    float relaunchTimer;
+    // Auto-relaunch delay
     const float RELAUNCH_DELAY = 2.0f; // 2 seconds
+    const float RIGHTY_RADIUS = 0.05f; // 5cm radius for collision detection
+    const float RIGHTY_HEIGHT = NET_HEIGHT * 2.5f; // Height of RIGHTY stick
     
     // RIGHTY position (in meters from left edge of court)
     float rightyPosition;
     
-    // RIGHTY hit dialog parameters
-    bool ballHitRighty;
-    bool simulationPaused;
-    float rightyHitForce;
-    float rightyHitAngle;
-    float rightyHitSpin;
+    // RIGHTY return hits
+    std::unique_ptr<ReturnHitPolicy> returnPolicy;
+    
+    // Ball machine drills (M key): every court's machine feeds hundreds of balls at
+    // RIGHTY, who plays FIXED_RETURN_HIT on each one it reaches
+    bool rallyMode;
+    BallSprites rallySprites; // UI thread: the viewed court's drill balls, drawn in one call
+    const float RALLY_BALL_PIXELS = 2.5f; // Radius of a drill ball in the court view
+    bool simulationPaused; // Physics clock held while the return policy waits on the user
+    
+    // Fixed-step physics clock
+    LARGE_INTEGER counterFrequency;
+    LARGE_INTEGER lastFrameCounter;
+    float physicsAccumulator; // Paced simulation time not yet stepped, in seconds
+    float renderAlpha;        // Fraction of a step between the last two physics states
+    const float MAX_FRAME_TIME = 0.25f; // seconds
+    const int MAX_STEPS_PER_FRAME = 2000;
+    
+    // Background parameter sweep (P key)
+    std::unique_ptr<ThreadPool> sweepPool;
+    std::thread sweepThread;
+    std::atomic<bool> sweepRunning;
+    std::atomic<bool> sweepCancel;
+    std::atomic<size_t> sweepShotsDone;
+    std::atomic<size_t> sweepShotCount;
+    
+    // Trajectory archives: K records the shot balls, Y replays the last archive written
+    std::unique_ptr<TrajectoryWriter> recording;
+    uint64_t recordedShots;     // Shot id of the next recorded shot
+    std::wstring archivePath;   // Recording or sweep archive opened by Y
+    TrajectoryReader replay;
+    bool replaying;
+    size_t replayShot;          // Shot table index on screen
+    size_t replayCourt;         // Court instance drawing it
+    size_t replayShownSample;   // Samples of replaySamples already in the court ball's trajectory
+    float replayTime;           // Shot time on screen, may run RELAUNCH_DELAY past the last sample
+    std::vector<TrajectorySample> replaySamples;
+    const float REPLAY_SCRUB_SPEED = 4.0f; // Shot seconds per second while Left/Right is held
+    
+    // Landing prediction: landing_table.bin is mapped, or built in the background, on first use,
+    // and rebuilt when a settings reload changes the air coefficients
+    LandingTable landingTable;
+    std::thread landingThread;
+    bool landingRequested;
+    std::atomic<bool> landingReady; // landingTable is only read once this is set
+    std::mutex landingLock;         // Held by readers of landingTable and by a rebuild clearing landingReady
+    std::atomic<bool> landingCancel;
+    std::atomic<size_t> landingShotsDone;
+    
+    // Monte Carlo ensemble (E key): perturbed copies of the aimed shot run in the
+    // background; the UI thread only reads ensembleHistogram's counters
+    bool ensembleMode;
+    std::unique_ptr<ThreadPool> ensemblePool;
+    std::thread ensembleThread;
+    std::atomic<bool> ensembleCancel;
+    LandingHistogram ensembleHistogram;
+    EnsembleSpec ensembleSpec; // Ensemble filling ensembleHistogram
+    const float HEATMAP_MAX_HEIGHT = 40.0f; // pixels, the fullest bin
+    
+    // Simulation thread and its handoff to the UI thread
+    std::thread simulationThread;
+    std::atomic<bool> simulationStop;
+    SpscQueue<InputCommand, INPUT_QUEUE_CAPACITY> inputQueue; // UI thread to simulation thread
+    TripleBuffer<SimSnapshot> snapshots;                      // Simulation thread to UI thread
+    const SimSnapshot* frame; // Snapshot the UI thread is drawing
+    const int SIMULATION_TICK_MS = 2; // Wait between physics ticks; steps are paced by the clock, not the tick
+    
+    // settings.ini hot reload (LoadLiveSettings). The simulation thread applies a change
+    // between ticks holding engineTablesLock exclusively; sweeps, ensembles and landing
+    // table builds hold it shared while they read courts[], airModes[] and
+    // launchPatterns[], so a reload waits for them to finish.
+    SettingsWatcher settingsWatcher;
+    std::shared_mutex engineTablesLock;
+    bool settingsReloadPending;      // Simulation thread: a change not applied yet
+    unsigned settingsGeneration;     // Simulation thread: reloads applied so far
+    unsigned seenSettingsGeneration; // UI thread: the reload it last reacted to
+    
+    // Instrumentation overlay (O key); the summary is refreshed a few times a second
+    bool profilerOverlay;
+    ProfileSummary profileSummary;
+    Profiler::Clock::time_point profileSummaryTime;
+    std::wstring profileNotice; // Result of the last J, shown under the overlay for a while
+    Profiler::Clock::time_point profileNoticeTime;
+    const double PROFILE_WINDOW_SECONDS = 1.0;
+    const double PROFILE_REFRESH_SECONDS = 0.25;
+    const double PROFILE_NOTICE_SECONDS = 3.0;
     
 public:
     D2DApp() : hwnd(NULL), pFactory(NULL), pRenderTarget(NULL), 
                pDWriteFactory(NULL), pTextFormat(NULL), pSmallTextFormat(NULL),
-               pBrush(NULL), simulationStarted(false), simulationComplete(false),
+               pBrush(NULL), pCourtGeometry(NULL), pNetGeometry(NULL), graphLayer(GRAPH_MAX_HEIGHT),
+               pGraphTitleLayout(NULL), simulationStarted(false), simulationComplete(false),
                currentScreen(MODE_ALL), horizontalForce(DEFAULT_HORIZONTAL_FORCE), launchAngle(DEFAULT_ANGLE),
                ballSpin(DEFAULT_SPIN), visualPaceMultiplier(DEFAULT_PACE), airResistanceMode(AIR_SEA_LEVEL),
-               currentLaunchPattern(PATTERN_RANDOM),
-               waitingToRelaunch(false), relaunchTimer(0.0f), rightyPosition(COURT_LENGTH - 1.0f),
-               ballHitRighty(false), simulationPaused(false), rightyHitForce(300.0f), rightyHitAngle(30.0f), rightyHitSpin(120.0f) {
-        for (int i = 0; i < 4; i++) {
-            balls[i] = new TennisBall(&courts[i]);
+               currentLaunchPattern(PATTERN_RANDOM), launchRandom(RANDOM_SEED, LAUNCH_RANDOM_STREAM),
+               rightyPosition(COURT_LENGTH - 1.0f), rallyMode(false),
+               simulationPaused(false),
+               physicsAccumulator(0.0f), renderAlpha(1.0f),
+               sweepRunning(false), sweepCancel(false), sweepShotsDone(0), sweepShotCount(0),
+               recordedShots(0), replaying(false), replayShot(0), replayCourt(0), replayShownSample(0), replayTime(0.0f),
+               landingRequested(false), landingReady(false), landingCancel(false), landingShotsDone(0),
+               ensembleMode(false), ensembleCancel(false), ensembleSpec(),
+               simulationStop(false), frame(NULL), settingsReloadPending(false), settingsGeneration(0),
+               seenSettingsGeneration(0), profilerOverlay(false), profileSummary() {
+        courtInstances.reserve(courtDefinitions.size());
+        for (const CourtDefinition& definition : courtDefinitions) {
+            CourtInstance court;
+            court.definition = &definition;
+            court.index = courtInstances.size();
+            court.dropBall = std::make_unique<TennisBall>(definition.surface);
+            court.shotBall = std::make_unique<TennisBall>(definition.surface);
+            court.courtTrace = std::make_unique<TraceGeometry>(TRACE_AXIS_POSITION);
+            court.graphTrace = std::make_unique<TraceGeometry>(TRACE_AXIS_TIME, GRAPH_MAX_HEIGHT);
+            court.waitingToRelaunch = false;
+            court.relaunchTimer = 0.0f;
+            
+            // Trajectory rings are sized once here; recording never allocates afterwards
+            court.dropBall->trajectory.setCapacity(TRAJECTORY_CAPACITY);
+            court.shotBall->trajectory.setCapacity(TRAJECTORY_CAPACITY);
+            if (INTEGRATOR != INTEGRATOR_EULER) {
+                court.dropIntegrator = CreateIntegrator(INTEGRATOR);
+                court.shotIntegrator = CreateIntegrator(INTEGRATOR);
+                court.dropBall->setIntegrator(court.dropIntegrator.get());
+                court.shotBall->setIntegrator(court.shotIntegrator.get());
+            }
+            court.dropBall->setRandomStream(RANDOM_SEED, 2 * court.index);
+            court.shotBall->setRandomStream(RANDOM_SEED, 2 * court.index + 1);
+            court.dropBall->reset();
+            court.shotBall->reset();
+            courtInstances.push_back(std::move(court));
         }
-        clayBall = new TennisBall(&courts[0]); // Use clay court properties
-        grassBall = new TennisBall(&courts[1]); // Use grass court properties
-        hardBall = new TennisBall(&courts[2]); // Use hard court properties
-        laverBall = new TennisBall(&courts[3]); // Use Laver Cup properties
+        graphTrajectories.resize(courtInstances.size());
+        
+        QueryPerformanceFrequency(&counterFrequency);
+        QueryPerformanceCounter(&lastFrameCounter);
         
         // Initialize combo box positions
         comboBoxRect = D2D1::RectF(10, 420, 200, 445);
@@ -448,19 +685,30 @@ public:
     }
     
     ~D2DApp() {
-        SafeRelease(&pBrush);
+        StopSimulationThread();
+        sweepCancel = true;
+        landingCancel = true;
+        if (sweepThread.joinable()) {
+            sweepThread.join();
+        }
+        if (landingThread.joinable()) {
+            landingThread.join();
+        }
+        StopEnsemble();
+        StopRecording();
+        courtInstances.clear(); // Trace geometry before the factory that made it
+        graphLayer.Discard();
+        deviceResources.Discard();
+        for (IDWriteTextLayout*& layout : graphLegendLayouts) {
+            SafeRelease(&layout);
+        }
+        SafeRelease(&pGraphTitleLayout);
+        SafeRelease(&pCourtGeometry);
+        SafeRelease(&pNetGeometry);
         SafeRelease(&pTextFormat);
         SafeRelease(&pSmallTextFormat);
-        SafeRelease(&pRenderTarget);
         SafeRelease(&pFactory);
         SafeRelease(&pDWriteFactory);
-        for (int i = 0; i < 4; i++) {
-            delete balls[i];
-        }
-        delete clayBall;
-        delete grassBall;
-        delete hardBall;
-        delete laverBall;
     }
     
     template <class T>
@@ -471,26 +719,114 @@ public:
         }
     }
     
+    ID2D1SolidColorBrush* CourtBrush(const CourtInstance& court) {
+        return deviceResources.Brush(BRUSH_COURT_FIRST + 2 * court.index);
+    }
+    
+    ID2D1SolidColorBrush* BallBrush(const CourtInstance& court) {
+        return deviceResources.Brush(BRUSH_COURT_FIRST + 2 * court.index + 1);
+    }
+    
+    // Title and legend labels of the combined graph. They never change, so they are
+    // laid out once instead of on every DrawTextW.
+    HRESULT CreateGraphLabels() {
+        const wchar_t* title = L"Height vs Time (All Courts)";
+        HRESULT hr = pDWriteFactory->CreateTextLayout(
+            title, (UINT32)wcslen(title), pSmallTextFormat, GRAPH_WIDTH - 10, 20, &pGraphTitleLayout
+        );
+        
+        // Entries narrower than MIN_LABEL_WIDTH keep only their dot
+        const float legendSpacing = GRAPH_WIDTH / courtInstances.size();
+        graphLegendLayouts.assign(courtInstances.size(), NULL);
+        for (size_t i = 0; SUCCEEDED(hr) && legendSpacing >= MIN_LABEL_WIDTH && i < courtInstances.size(); i++) {
+            const wchar_t* label = courtInstances[i].definition->legend;
+            hr = pDWriteFactory->CreateTextLayout(
+                label, (UINT32)wcslen(label), pSmallTextFormat, legendSpacing - 20, 16, &graphLegendLayouts[i]
+            );
+        }
+        return hr;
+    }
+    
+    // Court floor and net of the single-court views. Geometry is device independent,
+    // so it is built once and survives device loss.
+    HRESULT CreateCourtGeometry() {
+        HRESULT hr = pFactory->CreateRectangleGeometry(
+            D2D1::RectF(COURT_VIEW_MARGIN, COURT_VIEW_TOP, COURT_VIEW_MARGIN + COURT_VIEW_PIXEL_WIDTH, COURT_VIEW_BOTTOM),
+            &pCourtGeometry
+        );
+        
+        if (SUCCEEDED(hr)) {
+            hr = pFactory->CreatePathGeometry(&pNetGeometry);
+        }
+        
+        ID2D1GeometrySink* pSink = NULL;
+        if (SUCCEEDED(hr)) {
+            hr = pNetGeometry->Open(&pSink);
+        }
+        
+        if (SUCCEEDED(hr)) {
+            float netX = COURT_VIEW_MARGIN + COURT_VIEW_PIXEL_WIDTH / 2.0f;
+            float netTop = COURT_VIEW_BOTTOM - NET_HEIGHT * 50.0f * COURT_VIEW_ZOOM; // Scale with zoom
+            
+            // Net post
+            D2D1_POINT_2F post[] = {
+                D2D1::Point2F(netX + 2.0f, netTop),
+                D2D1::Point2F(netX + 2.0f, COURT_VIEW_BOTTOM),
+                D2D1::Point2F(netX - 2.0f, COURT_VIEW_BOTTOM)
+            };
+            pSink->BeginFigure(D2D1::Point2F(netX - 2.0f, netTop), D2D1_FIGURE_BEGIN_FILLED);
+            pSink->AddLines(post, 3);
+            pSink->EndFigure(D2D1_FIGURE_END_CLOSED);
+            
+            // Net top bar, 2 pixels thick
+            D2D1_POINT_2F bar[] = {
+                D2D1::Point2F(netX + 10.0f, netTop - 1.0f),
+                D2D1::Point2F(netX + 10.0f, netTop + 1.0f),
+                D2D1::Point2F(netX - 10.0f, netTop + 1.0f)
+            };
+            pSink->BeginFigure(D2D1::Point2F(netX - 10.0f, netTop - 1.0f), D2D1_FIGURE_BEGIN_FILLED);
+            pSink->AddLines(bar, 3);
+            pSink->EndFigure(D2D1_FIGURE_END_CLOSED);
+            
+            hr = pSink->Close();
+        }
+        SafeRelease(&pSink);
+        
+        return hr;
+    }
+    
+    // Fills the court, outlines it and draws the net; leaves the white brush selected
+    void DrawCourtFloor(ID2D1SolidColorBrush* courtBrush) {
+        pRenderTarget->FillGeometry(pCourtGeometry, courtBrush);
+        
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
+        pRenderTarget->DrawGeometry(pCourtGeometry, pBrush, 2.0f);
+        pRenderTarget->FillGeometry(pNetGeometry, pBrush);
+    }
+    
     HRESULT Initialize(HWND hwnd) {
         this->hwnd = hwnd;
+        SetReturnPolicy(RETURN_POLICY);
+        PublishSnapshot(); // Something to draw before the simulation thread's first tick
         
-        HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &pFactory);
+        if (COURT_THREADS > 1) {
+            courtPool = std::make_unique<ThreadPool>(COURT_THREADS);
+        }
+        
+        // Multithreaded, so courtPool's workers can build trace geometry from it
+        HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, &pFactory);
         if (SUCCEEDED(hr)) {
-            RECT rc;
-            GetClientRect(hwnd, &rc);
-            
-            hr = pFactory->CreateHwndRenderTarget(
-                D2D1::RenderTargetProperties(),
-                D2D1::HwndRenderTargetProperties(
-                    hwnd,
-                    D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top)
-                ),
-                &pRenderTarget
-            );
+            std::vector<D2D1_COLOR_F> brushColors(appBrushColors, appBrushColors + BRUSH_COURT_FIRST);
+            for (const CourtInstance& court : courtInstances) {
+                brushColors.push_back(court.definition->palette->color);
+                brushColors.push_back(court.definition->palette->ballColor);
+            }
+            deviceResources.Configure(pFactory, hwnd, brushColors.data(), brushColors.size());
+            hr = deviceResources.EnsureCreated();
         }
         
         if (SUCCEEDED(hr)) {
-            hr = pRenderTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &pBrush);
+            hr = CreateCourtGeometry();
         }
         
         if (SUCCEEDED(hr)) {
@@ -527,317 +863,570 @@ public:
             );
         }
         
+        if (SUCCEEDED(hr)) {
+            hr = CreateGraphLabels();
+        }
+        
+        if (SUCCEEDED(hr)) {
+            Profiler::Instance().BindThread(PROFILE_THREAD_UI);
+            Profiler::Instance().SetEnabled(PROFILING_ENABLED);
+            settingsWatcher.Start(GetSettingsPath().c_str());
+            simulationThread = std::thread(&D2DApp::RunSimulation, this);
+        }
+        
         return hr;
     }
     
+    // Simulation thread: applies queued input, advances the physics clock and
+    // publishes the result, until StopSimulationThread
+    void RunSimulation() {
+        Profiler::Instance().BindThread(PROFILE_THREAD_SIMULATION);
+        QueryPerformanceCounter(&lastFrameCounter);
+        while (!simulationStop) {
+            {
+                PROFILE_SCOPE(ZONE_PHYSICS_TICK);
+                if (settingsWatcher.TakeChange()) {
+                    settingsReloadPending = true;
+                }
+                if (settingsReloadPending) {
+                    ReloadSettings();
+                }
+                InputCommand command;
+                while (inputQueue.Pop(command)) {
+                    ApplyInput(command);
+                }
+                Update();
+                PublishSnapshot();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(SIMULATION_TICK_MS));
+        }
+    }
+    
+    // Simulation thread: applies an edited settings.ini between ticks. Balls in flight
+    // keep the bounce and drag they launched with, so only the next launch, key press,
+    // return or drill sees the new values. While a background job reads the engine
+    // tables the reload stays pending and is tried again next tick.
+    void ReloadSettings() {
+        std::unique_lock<std::shared_mutex> tables(engineTablesLock, std::try_to_lock);
+        if (!tables.owns_lock()) return;
+        settingsReloadPending = false;
+        
+        // A file caught mid-save is read again after the save's own change
+        SettingsFile settings;
+        if (!settings.Load(GetSettingsPath().c_str())) return;
+        ReturnPolicyType previousPolicy = RETURN_POLICY;
+        LoadLiveSettings(settings);
+        
+        // Rebuilt for the new hits and patterns, except that the dialog keeps its last
+        // answer; a T key choice stands unless ReturnPolicy itself changed
+        ReturnPolicyType type = RETURN_POLICY != previousPolicy ? RETURN_POLICY : returnPolicy->Type();
+        if (type != RETURN_POLICY_DIALOG || returnPolicy->Type() != RETURN_POLICY_DIALOG) {
+            SetReturnPolicy(type);
+        }
+        settingsGeneration++;
+    }
+    
+    // Called from the UI thread. A dialog request sent by the simulation thread may be
+    // waiting on it, so sent messages are answered until the thread has ended.
+    void StopSimulationThread() {
+        simulationStop = true;
+        if (!simulationThread.joinable()) return;
+        HANDLE thread = (HANDLE)simulationThread.native_handle();
+        while (MsgWaitForMultipleObjects(1, &thread, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1) {
+            MSG msg;
+            PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE);
+        }
+        simulationThread.join();
+    }
+    
+    // Copies what Render draws into the snapshot being written and publishes it.
+    // Trajectories only copy the samples added since that snapshot was last written.
+    void PublishSnapshot() {
+        PROFILE_SCOPE(ZONE_SNAPSHOT);
+        SimSnapshot& snapshot = snapshots.WriteBuffer();
+        snapshot.currentScreen = currentScreen;
+        snapshot.simulationStarted = simulationStarted;
+        snapshot.renderAlpha = renderAlpha;
+        snapshot.rightyPosition = rightyPosition;
+        snapshot.horizontalForce = horizontalForce;
+        snapshot.launchAngle = launchAngle;
+        snapshot.ballSpin = ballSpin;
+        snapshot.visualPaceMultiplier = visualPaceMultiplier;
+        snapshot.airResistanceMode = airResistanceMode;
+        snapshot.currentLaunchPattern = currentLaunchPattern;
+        snapshot.returnPolicyName = returnPolicy->Name();
+        snapshot.recording = recording != nullptr;
+        snapshot.recordedShots = recordedShots;
+        snapshot.replaying = replaying;
+        snapshot.replayShot = replayShot;
+        snapshot.replayShotCount = replaying ? replay.ShotCount() : 0;
+        snapshot.replayShotId = replaying ? replay.Shot(replayShot).shotId : 0;
+        snapshot.rallyMode = rallyMode;
+        snapshot.settingsGeneration = settingsGeneration;
+        
+        snapshot.courts.resize(courtInstances.size());
+        for (const CourtInstance& court : courtInstances) {
+            snapshot.courts[court.index].dropBall.capture(*court.dropBall);
+            snapshot.courts[court.index].shotBall.capture(*court.shotBall);
+            
+            CourtSnapshot& courtSnapshot = snapshot.courts[court.index];
+            courtSnapshot.rallyX.clear();
+            courtSnapshot.rallyY.clear();
+            if (rallyMode) {
+                court.machine.CopyPositions(courtSnapshot.rallyX, courtSnapshot.rallyY);
+            }
+            courtSnapshot.rallyLaunched = court.machine.Launched();
+            courtSnapshot.rallyReturned = court.machine.Returned();
+        }
+        snapshots.Publish();
+    }
+    
+    // UI thread: window input for the simulation thread. Only E, which toggles the
+    // UI thread's own ensemble, and the instrumentation keys are handled here.
+    void PostKey(WPARAM wParam) {
+        if (wParam == 'O' || wParam == 'o') {
+            // O key - show or hide the instrumentation overlay; timings are recorded while it is shown
+            profilerOverlay = !profilerOverlay;
+            Profiler::Instance().SetEnabled(profilerOverlay || PROFILING_ENABLED);
+            profileSummaryTime = Profiler::Clock::time_point();
+            return;
+        }
+        if (wParam == 'J' || wParam == 'j') {
+            // J key - save the recorded timings as a Chrome trace
+            SaveProfileTrace();
+            return;
+        }
+        
+        const SimSnapshot& latest = snapshots.Read();
+        if ((wParam == 'E' || wParam == 'e') && latest.currentScreen != MODE_ALL && !latest.replaying) {
+            // E key - show or hide the Monte Carlo ensemble of the aimed shot
+            ensembleMode = !ensembleMode;
+            if (!ensembleMode) {
+                StopEnsemble();
+            }
+            return;
+        }
+        
+        InputCommand command = {};
+        command.type = INPUT_KEY;
+        command.key = wParam;
+        command.control = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+        command.shift = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+        inputQueue.Push(command);
+    }
+    
+    void PostMouse(InputType type, int x, int y, int delta) {
+        InputCommand command = {};
+        command.type = type;
+        command.x = x;
+        command.y = y;
+        command.delta = delta;
+        inputQueue.Push(command);
+    }
+    
+    // Simulation thread: runs the handler the command was queued for
+    void ApplyInput(const InputCommand& command) {
+        switch (command.type) {
+            case INPUT_KEY: OnKeyPress(command); break;
+            case INPUT_CLICK: OnMouseClick(command.x, command.y); break;
+            case INPUT_RIGHT_CLICK: OnMouseRightClick(command.x, command.y); break;
+            case INPUT_WHEEL: OnMouseWheel(command.delta); break;
+        }
+    }
+    
+    // UI thread, WM_RIGHTY_HIT: shows the dialog the simulation thread asked for,
+    // unless the application is shutting down
+    bool AnswerRightyHit(RightyHitParams* params) {
+        if (simulationStop) return false;
+        PROFILE_SCOPE(ZONE_RIGHTY_DIALOG);
+        return ShowRightyHitDialog(hwnd, params);
+    }
+    
     void StartSimulation() {
         simulationStarted = true;
         simulationComplete = false;
-        waitingToRelaunch = false;
-        relaunchTimer = 0.0f;
         
         if (currentScreen == MODE_ALL) {
-            for (int i = 0; i < 4; i++) {
-                balls[i]->reset();
+            ResetDrops();
+        } else {
+            ResetShots();
+        }
+    }
+    
+    // Back to the top of the drop on every court
+    void ResetDrops() {
+        for (CourtInstance& court : courtInstances) {
+            court.dropBall->reset();
+        }
+    }
+    
+    // Every court's shot ball back on LEFTY with the current launch settings
+    void ResetShots() {
+        for (CourtInstance& court : courtInstances) {
+            LaunchShot(court);
+            if (rallyMode && RunsDrill(court)) {
+                StartRally(court);
             }
-        } else if (currentScreen == MODE_CLAY) {
-            clayBall->setAirResistance(airModes[airResistanceMode].coefficient);
-            clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (currentScreen == MODE_GRASS) {
-            grassBall->setAirResistance(airModes[airResistanceMode].coefficient);
-            grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (currentScreen == MODE_HARD) {
-            hardBall->setAirResistance(airModes[airResistanceMode].coefficient);
-            hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (currentScreen == MODE_LAVER) {
-            laverBall->setAirResistance(airModes[airResistanceMode].coefficient);
-            laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
         }
     }
     
+    // Drills are only drawn in a single-court view, so courts without one (the custom
+    // courts of settings.ini) run none. BallBatch lanes also take their restitution
+    // from the built-in courts[], which a custom surface is not part of.
+    static bool RunsDrill(const CourtInstance& court) {
+        return court.definition->screen != MODE_ALL;
+    }
+    
+    // The court's aimed shot, as ShotParams for the engine
+    ShotParams AimedShot(const CourtInstance& court) const {
+        ShotParams shot = {horizontalForce, launchAngle, ballSpin, (int)court.definition->surface->type,
+                           airResistanceMode, 0};
+        return shot;
+    }
+    
+    // Clears the court's drill and arms its ball machine with the aimed shot
+    void StartRally(CourtInstance& court) {
+        BallMachineConfig config;
+        config.ballCount = RALLY_BALLS;
+        config.feedInterval = RALLY_FEED_INTERVAL;
+        config.feed.center = AimedShot(court);
+        config.feed.forceSigma = ENSEMBLE_FORCE_SIGMA;
+        config.feed.angleSigma = ENSEMBLE_ANGLE_SIGMA;
+        config.feed.spinSigma = ENSEMBLE_SPIN_SIGMA;
+        config.feed.shotCount = 0;
+        config.feed.seed = RANDOM_SEED + 1 + court.index; // Each court's machine jitters on its own
+        court.machine.Start(config);
+    }
+    
+    // One physics step of a court's drill. RIGHTY answers every court's balls, on
+    // screen or not, since no drill ball ever asks for the dialog.
+    void StepRally(CourtInstance& court, float dt) {
+        RallyReceiver righty = {rightyPosition, BALL_RADIUS + RIGHTY_RADIUS, RIGHTY_HEIGHT, FIXED_RETURN_HIT};
+        court.machine.Step(dt, righty);
+    }
+    
+    // Puts a court's shot ball on LEFTY with the current launch settings. While
+    // recording, the shot it replaces goes to the archive and the new one starts.
+    void LaunchShot(CourtInstance& court) {
+        TennisBall* ball = court.shotBall.get();
+        if (recording) {
+            ArchiveShot(court);
+        }
+        
+        ball->setAirResistance(airModes[airResistanceMode].coefficient);
+        ball->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
+        court.waitingToRelaunch = false;
+        court.relaunchTimer = 0.0f;
+        
+        if (recording) {
+            ShotParams shot = {horizontalForce, launchAngle, ballSpin, (int)court.definition->surface->type,
+                               airResistanceMode, ball->random.Stream()};
+            court.recorder.Begin(shot);
+            court.recorder.Record(*ball);
+        }
+    }
+    
+    // Appends the court's recorded shot; shots re-aimed before they flew keep only the launch sample and are skipped
+    void ArchiveShot(CourtInstance& court) {
+        if (court.recorder.Samples().size() > 1) {
+            recording->AppendShot(recordedShots++, court.recorder);
+        }
+        court.recorder.Begin(ShotParams());
+    }
+    
+    // K key: shots launched from now on are archived to recording.trj
+    void StartRecording() {
+        std::wstring path = GetExeDirectory() + L"recording.trj";
+        recording = std::make_unique<TrajectoryWriter>();
+        if (!recording->Open(path.c_str())) {
+            recording.reset();
+            return;
+        }
+        archivePath = path;
+        recordedShots = 0;
+        for (CourtInstance& court : courtInstances) {
+            court.recorder.Begin(ShotParams());
+        }
+    }
+    
+    // Archives the shots still in flight and finishes the file
+    void StopRecording() {
+        if (!recording) return;
+        for (CourtInstance& court : courtInstances) {
+            ArchiveShot(court);
+        }
+        recording->Close();
+        recording.reset();
+    }
+    
+    // RIGHTY answers its next contact with a policy of the given type
+    void SetReturnPolicy(ReturnPolicyType type) {
+        if (type == RETURN_POLICY_DIALOG) {
+            returnPolicy = std::make_unique<DialogReturnPolicy>(hwnd);
+        } else if (type == RETURN_POLICY_TARGET) {
+            returnPolicy = std::make_unique<TargetReturnPolicy>(RETURN_TARGET_X, FIXED_RETURN_HIT, LANDING_GRID);
+        } else {
+            returnPolicy = CreateReturnPolicy(type, FIXED_RETURN_HIT);
+        }
+    }
+    
+    // Court shown by a single-court view, NULL in the all-courts view
+    CourtInstance* ViewedCourt(ScreenMode screen) {
+        if (screen == MODE_ALL) return NULL;
+        for (CourtInstance& court : courtInstances) {
+            if (court.definition->screen == screen) return &court;
+        }
+        return NULL;
+    }
+    
+    // Called on every simulation thread tick. Wall-clock time from the performance counter, scaled
+    // by the visual pace, feeds an accumulator drained in fixed PHYSICS_DT steps, so
+    // results do not depend on pace or on timer jitter. The leftover fraction of a step
+    // is kept in renderAlpha for interpolating ball positions between the last two states.
     void Update() {
-        if (!simulationStarted || simulationComplete || simulationPaused) return;
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        float frameSeconds = (float)(now.QuadPart - lastFrameCounter.QuadPart) / (float)counterFrequency.QuadPart;
+        lastFrameCounter = now;
+        
+        if (replaying) {
+            AdvanceReplay(min(frameSeconds, MAX_FRAME_TIME));
+            return;
+        }
+        
+        if (!simulationStarted || simulationComplete || simulationPaused) {
+            physicsAccumulator = 0.0f;
+            renderAlpha = 1.0f;
+            return;
+        }
         
-        float adjustedDT = DT * visualPaceMultiplier;
+        // Clamp long frames (modal dialogs, window drags) instead of replaying them in a burst
+        frameSeconds = min(frameSeconds, MAX_FRAME_TIME);
         
         // Update RIGHTY position based on keyboard input (for individual court screens)
         if (currentScreen != MODE_ALL) {
             const float NET_X = COURT_LENGTH / 2.0f; // Net position at center of court
             
             if (GetAsyncKeyState(VK_LEFT) & 0x8000) {
-                rightyPosition -= ::RIGHTY_SPEED * DT; // Use raw DT, not affected by visual pace
+                rightyPosition -= ::RIGHTY_SPEED * frameSeconds; // Wall-clock time, not affected by visual pace
                 // Don't allow RIGHTY to cross the net to the left
                 rightyPosition = max(NET_X, rightyPosition);
             }
             if (GetAsyncKeyState(VK_RIGHT) & 0x8000) {
-                rightyPosition += ::RIGHTY_SPEED * DT; // Use raw DT, not affected by visual pace
+                rightyPosition += ::RIGHTY_SPEED * frameSeconds; // Wall-clock time, not affected by visual pace
                 rightyPosition = min(COURT_LENGTH, rightyPosition);
             }
         }
         
+        physicsAccumulator += frameSeconds * visualPaceMultiplier;
+        int steps = 0;
+        if (CourtsStepIndependently()) {
+            while (physicsAccumulator >= PHYSICS_DT && steps < MAX_STEPS_PER_FRAME) {
+                physicsAccumulator -= PHYSICS_DT;
+                steps++;
+            }
+            StepCourtsInParallel(PHYSICS_DT, steps);
+        } else {
+            while (physicsAccumulator >= PHYSICS_DT && steps < MAX_STEPS_PER_FRAME) {
+                StepSimulation(PHYSICS_DT);
+                physicsAccumulator -= PHYSICS_DT;
+                steps++;
+                if (simulationComplete || simulationPaused) break;
+            }
+        }
+        if (steps == MAX_STEPS_PER_FRAME) {
+            physicsAccumulator = 0.0f; // Too far behind; drop the backlog rather than spiral
+        }
+        renderAlpha = min(1.0f, physicsAccumulator / PHYSICS_DT);
+    }
+    
+    // Advances one ball with the integrator selected in settings.ini
+    void AdvanceBall(TennisBall* ball, float dt, bool facesRighty) {
+        if (::EVENT_DRIVEN) {
+            // Stop the ball 1 mm inside RIGHTY's reach so CheckRightyCollision sees the contact
+            float rightyX = facesRighty ? rightyPosition - (BALL_RADIUS + RIGHTY_RADIUS) + 0.001f : -1.0f;
+            ball->updateEventDriven(dt, rightyX);
+        } else {
+            ball->update(dt);
+        }
+    }
+    
+    // Advances every court of the current view by one fixed physics step. All courts
+    // are stepped together, whichever one is on screen.
+    void StepSimulation(float dt) {
+        PROFILE_SCOPE(ZONE_PHYSICS_STEP);
         if (currentScreen == MODE_ALL) {
             bool anyActive = false;
-            for (int i = 0; i < 4; i++) {
-                balls[i]->update(adjustedDT);
-                if (balls[i]->isActive) anyActive = true;
+            for (CourtInstance& court : courtInstances) {
+                AdvanceBall(court.dropBall.get(), dt, false);
+                if (court.dropBall->isActive) anyActive = true;
             }
             
             if (!anyActive) {
                 simulationComplete = true;
             }
-        } else if (currentScreen == MODE_CLAY) {
-            // Check if ball reached right end of court or stopped moving
-            if (clayBall->isActive && clayBall->x >= COURT_LENGTH) {
-                clayBall->isActive = false;
-                waitingToRelaunch = true;
-                relaunchTimer = 0.0f;
-            }
-            
-            // Handle relaunch timer
-            if (waitingToRelaunch) {
-                relaunchTimer += adjustedDT;
-                if (relaunchTimer >= RELAUNCH_DELAY) {
-                    ApplyLaunchPattern();
-                    
-                    clayBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    waitingToRelaunch = false;
-                    relaunchTimer = 0.0f;
-                }
-            } else {
-                clayBall->update(adjustedDT);
-                
-                // Check for RIGHTY collision
-                if (CheckRightyCollision(clayBall)) {
-                    simulationPaused = true;
-                    ballHitRighty = true;
-                    
-                    // Show dialog for hit parameters
-                    RightyHitParams params;
-                    params.force = rightyHitForce;
-                    params.angle = rightyHitAngle;
-                    params.spin = rightyHitSpin;
-                    params.confirmed = false;
-                    
-                    if (ShowRightyHitDialog(hwnd, &params) && params.confirmed) {
-                        rightyHitForce = params.force;
-                        rightyHitAngle = params.angle;
-                        rightyHitSpin = params.spin;
-                        ApplyRightyHit(clayBall, params.force, params.angle, params.spin);
-                    } else {
-                        // User cancelled, just bounce back
-                        clayBall->vx = -clayBall->vx * 0.5f;
-                        clayBall->x = rightyPosition - 0.1f;
-                        simulationPaused = false;
-                        ballHitRighty = false;
-                    }
-                }
-                
-                // Check if ball stopped moving
-                if (!clayBall->isActive) {
-                    waitingToRelaunch = true;
-                    relaunchTimer = 0.0f;
+        } else {
+            CourtInstance* viewed = ViewedCourt(currentScreen);
+            for (CourtInstance& court : courtInstances) {
+                if (rallyMode) {
+                    if (RunsDrill(court)) StepRally(court, dt);
+                } else {
+                    StepShot(court, dt, &court == viewed);
                 }
             }
-        } else if (currentScreen == MODE_GRASS) {
-            // Check if ball reached right end of court or stopped moving
-            if (grassBall->isActive && grassBall->x >= COURT_LENGTH) {
-                grassBall->isActive = false;
-                waitingToRelaunch = true;
-                relaunchTimer = 0.0f;
+        }
+    }
+    
+    // Nothing couples the courts of the all-courts view or of ball machine drills: no
+    // dialog, launch settings or recording is touched, so each court can run a whole
+    // tick's steps on its own
+    bool CourtsStepIndependently() const {
+        return courtPool && (currentScreen == MODE_ALL || rallyMode);
+    }
+    
+    // StepSimulation's work for steps physics steps, one task per court on courtPool.
+    // Returns once every court is done, so the snapshot after it sees them all.
+    void StepCourtsInParallel(float dt, int steps) {
+        if (steps == 0) return;
+        PROFILE_SCOPE(ZONE_PHYSICS_STEP);
+        bool allCourts = currentScreen == MODE_ALL;
+        courtPool->ParallelFor(courtInstances.size(), [&](size_t i) {
+            CourtInstance& court = courtInstances[i];
+            for (int step = 0; step < steps; step++) {
+                if (allCourts) {
+                    AdvanceBall(court.dropBall.get(), dt, false);
+                } else if (RunsDrill(court)) {
+                    StepRally(court, dt);
+                }
             }
-            
-            // Handle relaunch timer
-            if (waitingToRelaunch) {
-                relaunchTimer += adjustedDT;
-                if (relaunchTimer >= RELAUNCH_DELAY) {
-                    ApplyLaunchPattern();
-                    
-                    grassBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    waitingToRelaunch = false;
-                    relaunchTimer = 0.0f;
-                }
-            } else {
-                grassBall->update(adjustedDT);
-                
-                // Check for RIGHTY collision
-                if (CheckRightyCollision(grassBall)) {
-                    simulationPaused = true;
-                    ballHitRighty = true;
-                    
-                    // Show dialog for hit parameters
-                    RightyHitParams params;
-                    params.force = rightyHitForce;
-                    params.angle = rightyHitAngle;
-                    params.spin = rightyHitSpin;
-                    params.confirmed = false;
-                    
-                    if (ShowRightyHitDialog(hwnd, &params) && params.confirmed) {
-                        rightyHitForce = params.force;
-                        rightyHitAngle = params.angle;
-                        rightyHitSpin = params.spin;
-                        ApplyRightyHit(grassBall, params.force, params.angle, params.spin);
-                    } else {
-                        // User cancelled, just bounce back
-                        grassBall->vx = -grassBall->vx * 0.5f;
-                        grassBall->x = rightyPosition - 0.1f;
-                        simulationPaused = false;
-                        ballHitRighty = false;
-                    }
-                }
-                
-                // Check if ball stopped moving
-                if (!grassBall->isActive) {
-                    waitingToRelaunch = true;
-                    relaunchTimer = 0.0f;
-                }
+        });
+        
+        if (allCourts) {
+            bool anyActive = false;
+            for (const CourtInstance& court : courtInstances) {
+                if (court.dropBall->isActive) anyActive = true;
             }
-        } else if (currentScreen == MODE_HARD) {
-            // Check if ball reached right end of court or stopped moving
-            if (hardBall->isActive && hardBall->x >= COURT_LENGTH) {
-                hardBall->isActive = false;
-                waitingToRelaunch = true;
-                relaunchTimer = 0.0f;
+            if (!anyActive) {
+                simulationComplete = true;
             }
-            
-            // Handle relaunch timer
-            if (waitingToRelaunch) {
-                relaunchTimer += adjustedDT;
-                if (relaunchTimer >= RELAUNCH_DELAY) {
+        }
+    }
+    
+    // One physics step of a court's horizontal shot. The court on screen draws the
+    // next launch pattern; the other courts relaunch with the current settings and
+    // only face RIGHTY when the return policy answers without asking the user.
+    void StepShot(CourtInstance& court, float dt, bool onScreen) {
+        TennisBall* ball = court.shotBall.get();
+        bool facesRighty = onScreen || returnPolicy->Type() != RETURN_POLICY_DIALOG;
+        
+        // Check if ball reached right end of court or stopped moving
+        if (ball->isActive && ball->x >= COURT_LENGTH) {
+            ball->isActive = false;
+            court.waitingToRelaunch = true;
+            court.relaunchTimer = 0.0f;
+        }
+        
+        // Handle relaunch timer
+        if (court.waitingToRelaunch) {
+            court.relaunchTimer += dt;
+            if (court.relaunchTimer >= RELAUNCH_DELAY) {
+                if (onScreen) {
                     ApplyLaunchPattern();
-                    
-                    hardBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    waitingToRelaunch = false;
-                    relaunchTimer = 0.0f;
-                }
-            } else {
-                hardBall->update(adjustedDT);
-                
-                // Check for RIGHTY collision
-                if (CheckRightyCollision(hardBall)) {
-                    simulationPaused = true;
-                    ballHitRighty = true;
-                    
-                    // Show dialog for hit parameters
-                    RightyHitParams params;
-                    params.force = rightyHitForce;
-                    params.angle = rightyHitAngle;
-                    params.spin = rightyHitSpin;
-                    params.confirmed = false;
-                    
-                    if (ShowRightyHitDialog(hwnd, &params) && params.confirmed) {
-                        rightyHitForce = params.force;
-                        rightyHitAngle = params.angle;
-                        rightyHitSpin = params.spin;
-                        ApplyRightyHit(hardBall, params.force, params.angle, params.spin);
-                    } else {
-                        // User cancelled, just bounce back
-                        hardBall->vx = -hardBall->vx * 0.5f;
-                        hardBall->x = rightyPosition - 0.1f;
-                        simulationPaused = false;
-                        ballHitRighty = false;
-                    }
                 }
                 
-                // Check if ball stopped moving
-                if (!hardBall->isActive) {
-                    waitingToRelaunch = true;
-                    relaunchTimer = 0.0f;
-                }
+                LaunchShot(court);
             }
-        } else if (currentScreen == MODE_LAVER) {
-            // Check if ball reached right end of court or stopped moving
-            if (laverBall->isActive && laverBall->x >= COURT_LENGTH) {
-                laverBall->isActive = false;
-                waitingToRelaunch = true;
-                relaunchTimer = 0.0f;
+            return;
+        }
+        
+        AdvanceBall(ball, dt, facesRighty);
+        uint8_t sampleFlags = 0;
+        
+        // Check for RIGHTY collision
+        if (facesRighty && CheckRightyCollision(ball)) {
+            // The dialog policy holds this thread until the user answers; hold the physics clock with it
+            simulationPaused = true;
+            ReturnHit hit;
+            bool returned = returnPolicy->ChooseReturn(*ball, currentLaunchPattern, rightyPosition, airResistanceMode, hit);
+            simulationPaused = false;
+            if (returnPolicy->Type() == RETURN_POLICY_DIALOG) {
+                QueryPerformanceCounter(&lastFrameCounter);
+                physicsAccumulator = 0.0f;
             }
             
-            // Handle relaunch timer
-            if (waitingToRelaunch) {
-                relaunchTimer += adjustedDT;
-                if (relaunchTimer >= RELAUNCH_DELAY) {
-                    ApplyLaunchPattern();
-                    
-                    laverBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    waitingToRelaunch = false;
-                    relaunchTimer = 0.0f;
-                }
+            if (returned) {
+                ApplyReturnHit(*ball, hit, rightyPosition);
             } else {
-                laverBall->update(adjustedDT);
-                
-                // Check for RIGHTY collision
-                if (CheckRightyCollision(laverBall)) {
-                    simulationPaused = true;
-                    ballHitRighty = true;
-                    
-                    // Show dialog for hit parameters
-                    RightyHitParams params;
-                    params.force = rightyHitForce;
-                    params.angle = rightyHitAngle;
-                    params.spin = rightyHitSpin;
-                    params.confirmed = false;
-                    
-                    if (ShowRightyHitDialog(hwnd, &params) && params.confirmed) {
-                        rightyHitForce = params.force;
-                        rightyHitAngle = params.angle;
-                        rightyHitSpin = params.spin;
-                        ApplyRightyHit(laverBall, params.force, params.angle, params.spin);
-                    } else {
-                        // User cancelled, just bounce back
-                        laverBall->vx = -laverBall->vx * 0.5f;
-                        laverBall->x = rightyPosition - 0.1f;
-                        simulationPaused = false;
-                        ballHitRighty = false;
-                    }
-                }
-                
-                // Check if ball stopped moving
-                if (!laverBall->isActive) {
-                    waitingToRelaunch = true;
-                    relaunchTimer = 0.0f;
-                }
+                BounceOffRighty(*ball, rightyPosition);
             }
+            sampleFlags = SAMPLE_RIGHTY_HIT;
+        }
+        
+        if (recording && !court.recorder.Samples().empty()) {
+            court.recorder.Record(*ball, sampleFlags);
+        }
+        
+        // Check if ball stopped moving
+        if (!ball->isActive) {
+            court.waitingToRelaunch = true;
+            court.relaunchTimer = 0.0f;
         }
     }
     
+    // UI thread: draws the newest snapshot published by the simulation thread
     void Render() {
-        if (!pRenderTarget) return;
+        PROFILE_SCOPE(ZONE_FRAME);
+        
+        // Recreates the target and brushes on the first frame after a device loss
+        if (FAILED(deviceResources.EnsureCreated())) return;
+        pRenderTarget = deviceResources.Target();
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
+        frame = &snapshots.Read();
+        
+        // The ensemble restarts on reloaded tables and the landing table is rebuilt for
+        // new air coefficients
+        if (frame->settingsGeneration != seenSettingsGeneration) {
+            seenSettingsGeneration = frame->settingsGeneration;
+            StopEnsemble();
+            RebuildStaleLandingTable();
+        }
         
         pRenderTarget->BeginDraw();
         pRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
         
-        if (currentScreen == MODE_ALL) {
+        CourtInstance* viewed = ViewedCourt(frame->currentScreen);
+        if (viewed) {
+            RenderCourt(*viewed);
+        } else {
             RenderAllCourts();
-        } else if (currentScreen == MODE_CLAY) {
-            RenderClayCourt();
-        } else if (currentScreen == MODE_GRASS) {
-            RenderGrassCourt();
-        } else if (currentScreen == MODE_HARD) {
-            RenderHardCourt();
-        } else if (currentScreen == MODE_LAVER) {
-            RenderLaverCourt();
         }
         
-        pRenderTarget->EndDraw();
+        DrawSweepStatus();
+        DrawArchiveStatus();
+        DrawProfilerOverlay();
+        
+        {
+            PROFILE_SCOPE(ZONE_PRESENT);
+            deviceResources.EndDraw();
+        }
+        pRenderTarget = deviceResources.Target();
     }
     
     void RenderAllCourts() {
-        // Draw each court section
-        for (int i = 0; i < 4; i++) {
-            float xOffset = i * SECTION_WIDTH;
-            DrawCourtSection(i, xOffset);
+        PROFILE_SCOPE(ZONE_RENDER_ALL_COURTS);
+        
+        // Draw each court section, side by side across the window
+        float sectionWidth = (float)WINDOW_WIDTH / courtInstances.size();
+        for (size_t i = 0; i < courtInstances.size(); i++) {
+            DrawCourtSection(courtInstances[i], i * sectionWidth, sectionWidth);
         }
         
         // Draw combined graph at the bottom
         DrawCombinedGraph();
         
         // Draw instructions
-        if (!simulationStarted) {
-            pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        if (!frame->simulationStarted) {
+            pBrush = deviceResources.Brush(BRUSH_WHITE);
             D2D1_RECT_F textRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 10);
             pRenderTarget->DrawTextW(
                 L"SPACE: Start | R: Reset | C: Clay | G: Grass | H: Hard | L: Laver",
@@ -849,455 +1438,36 @@ public:
         }
     }
     
-    void RenderClayCourt() {
-        const float courtMargin = 50.0f;
-        const float zoomFactor = 0.25f; // 4x wider court with 2x zoom out = 0.25 total
-        const float courtPixelWidth = (WINDOW_WIDTH - 2 * courtMargin) * 4.0f * zoomFactor; // 4x width with zoom
-        const float courtPixelHeight = 300.0f * zoomFactor;
-        const float courtTop = 240.0f;
-        const float courtBottom = courtTop + courtPixelHeight;
-        
-        // Draw clay court
-        pBrush->SetColor(courts[0].color); // Clay color
-        D2D1_RECT_F courtRect = D2D1::RectF(
-            courtMargin,
-            courtTop,
-            courtMargin + courtPixelWidth,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(courtRect, pBrush);
-        
-        // Draw court outline
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        pRenderTarget->DrawRectangle(courtRect, pBrush, 2.0f);
-        
-        // Draw net in the middle
-        float netX = courtMargin + courtPixelWidth / 2.0f;
-        float netPixelHeight = NET_HEIGHT * 50.0f * zoomFactor; // Scale with zoom
-        
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F netRect = D2D1::RectF(
-            netX - 2.0f,
-            courtBottom - netPixelHeight,
-            netX + 2.0f,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(netRect, pBrush);
-        
-        // Draw net top line
-        pRenderTarget->DrawLine(
-            D2D1::Point2F(netX - 10.0f, courtBottom - netPixelHeight),
-            D2D1::Point2F(netX + 10.0f, courtBottom - netPixelHeight),
-            pBrush, 2.0f
-        );
-        
-        // Draw ball trajectory trace (subtle light gray)
-        if (simulationStarted && clayBall && clayBall->trajectory.size() > 1) {
-            pBrush->SetColor(D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f)); // Light gray with transparency
-            for (size_t i = 1; i < clayBall->trajectory.size(); i++) {
-                float x1 = courtMargin + (clayBall->trajectory[i-1].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y1 = courtBottom - (clayBall->trajectory[i-1].height * 50.0f * zoomFactor);
-                float x2 = courtMargin + (clayBall->trajectory[i].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y2 = courtBottom - (clayBall->trajectory[i].height * 50.0f * zoomFactor);
-                
-                pRenderTarget->DrawLine(
-                    D2D1::Point2F(x1, y1),
-                    D2D1::Point2F(x2, y2),
-                    pBrush, 1.0f
-                );
-            }
-        }
-        
-        // Draw ball if simulation started
-        if (simulationStarted && clayBall) {
-            float ballPixelX = courtMargin + (clayBall->x / COURT_LENGTH) * courtPixelWidth;
-            float ballPixelY = courtBottom - (clayBall->y * 50.0f * zoomFactor); // Scale with zoom
-            
-            pBrush->SetColor(courts[0].ballColor); // Yellow ball
-            D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
-                D2D1::Point2F(ballPixelX, ballPixelY),
-                10.0f * zoomFactor, 10.0f * zoomFactor // Scale ball size with zoom
-            );
-            pRenderTarget->FillEllipse(ballEllipse, pBrush);
-            
-            // Draw BALL label
-            DrawBallLabel(ballPixelX, ballPixelY, zoomFactor);
-        }
-        
-        // Draw court labels (NET, LEFTY, RIGHTY)
-        DrawCourtLabels(courtMargin, courtPixelWidth, courtTop, courtBottom, zoomFactor);
-        
-        // Draw title
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F titleRect = D2D1::RectF(10, 10, WINDOW_WIDTH - 10, 40);
-        pRenderTarget->DrawTextW(
-            L"Clay Court - Horizontal Shot",
-            30,
-            pTextFormat,
-            titleRect,
-            pBrush
-        );
-        
-        // Draw telemetry
-        if (simulationStarted && clayBall) {
-            wchar_t telemetry[512];
-            swprintf_s(telemetry, 
-                L"Time: %.2fs | X: %.2fm | Y: %.2fm | Vx: %.2fm/s | Vy: %.2fm/s\nForce: %.0fN | Angle: %.0f° | Spin: %.0f RPM | Pace: %.0f%% | Bounces: %d",
-                clayBall->time, clayBall->x, clayBall->y, clayBall->vx, clayBall->vy,
-                horizontalForce, launchAngle, clayBall->spinRPM, visualPaceMultiplier * 100.0f, clayBall->bounceCount);
-            
-            D2D1_RECT_F telemetryRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 90);
-            pRenderTarget->DrawTextW(
-                telemetry,
-                wcslen(telemetry),
-                pSmallTextFormat,
-                telemetryRect,
-                pBrush
-            );
-        }
-        
-        // Draw instructions
-        if (!simulationStarted) {
-            wchar_t instructions[256];
-            swprintf_s(instructions, 
-                L"SPACE: Start | R: Reset | UP/DOWN: Force (%.0fN) | SCROLL: Angle (%.0f°) | +/-: Pace (%.0f%%) | A: Back",
-                horizontalForce, launchAngle, visualPaceMultiplier * 100.0f);
-            
-            D2D1_RECT_F instructRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 10);
-            pRenderTarget->DrawTextW(
-                instructions,
-                wcslen(instructions),
-                pSmallTextFormat,
-                instructRect,
-                pBrush
-            );
-        }
-        
-        // Draw air resistance combo box
-        DrawComboBox();
-    }
-    
-    void RenderGrassCourt() {
-        const float courtMargin = 50.0f;
-        const float zoomFactor = 0.25f; // 4x wider court with 2x zoom out = 0.25 total
-        const float courtPixelWidth = (WINDOW_WIDTH - 2 * courtMargin) * 4.0f * zoomFactor; // 4x width with zoom
-        const float courtPixelHeight = 300.0f * zoomFactor;
-        const float courtTop = 240.0f;
-        const float courtBottom = courtTop + courtPixelHeight;
+    // Single-court view: the court's horizontal shot against RIGHTY
+    void RenderCourt(CourtInstance& court) {
+        PROFILE_SCOPE(ZONE_RENDER_COURT);
+        const float courtMargin = COURT_VIEW_MARGIN;
+        const float zoomFactor = COURT_VIEW_ZOOM;
+        const float courtPixelWidth = COURT_VIEW_PIXEL_WIDTH;
+        const float courtTop = COURT_VIEW_TOP;
+        const float courtBottom = COURT_VIEW_BOTTOM;
+        const BallSnapshot* ball = &frame->courts[court.index].shotBall;
+        
+        // Draw court with outline and net
+        DrawCourtFloor(CourtBrush(court));
         
-        // Draw grass court
-        pBrush->SetColor(courts[1].color); // Grass color
-        D2D1_RECT_F courtRect = D2D1::RectF(
-            courtMargin,
-            courtTop,
-            courtMargin + courtPixelWidth,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(courtRect, pBrush);
-        
-        // Draw court outline
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        pRenderTarget->DrawRectangle(courtRect, pBrush, 2.0f);
-        
-        // Draw net in the middle
-        float netX = courtMargin + courtPixelWidth / 2.0f;
-        float netPixelHeight = NET_HEIGHT * 50.0f * zoomFactor; // Scale with zoom
-        
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F netRect = D2D1::RectF(
-            netX - 2.0f,
-            courtBottom - netPixelHeight,
-            netX + 2.0f,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(netRect, pBrush);
-        
-        // Draw net top line
-        pRenderTarget->DrawLine(
-            D2D1::Point2F(netX - 10.0f, courtBottom - netPixelHeight),
-            D2D1::Point2F(netX + 10.0f, courtBottom - netPixelHeight),
-            pBrush, 2.0f
-        );
-        
-        // Draw ball trajectory trace (subtle light gray)
-        if (simulationStarted && grassBall && grassBall->trajectory.size() > 1) {
-            pBrush->SetColor(D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f)); // Light gray with transparency
-            for (size_t i = 1; i < grassBall->trajectory.size(); i++) {
-                float x1 = courtMargin + (grassBall->trajectory[i-1].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y1 = courtBottom - (grassBall->trajectory[i-1].height * 50.0f * zoomFactor);
-                float x2 = courtMargin + (grassBall->trajectory[i].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y2 = courtBottom - (grassBall->trajectory[i].height * 50.0f * zoomFactor);
-                
-                pRenderTarget->DrawLine(
-                    D2D1::Point2F(x1, y1),
-                    D2D1::Point2F(x2, y2),
-                    pBrush, 1.0f
-                );
-            }
-        }
-        
-        // Draw ball if simulation started
-        if (simulationStarted && grassBall) {
-            float ballPixelX = courtMargin + (grassBall->x / COURT_LENGTH) * courtPixelWidth;
-            float ballPixelY = courtBottom - (grassBall->y * 50.0f * zoomFactor); // Scale with zoom
-            
-            pBrush->SetColor(courts[1].ballColor); // Bright green ball
-            D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
-                D2D1::Point2F(ballPixelX, ballPixelY),
-                10.0f * zoomFactor, 10.0f * zoomFactor // Scale ball size with zoom
-            );
-            pRenderTarget->FillEllipse(ballEllipse, pBrush);
-            
-            // Draw BALL label
-            DrawBallLabel(ballPixelX, ballPixelY, zoomFactor);
-        }
-        
-        // Draw court labels (NET, LEFTY, RIGHTY)
-        DrawCourtLabels(courtMargin, courtPixelWidth, courtTop, courtBottom, zoomFactor);
-        
-        // Draw title
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F titleRect = D2D1::RectF(10, 10, WINDOW_WIDTH - 10, 40);
-        pRenderTarget->DrawTextW(
-            L"Grass Court - Horizontal Shot",
-            31,
-            pTextFormat,
-            titleRect,
-            pBrush
-        );
-        
-        // Draw telemetry
-        if (simulationStarted && grassBall) {
-            wchar_t telemetry[512];
-            swprintf_s(telemetry, 
-                L"Time: %.2fs | X: %.2fm | Y: %.2fm | Vx: %.2fm/s | Vy: %.2fm/s\nForce: %.0fN | Angle: %.0f° | Spin: %.0f RPM | Pace: %.0f%% | Bounces: %d",
-                grassBall->time, grassBall->x, grassBall->y, grassBall->vx, grassBall->vy,
-                horizontalForce, launchAngle, grassBall->spinRPM, visualPaceMultiplier * 100.0f, grassBall->bounceCount);
-            
-            D2D1_RECT_F telemetryRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 90);
-            pRenderTarget->DrawTextW(
-                telemetry,
-                wcslen(telemetry),
-                pSmallTextFormat,
-                telemetryRect,
-                pBrush
-            );
-        }
-        
-        // Draw instructions
-        if (!simulationStarted) {
-            wchar_t instructions[300];
-            swprintf_s(instructions, 
-                L"SPACE: Start | R: Reset | W/S: Angle (%.0f°) | A/D: Force (%.0fN)\n>/<: Spin (%.0f RPM) | +/-: Pace (%.0f%%)",
-                launchAngle, horizontalForce, ballSpin, visualPaceMultiplier * 100.0f);
-            
-            D2D1_RECT_F instructRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 10);
-            pRenderTarget->DrawTextW(
-                instructions,
-                wcslen(instructions),
-                pSmallTextFormat,
-                instructRect,
-                pBrush
-            );
-        }
-        
-        // Draw air resistance combo box
-        DrawComboBox();
-    }
-    
-    void RenderHardCourt() {
-        const float courtMargin = 50.0f;
-        const float zoomFactor = 0.25f; // 4x wider court with 2x zoom out = 0.25 total
-        const float courtPixelWidth = (WINDOW_WIDTH - 2 * courtMargin) * 4.0f * zoomFactor; // 4x width with zoom
-        const float courtPixelHeight = 300.0f * zoomFactor;
-        const float courtTop = 240.0f;
-        const float courtBottom = courtTop + courtPixelHeight;
-        
-        // Draw hard court
-        pBrush->SetColor(courts[2].color); // Hard court color (blue)
-        D2D1_RECT_F courtRect = D2D1::RectF(
-            courtMargin,
-            courtTop,
-            courtMargin + courtPixelWidth,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(courtRect, pBrush);
-        
-        // Draw court outline
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        pRenderTarget->DrawRectangle(courtRect, pBrush, 2.0f);
-        
-        // Draw net in the middle
-        float netX = courtMargin + courtPixelWidth / 2.0f;
-        float netPixelHeight = NET_HEIGHT * 50.0f * zoomFactor; // Scale with zoom
-        
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F netRect = D2D1::RectF(
-            netX - 2.0f,
-            courtBottom - netPixelHeight,
-            netX + 2.0f,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(netRect, pBrush);
-        
-        // Draw net top line
-        pRenderTarget->DrawLine(
-            D2D1::Point2F(netX - 10.0f, courtBottom - netPixelHeight),
-            D2D1::Point2F(netX + 10.0f, courtBottom - netPixelHeight),
-            pBrush, 2.0f
-        );
-        
-        // Draw ball trajectory trace (subtle light gray)
-        if (simulationStarted && hardBall && hardBall->trajectory.size() > 1) {
-            pBrush->SetColor(D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f)); // Light gray with transparency
-            for (size_t i = 1; i < hardBall->trajectory.size(); i++) {
-                float x1 = courtMargin + (hardBall->trajectory[i-1].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y1 = courtBottom - (hardBall->trajectory[i-1].height * 50.0f * zoomFactor);
-                float x2 = courtMargin + (hardBall->trajectory[i].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y2 = courtBottom - (hardBall->trajectory[i].height * 50.0f * zoomFactor);
-                
-                pRenderTarget->DrawLine(
-                    D2D1::Point2F(x1, y1),
-                    D2D1::Point2F(x2, y2),
-                    pBrush, 1.0f
-                );
-            }
-        }
-        
-        // Draw ball if simulation started
-        if (simulationStarted && hardBall) {
-            float ballPixelX = courtMargin + (hardBall->x / COURT_LENGTH) * courtPixelWidth;
-            float ballPixelY = courtBottom - (hardBall->y * 50.0f * zoomFactor); // Scale with zoom
-            
-            pBrush->SetColor(courts[2].ballColor); // Yellow ball
-            D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
-                D2D1::Point2F(ballPixelX, ballPixelY),
-                10.0f * zoomFactor, 10.0f * zoomFactor // Scale ball size with zoom
-            );
-            pRenderTarget->FillEllipse(ballEllipse, pBrush);
-            
-            // Draw BALL label
-            DrawBallLabel(ballPixelX, ballPixelY, zoomFactor);
-        }
-        
-        // Draw court labels (NET, LEFTY, RIGHTY)
-        DrawCourtLabels(courtMargin, courtPixelWidth, courtTop, courtBottom, zoomFactor);
-        
-        // Draw title
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F titleRect = D2D1::RectF(10, 10, WINDOW_WIDTH - 10, 40);
-        pRenderTarget->DrawTextW(
-            L"Hard Court - Horizontal Shot",
-            30,
-            pTextFormat,
-            titleRect,
-            pBrush
-        );
-        
-        // Draw telemetry
-        if (simulationStarted && hardBall) {
-            wchar_t telemetry[512];
-            swprintf_s(telemetry, 
-                L"Time: %.2fs | X: %.2fm | Y: %.2fm | Vx: %.2fm/s | Vy: %.2fm/s\nForce: %.0fN | Angle: %.0f\u00b0 | Spin: %.0f RPM | Pace: %.0f%% | Bounces: %d",
-                hardBall->time, hardBall->x, hardBall->y, hardBall->vx, hardBall->vy,
-                horizontalForce, launchAngle, hardBall->spinRPM, visualPaceMultiplier * 100.0f, hardBall->bounceCount);
-            
-            D2D1_RECT_F telemetryRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 90);
-            pRenderTarget->DrawTextW(
-                telemetry,
-                wcslen(telemetry),
-                pSmallTextFormat,
-                telemetryRect,
-                pBrush
-            );
-        }
-        
-        // Draw instructions
-        if (!simulationStarted) {
-            wchar_t instructions[300];
-            swprintf_s(instructions, 
-                L"SPACE: Start | R: Reset | W/S: Angle (%.0f\u00b0) | A/D: Force (%.0fN)\n>/<: Spin (%.0f RPM) | +/-: Pace (%.0f%%)",
-                launchAngle, horizontalForce, ballSpin, visualPaceMultiplier * 100.0f);
-            
-            D2D1_RECT_F instructRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 10);
-            pRenderTarget->DrawTextW(
-                instructions,
-                wcslen(instructions),
-                pSmallTextFormat,
-                instructRect,
-                pBrush
-            );
-        }
-        
-        // Draw air resistance combo box
-        DrawComboBox();
-    }
-    
-    void RenderLaverCourt() {
-        const float courtMargin = 50.0f;
-        const float zoomFactor = 0.25f; // 4x wider court with 2x zoom out = 0.25 total
-        const float courtPixelWidth = (WINDOW_WIDTH - 2 * courtMargin) * 4.0f * zoomFactor; // 4x width with zoom
-        const float courtPixelHeight = 300.0f * zoomFactor;
-        const float courtTop = 240.0f;
-        const float courtBottom = courtTop + courtPixelHeight;
-        
-        // Draw Laver Cup court
-        pBrush->SetColor(courts[3].color); // Black court color
-        D2D1_RECT_F courtRect = D2D1::RectF(
-            courtMargin,
-            courtTop,
-            courtMargin + courtPixelWidth,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(courtRect, pBrush);
-        
-        // Draw court outline
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        pRenderTarget->DrawRectangle(courtRect, pBrush, 2.0f);
-        
-        // Draw net in the middle
-        float netX = courtMargin + courtPixelWidth / 2.0f;
-        float netPixelHeight = NET_HEIGHT * 50.0f * zoomFactor; // Scale with zoom
-        
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        D2D1_RECT_F netRect = D2D1::RectF(
-            netX - 2.0f,
-            courtBottom - netPixelHeight,
-            netX + 2.0f,
-            courtBottom
-        );
-        pRenderTarget->FillRectangle(netRect, pBrush);
-        
-        // Draw net top line
-        pRenderTarget->DrawLine(
-            D2D1::Point2F(netX - 10.0f, courtBottom - netPixelHeight),
-            D2D1::Point2F(netX + 10.0f, courtBottom - netPixelHeight),
-            pBrush, 2.0f
-        );
-        
-        // Draw ball trajectory trace (subtle light gray)
-        if (simulationStarted && laverBall && laverBall->trajectory.size() > 1) {
-            pBrush->SetColor(D2D1::ColorF(0.8f, 0.8f, 0.8f, 0.4f)); // Light gray with transparency
-            for (size_t i = 1; i < laverBall->trajectory.size(); i++) {
-                float x1 = courtMargin + (laverBall->trajectory[i-1].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y1 = courtBottom - (laverBall->trajectory[i-1].height * 50.0f * zoomFactor);
-                float x2 = courtMargin + (laverBall->trajectory[i].xPosition / COURT_LENGTH) * courtPixelWidth;
-                float y2 = courtBottom - (laverBall->trajectory[i].height * 50.0f * zoomFactor);
-                
-                pRenderTarget->DrawLine(
-                    D2D1::Point2F(x1, y1),
-                    D2D1::Point2F(x2, y2),
-                    pBrush, 1.0f
-                );
+        // Draw ball trajectory trace (subtle light gray)
+        if (frame->simulationStarted && !frame->rallyMode && ball->trajectory.size() > 1) {
+            pBrush = deviceResources.Brush(BRUSH_TRACE); // Light gray with transparency
+            D2D1_MATRIX_3X2_F toPixels = CourtTraceTransform(courtMargin, courtPixelWidth, courtBottom, zoomFactor);
+            if (FAILED(court.courtTrace->Draw(pFactory, pRenderTarget, pBrush, ball->trajectory, toPixels, 1.0f))) {
+                DrawTrajectoryTrace(pRenderTarget, pBrush, ball->trajectory, courtMargin, courtPixelWidth, courtBottom, zoomFactor);
             }
         }
         
-        // Draw ball if simulation started
-        if (simulationStarted && laverBall) {
-            float ballPixelX = courtMargin + (laverBall->x / COURT_LENGTH) * courtPixelWidth;
-            float ballPixelY = courtBottom - (laverBall->y * 50.0f * zoomFactor); // Scale with zoom
+        // Draw the drill's balls, or the single ball, once the simulation has started
+        if (frame->simulationStarted && frame->rallyMode) {
+            DrawRallyBalls(court, courtMargin, courtPixelWidth, courtBottom, zoomFactor);
+        } else if (frame->simulationStarted) {
+            float ballPixelX = courtMargin + (ball->interpolatedX(frame->renderAlpha) / COURT_LENGTH) * courtPixelWidth;
+            float ballPixelY = courtBottom - (ball->interpolatedY(frame->renderAlpha) * 50.0f * zoomFactor); // Scale with zoom
             
-            pBrush->SetColor(courts[3].ballColor); // Yellow ball
+            pBrush = BallBrush(court);
             D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
                 D2D1::Point2F(ballPixelX, ballPixelY),
                 10.0f * zoomFactor, 10.0f * zoomFactor // Scale ball size with zoom
@@ -1311,24 +1481,45 @@ public:
         // Draw court labels (NET, LEFTY, RIGHTY)
         DrawCourtLabels(courtMargin, courtPixelWidth, courtTop, courtBottom, zoomFactor);
         
+        // Draw where the aimed shot will land
+        if (!frame->simulationStarted && LANDING_PREDICTION) {
+            DrawLandingPrediction(courtMargin, courtPixelWidth, courtBottom, zoomFactor);
+        }
+        
+        // Draw the landing density of the aimed shot's ensemble
+        if (ensembleMode) {
+            DrawEnsemble(court, courtMargin, courtPixelWidth, courtBottom);
+        }
+        
         // Draw title
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
         D2D1_RECT_F titleRect = D2D1::RectF(10, 10, WINDOW_WIDTH - 10, 40);
         pRenderTarget->DrawTextW(
-            L"Laver Cup - Horizontal Shot",
-            30,
+            court.definition->title,
+            wcslen(court.definition->title),
             pTextFormat,
             titleRect,
             pBrush
         );
         
         // Draw telemetry
-        if (simulationStarted && laverBall) {
+        if (frame->simulationStarted && frame->rallyMode) {
+            const CourtSnapshot& courtSnapshot = frame->courts[court.index];
+            wchar_t telemetry[256];
+            swprintf_s(telemetry,
+                L"Ball machine: %zu in flight | %llu launched | %llu returned by RIGHTY\nForce: %.0fN | Angle: %.0f° | Spin: %.0f RPM | Pace: %.0f%% | M: Single shot",
+                courtSnapshot.rallyX.size(), (unsigned long long)courtSnapshot.rallyLaunched,
+                (unsigned long long)courtSnapshot.rallyReturned, frame->horizontalForce, frame->launchAngle,
+                frame->ballSpin, frame->visualPaceMultiplier * 100.0f);
+            
+            D2D1_RECT_F telemetryRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 90);
+            pRenderTarget->DrawTextW(telemetry, (UINT32)wcslen(telemetry), pSmallTextFormat, telemetryRect, pBrush);
+        } else if (frame->simulationStarted) {
             wchar_t telemetry[512];
             swprintf_s(telemetry, 
                 L"Time: %.2fs | X: %.2fm | Y: %.2fm | Vx: %.2fm/s | Vy: %.2fm/s\nForce: %.0fN | Angle: %.0f° | Spin: %.0f RPM | Pace: %.0f%% | Bounces: %d",
-                laverBall->time, laverBall->x, laverBall->y, laverBall->vx, laverBall->vy,
-                horizontalForce, launchAngle, laverBall->spinRPM, visualPaceMultiplier * 100.0f, laverBall->bounceCount);
+                ball->time, ball->x, ball->y, ball->vx, ball->vy,
+                frame->horizontalForce, frame->launchAngle, ball->spinRPM, frame->visualPaceMultiplier * 100.0f, ball->bounceCount);
             
             D2D1_RECT_F telemetryRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 90);
             pRenderTarget->DrawTextW(
@@ -1341,11 +1532,12 @@ public:
         }
         
         // Draw instructions
-        if (!simulationStarted) {
+        if (!frame->simulationStarted) {
             wchar_t instructions[300];
             swprintf_s(instructions, 
-                L"SPACE: Start | R: Reset | W/S: Angle (%.0f°) | A/D: Force (%.0fN)\n>/<: Spin (%.0f RPM) | +/-: Pace (%.0f%%)",
-                launchAngle, horizontalForce, ballSpin, visualPaceMultiplier * 100.0f);
+                L"SPACE: Start | R: Reset | W/S: Angle (%.0f°) | A/D: Force (%.0fN)\n>/<: Spin (%.0f RPM) | +/-: Pace (%.0f%%) | T: Return (%s) | E: Ensemble | M: %s",
+                frame->launchAngle, frame->horizontalForce, frame->ballSpin, frame->visualPaceMultiplier * 100.0f,
+                frame->returnPolicyName, frame->rallyMode ? L"Single shot" : L"Ball machine");
             
             D2D1_RECT_F instructRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 10);
             pRenderTarget->DrawTextW(
@@ -1370,7 +1562,7 @@ public:
         
         // Draw LEFTY icon (small rectangle representing launcher) - 20 pixels from left edge
         float netX = courtMargin + courtPixelWidth / 2.0f;
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::Green));
+        pBrush = deviceResources.Brush(BRUSH_LEFTY);
         D2D1_RECT_F leftyIcon = D2D1::RectF(
             courtMargin + 20.0f,
             courtBottom - 10.0f * zoomFactor,
@@ -1381,8 +1573,8 @@ public:
         
         // Draw RIGHTY icon (white stick 2.5x NET height)
         float rightyHeight = NET_HEIGHT * 2.5f * 50.0f * zoomFactor; // 2.5x NET height, scaled
-        float rightyPixelX = courtMargin + (rightyPosition / COURT_LENGTH) * courtPixelWidth;
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        float rightyPixelX = courtMargin + (frame->rightyPosition / COURT_LENGTH) * courtPixelWidth;
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
         D2D1_RECT_F rightyIcon = D2D1::RectF(
             rightyPixelX - 1.0f,
             courtBottom - rightyHeight,
@@ -1392,22 +1584,232 @@ public:
         pRenderTarget->FillRectangle(rightyIcon, pBrush);
     }
     
+    // First use maps the cached table; a missing or outdated cache is rebuilt on a
+    // background thread and saved for the next run
+    void RequestLandingTable() {
+        landingRequested = true;
+        std::wstring path = GetExeDirectory() + L"landing_table.bin";
+        {
+            std::shared_lock<std::shared_mutex> tables(engineTablesLock);
+            if (landingTable.Open(path.c_str(), LANDING_GRID)) {
+                landingReady = true;
+                return;
+            }
+        }
+        
+        StartLandingBuild(path);
+    }
+    
+    void StartLandingBuild(const std::wstring& path) {
+        landingThread = std::thread([this, path]() {
+            std::shared_lock<std::shared_mutex> tables(engineTablesLock);
+            ThreadPool pool(SWEEP_THREADS);
+            if (landingTable.Build(LANDING_GRID, pool, &landingCancel, &landingShotsDone)) {
+                landingTable.Save(path.c_str());
+                landingReady = true;
+            }
+        });
+    }
+    
+    // After a settings reload: a table built for other air coefficients is withdrawn
+    // from its readers, any build still running is cancelled, and a new one starts.
+    // Readers only touch landingTable under landingLock with landingReady set, so the
+    // rebuild never closes it under them.
+    void RebuildStaleLandingTable() {
+        if (!landingRequested) return;
+        {
+            std::shared_lock<std::shared_mutex> tables(engineTablesLock, std::try_to_lock);
+            // No reload applies while a build holds engineTablesLock, so a table still
+            // building already has the new coefficients
+            if (!tables.owns_lock() || !landingReady || landingTable.IsBuiltFor(LANDING_GRID)) return;
+        }
+        {
+            std::lock_guard<std::mutex> readers(landingLock);
+            landingReady = false;
+        }
+        landingCancel = true;
+        if (landingThread.joinable()) {
+            landingThread.join();
+        }
+        landingCancel = false;
+        landingShotsDone = 0;
+        StartLandingBuild(GetExeDirectory() + L"landing_table.bin");
+    }
+    
+    // Predicted first bounce of the aimed force, angle and spin, marked on the court
+    // floor, with the net clearance in the telemetry area
+    void DrawLandingPrediction(float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor) {
+        if (!landingRequested) {
+            RequestLandingTable();
+        }
+        
+        wchar_t predictionText[128];
+        std::unique_lock<std::mutex> readers(landingLock);
+        if (!landingReady) {
+            readers.unlock();
+            size_t total = LandingTable::SampleCount(LANDING_GRID);
+            swprintf_s(predictionText, L"Building landing table: %.0f%%", 100.0 * landingShotsDone / total);
+        } else {
+            LandingSample landing = landingTable.Lookup(frame->horizontalForce, frame->launchAngle, frame->ballSpin,
+                                                        frame->airResistanceMode);
+            readers.unlock();
+            if (landing.netClearance <= 0.0f) {
+                swprintf_s(predictionText, L"Predicted: does not clear the net (%.2fm below the tape)", -landing.netClearance);
+            } else if (landing.firstBounceX >= COURT_LENGTH) {
+                swprintf_s(predictionText, L"Predicted: long | Net clearance: %.2fm", landing.netClearance);
+            } else {
+                swprintf_s(predictionText, L"Predicted landing: %.2fm | Net clearance: %.2fm",
+                           landing.firstBounceX, landing.netClearance);
+            }
+            
+            // Marker on the floor where the first bounce lands
+            if (landing.firstBounceX >= 0.0f && landing.firstBounceX < COURT_LENGTH) {
+                float markerX = courtMargin + (landing.firstBounceX / COURT_LENGTH) * courtPixelWidth;
+                pBrush = deviceResources.Brush(BRUSH_BOUNCE_MARKER);
+                pRenderTarget->DrawLine(
+                    D2D1::Point2F(markerX - 6.0f * zoomFactor, courtBottom - 6.0f * zoomFactor),
+                    D2D1::Point2F(markerX + 6.0f * zoomFactor, courtBottom + 6.0f * zoomFactor),
+                    pBrush, 2.0f);
+                pRenderTarget->DrawLine(
+                    D2D1::Point2F(markerX - 6.0f * zoomFactor, courtBottom + 6.0f * zoomFactor),
+                    D2D1::Point2F(markerX + 6.0f * zoomFactor, courtBottom - 6.0f * zoomFactor),
+                    pBrush, 2.0f);
+            }
+        }
+        
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
+        D2D1_RECT_F predictionRect = D2D1::RectF(10, 40, WINDOW_WIDTH - 10, 60);
+        pRenderTarget->DrawTextW(predictionText, (UINT32)wcslen(predictionText), pSmallTextFormat, predictionRect, pBrush);
+    }
+    
+    // Restarts the ensemble around center; the previous one is cancelled first so
+    // the histogram is cleared with no writer left
+    void StartEnsemble(const ShotParams& center) {
+        StopEnsemble();
+        if (!ensemblePool) {
+            ensemblePool = std::make_unique<ThreadPool>(ENSEMBLE_THREADS);
+        }
+        
+        ensembleHistogram.Clear();
+        ensembleSpec.center = center;
+        ensembleSpec.forceSigma = ENSEMBLE_FORCE_SIGMA;
+        ensembleSpec.angleSigma = ENSEMBLE_ANGLE_SIGMA;
+        ensembleSpec.spinSigma = ENSEMBLE_SPIN_SIGMA;
+        ensembleSpec.shotCount = ENSEMBLE_SHOTS;
+        ensembleSpec.seed = RANDOM_SEED;
+        ensembleCancel = false;
+        
+        ensembleThread = std::thread([this]() {
+            std::shared_lock<std::shared_mutex> tables(engineTablesLock);
+            // Stepped like the shot on screen
+            SimulationEngine engine(PHYSICS_DT);
+            engine.SetIntegrationMode(::EVENT_DRIVEN ? INTEGRATION_EVENT_DRIVEN : INTEGRATION_FIXED_STEP);
+            engine.SetIntegrator(INTEGRATOR);
+            engine.SetRandomSeed(RANDOM_SEED);
+            RunEnsemble(ensembleSpec, engine, *ensemblePool, ensembleHistogram, &ensembleCancel);
+        });
+    }
+    
+    void StopEnsemble() {
+        ensembleCancel = true;
+        if (ensembleThread.joinable()) {
+            ensembleThread.join();
+        }
+    }
+    
+    // Landing-density heatmap along the floor: one bar per histogram bin, its height
+    // and color (yellow to red) scaled to the fullest bin, and the ensemble's statistics
+    void DrawEnsemble(const CourtInstance& court, float courtMargin, float courtPixelWidth, float courtBottom) {
+        ShotParams center = {frame->horizontalForce, frame->launchAngle, frame->ballSpin,
+                             (int)court.definition->surface->type, frame->airResistanceMode, 0};
+        const ShotParams& running = ensembleSpec.center;
+        if (!ensembleThread.joinable() || running.force != center.force || running.angle != center.angle ||
+            running.spin != center.spin || running.surfaceIndex != center.surfaceIndex || running.airMode != center.airMode) {
+            StartEnsemble(center);
+        }
+        
+        // Shots() is read first: every bin is at least as full as the batches it counts
+        uint64_t shots = ensembleHistogram.Shots();
+        uint32_t maxCount = 0;
+        uint64_t landed = 0;
+        double sum = 0.0, sumSquares = 0.0;
+        for (int bin = 0; bin < ensembleHistogram.BinCount(); bin++) {
+            uint32_t count = ensembleHistogram.Count(bin);
+            double x = (bin + 0.5) * ensembleHistogram.BinWidth();
+            maxCount = max(maxCount, count);
+            landed += count;
+            sum += x * count;
+            sumSquares += x * x * count;
+        }
+        
+        if (maxCount > 0) {
+            pBrush = deviceResources.Brush(BRUSH_HEATMAP);
+            float binPixels = ensembleHistogram.BinWidth() / COURT_LENGTH * courtPixelWidth;
+            for (int bin = 0; bin < ensembleHistogram.BinCount(); bin++) {
+                uint32_t count = ensembleHistogram.Count(bin);
+                if (count == 0) continue;
+                
+                float density = (float)count / maxCount;
+                pBrush->SetColor(D2D1::ColorF(1.0f, 1.0f - density, 0.0f, 0.35f + 0.55f * density));
+                float left = courtMargin + bin * binPixels;
+                D2D1_RECT_F bar = D2D1::RectF(left, courtBottom - HEATMAP_MAX_HEIGHT * density, left + binPixels, courtBottom);
+                pRenderTarget->FillRectangle(bar, pBrush);
+            }
+        }
+        
+        wchar_t ensembleText[160];
+        if (landed > 0) {
+            double mean = sum / landed;
+            double spread = sqrt(max(0.0, sumSquares / landed - mean * mean));
+            swprintf_s(ensembleText, L"Ensemble: %llu / %zu shots | Lands %.2fm ± %.2fm | Net %.1f%% | Long %.1f%%",
+                       (unsigned long long)shots, ensembleSpec.shotCount, mean, spread,
+                       100.0 * ensembleHistogram.NetHits() / max<uint64_t>(1, shots),
+                       100.0 * ensembleHistogram.LongShots() / max<uint64_t>(1, shots));
+        } else {
+            swprintf_s(ensembleText, L"Ensemble: %llu / %zu shots", (unsigned long long)shots, ensembleSpec.shotCount);
+        }
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
+        D2D1_RECT_F ensembleRect = D2D1::RectF(10, 90, WINDOW_WIDTH - 10, 110);
+        pRenderTarget->DrawTextW(ensembleText, (UINT32)wcslen(ensembleText), pSmallTextFormat, ensembleRect, pBrush);
+    }
+    
+    // Every ball of the court's drill in one mesh; ellipse by ellipse if the mesh cannot be made
+    void DrawRallyBalls(const CourtInstance& court, float courtMargin, float courtPixelWidth, float courtBottom, float zoomFactor) {
+        const CourtSnapshot& courtSnapshot = frame->courts[court.index];
+        rallySprites.Clear();
+        for (size_t i = 0; i < courtSnapshot.rallyX.size(); i++) {
+            rallySprites.Add(courtMargin + (courtSnapshot.rallyX[i] / COURT_LENGTH) * courtPixelWidth,
+                             courtBottom - courtSnapshot.rallyY[i] * 50.0f * zoomFactor);
+        }
+        
+        pBrush = BallBrush(court);
+        if (FAILED(rallySprites.Draw(pRenderTarget, pBrush, RALLY_BALL_PIXELS))) {
+            for (size_t i = 0; i < courtSnapshot.rallyX.size(); i++) {
+                D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
+                    D2D1::Point2F(courtMargin + (courtSnapshot.rallyX[i] / COURT_LENGTH) * courtPixelWidth,
+                                  courtBottom - courtSnapshot.rallyY[i] * 50.0f * zoomFactor),
+                    RALLY_BALL_PIXELS, RALLY_BALL_PIXELS);
+                pRenderTarget->FillEllipse(ballEllipse, pBrush);
+            }
+        }
+    }
+    
     void DrawBallLabel(float ballPixelX, float ballPixelY, float zoomFactor) {
         // BALL label is defined but not rendered on screen
     }
     
     void DrawComboBox() {
         // Draw air resistance combo box background
-        pBrush->SetColor(D2D1::ColorF(0.2f, 0.2f, 0.2f));
+        pBrush = deviceResources.Brush(BRUSH_COMBO_BOX);
         pRenderTarget->FillRectangle(comboBoxRect, pBrush);
         
         // Draw air resistance combo box border
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
         pRenderTarget->DrawRectangle(comboBoxRect, pBrush, 2.0f);
         
         // Draw current air resistance selection
         wchar_t labelText[128];
-        swprintf_s(labelText, L"Air: %s", airModes[airResistanceMode].name);
+        swprintf_s(labelText, L"Air: %s", airModes[frame->airResistanceMode].name);
         
         D2D1_RECT_F textRect = D2D1::RectF(
             comboBoxRect.left + 5,
@@ -1436,16 +1838,16 @@ public:
         pRenderTarget->DrawLine(arrow2, arrow3, pBrush, 1.5f);
         
         // Draw launch pattern combo box background
-        pBrush->SetColor(D2D1::ColorF(0.2f, 0.2f, 0.2f));
+        pBrush = deviceResources.Brush(BRUSH_COMBO_BOX);
         pRenderTarget->FillRectangle(launchPatternComboBoxRect, pBrush);
         
         // Draw launch pattern combo box border
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
         pRenderTarget->DrawRectangle(launchPatternComboBoxRect, pBrush, 2.0f);
         
         // Draw current launch pattern selection
         wchar_t patternText[128];
-        swprintf_s(patternText, L"Pattern: %s", launchPatterns[currentLaunchPattern].name);
+        swprintf_s(patternText, L"Pattern: %s", launchPatterns[frame->currentLaunchPattern].name);
         
         D2D1_RECT_F patternTextRect = D2D1::RectF(
             launchPatternComboBoxRect.left + 5,
@@ -1474,42 +1876,45 @@ public:
         pRenderTarget->DrawLine(patternArrow2, patternArrow3, pBrush, 1.5f);
     }
     
-    void DrawCourtSection(int index, float xOffset) {
-        TennisBall* ball = balls[index];
-        CourtSurface* surface = ball->surface;
+    void DrawCourtSection(const CourtInstance& court, float xOffset, float sectionWidth) {
+        const BallSnapshot* ball = &frame->courts[court.index].dropBall;
+        CourtSurface* surface = court.definition->surface;
         
         // Draw court floor
-        pBrush->SetColor(surface->color);
+        pBrush = CourtBrush(court);
         D2D1_RECT_F courtRect = D2D1::RectF(
             xOffset, 
             WINDOW_HEIGHT - 280, 
-            xOffset + SECTION_WIDTH, 
+            xOffset + sectionWidth, 
             WINDOW_HEIGHT - 180
         );
         pRenderTarget->FillRectangle(courtRect, pBrush);
+        bool labeled = sectionWidth >= MIN_LABEL_WIDTH; // Many courts leave no room for text
         
         // Draw court name
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
         D2D1_RECT_F nameRect = D2D1::RectF(
             xOffset + 5, 
             WINDOW_HEIGHT - 275, 
-            xOffset + SECTION_WIDTH - 5, 
+            xOffset + sectionWidth - 5, 
             WINDOW_HEIGHT - 240
         );
-        pRenderTarget->DrawTextW(
-            surface->name,
-            wcslen(surface->name),
-            pSmallTextFormat,
-            nameRect,
-            pBrush
-        );
+        if (labeled) {
+            pRenderTarget->DrawTextW(
+                surface->name,
+                wcslen(surface->name),
+                pSmallTextFormat,
+                nameRect,
+                pBrush
+            );
+        }
         
         // Draw ball
-        if (simulationStarted) {
-            float ballX = xOffset + SECTION_WIDTH / 2;
-            float ballY = WINDOW_HEIGHT - 180 - (ball->y * 50.0f); // Scale: 50 pixels per meter
+        if (frame->simulationStarted) {
+            float ballX = xOffset + sectionWidth / 2;
+            float ballY = WINDOW_HEIGHT - 180 - (ball->interpolatedY(frame->renderAlpha) * 50.0f); // Scale: 50 pixels per meter
             
-            pBrush->SetColor(surface->ballColor);
+            pBrush = BallBrush(court);
             D2D1_ELLIPSE ballEllipse = D2D1::Ellipse(
                 D2D1::Point2F(ballX, ballY),
                 8.0f, 8.0f
@@ -1517,37 +1922,39 @@ public:
             pRenderTarget->FillEllipse(ballEllipse, pBrush);
             
             // Draw height marker
-            pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::Gray));
+            pBrush = deviceResources.Brush(BRUSH_HEIGHT_MARKER);
             D2D1_POINT_2F p1 = D2D1::Point2F(xOffset + 5, ballY);
             D2D1_POINT_2F p2 = D2D1::Point2F(xOffset + 15, ballY);
             pRenderTarget->DrawLine(p1, p2, pBrush, 1.0f);
             
             // Draw telemetry
-            wchar_t telemetry[256];
-            swprintf_s(telemetry, L"Time: %.2fs\nHeight: %.2fm\nBounces: %d",
-                ball->time, ball->y, ball->bounceCount);
-            
-            pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-            D2D1_RECT_F telemetryRect = D2D1::RectF(
-                xOffset + 5,
-                WINDOW_HEIGHT - 230,
-                xOffset + SECTION_WIDTH - 5,
-                WINDOW_HEIGHT - 180
-            );
-            pRenderTarget->DrawTextW(
-                telemetry,
-                wcslen(telemetry),
-                pSmallTextFormat,
-                telemetryRect,
-                pBrush
-            );
+            if (labeled) {
+                wchar_t telemetry[256];
+                swprintf_s(telemetry, L"Time: %.2fs\nHeight: %.2fm\nBounces: %d",
+                    ball->time, ball->y, ball->bounceCount);
+                
+                pBrush = deviceResources.Brush(BRUSH_WHITE);
+                D2D1_RECT_F telemetryRect = D2D1::RectF(
+                    xOffset + 5,
+                    WINDOW_HEIGHT - 230,
+                    xOffset + sectionWidth - 5,
+                    WINDOW_HEIGHT - 180
+                );
+                pRenderTarget->DrawTextW(
+                    telemetry,
+                    wcslen(telemetry),
+                    pSmallTextFormat,
+                    telemetryRect,
+                    pBrush
+                );
+            }
             
             // Draw bounce markers
-            for (size_t b = 0; b < ball->bounces.size() && b < 3; b++) {
-                float bounceX = xOffset + SECTION_WIDTH / 2;
+            for (size_t b = 0; b < ball->bounceMarks && b < MAX_RECORDED_BOUNCES; b++) {
+                float bounceX = xOffset + sectionWidth / 2;
                 float bounceY = WINDOW_HEIGHT - 180;
                 
-                pBrush->SetColor(D2D1::ColorF(1.0f, 0.0f, 0.0f, 0.7f));
+                pBrush = deviceResources.Brush(BRUSH_BOUNCE_MARKER);
                 D2D1_ELLIPSE bounceMarker = D2D1::Ellipse(
                     D2D1::Point2F(bounceX, bounceY),
                     4.0f, 4.0f
@@ -1558,302 +1965,478 @@ public:
     }
     
     void DrawCombinedGraph() {
-        if (!simulationStarted || balls[0]->trajectory.size() < 2) return;
-        
-        const float graphX = 10;
-        const float graphY = 10;
-        const float graphWidth = WINDOW_WIDTH - 20;
-        const float graphHeight = 150;
+        PROFILE_SCOPE(ZONE_COMBINED_GRAPH);
+        if (!frame->simulationStarted || frame->courts[0].dropBall.trajectory.size() < 2) return;
         
-        // Draw graph background
-        pBrush->SetColor(D2D1::ColorF(0.1f, 0.1f, 0.1f, 0.8f));
-        D2D1_RECT_F graphRect = D2D1::RectF(graphX, graphY, graphX + graphWidth, graphY + graphHeight);
-        pRenderTarget->FillRectangle(graphRect, pBrush);
-        
-        // Draw graph border
-        pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-        pRenderTarget->DrawRectangle(graphRect, pBrush, 1.0f);
+        // The time axis doubles when the longest trace outgrows it; between those
+        // rescales the layer only takes the segments appended since the last frame
+        float maxTime = 0.0f;
+        for (size_t i = 0; i < courtInstances.size(); i++) {
+            const TrajectoryBuffer& trajectory = frame->courts[i].dropBall.trajectory;
+            graphTrajectories[i] = &trajectory;
+            if (!trajectory.empty()) {
+                maxTime = max(maxTime, trajectory.back().time);
+            }
+        }
+        const float timeSpan = HeightGraphTimeSpan(maxTime);
         
-        // Draw title
-        D2D1_RECT_F titleRect = D2D1::RectF(graphX + 5, graphY + 5, graphX + graphWidth - 5, graphY + 25);
-        pRenderTarget->DrawTextW(
-            L"Height vs Time (All Courts)",
-            29,
-            pSmallTextFormat,
-            titleRect,
-            pBrush
-        );
+        bool redraw = false;
+        if (FAILED(graphLayer.Begin(pRenderTarget, D2D1::SizeF(GRAPH_WIDTH, GRAPH_HEIGHT), timeSpan,
+                                    graphTrajectories.data(), graphTrajectories.size(), redraw))) {
+            return;
+        }
         
-        // Find max time for scaling
-        float maxTime = 0.0f;
-        for (int i = 0; i < 4; i++) {
-            if (!balls[i]->trajectory.empty()) {
-                maxTime = max(maxTime, balls[i]->trajectory.back().time);
+        // Layer coordinates: the graph's top left corner is (0, 0)
+        const float plotY = 30;
+        const float plotHeight = GRAPH_HEIGHT - 40;
+        D2D1_MATRIX_3X2_F toLayer = HeightGraphTransform(0, plotY, GRAPH_WIDTH, plotHeight, timeSpan, GRAPH_MAX_HEIGHT);
+        if (redraw) {
+            DrawGraphPanel(graphLayer.Target(), plotY, plotHeight);
+            
+            // Build every court's whole trace on the pool; DrawTrace then strokes them in
+            // order and only rebuilds what a failed Prepare left behind
+            if (courtPool) {
+                courtPool->ParallelFor(courtInstances.size(), [&](size_t i) {
+                    const TrajectoryBuffer& trajectory = frame->courts[i].dropBall.trajectory;
+                    if (trajectory.size() >= 2) {
+                        courtInstances[i].graphTrace->Prepare(pFactory, trajectory, toLayer);
+                    }
+                });
             }
         }
         
-        if (maxTime < 0.1f) maxTime = 1.0f;
+        // Draw trajectories
+        for (size_t i = 0; i < courtInstances.size(); i++) {
+            CourtInstance& court = courtInstances[i];
+            pBrush = BallBrush(court);
+            graphLayer.DrawTrace(i, pFactory, court.graphTrace.get(), pBrush, frame->courts[i].dropBall.trajectory,
+                                 toLayer, 2.0f);
+        }
+        
+        graphLayer.End(D2D1::Point2F(GRAPH_X, GRAPH_Y));
+    }
+    
+    // Background, border, title, grid and legend of the combined graph, in layer coordinates
+    void DrawGraphPanel(ID2D1RenderTarget* target, float plotY, float plotHeight) {
+        // Draw graph background
+        pBrush = deviceResources.Brush(BRUSH_GRAPH_BACKGROUND);
+        D2D1_RECT_F graphRect = D2D1::RectF(0, 0, GRAPH_WIDTH, GRAPH_HEIGHT);
+        target->FillRectangle(graphRect, pBrush);
+        
+        // Draw graph border, inset so the layer does not clip its outer half
+        pBrush = deviceResources.Brush(BRUSH_WHITE);
+        target->DrawRectangle(D2D1::RectF(0.5f, 0.5f, GRAPH_WIDTH - 0.5f, GRAPH_HEIGHT - 0.5f), pBrush, 1.0f);
         
-        const float maxHeight = 2.5f; // meters
-        const float plotY = graphY + 30;
-        const float plotHeight = graphHeight - 40;
+        // Draw title
+        target->DrawTextLayout(D2D1::Point2F(5, 5), pGraphTitleLayout, pBrush);
         
         // Draw grid lines
-        pBrush->SetColor(D2D1::ColorF(0.3f, 0.3f, 0.3f));
+        pBrush = deviceResources.Brush(BRUSH_GRAPH_GRID);
         for (int i = 0; i <= 5; i++) {
             float y = plotY + (plotHeight * i / 5.0f);
-            pRenderTarget->DrawLine(
-                D2D1::Point2F(graphX, y),
-                D2D1::Point2F(graphX + graphWidth, y),
+            target->DrawLine(
+                D2D1::Point2F(0, y),
+                D2D1::Point2F(GRAPH_WIDTH, y),
                 pBrush, 0.5f
             );
         }
         
-        // Draw trajectories
-        for (int i = 0; i < 4; i++) {
-            TennisBall* ball = balls[i];
-            if (ball->trajectory.size() < 2) continue;
-            
-            pBrush->SetColor(ball->surface->ballColor);
-            
-            for (size_t j = 1; j < ball->trajectory.size(); j++) {
-                float x1 = graphX + (ball->trajectory[j-1].time / maxTime) * graphWidth;
-                float y1 = plotY + plotHeight - (ball->trajectory[j-1].height / maxHeight) * plotHeight;
-                float x2 = graphX + (ball->trajectory[j].time / maxTime) * graphWidth;
-                float y2 = plotY + plotHeight - (ball->trajectory[j].height / maxHeight) * plotHeight;
-                
-                // Clamp to graph bounds
-                y1 = max(plotY, min(plotY + plotHeight, y1));
-                y2 = max(plotY, min(plotY + plotHeight, y2));
-                
-                pRenderTarget->DrawLine(
-                    D2D1::Point2F(x1, y1),
-                    D2D1::Point2F(x2, y2),
-                    pBrush, 2.0f
-                );
-            }
-            
-            // Draw legend
-            float legendX = graphX + 10 + (i * 150);
-            float legendY = graphY + graphHeight - 15;
+        // Draw legend
+        const float legendSpacing = GRAPH_WIDTH / courtInstances.size();
+        for (size_t i = 0; i < courtInstances.size(); i++) {
+            float legendX = 10 + i * legendSpacing;
+            float legendY = GRAPH_HEIGHT - 15;
             
-            pBrush->SetColor(ball->surface->ballColor);
+            pBrush = BallBrush(courtInstances[i]);
             D2D1_ELLIPSE legendDot = D2D1::Ellipse(
                 D2D1::Point2F(legendX, legendY),
                 4.0f, 4.0f
             );
-            pRenderTarget->FillEllipse(legendDot, pBrush);
+            target->FillEllipse(legendDot, pBrush);
+            if (!graphLegendLayouts[i]) continue;
             
-            pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
-            const wchar_t* labels[] = {L"Clay", L"Grass", L"Hard", L"Black"};
-            D2D1_RECT_F legendRect = D2D1::RectF(
-                legendX + 10, legendY - 8,
-                legendX + 140, legendY + 8
-            );
-            pRenderTarget->DrawTextW(
-                labels[i],
-                wcslen(labels[i]),
-                pSmallTextFormat,
-                legendRect,
-                pBrush
-            );
+            pBrush = deviceResources.Brush(BRUSH_WHITE);
+            target->DrawTextLayout(D2D1::Point2F(legendX + 10, legendY - 8), graphLegendLayouts[i], pBrush);
+        }
+    }
+    
+    void StartSweep() {
+        if (sweepThread.joinable()) {
+            sweepThread.join();
+        }
+        if (!sweepPool) {
+            sweepPool = std::make_unique<ThreadPool>(SWEEP_THREADS);
+        }
+        
+        sweepShotCount = SWEEP_GRID.ShotCount();
+        sweepShotsDone = 0;
+        sweepCancel = false;
+        sweepRunning = true;
+        
+        // The archive only opens for replay once the sweep has finished writing it
+        std::wstring sweepArchivePath = GetExeDirectory() + L"sweep_trajectories.trj";
+        if (SWEEP_ARCHIVE) {
+            archivePath = sweepArchivePath;
+        }
+        
+        sweepThread = std::thread([this, sweepArchivePath]() {
+            std::shared_lock<std::shared_mutex> tables(engineTablesLock);
+            SimulationEngine engine;
+            engine.SetIntegrationMode(SWEEP_EVENT_DRIVEN ? INTEGRATION_EVENT_DRIVEN : INTEGRATION_FIXED_STEP);
+            engine.SetIntegrator(SWEEP_INTEGRATOR);
+            engine.SetExactVacuum(SWEEP_EXACT_VACUUM);
+            engine.SetRandomSeed(RANDOM_SEED);
+            TrajectoryWriter archive;
+            bool archiving = SWEEP_ARCHIVE && archive.Open(sweepArchivePath.c_str());
+            
+            // Rows stream to disk as chunks finish; a cancelled sweep keeps the rows done so far
+            std::wstring resultPath = GetExeDirectory() + L"sweep_results" + ResultFormatExtension(SWEEP_RESULT_FORMAT);
+            FILE* out = _wfopen(resultPath.c_str(), L"wb");
+            std::unique_ptr<ResultSink> sink;
+            std::unique_ptr<ResultExporter> exporter;
+            if (out) {
+                sink = CreateResultSink(SWEEP_RESULT_FORMAT, out);
+                exporter = std::make_unique<ResultExporter>(*sink);
+            }
+            
+            SweepOutputs outputs;
+            outputs.archive = archiving ? &archive : nullptr;
+            outputs.results = exporter.get();
+            outputs.keepResults = false;
+            RunParameterSweep(SWEEP_GRID, engine, *sweepPool, &sweepShotsDone, &sweepCancel, outputs);
+            archive.Close();
+            if (exporter) {
+                exporter->Finish();
+                fclose(out);
+            }
+            sweepRunning = false;
+        });
+    }
+    
+    void DrawSweepStatus() {
+        if (!sweepRunning) return;
+        
+        size_t done = sweepShotsDone;
+        size_t total = sweepShotCount;
+        wchar_t statusText[96];
+        swprintf_s(statusText, L"Sweep: %zu / %zu shots (%u threads) - P: Cancel",
+                   done, total, sweepPool->ThreadCount());
+        
+        pBrush = deviceResources.Brush(BRUSH_SWEEP_STATUS);
+        D2D1_RECT_F textRect = D2D1::RectF(10, 5, WINDOW_WIDTH - 10, 20);
+        pRenderTarget->DrawTextW(statusText, (UINT32)wcslen(statusText), pSmallTextFormat, textRect, pBrush);
+    }
+    
+    void DrawArchiveStatus() {
+        pBrush = deviceResources.Brush(BRUSH_SWEEP_STATUS);
+        if (frame->recording) {
+            wchar_t recordText[64];
+            swprintf_s(recordText, L"REC %llu shots", (unsigned long long)frame->recordedShots);
+            D2D1_RECT_F recordRect = D2D1::RectF(WINDOW_WIDTH - 110, 5, WINDOW_WIDTH - 10, 20);
+            pRenderTarget->DrawTextW(recordText, (UINT32)wcslen(recordText), pSmallTextFormat, recordRect, pBrush);
+        }
+        if (frame->replaying) {
+            wchar_t replayText[200];
+            swprintf_s(replayText,
+                L"Replay shot %zu / %zu (id %llu)\nPgUp/PgDn: Shot (Ctrl: 100) | Home/End | Left/Right: Scrub | SPACE: Restart | Y: Exit",
+                frame->replayShot + 1, frame->replayShotCount, (unsigned long long)frame->replayShotId);
+            D2D1_RECT_F replayRect = D2D1::RectF(10, WINDOW_HEIGHT - 30, WINDOW_WIDTH - 10, WINDOW_HEIGHT - 5);
+            pRenderTarget->DrawTextW(replayText, (UINT32)wcslen(replayText), pSmallTextFormat, replayRect, pBrush);
+        }
+    }
+    
+    // Percentiles of the last second, under the title on the right
+    void DrawProfilerOverlay() {
+        Profiler::Clock::time_point now = Profiler::Clock::now();
+        if (profilerOverlay) {
+            if (std::chrono::duration<double>(now - profileSummaryTime).count() >= PROFILE_REFRESH_SECONDS) {
+                profileSummary = Profiler::Instance().Summarize(PROFILE_WINDOW_SECONDS);
+                profileSummaryTime = now;
+            }
+            
+            const ZoneStats* zones = profileSummary.zones;
+            const ZoneStats& render = zones[ZONE_RENDER_COURT].count ? zones[ZONE_RENDER_COURT] : zones[ZONE_RENDER_ALL_COURTS];
+            double seconds = profileSummary.windowSeconds;
+            wchar_t overlayText[320];
+            swprintf_s(overlayText,
+                L"Frame %.1f / %.1f ms (p50/p99) | %.0f fps\n"
+                L"Draw %.2f / %.2f ms | Graph %.2f | Present %.2f / %.2f\n"
+                L"Physics tick p99 %.2f ms | %.0f steps/s | Snapshot %.3f\n"
+                L"Dialog stall %.0f ms | O: Hide | J: Save trace",
+                profileSummary.frameIntervals.p50, profileSummary.frameIntervals.p99,
+                zones[ZONE_FRAME].count / seconds,
+                render.p50, render.p99, zones[ZONE_COMBINED_GRAPH].p99,
+                zones[ZONE_PRESENT].p50, zones[ZONE_PRESENT].p99,
+                zones[ZONE_PHYSICS_TICK].p99, zones[ZONE_PHYSICS_STEP].count / seconds, zones[ZONE_SNAPSHOT].p99,
+                zones[ZONE_RIGHTY_DIALOG].max);
+            
+            D2D1_RECT_F overlayRect = D2D1::RectF(WINDOW_WIDTH - 250, 115, WINDOW_WIDTH - 10, 175);
+            pBrush = deviceResources.Brush(BRUSH_GRAPH_BACKGROUND);
+            pRenderTarget->FillRectangle(overlayRect, pBrush);
+            pBrush = deviceResources.Brush(BRUSH_WHITE);
+            D2D1_RECT_F textRect = D2D1::RectF(overlayRect.left + 5, overlayRect.top + 3, overlayRect.right - 5, overlayRect.bottom);
+            pRenderTarget->DrawTextW(overlayText, (UINT32)wcslen(overlayText), pSmallTextFormat, textRect, pBrush);
+        }
+        
+        if (!profileNotice.empty() && std::chrono::duration<double>(now - profileNoticeTime).count() < PROFILE_NOTICE_SECONDS) {
+            pBrush = deviceResources.Brush(BRUSH_SWEEP_STATUS);
+            D2D1_RECT_F noticeRect = D2D1::RectF(WINDOW_WIDTH - 250, 177, WINDOW_WIDTH - 10, 192);
+            pRenderTarget->DrawTextW(profileNotice.c_str(), (UINT32)profileNotice.size(), pSmallTextFormat, noticeRect, pBrush);
+        }
+    }
+    
+    // J key: profile_trace.json next to the executable, for chrome://tracing or Perfetto
+    void SaveProfileTrace() {
+        std::wstring path = GetExeDirectory() + L"profile_trace.json";
+        if (!Profiler::Enabled()) {
+            profileNotice = L"Nothing recorded - O starts profiling";
+        } else if (Profiler::Instance().WriteChromeTrace(path.c_str())) {
+            profileNotice = L"Trace saved to profile_trace.json";
+        } else {
+            profileNotice = L"Could not write profile_trace.json";
+        }
+        profileNoticeTime = Profiler::Clock::now();
+    }
+    
+    // Y key: opens the last archive written this session (recording.trj next to the
+    // executable otherwise) and shows its first shot
+    void StartReplay() {
+        StopRecording();
+        std::wstring path = archivePath.empty() ? GetExeDirectory() + L"recording.trj" : archivePath;
+        if (!replay.Open(path.c_str()) || replay.ShotCount() == 0) {
+            replay.Close();
+            return;
+        }
+        replaying = true;
+        simulationStarted = true;
+        simulationComplete = false;
+        ShowReplayShot(0);
+    }
+    
+    void StopReplay() {
+        replaying = false;
+        replay.Close();
+        replaySamples.clear();
+        simulationStarted = false;
+        simulationComplete = false;
+        ResetShots();
+    }
+    
+    // Decodes a shot and switches to the single-court view of its surface
+    void ShowReplayShot(size_t index) {
+        replayShot = index;
+        replay.ReadShot(index, replaySamples);
+        const ArchivedShot& shot = replay.Shot(index);
+        
+        replayCourt = 0;
+        for (const CourtInstance& court : courtInstances) {
+            if (court.definition->screen != MODE_ALL && (int)court.definition->surface->type == shot.surfaceIndex) {
+                replayCourt = court.index;
+                break;
+            }
+        }
+        currentScreen = courtInstances[replayCourt].definition->screen;
+        
+        // Telemetry shows the archived launch settings
+        horizontalForce = shot.force;
+        launchAngle = shot.angle;
+        ballSpin = shot.spin;
+        airResistanceMode = (AirResistanceMode)min(3, max(0, (int)shot.airMode));
+        
+        replayTime = 0.0f;
+        courtInstances[replayCourt].shotBall->trajectory.clear();
+        replayShownSample = 0;
+        ShowReplayFrame();
+    }
+    
+    // Plays the shot on at the visual pace, or scrubs while Left/Right is held, and
+    // moves to the next shot RELAUNCH_DELAY after the last sample like a live relaunch
+    void AdvanceReplay(float frameSeconds) {
+        if (replaySamples.empty()) return;
+        
+        float scrub = 0.0f;
+        if (GetAsyncKeyState(VK_LEFT) & 0x8000) scrub -= REPLAY_SCRUB_SPEED;
+        if (GetAsyncKeyState(VK_RIGHT) & 0x8000) scrub += REPLAY_SCRUB_SPEED;
+        
+        float endTime = replaySamples.back().time;
+        replayTime += frameSeconds * (scrub != 0.0f ? scrub : visualPaceMultiplier);
+        replayTime = max(0.0f, replayTime);
+        if (scrub != 0.0f) {
+            replayTime = min(endTime, replayTime);
+        } else if (replayTime >= endTime + RELAUNCH_DELAY && replayShot + 1 < replay.ShotCount()) {
+            ShowReplayShot(replayShot + 1);
+            return;
+        }
+        renderAlpha = 1.0f;
+        ShowReplayFrame();
+    }
+    
+    // Poses the court's shot ball at the last sample not after replayTime. Moving
+    // forward appends to its trajectory; moving back rebuilds it from the start.
+    void ShowReplayFrame() {
+        if (replaySamples.empty()) return;
+        TennisBall* ball = courtInstances[replayCourt].shotBall.get();
+        
+        auto after = std::upper_bound(replaySamples.begin(), replaySamples.end(), replayTime,
+            [](float time, const TrajectorySample& sample) { return time < sample.time; });
+        size_t shown = (size_t)max((ptrdiff_t)1, after - replaySamples.begin());
+        
+        if (shown < replayShownSample) {
+            ball->trajectory.clear();
+            replayShownSample = 0;
+        }
+        if (replayShownSample == 0) {
+            ball->bounceCount = 0;
+        }
+        for (; replayShownSample < shown; replayShownSample++) {
+            const TrajectorySample& sample = replaySamples[replayShownSample];
+            ball->trajectory.push_back({sample.time, sample.y, sample.x});
+            if (sample.flags & SAMPLE_BOUNCE) ball->bounceCount++;
+        }
+        
+        const TrajectorySample& sample = replaySamples[shown - 1];
+        ball->time = sample.time;
+        ball->x = ball->prevX = sample.x;
+        ball->y = ball->prevY = sample.y;
+        ball->vx = sample.vx;
+        ball->vy = sample.vy;
+        ball->spinRPM = sample.spin;
+        ball->isActive = true;
+    }
+    
+    void OnReplayKey(const InputCommand& command) {
+        WPARAM wParam = command.key;
+        size_t count = replay.ShotCount();
+        size_t jump = command.control ? 100 : 1;
+        
+        if (wParam == 'Y' || wParam == 'y') {
+            StopReplay();
+        } else if (wParam == VK_BACK) {
+            StopReplay();
+            currentScreen = MODE_ALL;
+            ResetDrops();
+        } else if (wParam == VK_NEXT) {
+            ShowReplayShot(min(count - 1, replayShot + jump));
+        } else if (wParam == VK_PRIOR) {
+            ShowReplayShot(replayShot - min(replayShot, jump));
+        } else if (wParam == VK_HOME) {
+            ShowReplayShot(0);
+        } else if (wParam == VK_END) {
+            ShowReplayShot(count - 1);
+        } else if (wParam == VK_SPACE) {
+            replayTime = 0.0f;
+            ShowReplayFrame();
+        } else if (wParam == VK_OEM_PLUS || wParam == VK_ADD) {
+            visualPaceMultiplier = min(10.0f, visualPaceMultiplier * 1.1f);
+        } else if (wParam == VK_OEM_MINUS || wParam == VK_SUBTRACT) {
+            visualPaceMultiplier = max(0.1f, visualPaceMultiplier / 1.1f);
         }
     }
     
-    void OnKeyPress(WPARAM wParam) {
+    void OnKeyPress(const InputCommand& command) {
+        if (replaying) {
+            OnReplayKey(command);
+            return;
+        }
+        
+        WPARAM wParam = command.key;        
+        CourtInstance* selected = CourtForKey(wParam);
+        
         if (wParam == VK_SPACE) {
             StartSimulation();
+        } else if (wParam == 'P' || wParam == 'p') {
+            // P key - run the parameter sweep in the background, or cancel a running one
+            if (sweepRunning) {
+                sweepCancel = true;
+            } else {
+                StartSweep();
+            }
+        } else if (wParam == 'K' || wParam == 'k') {
+            // K key - start or stop recording the shot balls to recording.trj
+            if (recording) {
+                StopRecording();
+            } else {
+                StartRecording();
+            }
+        } else if (wParam == 'Y' || wParam == 'y') {
+            // Y key - replay the last archive without re-simulating
+            StartReplay();
         } else if (wParam == 'R' || wParam == 'r') {
             simulationStarted = false;
             simulationComplete = false;
             if (currentScreen == MODE_ALL) {
-                for (int i = 0; i < 4; i++) {
-                    balls[i]->reset();
-                }
-            } else if (currentScreen == MODE_CLAY) {
-                clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_GRASS) {
-                grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_HARD) {
-                hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_LAVER) {
-                laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
+                ResetDrops();
+            } else {
+                ResetShots();
             }
-        } else if (wParam == 'C' || wParam == 'c') {
-            currentScreen = MODE_CLAY;
-            simulationStarted = false;
-            simulationComplete = false;
-            clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (wParam == 'G' || wParam == 'g') {
-            currentScreen = MODE_GRASS;
-            simulationStarted = false;
-            simulationComplete = false;
-            grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (wParam == 'H' || wParam == 'h') {
-            currentScreen = MODE_HARD;
+        } else if (selected) {
+            // Court key - open that court's single-court view
+            currentScreen = selected->definition->screen;
             simulationStarted = false;
             simulationComplete = false;
-            hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-        } else if (wParam == 'L' || wParam == 'l') {
-            currentScreen = MODE_LAVER;
+            ResetShots();
+        } else if ((wParam == 'M' || wParam == 'm') && currentScreen != MODE_ALL) {
+            // M key - switch between the single shot and the ball machine drill
+            rallyMode = !rallyMode;
             simulationStarted = false;
             simulationComplete = false;
-            laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
+            ResetShots();
+        } else if ((wParam == 'T' || wParam == 't') && currentScreen != MODE_ALL) {
+            // T key - cycle RIGHTY's return policy (dialog, fixed, pattern table, target)
+            SetReturnPolicy((ReturnPolicyType)((returnPolicy->Type() + 1) % 4));
         } else if (wParam == 'A' || wParam == 'a') {
-            if (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER) {
-                // A key - decrease force in Clay/Grass/Hard/Laver courts
+            if (currentScreen != MODE_ALL) {
+                // A key - decrease force in the single-court views
                 horizontalForce = max(MIN_HORIZONTAL_FORCE, horizontalForce - 10.0f);
-                if (!simulationStarted) {
-                    if (currentScreen == MODE_CLAY) {
-                        clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_GRASS) {
-                        grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_HARD) {
-                        hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else {
-                        laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    }
-                }
+                AimWaitingShots();
             }
         } else if (wParam == VK_BACK) {
             // Backspace - return to all courts view
             currentScreen = MODE_ALL;
             simulationStarted = false;
             simulationComplete = false;
-            for (int i = 0; i < 4; i++) {
-                balls[i]->reset();
-            }
-        } else if (wParam == VK_UP && (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER)) {
+            ResetDrops();
+        } else if (wParam == VK_UP && currentScreen != MODE_ALL) {
             horizontalForce = min(MAX_HORIZONTAL_FORCE, horizontalForce + 10.0f);
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else {
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
-        } else if (wParam == VK_DOWN && (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER)) {
+            AimWaitingShots();
+        } else if (wParam == VK_DOWN && currentScreen != MODE_ALL) {
             horizontalForce = max(MIN_HORIZONTAL_FORCE, horizontalForce - 10.0f);
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else {
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
-        } else if ((wParam == 'W' || wParam == 'w') && (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER)) {
+            AimWaitingShots();
+        } else if ((wParam == 'W' || wParam == 'w') && currentScreen != MODE_ALL) {
             // W key - increase angle
             launchAngle = min(MAX_ANGLE, launchAngle + ANGLE_STEP);
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else {
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
-        } else if ((wParam == 'S' || wParam == 's') && (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER)) {
+            AimWaitingShots();
+        } else if ((wParam == 'S' || wParam == 's') && currentScreen != MODE_ALL) {
             // S key - decrease angle
             launchAngle = max(MIN_ANGLE, launchAngle - ANGLE_STEP);
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else {
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
-        } else if ((wParam == 'D' || wParam == 'd') && (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER)) {
+            AimWaitingShots();
+        } else if ((wParam == 'D' || wParam == 'd') && currentScreen != MODE_ALL) {
             // D key - increase force
             horizontalForce = min(MAX_HORIZONTAL_FORCE, horizontalForce + 10.0f);
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else {
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
-        } else if ((GetKeyState(VK_CONTROL) & 0x8000) && (wParam == VK_OEM_PLUS || wParam == VK_ADD)) {
+            AimWaitingShots();
+        } else if (command.control && (wParam == VK_OEM_PLUS || wParam == VK_ADD)) {
             // Ctrl + + for topspin
-            if (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER) {
+            if (currentScreen != MODE_ALL) {
                 ballSpin = min(MAX_SPIN, ballSpin + SPIN_STEP);
-                if (!simulationStarted) {
-                    if (currentScreen == MODE_CLAY) {
-                        clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_GRASS) {
-                        grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_HARD) {
-                        hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else {
-                        laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    }
-                }
+                AimWaitingShots();
             }
-        } else if ((GetKeyState(VK_CONTROL) & 0x8000) && (wParam == VK_OEM_MINUS || wParam == VK_SUBTRACT)) {
+        } else if (command.control && (wParam == VK_OEM_MINUS || wParam == VK_SUBTRACT)) {
             // Ctrl + - for backspin
-            if (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER) {
+            if (currentScreen != MODE_ALL) {
                 ballSpin = max(MIN_SPIN, ballSpin - SPIN_STEP);
-                if (!simulationStarted) {
-                    if (currentScreen == MODE_CLAY) {
-                        clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_GRASS) {
-                        grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_HARD) {
-                        hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else {
-                        laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    }
-                }
+                AimWaitingShots();
             }
-        } else if ((wParam == VK_OEM_PERIOD || wParam == '.') && (GetKeyState(VK_SHIFT) & 0x8000)) {
+        } else if ((wParam == VK_OEM_PERIOD || wParam == '.') && command.shift) {
             // > key (Shift + .) for topspin
-            if (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER) {
+            if (currentScreen != MODE_ALL) {
                 ballSpin = min(MAX_SPIN, ballSpin + SPIN_STEP);
-                if (!simulationStarted) {
-                    if (currentScreen == MODE_CLAY) {
-                        clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_GRASS) {
-                        grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_HARD) {
-                        hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else {
-                        laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    }
-                }
+                AimWaitingShots();
             }
-        } else if ((wParam == VK_OEM_COMMA || wParam == ',') && (GetKeyState(VK_SHIFT) & 0x8000)) {
+        } else if ((wParam == VK_OEM_COMMA || wParam == ',') && command.shift) {
             // < key (Shift + ,) for backspin
-            if (currentScreen == MODE_CLAY || currentScreen == MODE_GRASS || currentScreen == MODE_HARD || currentScreen == MODE_LAVER) {
+            if (currentScreen != MODE_ALL) {
                 ballSpin = max(MIN_SPIN, ballSpin - SPIN_STEP);
-                if (!simulationStarted) {
-                    if (currentScreen == MODE_CLAY) {
-                        clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_GRASS) {
-                        grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else if (currentScreen == MODE_HARD) {
-                        hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    } else {
-                        laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                    }
-                }
+                AimWaitingShots();
             }
         } else if (wParam == VK_OEM_PLUS || wParam == VK_ADD) {
             // + key (both regular and numpad) - visual pace
@@ -1864,8 +2447,29 @@ public:
         }
     }
     
+    // Court whose single-court view the key opens, NULL if it selects none
+    CourtInstance* CourtForKey(WPARAM wParam) {
+        for (CourtInstance& court : courtInstances) {
+            WPARAM key = court.definition->key;
+            if (key && (wParam == key || wParam == key - 'A' + 'a')) return &court;
+        }
+        return NULL;
+    }
+    
+    // Launch settings changed: re-aim the shot balls unless a shot is in flight. Ball
+    // machines in a running drill take the new aim from their next launch on.
+    void AimWaitingShots() {
+        if (!simulationStarted) {
+            ResetShots();
+        } else if (rallyMode) {
+            for (CourtInstance& court : courtInstances) {
+                if (RunsDrill(court)) court.machine.Aim(AimedShot(court));
+            }
+        }
+    }
+    
     void OnMouseClick(int x, int y) {
-        if (currentScreen != MODE_CLAY && currentScreen != MODE_GRASS && currentScreen != MODE_HARD && currentScreen != MODE_LAVER) return;
+        if (currentScreen == MODE_ALL || replaying) return;
         
         // Check if click is inside air resistance combo box
         if (x >= comboBoxRect.left && x <= comboBoxRect.right &&
@@ -1873,22 +2477,8 @@ public:
             // Cycle through air resistance modes
             airResistanceMode = (AirResistanceMode)((airResistanceMode + 1) % 4);
             
-            // Update ball if not running simulation
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_LAVER) {
-                    laverBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
-            }
+            // Update balls if not running simulation
+            AimWaitingShots();
         }
         
         // Check if click is inside launch pattern combo box
@@ -1900,33 +2490,46 @@ public:
             // Apply the new pattern
             ApplyLaunchPattern();
             
-            // Update ball if not running simulation
-            if (!simulationStarted) {
-                if (currentScreen == MODE_CLAY) {
-                    clayBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_GRASS) {
-                    grassBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_HARD) {
-                    hardBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                } else if (currentScreen == MODE_LAVER) {
-                    laverBall->setAirResistance(airModes[airResistanceMode].coefficient);
-                    laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-                }
+            // Update balls if not running simulation
+            AimWaitingShots();
+        }
+    }
+    
+    // Right click on the court floor: aim the shot at that spot. The force is solved
+    // for the current angle and spin; a spot that force cannot reach solves the angle
+    // instead, and if neither lands there the closest force is kept.
+    void OnMouseRightClick(int x, int y) {
+        if (currentScreen == MODE_ALL || replaying || simulationStarted) return;
+        if (x < COURT_VIEW_MARGIN || x > COURT_VIEW_MARGIN + COURT_VIEW_PIXEL_WIDTH ||
+            y < COURT_VIEW_TOP || y > COURT_VIEW_BOTTOM) return;
+        
+        float landingX = (x - COURT_VIEW_MARGIN) / COURT_VIEW_PIXEL_WIDTH * COURT_LENGTH;
+        std::unique_lock<std::mutex> readers(landingLock);
+        ShotSolver solver(LANDING_GRID, landingReady ? &landingTable : NULL);
+        ShotSolution solution = solver.Solve(
+            LaunchTarget(landingX, SOLVE_FORCE, horizontalForce, launchAngle, ballSpin, airResistanceMode));
+        if (!solution.solved) {
+            ShotSolution angleSolution = solver.Solve(
+                LaunchTarget(landingX, SOLVE_ANGLE, horizontalForce, launchAngle, ballSpin, airResistanceMode));
+            if (angleSolution.solved) {
+                solution = angleSolution;
             }
         }
+        readers.unlock();
+        
+        horizontalForce = solution.force;
+        launchAngle = solution.angle;
+        AimWaitingShots();
     }
     
     void ApplyLaunchPattern() {
         if (currentLaunchPattern == PATTERN_RANDOM) {
             // Random force: 200-400N
-            horizontalForce = 200.0f + (rand() % 201);
+            horizontalForce = 200.0f + launchRandom.NextInt(201);
             // Random angle: 9-39 degrees
-            launchAngle = 9.0f + (rand() % 31);
+            launchAngle = 9.0f + launchRandom.NextInt(31);
             // Random spin: 60-600 RPM
-            ballSpin = 60.0f + (rand() % 541);
+            ballSpin = 60.0f + launchRandom.NextInt(541);
         } else {
             // Use preset pattern
             horizontalForce = launchPatterns[currentLaunchPattern].force;
@@ -1936,7 +2539,7 @@ public:
     }
     
     void OnMouseWheel(int delta) {
-        if (currentScreen != MODE_CLAY && currentScreen != MODE_GRASS && currentScreen != MODE_HARD && currentScreen != MODE_LAVER) return;
+        if (currentScreen == MODE_ALL || replaying) return;
         
         // Positive delta = scroll up, negative = scroll down
         if (delta > 0) {
@@ -1945,26 +2548,13 @@ public:
             launchAngle = max(MIN_ANGLE, launchAngle - ANGLE_STEP);
         }
         
-        // Update ball if not running simulation
-        if (!simulationStarted) {
-            if (currentScreen == MODE_CLAY) {
-                clayBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_GRASS) {
-                grassBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_HARD) {
-                hardBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            } else if (currentScreen == MODE_LAVER) {
-                laverBall->resetForHorizontalShot(horizontalForce, launchAngle, ballSpin);
-            }
-        }
+        // Update balls if not running simulation
+        AimWaitingShots();
     }
     
     bool CheckRightyCollision(TennisBall* ball) {
         if (!ball->isActive || simulationPaused) return false;
         
-        const float RIGHTY_RADIUS = 0.05f; // 5cm radius for collision detection
-        const float RIGHTY_HEIGHT = NET_HEIGHT * 2.5f; // Height of RIGHTY stick
-        
         // Check if ball is in RIGHTY's horizontal range
         float distX = fabs(ball->x - rightyPosition);
         
@@ -1976,28 +2566,6 @@ public:
         
         return false;
     }
-    
-    void ApplyRightyHit(TennisBall* ball, float force, float angle, float spin) {
-        // RIGHTY hits the ball back to the left
-        // Calculate velocity from force (force range 10-600N mapped to velocity 5-30 m/s)
-        float totalVelocity = (force / 600.0f) * 30.0f;
-        totalVelocity = max(5.0f, totalVelocity);
-        
-        // Convert angle to radians and calculate velocity components
-        // Negative X velocity since hitting back to the left
-        float angleRad = angle * 3.14159265f / 180.0f;
-        ball->vx = -totalVelocity * cos(angleRad); // Negative for leftward direction
-        ball->vy = totalVelocity * sin(angleRad);
-        
-        // Apply spin
-        ball->spinRPM = spin;
-        
-        // Reset ball position slightly away from RIGHTY to avoid re-collision
-        ball->x = rightyPosition - 0.1f;
-        
-        simulationPaused = false;
-        ballHitRighty = false;
-    }
 };
 
 
@@ -2118,9 +2686,10 @@ bool ShowRightyHitDialog(HWND hwndParent, RightyHitParams* params) {
         WCHAR font[13];
     };
     
-    // Allocate memory for dialog template with controls
+    // Dialog template with controls, rebuilt in the same buffer for every hit
     const int TEMPLATE_SIZE = 2048;
-    BYTE* pTemplate = new BYTE[TEMPLATE_SIZE];
+    static DWORD templateBuffer[TEMPLATE_SIZE / sizeof(DWORD)];
+    BYTE* pTemplate = (BYTE*)templateBuffer;
     ZeroMemory(pTemplate, TEMPLATE_SIZE);
     
     DLGTEMPLATE* pDlg = (DLGTEMPLATE*)pTemplate;
@@ -2208,8 +2777,6 @@ bool ShowRightyHitDialog(HWND hwndParent, RightyHitParams* params) {
     // Show dialog
     INT_PTR result = DialogBoxIndirectParam(GetModuleHandle(NULL), pDlg, hwndParent, RightyHitDialogProc, (LPARAM)params);
     
-    delete[] pTemplate;
-    
     return (result == IDOK && params->confirmed);
 }
 
@@ -2227,16 +2794,20 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         case WM_DESTROY:
             KillTimer(hwnd, 1);
             delete g_pApp;
+            g_pApp = NULL;
             PostQuitMessage(0);
             return 0;
             
         case WM_TIMER:
+            // Physics runs on the simulation thread; the timer only paces frames
             if (g_pApp) {
-                g_pApp->Update();
                 InvalidateRect(hwnd, NULL, FALSE);
             }
             return 0;
             
+        case WM_RIGHTY_HIT:
+            return g_pApp && g_pApp->AnswerRightyHit((RightyHitParams*)lParam);
+            
         case WM_PAINT:
             if (g_pApp) {
                 g_pApp->Render();
@@ -2246,7 +2817,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             
         case WM_KEYDOWN:
             if (g_pApp) {
-                g_pApp->OnKeyPress(wParam);
+                g_pApp->PostKey(wParam);
             }
             return 0;
             
@@ -2254,7 +2825,16 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             if (g_pApp) {
                 int xPos = LOWORD(lParam);
                 int yPos = HIWORD(lParam);
-                g_pApp->OnMouseClick(xPos, yPos);
+                g_pApp->PostMouse(INPUT_CLICK, xPos, yPos, 0);
+                InvalidateRect(hwnd, NULL, FALSE);
+            }
+            return 0;
+            
+        case WM_RBUTTONDOWN:
+            if (g_pApp) {
+                int xPos = LOWORD(lParam);
+                int yPos = HIWORD(lParam);
+                g_pApp->PostMouse(INPUT_RIGHT_CLICK, xPos, yPos, 0);
                 InvalidateRect(hwnd, NULL, FALSE);
             }
             return 0;
@@ -2262,7 +2842,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         case WM_MOUSEWHEEL:
             if (g_pApp) {
                 int delta = GET_WHEEL_DELTA_WPARAM(wParam);
-                g_pApp->OnMouseWheel(delta);
+                g_pApp->PostMouse(INPUT_WHEEL, 0, 0, delta);
                 InvalidateRect(hwnd, NULL, FALSE);
             }
             return 0;
@@ -2273,11 +2853,11 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
 // Main entry point
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int nCmdShow) {
-    // Seed random number generator
-    srand((unsigned int)time(NULL));
-    
-    // Load settings from INI file
-    LoadSettings();
+    // Load settings from INI file, read once into a table
+    SettingsFile settings;
+    settings.Load(GetSettingsPath().c_str());
+    LoadSettings(settings);
+    LoadCourtDefinitions(settings);
     
     // Register window class
     const wchar_t CLASS_NAME[] = L"TennisBallPhysicsSimulator";